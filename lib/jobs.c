@@ -0,0 +1,256 @@
+/* Running jobs in parallel processes.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <argp.h>
+#include <errno.h>
+#include <error.h>
+#include <libintl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "libeu.h"
+#include "jobs.h"
+
+/* Prototype for option handler.  */
+static error_t parse_opt (int key, char *arg, struct argp_state *state);
+
+/* Definitions of arguments for argp functions.  */
+static const struct argp_option options[] =
+{
+  { "jobs", 'j', "N", 0,
+    N_("Process up to N files at the same time, 0 means one per processor (defaults to 1)"), 0 },
+
+  { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+/* Parser data structure.  */
+const struct argp jobs_argp =
+  {
+    options, parse_opt, NULL, NULL, NULL, NULL, NULL
+  };
+
+/* Number of jobs to run at the same time.  */
+unsigned int jobs_max = 1;
+
+
+/* Handle program arguments.  */
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  switch (key)
+    {
+    case 'j':
+      {
+	char *end;
+	errno = 0;
+	unsigned long int n = strtoul (arg, &end, 10);
+	if (errno != 0 || *end != '\0' || n > UINT_MAX)
+	  {
+	    argp_error (state, dgettext ("elfutils",
+					 "invalid number of jobs '%s'"), arg);
+	    return EINVAL;
+	  }
+	if (n == 0)
+	  {
+	    long int nproc = sysconf (_SC_NPROCESSORS_ONLN);
+	    n = nproc > 0 ? nproc : 1;
+	  }
+	jobs_max = n;
+      }
+      break;
+
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+  return 0;
+}
+
+
+/* State of one job run in its own process.  */
+struct job_state
+{
+  pid_t pid;
+  int status;
+  bool done;
+
+  /* Where the child writes its standard output and error.  */
+  FILE *out;
+  FILE *err;
+
+  /* What it wrote, read back once it is done.  */
+  char *out_buf;
+  size_t out_size;
+  char *err_buf;
+  size_t err_size;
+};
+
+/* Read all of the temporary file F into a new buffer and close it.  */
+static void
+read_back (FILE *f, char **bufp, size_t *sizep)
+{
+  struct stat st;
+  if (fstat (fileno (f), &st) < 0)
+    error (EXIT_FAILURE, errno,
+	   dgettext ("elfutils", "cannot read job output"));
+
+  char *buf = xmalloc (st.st_size ?: 1);
+  rewind (f);
+  if (fread (buf, 1, st.st_size, f) != (size_t) st.st_size)
+    error (EXIT_FAILURE, errno,
+	   dgettext ("elfutils", "cannot read job output"));
+  fclose (f);
+
+  *bufp = buf;
+  *sizep = st.st_size;
+}
+
+/* Start JOB for NDX in a new process.  Returns false if no process
+   could be created.  */
+static bool
+start_job (struct job_state *js, size_t ndx,
+	   int (*job) (size_t ndx, void *arg), void *arg)
+{
+  js->out = tmpfile ();
+  js->err = tmpfile ();
+  if (js->out == NULL || js->err == NULL)
+    error (EXIT_FAILURE, errno,
+	   dgettext ("elfutils", "cannot create temporary file"));
+
+  /* Nothing buffered may be written twice.  */
+  fflush (stdout);
+  fflush (stderr);
+
+  js->pid = fork ();
+  if (js->pid < 0)
+    {
+      fclose (js->out);
+      fclose (js->err);
+      return false;
+    }
+
+  if (js->pid == 0)
+    {
+      if (dup2 (fileno (js->out), STDOUT_FILENO) < 0
+	  || dup2 (fileno (js->err), STDERR_FILENO) < 0)
+	_exit (EXIT_FAILURE);
+      exit (job (ndx, arg));
+    }
+
+  return true;
+}
+
+int
+run_jobs (size_t njobs, int (*job) (size_t ndx, void *arg), void *arg,
+	  const char *const *names)
+{
+  int result = 0;
+
+  if (jobs_max <= 1 || njobs <= 1)
+    {
+      for (size_t ndx = 0; ndx < njobs; ++ndx)
+	result |= job (ndx, arg);
+      return result;
+    }
+
+  struct job_state *jobs = xcalloc (njobs, sizeof jobs[0]);
+  size_t next = 0;
+  size_t printed = 0;
+  unsigned int running = 0;
+
+  while (printed < njobs)
+    {
+      while (next < njobs && running < jobs_max)
+	{
+	  if (! start_job (&jobs[next], next, job, arg))
+	    {
+	      /* Try again when one of the running jobs is done.  */
+	      if (running == 0)
+		error (EXIT_FAILURE, errno,
+		       dgettext ("elfutils", "cannot create process"));
+	      break;
+	    }
+	  ++next;
+	  ++running;
+	}
+
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  error (EXIT_FAILURE, errno,
+		 dgettext ("elfutils", "cannot wait for process"));
+	}
+
+      for (size_t ndx = printed; ndx < next; ++ndx)
+	if (jobs[ndx].pid == pid && ! jobs[ndx].done)
+	  {
+	    struct job_state *js = &jobs[ndx];
+	    js->status = status;
+	    js->done = true;
+	    read_back (js->out, &js->out_buf, &js->out_size);
+	    read_back (js->err, &js->err_buf, &js->err_size);
+	    --running;
+	    break;
+	  }
+
+      /* Print what all jobs up to the first still running one wrote.  */
+      while (printed < next && jobs[printed].done)
+	{
+	  struct job_state *js = &jobs[printed];
+	  fwrite (js->out_buf, 1, js->out_size, stdout);
+	  fflush (stdout);
+	  fwrite (js->err_buf, 1, js->err_size, stderr);
+	  fflush (stderr);
+	  free (js->out_buf);
+	  free (js->err_buf);
+
+	  if (WIFEXITED (js->status))
+	    result |= WEXITSTATUS (js->status);
+	  else
+	    {
+	      error (0, 0, dgettext ("elfutils", "%s: terminated by signal %s"),
+		     names[printed], strsignal (WTERMSIG (js->status)));
+	      result |= 1;
+	    }
+	  ++printed;
+	}
+    }
+
+  free (jobs);
+  return result;
+}
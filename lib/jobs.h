@@ -0,0 +1,50 @@
+/* Running jobs in parallel processes.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef JOBS_H
+#define JOBS_H 1
+
+#include <stddef.h>
+
+/* Command line parser for -j.  */
+extern const struct argp jobs_argp;
+
+/* Number of jobs to run at the same time.  */
+extern unsigned int jobs_max;
+
+/* Call JOB for each index below NJOBS, passing ARG along.  With
+   jobs_max above one every call is made in a child process of its own
+   and up to jobs_max of them run at the same time.  Whatever a job
+   writes to standard output and standard error is held back until all
+   earlier jobs are done, so the output is the same as when running
+   them one after the other.  A job that fails with error (EXIT_FAILURE)
+   only ends its own process.  NAMES are used to report jobs killed by a
+   signal.  Returns the bitwise or of the results of all jobs.  */
+extern int run_jobs (size_t njobs, int (*job) (size_t ndx, void *arg),
+		     void *arg, const char *const *names);
+
+#endif /* jobs.h */
@@ -59,6 +59,9 @@ disasm_begin (Ebl *ebl, Elf *elf, DisasmGetSymCB_t symcb)
   ctx->ebl = ebl;
   ctx->elf = elf;
   ctx->symcb = symcb;
+  ctx->symbols = NULL;
+  ctx->nsymbols = 0;
+  ctx->symbols_read = false;
 
   return ctx;
 }
@@ -30,6 +30,9 @@
 # include <config.h>
 #endif
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "libasmP.h"
@@ -40,9 +43,43 @@ struct symtoken
 {
   DisasmCtx_t *ctx;
   void *symcbarg;
+  /* Section of the code for ET_REL files, zero otherwise.  */
+  Elf32_Word shndx;
 };
 
 
+/* Find the symbol containing VALUE in section SHNDX.  */
+static const struct disasm_symbol *
+lookup_symbol (DisasmCtx_t *ctx, Elf32_Word shndx, GElf_Addr value,
+	       GElf_Addr *offset)
+{
+  /* Find the last symbol at or before VALUE.  */
+  size_t l = 0;
+  size_t u = ctx->nsymbols;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      const struct disasm_symbol *sym = &ctx->symbols[idx];
+      if (sym->shndx < shndx
+	  || (sym->shndx == shndx && sym->addr <= value))
+	l = idx + 1;
+      else
+	u = idx;
+    }
+
+  if (l == 0)
+    return NULL;
+
+  const struct disasm_symbol *sym = &ctx->symbols[l - 1];
+  if (sym->shndx != shndx
+      || (value != sym->addr && value - sym->addr >= sym->size))
+    return NULL;
+
+  *offset = value - sym->addr;
+  return sym;
+}
+
+
 static int
 default_elf_getsym (GElf_Addr addr, Elf32_Word scnndx, GElf_Addr value,
 		    char **buf, size_t *buflen, void *arg)
@@ -58,32 +95,105 @@ default_elf_getsym (GElf_Addr addr, Elf32_Word scnndx, GElf_Addr value,
 	return res;
     }
 
-  // XXX Look up in ELF file.
+  GElf_Addr offset;
+  const struct disasm_symbol *sym = lookup_symbol (symtoken->ctx,
+						   symtoken->shndx, value,
+						   &offset);
+  if (sym == NULL)
+    return -1;
+
+  char offstr[sizeof "+0x" + 16];
+  if (offset == 0)
+    offstr[0] = '\0';
+  else
+    snprintf (offstr, sizeof offstr, "+%#" PRIx64, (uint64_t) offset);
+
+  size_t namelen = strlen (sym->name);
+  size_t needed = namelen + strlen (offstr) + 1;
+  if (*buflen < needed)
+    {
+      char *newbuf = realloc (*buf, needed);
+      if (newbuf == NULL)
+	return -1;
+      *buf = newbuf;
+      *buflen = needed;
+    }
 
-  return -1;
+  stpcpy (mempcpy (*buf, sym->name, namelen), offstr);
+
+  return 0;
 }
 
 
-struct symaddrpair
+static int
+compare_symbols (const void *p1, const void *p2)
 {
-  GElf_Addr addr;
-  const char *name;
-};
+  const struct disasm_symbol *s1 = (const struct disasm_symbol *) p1;
+  const struct disasm_symbol *s2 = (const struct disasm_symbol *) p2;
+
+  if (s1->shndx != s2->shndx)
+    return s1->shndx < s2->shndx ? -1 : 1;
+  if (s1->addr != s2->addr)
+    return s1->addr < s2->addr ? -1 : 1;
+
+  /* Of several symbols at the same address the first one is used.
+     Prefer symbols with a size, then global over weak over local
+     ones, then the order in the symbol tables.  */
+  if ((s1->size == 0) != (s2->size == 0))
+    return s1->size == 0 ? 1 : -1;
+  if (s1->bind != s2->bind)
+    {
+      if (s1->bind == STB_GLOBAL || s2->bind == STB_LOCAL)
+	return -1;
+      if (s2->bind == STB_GLOBAL || s1->bind == STB_LOCAL)
+	return 1;
+    }
+  return s1->order < s2->order ? -1 : s1->order > s2->order;
+}
 
 
 static void
-read_symtab_exec (DisasmCtx_t *ctx)
+read_symtab (DisasmCtx_t *ctx)
 {
-  /* We simply use all we can get our hands on.  This will produce
-     some duplicate information but this is no problem, we simply
-     ignore the latter definitions.  */
-  Elf_Scn *scn= NULL;
+  ctx->symbols_read = true;
+
+  /* Find the symbol table(s).  */
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (ctx->elf, &ehdr_mem);
+  if (ehdr == NULL)
+    return;
+
+  /* The symbol values of relocatable files are offsets in their
+     section, so symbols are looked up by section and value.  */
+  bool rel;
+  switch (ehdr->e_type)
+    {
+    case ET_EXEC:
+    case ET_DYN:
+      rel = false;
+      break;
+
+    case ET_REL:
+      rel = true;
+      break;
+
+    default:
+      return;
+    }
+
+  /* We simply use all we can get our hands on, .symtab and .dynsym.
+     This will produce some duplicate information but this is no
+     problem, we simply ignore the latter definitions.  */
+  size_t maxsyms = 0;
+  Elf_Scn *scn = NULL;
   while ((scn = elf_nextscn (ctx->elf, scn)) != NULL)
     {
       GElf_Shdr shdr_mem;
       GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
       Elf_Data *data;
-      if (shdr == NULL || shdr->sh_type != SHT_SYMTAB
+      if (shdr == NULL
+	  || (shdr->sh_type != SHT_SYMTAB && shdr->sh_type != SHT_DYNSYM)
+	  || shdr->sh_entsize == 0
 	  || (data = elf_getdata (scn, NULL)) == NULL)
 	continue;
 
@@ -93,8 +203,8 @@ read_symtab_exec (DisasmCtx_t *ctx)
 	xndxdata = elf_getdata (elf_getscn (ctx->elf, xndxscnidx), NULL);
 
       /* Iterate over all symbols.  Add all defined symbols.  */
-      int nsyms = shdr->sh_size / shdr->sh_entsize;
-      for (int cnt = 1; cnt < nsyms; ++cnt)
+      size_t nsyms = shdr->sh_size / shdr->sh_entsize;
+      for (size_t cnt = 1; cnt < nsyms; ++cnt)
 	{
 	  Elf32_Word xshndx;
 	  GElf_Sym sym_mem;
@@ -103,39 +213,82 @@ read_symtab_exec (DisasmCtx_t *ctx)
 	  if (sym == NULL)
 	    continue;
 
-	  /* Undefined symbols are useless here.  */
-	  if (sym->st_shndx == SHN_UNDEF)
+	  /* Undefined symbols are useless here, and so are symbols
+	     which do not name an address in a section.  */
+	  if (sym->st_shndx == SHN_UNDEF || sym->st_shndx == SHN_ABS
+	      || sym->st_shndx == SHN_COMMON)
+	    continue;
+	  int type = GELF_ST_TYPE (sym->st_info);
+	  if (type == STT_SECTION || type == STT_FILE || type == STT_TLS)
 	    continue;
 
+	  const char *name = elf_strptr (ctx->elf, shdr->sh_link,
+					 sym->st_name);
+	  if (name == NULL || name[0] == '\0')
+	    continue;
 
+	  if (ctx->nsymbols == maxsyms)
+	    {
+	      maxsyms = 2 * maxsyms + 64;
+	      struct disasm_symbol *newp
+		= realloc (ctx->symbols, maxsyms * sizeof (*newp));
+	      if (newp == NULL)
+		goto out;
+	      ctx->symbols = newp;
+	    }
+
+	  struct disasm_symbol *newp = &ctx->symbols[ctx->nsymbols];
+	  newp->addr = sym->st_value;
+	  newp->size = sym->st_size;
+	  newp->shndx = (! rel ? 0
+			 : sym->st_shndx == SHN_XINDEX ? xshndx
+			 : sym->st_shndx);
+	  newp->bind = GELF_ST_BIND (sym->st_info);
+	  newp->order = ctx->nsymbols;
+	  newp->name = name;
+	  ++ctx->nsymbols;
 	}
     }
+
+ out:
+  if (ctx->nsymbols == 0)
+    return;
+
+  /* Sort the symbols and keep only the preferred one at each
+     address.  */
+  qsort (ctx->symbols, ctx->nsymbols, sizeof (ctx->symbols[0]),
+	 compare_symbols);
+  size_t n = 1;
+  for (size_t cnt = 1; cnt < ctx->nsymbols; ++cnt)
+    if (ctx->symbols[cnt].shndx != ctx->symbols[n - 1].shndx
+	|| ctx->symbols[cnt].addr != ctx->symbols[n - 1].addr)
+      ctx->symbols[n++] = ctx->symbols[cnt];
+  ctx->nsymbols = n;
 }
 
 
-static void
-read_symtab (DisasmCtx_t *ctx)
+/* Return the index of the section of a relocatable file whose data
+   contains START, or zero.  */
+static Elf32_Word
+code_section (Elf *elf, const uint8_t *start)
 {
-  /* Find the symbol table(s).  */
-  GElf_Ehdr ehdr_mem;
-  GElf_Ehdr *ehdr = gelf_getehdr (ctx->elf, &ehdr_mem);
-  if (ehdr == NULL)
-    return;
-
-  switch (ehdr->e_type)
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
     {
-    case ET_EXEC:
-    case ET_DYN:
-      read_symtab_exec (ctx);
-      break;
-
-    case ET_REL:
-      // XXX  Handle
-      break;
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL || shdr->sh_type != SHT_PROGBITS
+	  || (shdr->sh_flags & SHF_EXECINSTR) == 0)
+	continue;
 
-    default:
-      break;
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data != NULL && data->d_buf != NULL
+	  && start >= (const uint8_t *) data->d_buf
+	  && start < (const uint8_t *) data->d_buf + data->d_size)
+	return elf_ndxscn (scn);
     }
+
+  return 0;
 }
 
 
@@ -161,12 +314,19 @@ disasm_cb (DisasmCtx_t *ctx, const uint8_t **startp, const uint8_t *end,
 
   if (ctx->elf != NULL)
     {
-      /* Read all symbols of the ELF file and stuff them into a hash
-	 table.  The key is the address and the section index.  */
-      read_symtab (ctx);
+      /* Read all symbols of the ELF file once and sort them.  They are
+	 looked up by the section index and the address.  */
+      if (! ctx->symbols_read)
+	read_symtab (ctx);
+
+      GElf_Ehdr ehdr_mem;
+      GElf_Ehdr *ehdr = gelf_getehdr (ctx->elf, &ehdr_mem);
 
       symtoken.ctx = ctx;
       symtoken.symcbarg = symcbarg;
+      symtoken.shndx = 0;
+      if (ehdr != NULL && ehdr->e_type == ET_REL && ctx->nsymbols > 0)
+	symtoken.shndx = code_section (ctx->elf, *startp);
 
       symcbarg = &symtoken;
 
@@ -241,6 +241,22 @@ struct AsmScnGrp
 };
 
 
+/* Symbol of the ELF file used to name addresses in the disassembly.  */
+struct disasm_symbol
+{
+  GElf_Addr addr;
+  GElf_Xword size;
+  /* Section index for ET_REL files, where the addresses are relative
+     to the section.  Zero otherwise.  */
+  Elf32_Word shndx;
+  /* Binding, and the position in the symbol tables.  Only used to pick
+     one of several symbols at the same address.  */
+  unsigned char bind;
+  size_t order;
+  const char *name;
+};
+
+
 /* Descriptor for disassembler.   */
 struct DisasmCtx
 {
@@ -253,6 +269,12 @@ struct DisasmCtx
 
   /* Callback function to determine symbol names.  */
   DisasmGetSymCB_t symcb;
+
+  /* Defined symbols of ELF, sorted by section index and address.  Read
+     the first time disasm_cb is used.  */
+  struct disasm_symbol *symbols;
+  size_t nsymbols;
+  bool symbols_read;
 };
 
 
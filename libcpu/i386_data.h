@@ -598,6 +598,14 @@ FCT_disp8 (struct output_data *d)
   if ((size_t) needed > avail)
     return needed - avail;
   *bufcntp += needed;
+
+  /* Name the branch target if there is a symbol for it.  */
+  d->symaddr_use = addr_abs_symbolic;
+#ifdef X86_64
+  d->symaddr = d->addr + (*d->param_start - d->data) + offset;
+#else
+  d->symaddr = (uint32_t) (d->addr + (*d->param_start - d->data) + offset);
+#endif
   return 0;
 }
 
@@ -898,17 +906,22 @@ FCT_rel (struct output_data *d)
     return -1;
   int32_t rel = read_4sbyte_unaligned_inc (*d->param_start);
 #ifdef X86_64
+  GElf_Addr target = d->addr + rel + (*d->param_start - d->data);
   int needed = snprintf (&d->bufp[*bufcntp], avail, "0x%" PRIx64,
-			 (uint64_t) (d->addr + rel
-				     + (*d->param_start - d->data)));
+			 (uint64_t) target);
 #else
+  GElf_Addr target = (uint32_t) (d->addr + rel
+				 + (*d->param_start - d->data));
   int needed = snprintf (&d->bufp[*bufcntp], avail, "0x%" PRIx32,
-			 (uint32_t) (d->addr + rel
-				     + (*d->param_start - d->data)));
+			 (uint32_t) target);
 #endif
   if ((size_t) needed > avail)
     return (size_t) needed - avail;
   *bufcntp += needed;
+
+  /* Name the branch target if there is a symbol for it.  */
+  d->symaddr_use = addr_abs_symbolic;
+  d->symaddr = target;
   return 0;
 }
 
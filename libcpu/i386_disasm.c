@@ -369,9 +369,6 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
       bufcnt = 0;
       size_t cnt = 0;
 
-      const uint8_t *curr = match_data;
-      const uint8_t *const match_end = match_data + sizeof (match_data);
-
       assert (data <= end);
       if (data == end)
 	{
@@ -382,16 +379,30 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	  goto do_ret;
 	}
 
+      /* Only the instructions which can match the first opcode byte
+	 (and if there are many of them, the second) are tried.  */
+      const uint16_t *cand = &match_list[match_first[data[0]]];
+      const uint16_t *cand_end = &match_list[match_first[data[0] + 1]];
+      if (match_second_idx[data[0]] != 0 && data + 1 < end)
+	{
+	  const uint16_t *second
+	    = match_second[match_second_idx[data[0]] - 1];
+	  cand = &match_list[second[data[1]]];
+	  cand_end = &match_list[second[data[1] + 1]];
+	}
+
     next_match:
-      while (curr < match_end)
+      while (cand < cand_end)
 	{
+	  cnt = *cand++;
+	  const uint8_t *curr = &match_data[match_offset[cnt]];
 	  uint_fast8_t len = *curr++;
 	  uint_fast8_t clen = len >> 4;
 	  len &= 0xf;
-	  const uint8_t *next_curr = curr + clen + (len - clen) * 2;
 
 	  assert (len > 0);
-	  assert (curr + clen + 2 * (len - clen) <= match_end);
+	  assert (curr + clen + 2 * (len - clen)
+		  <= match_data + sizeof (match_data));
 
 	  const uint8_t *codep = data;
 	  int correct_prefix = 0;
@@ -428,8 +439,6 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 	      if (masked != *curr++)
 		{
 		not:
-		  curr = next_curr;
-		  ++cnt;
 		  bufcnt = 0;
 		  goto next_match;
 		}
@@ -481,7 +490,7 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 		 are not used uninitialized.  */
 	      asm (""
 		   : "=mr" (opoff), "=mr" (correct_prefix), "=mr" (codep),
-		     "=mr" (next_curr), "=mr" (len));
+		     "=mr" (cand), "=mr" (cand_end), "=mr" (len));
 	    }
 
 	  size_t prefix_size = 0;
@@ -622,6 +631,7 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 
 	  output_data.addr = addr + (data - begin);
 	  output_data.data = data;
+	  output_data.symaddr_use = addr_none;
 
 	  unsigned long string_end_idx = 0;
 	  fmt = save_fmt;
@@ -1064,7 +1074,6 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 		      if (output_data.symaddr_use >= addr_rel_symbolic)
 			symaddr += addr + param_start - begin;
 
-		      // XXX Lookup symbol based on symaddr
 		      const char *symstr = NULL;
 		      if (symcb != NULL
 			  && symcb (0 /* XXX */, 0 /* XXX */, symaddr,
@@ -1086,9 +1095,12 @@ i386_disasm (Ebl *ebl __attribute__((unused)),
 		      if ((size_t) r >= bufavail)
 			goto enomem;
 		      bufcnt += r;
-		      string_end_idx = bufcnt;
+		      if (r > 0)
+			string_end_idx = bufcnt;
 
 		      output_data.symaddr_use = addr_none;
+		      if (symstr != NULL)
+			output_data.labelbuf[0] = '\0';
 		    }
 		  if (deferred_start != NULL)
 		    {
@@ -1113,6 +1113,204 @@ print_op_fct (const void *nodep, VISIT value,
 # error "bogus NMNES value"
 #endif
 
+/* Copy of the match_data table as it is written out, with the offset
+   of each instruction's pattern.  Used to compute the dispatch table.  */
+static uint8_t *match_bytes;
+static size_t nmatch_bytes;
+static size_t match_bytes_max;
+static size_t *match_offsets;
+static size_t nmatch_offsets;
+static size_t match_offsets_max;
+
+static void
+record_match_byte (uint8_t byte)
+{
+  if (nmatch_bytes == match_bytes_max)
+    {
+      match_bytes_max = 2 * match_bytes_max + 1024;
+      match_bytes = xrealloc (match_bytes, match_bytes_max);
+    }
+  match_bytes[nmatch_bytes++] = byte;
+}
+
+static void
+record_match_start (void)
+{
+  if (nmatch_offsets == match_offsets_max)
+    {
+      match_offsets_max = 2 * match_offsets_max + 256;
+      match_offsets = xrealloc (match_offsets,
+				match_offsets_max * sizeof (size_t));
+    }
+  match_offsets[nmatch_offsets++] = nmatch_bytes;
+}
+
+
+/* Return true if the pattern of instruction IDX can accept BYTE as byte
+   POS of the instruction.  Bytes beyond the pattern accept anything.  */
+static bool
+pattern_accepts (size_t idx, size_t pos, uint8_t byte)
+{
+  const uint8_t *p = &match_bytes[match_offsets[idx]];
+  size_t len = p[0] & 0xf;
+  size_t clen = p[0] >> 4;
+
+  if (pos >= len)
+    return true;
+  if (pos < clen)
+    return p[1 + pos] == byte;
+
+  const uint8_t *mp = &p[1 + clen + 2 * (pos - clen)];
+  return (byte & mp[0]) == mp[1];
+}
+
+
+/* Return true if instruction IDX can be matched with its leading byte
+   taken from the preceding prefix byte.  The decoder only does this for
+   bytes it has consumed as prefixes, see known_prefixes in
+   i386_disasm.c, and for the x86-64 REX prefixes.  */
+static bool
+prefix_pattern (size_t idx)
+{
+  static const uint8_t decoder_prefixes[] =
+    {
+      0x26, 0x2e, 0x36, 0x3e, 0x64, 0x65, 0x66, 0x67, 0xf0, 0xf2, 0xf3
+    };
+  const uint8_t *p = &match_bytes[match_offsets[idx]];
+
+  if ((p[0] >> 4) == 0)
+    return false;
+  if ((p[1] & 0xf0) == 0x40)
+    return true;
+  for (size_t i = 0; i < sizeof (decoder_prefixes); ++i)
+    if (p[1] == decoder_prefixes[i])
+      return true;
+  return false;
+}
+
+
+/* Return true if instruction IDX has to be tried when the first opcode
+   byte is FIRST.  */
+static bool
+candidate_first (size_t idx, uint8_t first)
+{
+  return (pattern_accepts (idx, 0, first)
+	  || (prefix_pattern (idx) && pattern_accepts (idx, 1, first)));
+}
+
+
+/* Likewise, for the first two opcode bytes FIRST and SECOND.  */
+static bool
+candidate_second (size_t idx, uint8_t first, uint8_t second)
+{
+  return ((pattern_accepts (idx, 0, first)
+	   && pattern_accepts (idx, 1, second))
+	  || (prefix_pattern (idx) && pattern_accepts (idx, 1, first)
+	      && pattern_accepts (idx, 2, second)));
+}
+
+
+/* Lists with more candidates than this are split again by the second
+   opcode byte.  */
+#define MAX_FIRST_CANDIDATES 16
+
+/* Write out the tables which let the decoder try only the instructions
+   which can match the first (and for crowded first bytes, the second)
+   opcode byte, in the same order the linear search would.  */
+static void
+dispatch_out (void)
+{
+  size_t nlist = 0;
+  uint16_t *list = NULL;
+  size_t list_max = 0;
+  size_t first_start[257];
+  size_t nsecond = 0;
+  size_t second_idx[256];
+  size_t (*second_start)[257] = xmalloc (256 * sizeof (*second_start));
+
+#define ADD_CANDIDATE(idx) \
+  do {									      \
+    if (nlist == list_max)						      \
+      {									      \
+	list_max = 2 * list_max + 1024;					      \
+	list = xrealloc (list, list_max * sizeof (uint16_t));		      \
+      }									      \
+    list[nlist++] = (idx);						      \
+  } while (0)
+
+  assert (nmatch_offsets <= UINT16_MAX);
+
+  for (unsigned int first = 0; first < 256; ++first)
+    {
+      first_start[first] = nlist;
+      for (size_t idx = 0; idx < nmatch_offsets; ++idx)
+	if (candidate_first (idx, first))
+	  ADD_CANDIDATE (idx);
+    }
+  first_start[256] = nlist;
+
+  for (unsigned int first = 0; first < 256; ++first)
+    {
+      second_idx[first] = 0;
+      if (first_start[first + 1] - first_start[first] <= MAX_FIRST_CANDIDATES)
+	continue;
+
+      size_t *start = second_start[nsecond++];
+      second_idx[first] = nsecond;
+      for (unsigned int second = 0; second < 256; ++second)
+	{
+	  start[second] = nlist;
+	  for (size_t i = first_start[first]; i < first_start[first + 1]; ++i)
+	    if (candidate_second (list[i], first, second))
+	      ADD_CANDIDATE (list[i]);
+	}
+      start[256] = nlist;
+    }
+#undef ADD_CANDIDATE
+
+  assert (nlist <= UINT16_MAX);
+  assert (nmatch_bytes <= UINT16_MAX);
+  assert (nsecond <= UINT8_MAX);
+
+  fputs ("static const uint16_t match_offset[] =\n{", outfile);
+  for (size_t idx = 0; idx < nmatch_offsets; ++idx)
+    fprintf (outfile, "%s %zu,", idx % 12 == 0 ? "\n " : "",
+	     match_offsets[idx]);
+  fputs ("\n};\n", outfile);
+
+  fputs ("static const uint16_t match_list[] =\n{", outfile);
+  for (size_t i = 0; i < nlist; ++i)
+    fprintf (outfile, "%s %" PRIu16 ",", i % 12 == 0 ? "\n " : "", list[i]);
+  fputs ("\n};\n", outfile);
+
+  fputs ("static const uint16_t match_first[257] =\n{", outfile);
+  for (size_t i = 0; i < 257; ++i)
+    fprintf (outfile, "%s %zu,", i % 12 == 0 ? "\n " : "", first_start[i]);
+  fputs ("\n};\n", outfile);
+
+  fputs ("static const uint8_t match_second_idx[256] =\n{", outfile);
+  for (size_t i = 0; i < 256; ++i)
+    fprintf (outfile, "%s %zu,", i % 16 == 0 ? "\n " : "", second_idx[i]);
+  fputs ("\n};\n", outfile);
+
+  fprintf (outfile, "static const uint16_t match_second[%zu][257] =\n{\n",
+	   nsecond == 0 ? 1 : nsecond);
+  for (size_t n = 0; n < nsecond; ++n)
+    {
+      fputs ("  {", outfile);
+      for (size_t i = 0; i < 257; ++i)
+	fprintf (outfile, "%s %zu,", i % 12 == 0 ? "\n   " : "",
+		 second_start[n][i]);
+      fputs ("\n  },\n", outfile);
+    }
+  if (nsecond == 0)
+    fputs ("  { 0 }\n", outfile);
+  fputs ("};\n", outfile);
+
+  free (second_start);
+  free (list);
+}
+
 static void
 instrtable_out (void)
 {
@@ -1280,6 +1478,8 @@ instrtable_out (void)
       assert (nbytes > 0);
       size_t leadingbytes = leadingbits / 8;
 
+      record_match_start ();
+      record_match_byte (nbytes | (leadingbytes << 4));
       fprintf (outfile, "  %#zx,", nbytes | (leadingbytes << 4));
 
       /* Now create the mask and byte values.  */
@@ -1299,11 +1499,16 @@ instrtable_out (void)
 		    {
 		      assert (mask == 0xff);
 		      fprintf (outfile, " %#" PRIx8 ",", byte);
+		      record_match_byte (byte);
 		      --leadingbytes;
 		    }
 		  else
-		    fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",",
-			     mask, byte);
+		    {
+		      fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",",
+			       mask, byte);
+		      record_match_byte (mask);
+		      record_match_byte (byte);
+		    }
 		  byte = mask = nbits = 0;
 		  if (--nbytes == 0)
 		    break;
@@ -1318,6 +1523,8 @@ instrtable_out (void)
 		{
 		  fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",",
 			   mask << (8 - nbits), byte << (8 - nbits));
+		  record_match_byte (mask << (8 - nbits));
+		  record_match_byte (byte << (8 - nbits));
 		  remaining = nbits + remaining - 8;
 		  byte = mask = nbits = 0;
 		  if (--nbytes == 0)
@@ -1329,6 +1536,8 @@ instrtable_out (void)
 	      if (nbits == 8)
 		{
 		  fprintf (outfile, " %#" PRIx8 ", %#" PRIx8 ",", mask, byte);
+		  record_match_byte (mask);
+		  record_match_byte (byte);
 		  byte = mask = nbits = 0;
 		  if (--nbytes == 0)
 		    break;
@@ -1340,6 +1549,8 @@ instrtable_out (void)
       fputc_unlocked ('\n', outfile);
     }
   fputs ("};\n", outfile);
+
+  dispatch_out ();
 }
 
 
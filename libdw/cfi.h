@@ -92,9 +92,17 @@ struct Dwarf_CFI_s
   /* Search tree for the CIEs, indexed by CIE_pointer (section offset).  */
   void *cie_tree;
 
-  /* Search tree for the FDEs, indexed by PC address.  */
+  /* Search tree for the FDEs read through the binary search table,
+     indexed by PC address.  */
   void *fde_tree;
 
+  /* Without a binary search table, all FDEs sorted by PC address.
+     FDES_INVALID is set if there was a bad FDE whose range is unknown.  */
+  struct dwarf_fde *fdes;
+  size_t nfdes;
+  bool fdes_read;
+  bool fdes_invalid;
+
   /* Search tree for parsed DWARF expressions, indexed by raw pointer.  */
   void *expr_tree;
 
@@ -60,7 +60,8 @@ static const char dwarf_scnnames[IDX_last][18] =
   [IDX_debug_macinfo] = ".debug_macinfo",
   [IDX_debug_macro] = ".debug_macro",
   [IDX_debug_ranges] = ".debug_ranges",
-  [IDX_gnu_debugaltlink] = ".gnu_debugaltlink"
+  [IDX_gnu_debugaltlink] = ".gnu_debugaltlink",
+  [IDX_gdb_index] = ".gdb_index"
 };
 #define ndwarf_scnnames (sizeof (dwarf_scnnames) / sizeof (dwarf_scnnames[0]))
 
@@ -308,8 +309,13 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
   size_t mem_default_size = sysconf (_SC_PAGESIZE) - 4 * sizeof (void *);
   assert (sizeof (struct Dwarf) < mem_default_size);
 
-  /* Allocate the data structure.  */
+  /* Allocate the data structure.  Without locking the first memory
+     block comes with it, otherwise each thread allocates its own.  */
+#ifdef USE_LOCKS
+  Dwarf *result = (Dwarf *) calloc (1, sizeof (Dwarf));
+#else
   Dwarf *result = (Dwarf *) calloc (1, sizeof (Dwarf) + mem_default_size);
+#endif
   if (unlikely (result == NULL)
       || unlikely (Dwarf_Sig8_Hash_init (&result->sig8_hash, 11) < 0))
     {
@@ -318,6 +324,10 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
       return NULL;
     }
 
+  rwlock_init (result->cu_lock);
+  rwlock_init (result->abbrev_lock);
+  rwlock_init (result->lock);
+
   /* Fill in some values.  */
   if ((BYTE_ORDER == LITTLE_ENDIAN && ehdr->e_ident[EI_DATA] == ELFDATA2MSB)
       || (BYTE_ORDER == BIG_ENDIAN && ehdr->e_ident[EI_DATA] == ELFDATA2LSB))
@@ -328,11 +338,15 @@ dwarf_begin_elf (Elf *elf, Dwarf_Cmd cmd, Elf_Scn *scngrp)
   /* Initialize the memory handling.  */
   result->mem_default_size = mem_default_size;
   result->oom_handler = __libdw_oom;
+#ifdef USE_LOCKS
+  __libdw_alloc_init (result);
+#else
   result->mem_tail = (struct libdw_memblock *) (result + 1);
   result->mem_tail->size = (result->mem_default_size
 			    - offsetof (struct libdw_memblock, mem));
   result->mem_tail->remaining = result->mem_tail->size;
   result->mem_tail->prev = NULL;
+#endif
 
   if (cmd == DWARF_C_READ || cmd == DWARF_C_RDWR)
     {
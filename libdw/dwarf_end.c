@@ -57,6 +57,17 @@ cu_free (void *arg)
 }
 
 
+static void
+unit_index_free (struct libdw_unit_index *index)
+{
+  for (size_t cnt = 0; cnt < index->nunits; ++cnt)
+    cu_free (index->units[cnt]);
+
+  free (index->starts);
+  free (index->units);
+}
+
+
 int
 dwarf_end (Dwarf *dwarf)
 {
@@ -68,11 +79,11 @@ dwarf_end (Dwarf *dwarf)
 
       Dwarf_Sig8_Hash_free (&dwarf->sig8_hash);
 
-      /* The search tree for the CUs.  NB: the CU data itself is
-	 allocated separately, but the abbreviation hash tables need
-	 to be handled.  */
-      tdestroy (dwarf->cu_tree, cu_free);
-      tdestroy (dwarf->tu_tree, cu_free);
+      /* The indexes of the CUs.  NB: the CU data itself is allocated
+	 separately, but the abbreviation hash tables need to be
+	 handled.  */
+      unit_index_free (&dwarf->cu_index);
+      unit_index_free (&dwarf->tu_index);
 
       /* Search tree for macro opcode tables.  */
       tdestroy (dwarf->macro_ops, noop_free);
@@ -80,6 +91,26 @@ dwarf_end (Dwarf *dwarf)
       /* Search tree for decoded .debug_lines units.  */
       tdestroy (dwarf->files_lines, noop_free);
 
+      /* Name index of dwarf_lookup_name.  */
+      __libdw_name_index_free (dwarf->name_index);
+
+#ifdef USE_LOCKS
+      /* Every thread allocated its own blocks.  */
+      for (size_t i = 0; i < dwarf->mem_stacks; ++i)
+	if (dwarf->mem_tails[i] != NULL)
+	  {
+	    struct libdw_memblock *memp = *dwarf->mem_tails[i];
+	    while (memp != NULL)
+	      {
+		struct libdw_memblock *prevp = memp->prev;
+		free (memp);
+		memp = prevp;
+	      }
+	    free (dwarf->mem_tails[i]);
+	  }
+      free (dwarf->mem_tails);
+      rwlock_fini (dwarf->mem_rwl);
+#else
       struct libdw_memblock *memp = dwarf->mem_tail;
       /* The first block is allocated together with the Dwarf object.  */
       while (memp->prev != NULL)
@@ -88,6 +119,7 @@ dwarf_end (Dwarf *dwarf)
 	  free (memp);
 	  memp = prevp;
 	}
+#endif
 
       /* Free the pubnames helper structure.  */
       free (dwarf->pubnames_sets);
@@ -103,6 +135,10 @@ dwarf_end (Dwarf *dwarf)
 	  free (dwarf->fake_loc_cu);
 	}
 
+      rwlock_fini (dwarf->cu_lock);
+      rwlock_fini (dwarf->abbrev_lock);
+      rwlock_fini (dwarf->lock);
+
       /* Free the context descriptor.  */
       free (dwarf);
     }
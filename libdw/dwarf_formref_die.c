@@ -76,20 +76,29 @@ dwarf_formref_die (Dwarf_Attribute *attr, Dwarf_Die *result)
 	 have to match in the .debug_types type unit headers.  */
 
       uint64_t sig = read_8ubyte_unaligned (cu->dbg, attr->valp);
-      cu = Dwarf_Sig8_Hash_find (&cu->dbg->sig8_hash, sig, NULL);
+      Dwarf *dbg = cu->dbg;
+      rwlock_rdlock (dbg->cu_lock);
+      cu = Dwarf_Sig8_Hash_find (&dbg->sig8_hash, sig, NULL);
+      rwlock_unlock (dbg->cu_lock);
       if (cu == NULL)
-	/* Not seen before.  We have to scan through the type units.  */
-	do
-	  {
-	    cu = __libdw_intern_next_unit (attr->cu->dbg, true);
-	    if (cu == NULL)
-	      {
-		__libdw_seterrno (INTUSE(dwarf_errno) ()
-				  ?: DWARF_E_INVALID_REFERENCE);
-		return NULL;
-	      }
-	  }
-	while (cu->type_sig8 != sig);
+	{
+	  /* Not seen before.  We have to scan through the type units.
+	     Another thread might have done that in the meantime.  */
+	  rwlock_wrlock (dbg->cu_lock);
+	  cu = Dwarf_Sig8_Hash_find (&dbg->sig8_hash, sig, NULL);
+	  while (cu == NULL || cu->type_sig8 != sig)
+	    {
+	      cu = __libdw_intern_next_unit (dbg, true);
+	      if (cu == NULL)
+		{
+		  rwlock_unlock (dbg->cu_lock);
+		  __libdw_seterrno (INTUSE(dwarf_errno) ()
+				    ?: DWARF_E_INVALID_REFERENCE);
+		  return NULL;
+		}
+	    }
+	  rwlock_unlock (dbg->cu_lock);
+	}
 
       datap = cu->dbg->sectiondata[IDX_debug_types]->d_buf;
       size = cu->dbg->sectiondata[IDX_debug_types]->d_size;
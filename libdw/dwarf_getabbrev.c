@@ -152,7 +152,11 @@ __libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu, Dwarf_Off offset,
 Dwarf_Abbrev *
 dwarf_getabbrev (Dwarf_Die *die, Dwarf_Off offset, size_t *lengthp)
 {
-  return __libdw_getabbrev (die->cu->dbg, die->cu,
-			    die->cu->orig_abbrev_offset + offset, lengthp,
-			    NULL);
+  Dwarf *dbg = die->cu->dbg;
+  rwlock_wrlock (dbg->abbrev_lock);
+  Dwarf_Abbrev *result = __libdw_getabbrev (dbg, die->cu,
+					    die->cu->orig_abbrev_offset
+					    + offset, lengthp, NULL);
+  rwlock_unlock (dbg->abbrev_lock);
+  return result;
 }
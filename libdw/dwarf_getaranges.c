@@ -53,12 +53,11 @@ compare_aranges (const void *a, const void *b)
   return 0;
 }
 
-int
-dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
+/* Read .debug_aranges into DBG->aranges.  Called with DBG's lock held
+   for writing.  */
+static int
+read_aranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
 {
-  if (dbg == NULL)
-    return -1;
-
   if (dbg->aranges != NULL)
     {
       *aranges = dbg->aranges;
@@ -271,4 +270,28 @@ dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
 
   return 0;
 }
+
+int
+dwarf_getaranges (Dwarf *dbg, Dwarf_Aranges **aranges, size_t *naranges)
+{
+  if (dbg == NULL)
+    return -1;
+
+  rwlock_rdlock (dbg->lock);
+  if (dbg->aranges != NULL)
+    {
+      *aranges = dbg->aranges;
+      if (naranges != NULL)
+	*naranges = dbg->aranges->naranges;
+      rwlock_unlock (dbg->lock);
+      return 0;
+    }
+  rwlock_unlock (dbg->lock);
+
+  rwlock_wrlock (dbg->lock);
+  int result = read_aranges (dbg, aranges, naranges);
+  rwlock_unlock (dbg->lock);
+
+  return result;
+}
 INTDEF(dwarf_getaranges)
@@ -40,6 +40,13 @@ dwarf_getcfi (Dwarf *dbg)
   if (dbg == NULL)
     return NULL;
 
+  rwlock_rdlock (dbg->lock);
+  Dwarf_CFI *result = dbg->cfi;
+  rwlock_unlock (dbg->lock);
+  if (result != NULL)
+    return result;
+
+  rwlock_wrlock (dbg->lock);
   if (dbg->cfi == NULL && dbg->sectiondata[IDX_debug_frame] != NULL)
     {
       Dwarf_CFI *cfi = libdw_typed_alloc (dbg, Dwarf_CFI);
@@ -61,12 +68,18 @@ dwarf_getcfi (Dwarf *dbg)
 
       cfi->next_offset = 0;
       cfi->cie_tree = cfi->fde_tree = cfi->expr_tree = NULL;
+      cfi->fdes = NULL;
+      cfi->nfdes = 0;
+      cfi->fdes_read = false;
+      cfi->fdes_invalid = false;
 
       cfi->ebl = NULL;
 
       dbg->cfi = cfi;
     }
+  result = dbg->cfi;
+  rwlock_unlock (dbg->lock);
 
-  return dbg->cfi;
+  return result;
 }
 INTDEF (dwarf_getcfi)
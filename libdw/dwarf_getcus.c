@@ -0,0 +1,168 @@
+/* Call a function for every CU, from several threads.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <system.h>
+#include "libdwP.h"
+
+
+struct getcus_state
+{
+  int (*callback) (Dwarf_Die *, unsigned int, void *);
+  void *arg;
+
+  /* Snapshot of the CUs, handed out in order.  */
+  struct Dwarf_CU **units;
+  size_t nunits;
+  size_t next;
+
+  /* Set when a callback returned DWARF_CB_ABORT.  */
+  bool aborted;
+};
+
+struct getcus_worker
+{
+  struct getcus_state *state;
+  unsigned int worker;
+};
+
+static void *
+getcus_worker (void *arg)
+{
+  struct getcus_worker *w = arg;
+  struct getcus_state *state = w->state;
+
+  /* Take one CU at a time, CU sizes vary too much to split the list
+     up front.  */
+  while (! __atomic_load_n (&state->aborted, __ATOMIC_RELAXED))
+    {
+      size_t idx = __atomic_fetch_add (&state->next, 1, __ATOMIC_RELAXED);
+      if (idx >= state->nunits)
+	break;
+
+      Dwarf_Die cudie = CUDIE (state->units[idx]);
+      if (state->callback (&cudie, w->worker, state->arg) != DWARF_CB_OK)
+	__atomic_store_n (&state->aborted, true, __ATOMIC_RELAXED);
+    }
+
+  return NULL;
+}
+
+int
+dwarf_getcus (Dwarf *dbg, int (*callback) (Dwarf_Die *, unsigned int, void *),
+	      void *arg, unsigned int nthreads)
+{
+  if (dbg == NULL)
+    return -1;
+
+  /* Find all CU headers first, so the workers only ever look at units
+     that already exist.  The units that could be read are still
+     handled when some could not, the error is reported afterwards.  */
+  int error = DWARF_E_NOERROR;
+  if (INTUSE(dwarf_index_units) (dbg) != 0)
+    error = INTUSE(dwarf_errno) () ?: DWARF_E_INVALID_DWARF;
+
+  struct getcus_state state =
+    {
+      .callback = callback,
+      .arg = arg,
+      .next = 0,
+      .aborted = false
+    };
+
+  rwlock_rdlock (dbg->cu_lock);
+  state.nunits = dbg->cu_index.nunits;
+  state.units = malloc (state.nunits * sizeof state.units[0] ?: 1);
+  if (state.units != NULL)
+    memcpy (state.units, dbg->cu_index.units,
+	    state.nunits * sizeof state.units[0]);
+  rwlock_unlock (dbg->cu_lock);
+  if (state.units == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+
+#ifdef USE_LOCKS
+  if (nthreads == 0)
+    {
+      long int ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+      nthreads = ncpus > 0 ? ncpus : 1;
+    }
+  if (nthreads > state.nunits)
+    nthreads = MAX (state.nunits, 1);
+
+  /* The calling thread is worker 0.  If we cannot start as many
+     threads as requested, the ones we have do all the work.  */
+  struct getcus_worker *workers = malloc (nthreads * sizeof workers[0]);
+  pthread_t *threads = malloc (nthreads * sizeof threads[0]);
+  if (workers == NULL || threads == NULL)
+    nthreads = 1;
+  struct getcus_worker self = { .state = &state, .worker = 0 };
+  unsigned int started = 1;
+  while (started < nthreads)
+    {
+      workers[started].state = &state;
+      workers[started].worker = started;
+      if (pthread_create (&threads[started], NULL, getcus_worker,
+			  &workers[started]) != 0)
+	break;
+      ++started;
+    }
+
+  getcus_worker (&self);
+
+  for (unsigned int cnt = 1; cnt < started; ++cnt)
+    pthread_join (threads[cnt], NULL);
+
+  free (workers);
+  free (threads);
+#else
+  /* Without locking a Dwarf cannot be shared between threads, so all
+     CUs are handled by the calling thread.  */
+  (void) nthreads;
+  struct getcus_worker worker = { .state = &state, .worker = 0 };
+  getcus_worker (&worker);
+#endif
+
+  free (state.units);
+
+  if (state.aborted)
+    return 1;
+  if (error != DWARF_E_NOERROR)
+    {
+      __libdw_seterrno (error);
+      return -1;
+    }
+  return 0;
+}
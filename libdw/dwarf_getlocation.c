@@ -120,7 +120,9 @@ dwarf_getlocation_implicit_value (Dwarf_Attribute *attr, const Dwarf_Op *op,
     return -1;
 
   struct loc_block_s fake = { .addr = (void *) op };
+  rwlock_rdlock (attr->cu->dbg->lock);
   struct loc_block_s **found = tfind (&fake, &attr->cu->locs, loc_compare);
+  rwlock_unlock (attr->cu->dbg->lock);
   if (unlikely (found == NULL))
     {
       __libdw_seterrno (DWARF_E_NO_BLOCK);
@@ -158,7 +160,10 @@ check_constant_offset (Dwarf_Attribute *attr,
 
   /* Check whether we already cached this location.  */
   struct loc_s fake = { .addr = attr->valp };
+  Dwarf *dbg = attr->cu->dbg;
+  rwlock_rdlock (dbg->lock);
   struct loc_s **found = tfind (&fake, &attr->cu->locs, loc_compare);
+  rwlock_unlock (dbg->lock);
 
   if (found == NULL)
     {
@@ -166,23 +171,28 @@ check_constant_offset (Dwarf_Attribute *attr,
       if (INTUSE(dwarf_formudata) (attr, &offset) != 0)
 	return -1;
 
-      Dwarf_Op *result = libdw_alloc (attr->cu->dbg,
-				      Dwarf_Op, sizeof (Dwarf_Op), 1);
-
-      result->atom = DW_OP_plus_uconst;
-      result->number = offset;
-      result->number2 = 0;
-      result->offset = 0;
-
-      /* Insert a record in the search tree so we can find it again later.  */
-      struct loc_s *newp = libdw_alloc (attr->cu->dbg,
-					struct loc_s, sizeof (struct loc_s),
-					1);
-      newp->addr = attr->valp;
-      newp->loc = result;
-      newp->nloc = 1;
-
-      found = tsearch (newp, &attr->cu->locs, loc_compare);
+      rwlock_wrlock (dbg->lock);
+      found = tfind (&fake, &attr->cu->locs, loc_compare);
+      if (found == NULL)
+	{
+	  Dwarf_Op *result = libdw_alloc (dbg, Dwarf_Op, sizeof (Dwarf_Op), 1);
+
+	  result->atom = DW_OP_plus_uconst;
+	  result->number = offset;
+	  result->number2 = 0;
+	  result->offset = 0;
+
+	  /* Insert a record in the search tree so we can find it again
+	     later.  */
+	  struct loc_s *newp = libdw_alloc (dbg, struct loc_s,
+					    sizeof (struct loc_s), 1);
+	  newp->addr = attr->valp;
+	  newp->loc = result;
+	  newp->nloc = 1;
+
+	  found = tsearch (newp, &attr->cu->locs, loc_compare);
+	}
+      rwlock_unlock (dbg->lock);
     }
 
   assert ((*found)->nloc == 1);
@@ -597,13 +607,18 @@ getlocation (struct Dwarf_CU *cu, const Dwarf_Block *block,
       return 0;
     }
 
-  return __libdw_intern_expression (cu->dbg, cu->dbg->other_byte_order,
-				    cu->address_size, (cu->version == 2
-						       ? cu->address_size
-						       : cu->offset_size),
-				    &cu->locs, block,
-				    false, false,
-				    llbuf, listlen, sec_index);
+  rwlock_wrlock (cu->dbg->lock);
+  int result = __libdw_intern_expression (cu->dbg, cu->dbg->other_byte_order,
+					  cu->address_size,
+					  (cu->version == 2
+					   ? cu->address_size
+					   : cu->offset_size),
+					  &cu->locs, block,
+					  false, false,
+					  llbuf, listlen, sec_index);
+  rwlock_unlock (cu->dbg->lock);
+
+  return result;
 }
 
 int
@@ -271,8 +271,10 @@ cache_op_table (Dwarf *dbg, int sec_index, Dwarf_Off macoff,
 		Dwarf_Die *cudie)
 {
   Dwarf_Macro_Op_Table fake = { .offset = macoff, .sec_index = sec_index };
+  rwlock_rdlock (dbg->lock);
   Dwarf_Macro_Op_Table **found = tfind (&fake, &dbg->macro_ops,
 					macro_op_compare);
+  rwlock_unlock (dbg->lock);
   if (found != NULL)
     return *found;
 
@@ -283,8 +285,12 @@ cache_op_table (Dwarf *dbg, int sec_index, Dwarf_Off macoff,
   if (table == NULL)
     return NULL;
 
+  /* Another thread may have built the same table meanwhile, tsearch
+     then returns that one and ours is simply left unused.  */
+  rwlock_wrlock (dbg->lock);
   Dwarf_Macro_Op_Table **ret = tsearch (table, &dbg->macro_ops,
 					macro_op_compare);
+  rwlock_unlock (dbg->lock);
   if (unlikely (ret == NULL))
     {
       __libdw_seterrno (DWARF_E_NOMEM);
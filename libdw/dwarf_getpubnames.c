@@ -161,8 +161,17 @@ dwarf_getpubnames (Dwarf *dbg,
     return 0;
 
   /* If necessary read the set information.  */
-  if (dbg->pubnames_nsets == 0 && unlikely (get_offsets (dbg) != 0))
-    return -1l;
+  rwlock_rdlock (dbg->lock);
+  size_t nsets = dbg->pubnames_nsets;
+  rwlock_unlock (dbg->lock);
+  if (nsets == 0)
+    {
+      rwlock_wrlock (dbg->lock);
+      int res = dbg->pubnames_nsets == 0 ? get_offsets (dbg) : 0;
+      rwlock_unlock (dbg->lock);
+      if (unlikely (res != 0))
+	return -1l;
+    }
 
   /* Find the place where to start.  */
   size_t cnt;
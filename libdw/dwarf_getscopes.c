@@ -180,12 +180,89 @@ pc_record (unsigned int depth, struct Dwarf_Die_Chain *die, void *arg)
 }
 
 
+/* Find the scopes like the traversals above, in the scope index of the
+   CU.  */
+static int
+indexed_scopes (struct libdw_scope_index *index, Dwarf_Addr pc,
+		Dwarf_Die **scopes)
+{
+  unsigned int innermost = __libdw_scope_find_pc (index, pc);
+  if (innermost == 0)
+    return 0;
+
+  /* Find the innermost concrete inlined instance.  */
+  unsigned int inlined = innermost;
+  while (inlined != 0
+	 && INTUSE (dwarf_tag) (&index->nodes[inlined].die)
+	    != DW_TAG_inlined_subroutine)
+    inlined = index->nodes[inlined].parent;
+
+  unsigned int depth = index->nodes[innermost].depth;
+  if (inlined == 0)
+    {
+      *scopes = malloc ((depth + 1) * sizeof (*scopes)[0]);
+      if (*scopes == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      __libdw_scope_chain (index, innermost, *scopes);
+      return depth + 1;
+    }
+
+  Dwarf_Attribute attr_mem;
+  Dwarf_Attribute *attr = INTUSE (dwarf_attr) (&index->nodes[inlined].die,
+					       DW_AT_abstract_origin,
+					       &attr_mem);
+  Dwarf_Die origin_die;
+  if (INTUSE (dwarf_formref_die) (attr, &origin_die) == NULL)
+    return -1;
+
+  /* Search the scopes containing the inlined instance for its abstract
+     definition, innermost first.  */
+  unsigned int origin = 0;
+  unsigned int scope = inlined;
+  while (origin == 0 && scope != 0)
+    {
+      scope = index->nodes[scope].parent;
+      origin = __libdw_scope_find_die (index, &origin_die, scope);
+    }
+  if (origin == 0)
+    return 0;
+
+  unsigned int ninlined = depth + 1 - index->nodes[inlined].depth;
+  unsigned int nscopes = ninlined + index->nodes[origin].depth;
+  *scopes = malloc (nscopes * sizeof (*scopes)[0]);
+  if (*scopes == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return -1;
+    }
+
+  unsigned int node = innermost;
+  for (unsigned int i = 0; i < ninlined; ++i)
+    {
+      (*scopes)[i] = index->nodes[node].die;
+      node = index->nodes[node].parent;
+    }
+  __libdw_scope_chain (index, index->nodes[origin].parent,
+		       &(*scopes)[ninlined]);
+  return nscopes;
+}
+
 int
 dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
 {
   if (cudie == NULL)
     return -1;
 
+  if (is_cudie (cudie))
+    {
+      struct libdw_scope_index *index = __libdw_scope_index (cudie->cu);
+      if (index != NULL)
+	return indexed_scopes (index, pc, scopes);
+    }
+
   struct Dwarf_Die_Chain cu = { .parent = NULL, .die = *cudie };
   struct args a = { .pc = pc };
 
@@ -199,3 +276,4 @@ dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
 
   return result;
 }
+INTDEF (dwarf_getscopes)
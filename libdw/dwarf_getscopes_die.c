@@ -65,6 +65,25 @@ dwarf_getscopes_die (Dwarf_Die *die, Dwarf_Die **scopes)
   if (die == NULL)
     return -1;
 
+  /* The index has the scopes of every DIE the traversal can find.  */
+  struct libdw_scope_index *index = __libdw_scope_index (die->cu);
+  if (index != NULL)
+    {
+      unsigned int node = __libdw_scope_find_die (index, die, 0);
+      if (node == 0)
+	return 0;
+
+      unsigned int nscopes = index->nodes[node].depth + 1;
+      *scopes = malloc (nscopes * sizeof (*scopes)[0]);
+      if (*scopes == NULL)
+	{
+	  __libdw_seterrno (DWARF_E_NOMEM);
+	  return -1;
+	}
+      __libdw_scope_chain (index, node, *scopes);
+      return nscopes;
+    }
+
   struct Dwarf_Die_Chain cu = { .die = CUDIE (die->cu), .parent = NULL };
   void *info = die->addr;
   int result = __libdw_visit_scopes (1, &cu, NULL, &scope_visitor, NULL, &info);
@@ -72,3 +91,4 @@ dwarf_getscopes_die (Dwarf_Die *die, Dwarf_Die **scopes)
     *scopes = info;
   return result;
 }
+INTDEF (dwarf_getscopes_die)
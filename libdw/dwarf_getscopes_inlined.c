@@ -0,0 +1,72 @@
+/* Return the scope DIEs containing PC, with all inlined instances.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+#include "libdwP.h"
+#include <stdlib.h>
+
+
+int
+dwarf_getscopes_inlined (Dwarf_Die *cudie, Dwarf_Addr pc, Dwarf_Die **scopes)
+{
+  if (cudie == NULL)
+    return -1;
+
+  if (is_cudie (cudie))
+    {
+      struct libdw_scope_index *index = __libdw_scope_index (cudie->cu);
+      if (index != NULL)
+	{
+	  unsigned int node = __libdw_scope_find_pc (index, pc);
+	  if (node == 0)
+	    return 0;
+
+	  unsigned int nscopes = index->nodes[node].depth + 1;
+	  *scopes = malloc (nscopes * sizeof (*scopes)[0]);
+	  if (*scopes == NULL)
+	    {
+	      __libdw_seterrno (DWARF_E_NOMEM);
+	      return -1;
+	    }
+	  __libdw_scope_chain (index, node, *scopes);
+	  return nscopes;
+	}
+    }
+
+  /* The innermost scope is the same, its containing scopes are the
+     ones we want.  */
+  Dwarf_Die *pc_scopes;
+  int nscopes = INTUSE(dwarf_getscopes) (cudie, pc, &pc_scopes);
+  if (nscopes <= 0)
+    return nscopes;
+
+  Dwarf_Die innermost = pc_scopes[0];
+  free (pc_scopes);
+  return INTUSE(dwarf_getscopes_die) (&innermost, scopes);
+}
@@ -45,28 +45,18 @@ dwarf_getsrc_die (Dwarf_Die *cudie, Dwarf_Addr addr)
     return NULL;
 
   /* The lines are sorted by address, so we can use binary search.  */
-  if (nlines > 0)
+  size_t l = __libdw_lines_upper_bound (lines, 0, nlines, addr);
+  if (l > 0)
     {
-      size_t l = 0, u = nlines - 1;
-      while (l < u)
-	{
-	  size_t idx = u - (u - l) / 2;
-	  Dwarf_Line *line = &lines->info[idx];
-	  if (addr < line->addr)
-	    u = idx - 1;
-	  else
-	    l = idx;
-	}
-
       /* This is guaranteed for us by libdw read_srclines.  */
       assert (lines->info[nlines - 1].end_sequence);
 
       /* The last line which is less than or equal to addr is what we
 	 want, unless it is the end_sequence which is after the
 	 current line sequence.  */
-      Dwarf_Line *line = &lines->info[l];
-      if (! line->end_sequence && line->addr <= addr)
-	return &lines->info[l];
+      Dwarf_Line *line = &lines->info[l - 1];
+      if (! line->end_sequence)
+	return line;
     }
 
   __libdw_seterrno (DWARF_E_ADDR_OUTOFRANGE);
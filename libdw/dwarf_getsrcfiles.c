@@ -39,41 +39,15 @@
 int
 dwarf_getsrcfiles (Dwarf_Die *cudie, Dwarf_Files **files, size_t *nfiles)
 {
-  if (cudie == NULL)
+  /* Let the more generic function do the work.  It'll create more
+     data but that will be needed in an real program anyway.  */
+  if (__libdw_getcu_srclines (cudie, NULL, files) != 0)
     return -1;
-  if (! is_cudie (cudie))
-    {
-      __libdw_seterrno (DWARF_E_NOT_CUDIE);
-      return -1;
-    }
 
-  int res = -1;
+  assert (*files != NULL && *files != (void *) -1l);
+  if (nfiles != NULL)
+    *nfiles = (*files)->nfiles;
 
-  /* Get the information if it is not already known.  */
-  struct Dwarf_CU *const cu = cudie->cu;
-  if (cu->lines == NULL)
-    {
-      Dwarf_Lines *lines;
-      size_t nlines;
-
-      /* Let the more generic function do the work.  It'll create more
-	 data but that will be needed in an real program anyway.  */
-      res = INTUSE(dwarf_getsrclines) (cudie, &lines, &nlines);
-    }
-  else if (cu->files != (void *) -1l)
-    /* We already have the information.  */
-    res = 0;
-
-  if (likely (res == 0))
-    {
-      assert (cu->files != NULL && cu->files != (void *) -1l);
-      *files = cu->files;
-      if (nfiles != NULL)
-	*nfiles = cu->files->nfiles;
-    }
-
-  // XXX Eventually: unlocking here.
-
-  return res;
+  return 0;
 }
 INTDEF (dwarf_getsrcfiles)
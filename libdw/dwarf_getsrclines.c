@@ -78,6 +78,87 @@ compare_lines (const void *a, const void *b)
     : 0;
 }
 
+/* A sequence of lines, sorted by address as it ends with
+   DW_LNE_end_sequence.  */
+struct sequence
+{
+  struct linelist **first;
+  size_t n;
+};
+
+static int
+compare_sequences (const void *a, const void *b)
+{
+  const struct sequence *seq1 = a;
+  const struct sequence *seq2 = b;
+  return compare_lines (seq1->first, seq2->first);
+}
+
+/* Sort the N lines in SORTLINES like qsort with compare_lines.  The
+   addresses only grow in each sequence of lines, so usually sorting
+   the sequences by their first line is enough.  Then the lines are
+   only copied instead of sorted one by one.  */
+static void
+sort_lines (struct linelist **sortlines, size_t n)
+{
+  /* Check if the lines are sorted already, and count the sequences.  */
+  size_t nseq = n > 0;
+  bool sorted = true;
+  for (size_t i = 1; i < n; ++i)
+    if (compare_lines (&sortlines[i - 1], &sortlines[i]) > 0)
+      {
+	/* Not sorted in its sequence, they have to be sorted anyway.  */
+	if (! sortlines[i - 1]->line.end_sequence)
+	  goto sort_all;
+	sorted = false;
+	++nseq;
+      }
+    else if (sortlines[i - 1]->line.end_sequence)
+      ++nseq;
+  if (sorted)
+    return;
+
+  struct sequence *seqs = malloc (nseq * sizeof seqs[0]);
+  struct linelist **copy = malloc (n * sizeof copy[0]);
+  if (seqs == NULL || copy == NULL)
+    {
+      free (seqs);
+      free (copy);
+      goto sort_all;
+    }
+
+  size_t s = 0;
+  seqs[0].first = sortlines;
+  for (size_t i = 1; i < n; ++i)
+    if (sortlines[i - 1]->line.end_sequence)
+      {
+	seqs[s].n = &sortlines[i] - seqs[s].first;
+	seqs[++s].first = &sortlines[i];
+      }
+  seqs[s].n = &sortlines[n] - seqs[s].first;
+  assert (s + 1 == nseq);
+  qsort (seqs, nseq, sizeof seqs[0], &compare_sequences);
+
+  /* The sequences may overlap, then all lines need sorting.  */
+  size_t i = 0;
+  for (s = 0; s < nseq; ++s)
+    {
+      if (s > 0 && compare_lines (&copy[i - 1], seqs[s].first) > 0)
+	break;
+      memcpy (&copy[i], seqs[s].first, seqs[s].n * sizeof copy[0]);
+      i += seqs[s].n;
+    }
+  if (s == nseq)
+    memcpy (sortlines, copy, n * sizeof copy[0]);
+  free (seqs);
+  free (copy);
+  if (s == nseq)
+    return;
+
+ sort_all:
+  qsort (sortlines, n, sizeof sortlines[0], &compare_lines);
+}
+
 struct line_state
 {
   Dwarf_Word addr;
@@ -763,15 +844,16 @@ read_srclines (Dwarf *dbg,
   if (filesp != NULL)
     *filesp = files;
 
-  size_t buf_size = (sizeof (Dwarf_Lines)
-		     + (sizeof (Dwarf_Line) * state.nlinelist));
+  size_t info_size = (sizeof (Dwarf_Lines)
+		      + (sizeof (Dwarf_Line) * state.nlinelist));
+  size_t buf_size = info_size + sizeof (Dwarf_Addr) * state.nlinelist;
   void *buf = libdw_alloc (dbg, Dwarf_Lines, buf_size, 1);
 
   /* First use the buffer for the pointers, and sort the entries.
-     We'll write the pointers in the end of the buffer, and then
+     We'll write the pointers in the end of the lines, and then
      copy into the buffer from the beginning so the overlap works.  */
   assert (sizeof (Dwarf_Line) >= sizeof (struct linelist *));
-  struct linelist **sortlines = (buf + buf_size
+  struct linelist **sortlines = (buf + info_size
 				 - sizeof (struct linelist **) * state.nlinelist);
 
   /* The list is in LIFO order and usually they come in clumps with
@@ -786,17 +868,19 @@ read_srclines (Dwarf *dbg,
   assert (lineslist == NULL);
 
   /* Sort by ascending address.  */
-  qsort (sortlines, state.nlinelist, sizeof sortlines[0], &compare_lines);
+  sort_lines (sortlines, state.nlinelist);
 
   /* Now that they are sorted, put them in the final array.
      The buffers overlap, so we've clobbered the early elements
      of SORTLINES by the time we're reading the later ones.  */
   Dwarf_Lines *lines = buf;
   lines->nlines = state.nlinelist;
+  lines->addrs = buf + info_size;
   for (size_t i = 0; i < state.nlinelist; ++i)
     {
       lines->info[i] = sortlines[i]->line;
       lines->info[i].files = files;
+      lines->addrs[i] = lines->info[i].addr;
     }
 
   /* Make sure the highest address for the CU is marked as end_sequence.
@@ -904,7 +988,9 @@ __libdw_getcompdir (Dwarf_Die *cudie)
 }
 
 int
-dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
+internal_function
+__libdw_getcu_srclines (Dwarf_Die *cudie, Dwarf_Lines **linesp,
+			Dwarf_Files **filesp)
 {
   if (cudie == NULL)
     return -1;
@@ -916,13 +1002,15 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
 
   /* Get the information if it is not already known.  */
   struct Dwarf_CU *const cu = cudie->cu;
-  if (cu->lines == NULL)
+  Dwarf *dbg = cu->dbg;
+  rwlock_rdlock (dbg->lock);
+  Dwarf_Lines *lines = cu->lines;
+  Dwarf_Files *files = cu->files;
+  rwlock_unlock (dbg->lock);
+  if (lines == NULL)
     {
-      /* Failsafe mode: no data found.  */
-      cu->lines = (void *) -1l;
-      cu->files = (void *) -1l;
-
-      /* The die must have a statement list associated.  */
+      /* The die must have a statement list associated.  Read the
+	 attributes before taking the lock, they need the abbrevs.  */
       Dwarf_Attribute stmt_list_mem;
       Dwarf_Attribute *stmt_list = INTUSE(dwarf_attr) (cudie, DW_AT_stmt_list,
 						       &stmt_list_mem);
@@ -930,23 +1018,46 @@ dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
       /* Get the offset into the .debug_line section.  NB: this call
 	 also checks whether the previous dwarf_attr call failed.  */
       Dwarf_Off debug_line_offset;
-      if (__libdw_formptr (stmt_list, IDX_debug_line, DWARF_E_NO_DEBUG_LINE,
-			   NULL, &debug_line_offset) == NULL)
-	return -1;
-
-      if (__libdw_getsrclines (cu->dbg, debug_line_offset,
-			       __libdw_getcompdir (cudie),
-			       cu->address_size, &cu->lines, &cu->files) < 0)
-	return -1;
+      bool have_stmt_list = (__libdw_formptr (stmt_list, IDX_debug_line,
+					      DWARF_E_NO_DEBUG_LINE, NULL,
+					      &debug_line_offset) != NULL);
+      const char *comp_dir = (have_stmt_list
+			      ? __libdw_getcompdir (cudie) : NULL);
+
+      rwlock_wrlock (dbg->lock);
+      if (cu->lines == NULL)
+	{
+	  /* Failsafe mode: no data found.  */
+	  cu->lines = (void *) -1l;
+	  cu->files = (void *) -1l;
+
+	  if (have_stmt_list)
+	    (void) __libdw_getsrclines (dbg, debug_line_offset, comp_dir,
+					cu->address_size,
+					&cu->lines, &cu->files);
+	}
+      lines = cu->lines;
+      files = cu->files;
+      rwlock_unlock (dbg->lock);
     }
-  else if (cu->lines == (void *) -1l)
+
+  if (lines == (void *) -1l)
     return -1;
 
-  *lines = cu->lines;
-  *nlines = cu->lines->nlines;
+  if (linesp != NULL)
+    *linesp = lines;
+  if (filesp != NULL)
+    *filesp = files;
+  return 0;
+}
 
-  // XXX Eventually: unlocking here.
+int
+dwarf_getsrclines (Dwarf_Die *cudie, Dwarf_Lines **lines, size_t *nlines)
+{
+  if (__libdw_getcu_srclines (cudie, lines, NULL) != 0)
+    return -1;
 
+  *nlines = (*lines)->nlines;
   return 0;
 }
 INTDEF(dwarf_getsrclines)
@@ -0,0 +1,81 @@
+/* Read all unit headers of a Dwarf handle up front.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwP.h"
+
+
+static int
+index_units (Dwarf *dbg, bool debug_types)
+{
+  Elf_Data *data = dbg->sectiondata[debug_types
+				    ? IDX_debug_types : IDX_debug_info];
+  Dwarf_Off *next_offset
+    = debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
+
+  if (data == NULL)
+    return 0;
+
+  int result = 0;
+  while (*next_offset < data->d_size)
+    {
+      Dwarf_Off offset = *next_offset;
+      if (__libdw_intern_next_unit (dbg, debug_types) == NULL)
+	{
+	  /* A unit we cannot handle is skipped, but if we could not
+	     even read its header there is nothing more to find.  */
+	  result = -1;
+	  if (*next_offset == offset)
+	    {
+	      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+	      break;
+	    }
+	}
+    }
+
+  return result;
+}
+
+
+int
+dwarf_index_units (Dwarf *dbg)
+{
+  if (dbg == NULL)
+    return -1;
+
+  rwlock_wrlock (dbg->cu_lock);
+  int result = index_units (dbg, false);
+  if (index_units (dbg, true) != 0)
+    result = -1;
+  rwlock_unlock (dbg->cu_lock);
+
+  return result;
+}
+INTDEF (dwarf_index_units)
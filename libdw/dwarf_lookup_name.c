@@ -0,0 +1,468 @@
+/* Look up DIEs by name using the name index sections.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <ctype.h>
+#include <dwarf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libdwP.h"
+#include "memory-access.h"
+
+
+/* In-memory name index, built when the file has no index section.  */
+struct libdw_name_index
+{
+  size_t nbuckets;		/* Power of two.  */
+  uint32_t *buckets;		/* Entry index + 1 of the chain, or 0.  */
+  size_t nentries;
+  size_t allocated;
+  struct name_entry
+  {
+    const char *name;
+    Dwarf_Off offset;
+    uint32_t hash;
+    uint32_t next;		/* Entry index + 1, or 0.  */
+    bool type_unit;
+  } *entries;
+};
+
+
+/* The DJB hash of NAME.  */
+static uint32_t
+name_hash (const char *name)
+{
+  uint32_t hash = 5381;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0'; ++p)
+    hash = hash * 33 + *p;
+  return hash;
+}
+
+/* Call CALLBACK for the DIE at OFFSET.  */
+static int
+found_die (Dwarf *dbg, Dwarf_Off offset, bool type_unit,
+	   int (*callback) (Dwarf_Die *, void *), void *arg)
+{
+  Dwarf_Die die;
+  if ((type_unit
+       ? dwarf_offdie_types (dbg, offset, &die)
+       : INTUSE(dwarf_offdie) (dbg, offset, &die)) == NULL)
+    return -1;
+
+  return callback (&die, arg) == DWARF_CB_OK ? 0 : 1;
+}
+
+
+/* The hash of .gdb_index, see mapped_index_string_hash in gdb.  */
+static uint32_t
+gdb_index_hash (const char *name, uint32_t version)
+{
+  uint32_t hash = 0;
+  for (const unsigned char *p = (const unsigned char *) name; *p != '\0'; ++p)
+    hash = hash * 67 + (version >= 5 ? tolower (*p) : *p) - 113;
+  return hash;
+}
+
+/* Whether DIE is named NAME.  .gdb_index names are qualified, the DIEs
+   only have the last component.  */
+static bool
+die_has_name (Dwarf_Die *die, const char *name)
+{
+  const char *diename = INTUSE(dwarf_diename) (die);
+  if (diename == NULL)
+    return false;
+  if (strcmp (diename, name) == 0)
+    return true;
+
+  size_t namelen = strlen (name);
+  size_t dienamelen = strlen (diename);
+  return (namelen > dienamelen + 2
+	  && strcmp (name + namelen - dienamelen, diename) == 0
+	  && name[namelen - dienamelen - 1] == ':'
+	  && name[namelen - dienamelen - 2] == ':');
+}
+
+/* Report DIEs named NAME in the DIE tree starting at DIE.  Local
+   entities inside functions are not in the index.  */
+static int
+report_named (Dwarf_Die *die, const char *name,
+	      int (*callback) (Dwarf_Die *, void *), void *arg)
+{
+  int res;
+  do
+    {
+      if (die_has_name (die, name)
+	  && ! INTUSE(dwarf_hasattr) (die, DW_AT_declaration))
+	{
+	  Dwarf_Die copy = *die;
+	  if (callback (&copy, arg) != DWARF_CB_OK)
+	    return 1;
+	}
+
+      Dwarf_Die child;
+      int tag = INTUSE(dwarf_tag) (die);
+      if (tag != DW_TAG_subprogram && tag != DW_TAG_lexical_block
+	  && tag != DW_TAG_inlined_subroutine
+	  && (res = INTUSE(dwarf_child) (die, &child)) == 0)
+	{
+	  res = report_named (&child, name, callback, arg);
+	  if (res != 0)
+	    return res;
+	}
+    }
+  while ((res = INTUSE(dwarf_siblingof) (die, die)) == 0);
+
+  return res < 0 ? -1 : 0;
+}
+
+/* Get the DIE of the unit with its header at OFF.  */
+static int
+unit_die (Dwarf *dbg, Dwarf_Off off, bool type_unit, Dwarf_Die *result)
+{
+  Dwarf_Off next;
+  size_t header_size;
+  uint64_t signature;
+  Dwarf_Off type_offset;
+  if (INTUSE(dwarf_next_unit) (dbg, off, &next, &header_size, NULL, NULL,
+			       NULL, NULL, type_unit ? &signature : NULL,
+			       type_unit ? &type_offset : NULL) != 0)
+    return -1;
+
+  if ((type_unit
+       ? dwarf_offdie_types (dbg, off + header_size, result)
+       : INTUSE(dwarf_offdie) (dbg, off + header_size, result)) == NULL)
+    return -1;
+  return 0;
+}
+
+static int
+lookup_gdb_index (Dwarf *dbg, const char *name,
+		  int (*callback) (Dwarf_Die *, void *), void *arg)
+{
+  Elf_Data *data = dbg->sectiondata[IDX_gdb_index];
+  const unsigned char *start = data->d_buf;
+  size_t size = data->d_size;
+
+  /* .gdb_index is always little endian.  */
+  Dwarf dummy_dbg = { .other_byte_order = BYTE_ORDER != LITTLE_ENDIAN };
+
+  if (size < 24)
+    goto invalid;
+  uint32_t version = read_4ubyte_unaligned (&dummy_dbg, start);
+  if (version < 4 || version > 8)
+    goto invalid;
+  uint32_t cu_list = read_4ubyte_unaligned (&dummy_dbg, start + 4);
+  uint32_t tu_list = read_4ubyte_unaligned (&dummy_dbg, start + 8);
+  uint32_t addr_table = read_4ubyte_unaligned (&dummy_dbg, start + 12);
+  uint32_t sym_table = read_4ubyte_unaligned (&dummy_dbg, start + 16);
+  uint32_t pool = read_4ubyte_unaligned (&dummy_dbg, start + 20);
+  if (cu_list > tu_list || tu_list > addr_table || addr_table > sym_table
+      || sym_table > pool || pool > size)
+    goto invalid;
+
+  size_t ncus = (tu_list - cu_list) / 16;
+  size_t ntus = (addr_table - tu_list) / 24;
+  size_t nslots = (pool - sym_table) / 8;
+  if (nslots == 0 || (nslots & (nslots - 1)) != 0)
+    goto invalid;
+
+  uint32_t hash = gdb_index_hash (name, version);
+  size_t slot = hash & (nslots - 1);
+  size_t step = ((hash * 17) & (nslots - 1)) | 1;
+  const unsigned char *vec = NULL;
+  for (size_t n = 0; n < nslots; ++n)
+    {
+      const unsigned char *p = start + sym_table + 8 * slot;
+      uint32_t name_off = read_4ubyte_unaligned (&dummy_dbg, p);
+      uint32_t vec_off = read_4ubyte_unaligned (&dummy_dbg, p + 4);
+      if (name_off == 0 && vec_off == 0)
+	break;
+
+      if (name_off >= size - pool || vec_off >= size - pool)
+	goto invalid;
+      const char *str = (const char *) start + pool + name_off;
+      if (memchr (str, '\0', size - pool - name_off) == NULL)
+	goto invalid;
+      if (strcmp (str, name) == 0)
+	{
+	  vec = start + pool + vec_off;
+	  break;
+	}
+
+      slot = (slot + step) & (nslots - 1);
+    }
+  if (vec == NULL)
+    return 0;
+
+  if ((size_t) (start + size - vec) < 4)
+    goto invalid;
+  uint32_t count = read_4ubyte_unaligned (&dummy_dbg, vec);
+  if ((size_t) (start + size - vec - 4) / 4 < count)
+    goto invalid;
+
+  /* The index only says which units define NAME, find the DIEs in
+     each unit once.  */
+  for (uint32_t n = 0; n < count; ++n)
+    {
+      uint32_t ndx = read_4ubyte_unaligned (&dummy_dbg, vec + 4 + 4 * n);
+      if (version >= 7)
+	ndx &= 0xffffff;
+
+      bool seen = false;
+      for (uint32_t prev = 0; prev < n && ! seen; ++prev)
+	{
+	  uint32_t pndx = read_4ubyte_unaligned (&dummy_dbg,
+						 vec + 4 + 4 * prev);
+	  seen = (version >= 7 ? pndx & 0xffffff : pndx) == ndx;
+	}
+      if (seen)
+	continue;
+
+      /* The index has the offsets of the unit headers.  */
+      Dwarf_Off off;
+      bool type_unit = ndx >= ncus;
+      if (! type_unit)
+	off = read_8ubyte_unaligned (&dummy_dbg, start + cu_list + 16 * ndx);
+      else if (ndx - ncus < ntus)
+	off = read_8ubyte_unaligned (&dummy_dbg,
+				     start + tu_list + 24 * (ndx - ncus));
+      else
+	goto invalid;
+
+      Dwarf_Die cudie;
+      if (unit_die (dbg, off, type_unit, &cudie) != 0)
+	return -1;
+      int res = report_named (&cudie, name, callback, arg);
+      if (res != 0)
+	return res;
+    }
+
+  return 0;
+
+ invalid:
+  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+  return -1;
+}
+
+
+static int
+name_index_add (struct libdw_name_index *index, const char *name,
+		Dwarf_Off offset, bool type_unit)
+{
+  if (index->nentries == index->allocated)
+    {
+      size_t allocated = index->allocated == 0 ? 1024 : 2 * index->allocated;
+      struct name_entry *entries = realloc (index->entries,
+					    allocated * sizeof entries[0]);
+      if (entries == NULL)
+	return -1;
+      index->entries = entries;
+      index->allocated = allocated;
+    }
+
+  struct name_entry *entry = &index->entries[index->nentries++];
+  entry->name = name;
+  entry->offset = offset;
+  entry->hash = name_hash (name);
+  entry->type_unit = type_unit;
+  return 0;
+}
+
+/* Add the names defined in the DIE tree starting at DIE, the ones an
+   index section would list.  */
+static int
+name_index_add_tree (struct libdw_name_index *index, Dwarf_Die *die,
+		     bool type_unit)
+{
+  int res;
+  do
+    {
+      if (! INTUSE(dwarf_hasattr) (die, DW_AT_declaration))
+	{
+	  const char *name = INTUSE(dwarf_diename) (die);
+	  if (name != NULL
+	      && name_index_add (index, name, INTUSE(dwarf_dieoffset) (die),
+				 type_unit) != 0)
+	    return -1;
+
+	  Dwarf_Attribute attr_mem;
+	  Dwarf_Attribute *attr
+	    = INTUSE(dwarf_attr) (die, DW_AT_linkage_name, &attr_mem);
+	  if (attr == NULL)
+	    attr = INTUSE(dwarf_attr) (die, DW_AT_MIPS_linkage_name,
+				       &attr_mem);
+	  const char *linkage_name = INTUSE(dwarf_formstring) (attr);
+	  if (linkage_name != NULL
+	      && (name == NULL || strcmp (name, linkage_name) != 0)
+	      && name_index_add (index, linkage_name,
+				 INTUSE(dwarf_dieoffset) (die),
+				 type_unit) != 0)
+	    return -1;
+	}
+
+      Dwarf_Die child;
+      int tag = INTUSE(dwarf_tag) (die);
+      if (tag != DW_TAG_subprogram && tag != DW_TAG_lexical_block
+	  && tag != DW_TAG_inlined_subroutine
+	  && (res = INTUSE(dwarf_child) (die, &child)) == 0
+	  && name_index_add_tree (index, &child, type_unit) != 0)
+	return -1;
+    }
+  while ((res = INTUSE(dwarf_siblingof) (die, die)) == 0);
+
+  return res < 0 ? -1 : 0;
+}
+
+void
+internal_function
+__libdw_name_index_free (struct libdw_name_index *index)
+{
+  if (index != NULL)
+    {
+      free (index->buckets);
+      free (index->entries);
+      free (index);
+    }
+}
+
+static struct libdw_name_index *
+name_index_build (Dwarf *dbg)
+{
+  struct libdw_name_index *index = calloc (1, sizeof *index);
+  if (index == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  for (int type_units = 0; type_units <= 1; ++type_units)
+    {
+      Dwarf_Off off = 0;
+      Dwarf_Off next;
+      size_t hsize;
+      uint64_t sig;
+      Dwarf_Off type_offset;
+      while (INTUSE(dwarf_next_unit) (dbg, off, &next, &hsize, NULL, NULL,
+				      NULL, NULL,
+				      type_units ? &sig : NULL,
+				      type_units ? &type_offset : NULL) == 0)
+	{
+	  Dwarf_Die cudie;
+	  if ((type_units
+	       ? dwarf_offdie_types (dbg, off + hsize, &cudie)
+	       : INTUSE(dwarf_offdie) (dbg, off + hsize, &cudie)) == NULL
+	      || name_index_add_tree (index, &cudie, type_units) != 0)
+	    goto fail;
+	  off = next;
+	}
+    }
+
+  index->nbuckets = 16;
+  while (index->nbuckets < index->nentries)
+    index->nbuckets *= 2;
+  index->buckets = calloc (index->nbuckets, sizeof index->buckets[0]);
+  if (index->buckets == NULL)
+    goto fail;
+
+  /* Chain in reverse, so every chain is in DIE order.  */
+  for (size_t n = index->nentries; n-- > 0; )
+    {
+      struct name_entry *entry = &index->entries[n];
+      uint32_t *bucket = &index->buckets[entry->hash & (index->nbuckets - 1)];
+      entry->next = *bucket;
+      *bucket = n + 1;
+    }
+
+  return index;
+
+ fail:
+  if (INTUSE(dwarf_errno) () == DWARF_E_NOERROR)
+    __libdw_seterrno (DWARF_E_NOMEM);
+  __libdw_name_index_free (index);
+  return NULL;
+}
+
+static int
+lookup_name_index (Dwarf *dbg, const char *name,
+		   int (*callback) (Dwarf_Die *, void *), void *arg)
+{
+  rwlock_rdlock (dbg->lock);
+  struct libdw_name_index *index = dbg->name_index;
+  rwlock_unlock (dbg->lock);
+
+  if (index == NULL)
+    {
+      /* Build it without holding the lock, walking all DIEs takes a
+	 while.  If another thread was faster we use its index.  */
+      index = name_index_build (dbg);
+      if (index == NULL)
+	return -1;
+
+      rwlock_wrlock (dbg->lock);
+      if (dbg->name_index == NULL)
+	dbg->name_index = index;
+      else
+	{
+	  __libdw_name_index_free (index);
+	  index = dbg->name_index;
+	}
+      rwlock_unlock (dbg->lock);
+    }
+
+  uint32_t hash = name_hash (name);
+  for (uint32_t n = index->buckets[hash & (index->nbuckets - 1)]; n != 0;
+       n = index->entries[n - 1].next)
+    {
+      struct name_entry *entry = &index->entries[n - 1];
+      if (entry->hash != hash || strcmp (entry->name, name) != 0)
+	continue;
+
+      int res = found_die (dbg, entry->offset, entry->type_unit,
+			   callback, arg);
+      if (res != 0)
+	return res;
+    }
+
+  return 0;
+}
+
+
+int
+dwarf_lookup_name (Dwarf *dbg, const char *name,
+		   int (*callback) (Dwarf_Die *, void *), void *arg)
+{
+  if (dbg == NULL)
+    return -1;
+
+  if (dbg->sectiondata[IDX_gdb_index] != NULL)
+    return lookup_gdb_index (dbg, name, callback, arg);
+  return lookup_name_index (dbg, name, callback, arg);
+}
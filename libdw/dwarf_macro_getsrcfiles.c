@@ -38,7 +38,10 @@ dwarf_macro_getsrcfiles (Dwarf *dbg, Dwarf_Macro *macro,
 {
   /* macro is declared NN */
   Dwarf_Macro_Op_Table *const table = macro->table;
-  if (table->files == NULL)
+  rwlock_rdlock (dbg->lock);
+  Dwarf_Files *table_files = table->files;
+  rwlock_unlock (dbg->lock);
+  if (table_files == NULL)
     {
       Dwarf_Off line_offset = table->line_offset;
       if (line_offset == (Dwarf_Off) -1)
@@ -71,16 +74,20 @@ dwarf_macro_getsrcfiles (Dwarf *dbg, Dwarf_Macro *macro,
 	 the same unit through dwarf_getsrcfiles, and the file names
 	 will be broken.  */
 
-      if (__libdw_getsrclines (dbg, line_offset, table->comp_dir,
-			       table->is_64bit ? 8 : 4,
-			       NULL, &table->files) < 0)
+      rwlock_wrlock (dbg->lock);
+      if (table->files == NULL
+	  && __libdw_getsrclines (dbg, line_offset, table->comp_dir,
+				  table->is_64bit ? 8 : 4,
+				  NULL, &table->files) < 0)
 	table->files = (void *) -1;
+      table_files = table->files;
+      rwlock_unlock (dbg->lock);
     }
 
-  if (table->files == (void *) -1)
+  if (table_files == (void *) -1)
     return -1;
 
-  *files = table->files;
-  *nfiles = table->files->nfiles;
+  *files = table_files;
+  *nfiles = table_files->nfiles;
   return 0;
 }
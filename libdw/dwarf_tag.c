@@ -45,29 +45,41 @@ __libdw_findabbrev (struct Dwarf_CU *cu, unsigned int code)
     return DWARF_END_ABBREV;
 
   /* See whether the entry is already in the hash table.  */
+  rwlock_rdlock (cu->dbg->abbrev_lock);
   abb = Dwarf_Abbrev_Hash_find (&cu->abbrev_hash, code, NULL);
+  rwlock_unlock (cu->dbg->abbrev_lock);
   if (abb == NULL)
-    while (cu->last_abbrev_offset != (size_t) -1l)
-      {
-	size_t length;
-
-	/* Find the next entry.  It gets automatically added to the
-	   hash table.  */
-	abb = __libdw_getabbrev (cu->dbg, cu, cu->last_abbrev_offset, &length,
-				 NULL);
-	if (abb == NULL || abb == DWARF_END_ABBREV)
+    {
+      rwlock_wrlock (cu->dbg->abbrev_lock);
+
+      /* Another thread might have read it in the meantime.  */
+      abb = Dwarf_Abbrev_Hash_find (&cu->abbrev_hash, code, NULL);
+      if (abb == NULL)
+	while (cu->last_abbrev_offset != (size_t) -1l)
 	  {
-	    /* Make sure we do not try to search for it again.  */
-	    cu->last_abbrev_offset = (size_t) -1l;
-	    return DWARF_END_ABBREV;
+	    size_t length;
+
+	    /* Find the next entry.  It gets automatically added to the
+	       hash table.  */
+	    abb = __libdw_getabbrev (cu->dbg, cu, cu->last_abbrev_offset,
+				     &length, NULL);
+	    if (abb == NULL || abb == DWARF_END_ABBREV)
+	      {
+		/* Make sure we do not try to search for it again.  */
+		cu->last_abbrev_offset = (size_t) -1l;
+		abb = DWARF_END_ABBREV;
+		break;
+	      }
+
+	    cu->last_abbrev_offset += length;
+
+	    /* Is this the code we are looking for?  */
+	    if (abb->code == code)
+	      break;
 	  }
 
-	cu->last_abbrev_offset += length;
-
-	/* Is this the code we are looking for?  */
-	if (abb->code == code)
-	  break;
-      }
+      rwlock_unlock (cu->dbg->abbrev_lock);
+    }
 
   /* This is our second (or third, etc.) call to __libdw_findabbrev
      and the code is invalid.  */
@@ -62,20 +62,17 @@ compare_fde (const void *a, const void *b)
   return 0;
 }
 
-static struct dwarf_fde *
-intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
+/* Fill in FDE from ENTRY.  Returns DWARF_E_NOERROR, -1 for an FDE that
+   covers no code, which can be ignored, or the error code.  On error the
+   FDE's start and end are still set if they could be read, or else are
+   both zero.  */
+static int
+parse_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry, struct dwarf_fde *fde)
 {
   /* Look up the new entry's CIE.  */
   struct dwarf_cie *cie = __libdw_find_cie (cache, entry->CIE_pointer);
   if (cie == NULL)
-    return (void *) -1l;
-
-  struct dwarf_fde *fde = malloc (sizeof (struct dwarf_fde));
-  if (fde == NULL)
-    {
-      __libdw_seterrno (DWARF_E_NOMEM);
-      return NULL;
-    }
+    return -1;
 
   fde->instructions = entry->start;
   fde->instructions_end = entry->end;
@@ -84,18 +81,14 @@ intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
       || unlikely (read_encoded_value (cache, cie->fde_encoding & 0x0f,
 				       &fde->instructions, &fde->end)))
     {
-      free (fde);
-      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-      return NULL;
+      fde->start = fde->end = 0;
+      return DWARF_E_INVALID_DWARF;
     }
   fde->end += fde->start;
 
   /* Make sure the fde actually covers a real code range.  */
   if (fde->start >= fde->end)
-    {
-      free (fde);
-      return (void *) -1;
-    }
+    return -1;
 
   fde->cie = cie;
 
@@ -106,11 +99,7 @@ intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
       Dwarf_Word len;
       get_uleb128 (len, fde->instructions, fde->instructions_end);
       if ((Dwarf_Word) (fde->instructions_end - fde->instructions) < len)
-	{
-	  free (fde);
-	  __libdw_seterrno (DWARF_E_INVALID_DWARF);
-	  return NULL;
-	}
+	return DWARF_E_INVALID_DWARF;
       fde->instructions += len;
     }
   else
@@ -118,6 +107,29 @@ intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
        We've recorded the number of data bytes in FDEs.  */
     fde->instructions += cie->fde_augmentation_data_size;
 
+  return DWARF_E_NOERROR;
+}
+
+static struct dwarf_fde *
+intern_fde (Dwarf_CFI *cache, const Dwarf_FDE *entry)
+{
+  struct dwarf_fde *fde = malloc (sizeof (struct dwarf_fde));
+  if (fde == NULL)
+    {
+      __libdw_seterrno (DWARF_E_NOMEM);
+      return NULL;
+    }
+
+  int result = parse_fde (cache, entry, fde);
+  if (result != DWARF_E_NOERROR)
+    {
+      free (fde);
+      if (result == -1)
+	return (void *) -1l;
+      __libdw_seterrno (result);
+      return NULL;
+    }
+
   /* Add the new entry to the search tree.  */
   struct dwarf_fde **tres = tsearch (fde, &cache->fde_tree, &compare_fde);
   if (tres == NULL)
@@ -242,20 +254,121 @@ binary_search_fde (Dwarf_CFI *cache, Dwarf_Addr address)
   return (Dwarf_Off) -1l;
 }
 
+static int
+compare_fde_start (const void *a, const void *b)
+{
+  const struct dwarf_fde *fde1 = a;
+  const struct dwarf_fde *fde2 = b;
+
+  if (fde1->start != fde2->start)
+    return fde1->start < fde2->start ? -1 : 1;
+
+  /* Keep the section order between FDEs with the same start.  */
+  return (fde1->instructions < fde2->instructions ? -1
+	  : fde1->instructions > fde2->instructions);
+}
+
+/* Read all FDEs of the section into CACHE->fdes, sorted by address.
+   This is done once for CFI without a binary search table.  A bad FDE
+   is kept with a null CIE, so looking up an address it covers fails.
+   If its range can't be read, looking up any address not covered by
+   another FDE fails, as it did reading the FDEs one by one.  */
+static int
+read_fdes (Dwarf_CFI *cache)
+{
+  struct dwarf_fde *fdes = NULL;
+  size_t nfdes = 0;
+  size_t allocated = 0;
+
+  Dwarf_Off offset = 0;
+  while (1)
+    {
+      Dwarf_Off last_offset = offset;
+      Dwarf_CFI_Entry entry;
+      int result = INTUSE(dwarf_next_cfi) (cache->e_ident,
+					   &cache->data->d, CFI_IS_EH (cache),
+					   last_offset, &offset, &entry);
+      if (result > 0)
+	break;
+      if (result < 0)
+	{
+	  if (offset == last_offset)
+	    /* We couldn't progress past the bogus FDE.  */
+	    break;
+	  /* Skip the loser and look at the next entry.  */
+	  continue;
+	}
+
+      if (dwarf_cfi_cie_p (&entry))
+	{
+	  /* This is a CIE, not an FDE.  We eagerly intern these
+	     because the next FDE will usually refer to this CIE.  */
+	  __libdw_intern_cie (cache, last_offset, &entry.cie);
+	  continue;
+	}
+
+      if (nfdes == allocated)
+	{
+	  allocated = allocated == 0 ? 64 : allocated * 2;
+	  struct dwarf_fde *newp = realloc (fdes, allocated * sizeof *fdes);
+	  if (unlikely (newp == NULL))
+	    {
+	      free (fdes);
+	      return DWARF_E_NOMEM;
+	    }
+	  fdes = newp;
+	}
+
+      /* FDEs without code are left out.  */
+      result = parse_fde (cache, &entry.fde, &fdes[nfdes]);
+      if (result == DWARF_E_NOERROR)
+	++nfdes;
+      else if (result != -1)
+	{
+	  fdes[nfdes].cie = NULL;
+	  if (fdes[nfdes].start < fdes[nfdes].end)
+	    ++nfdes;
+	  else
+	    cache->fdes_invalid = true;
+	}
+    }
+
+  qsort (fdes, nfdes, sizeof *fdes, compare_fde_start);
+
+  /* Like in the search tree, an FDE overlapping one we already have is
+     odd.  Keep only the first.  */
+  size_t n = 0;
+  for (size_t i = 0; i < nfdes; ++i)
+    if (n == 0 || fdes[i].start >= fdes[n - 1].end)
+      fdes[n++] = fdes[i];
+
+  if (n == 0)
+    {
+      free (fdes);
+      fdes = NULL;
+    }
+  else
+    fdes = (realloc (fdes, n * sizeof *fdes) ?: fdes);
+  cache->fdes = fdes;
+  cache->nfdes = n;
+  cache->next_offset = offset;
+  return DWARF_E_NOERROR;
+}
+
 struct dwarf_fde *
 internal_function
 __libdw_find_fde (Dwarf_CFI *cache, Dwarf_Addr address)
 {
-  /* Look for a cached FDE covering this address.  */
-
-  const struct dwarf_fde fde_key = { .start = address, .end = 0 };
-  struct dwarf_fde **found = tfind (&fde_key, &cache->fde_tree, &compare_fde);
-  if (found != NULL)
-    return *found;
-
   /* Use .eh_frame_hdr binary search table if possible.  */
   if (cache->search_table != NULL)
     {
+      /* Look for a cached FDE covering this address.  */
+      const struct dwarf_fde fde_key = { .start = address, .end = 0 };
+      struct dwarf_fde **found = tfind (&fde_key, &cache->fde_tree,
+					&compare_fde);
+      if (found != NULL)
+	return *found;
+
       Dwarf_Off offset = binary_search_fde (cache, address);
       if (offset == (Dwarf_Off) -1l)
 	goto no_match;
@@ -275,46 +388,41 @@ __libdw_find_fde (Dwarf_CFI *cache, Dwarf_Addr address)
       return fde;
     }
 
-  /* It's not there.  Read more CFI entries until we find it.  */
-  while (1)
+  /* Otherwise read all FDEs into our own sorted table.  */
+  if (! cache->fdes_read)
     {
-      Dwarf_Off last_offset = cache->next_offset;
-      Dwarf_CFI_Entry entry;
-      int result = INTUSE(dwarf_next_cfi) (cache->e_ident,
-					   &cache->data->d, CFI_IS_EH (cache),
-					   last_offset, &cache->next_offset,
-					   &entry);
-      if (result > 0)
-	break;
-      if (result < 0)
+      int result = read_fdes (cache);
+      if (unlikely (result != DWARF_E_NOERROR))
 	{
-	  if (cache->next_offset == last_offset)
-	    /* We couldn't progress past the bogus FDE.  */
-	    break;
-	  /* Skip the loser and look at the next entry.  */
-	  continue;
+	  __libdw_seterrno (result);
+	  return NULL;
 	}
+      cache->fdes_read = true;
+    }
 
-      if (dwarf_cfi_cie_p (&entry))
+  /* Find the last FDE starting at or before ADDRESS.  */
+  size_t l = 0, u = cache->nfdes;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (address < cache->fdes[idx].start)
+	u = idx;
+      else
+	l = idx + 1;
+    }
+  if (l > 0 && address < cache->fdes[l - 1].end)
+    {
+      if (unlikely (cache->fdes[l - 1].cie == NULL))
 	{
-	  /* This is a CIE, not an FDE.  We eagerly intern these
-	     because the next FDE will usually refer to this CIE.  */
-	  __libdw_intern_cie (cache, last_offset, &entry.cie);
-	  continue;
+	  __libdw_seterrno (DWARF_E_INVALID_DWARF);
+	  return NULL;
 	}
-
-      /* We have a new FDE to consider.  */
-      struct dwarf_fde *fde = intern_fde (cache, &entry.fde);
-
-      if (fde == (void *) -1l)	/* Bad FDE, but we can keep looking.  */
-	continue;
-
-      if (fde == NULL)		/* Bad data.  */
-	return NULL;
-
-      /* Is this the one we're looking for?  */
-      if (fde->start <= address && fde->end > address)
-	return fde;
+      return &cache->fdes[l - 1];
+    }
+  if (unlikely (cache->fdes_invalid))
+    {
+      __libdw_seterrno (DWARF_E_INVALID_DWARF);
+      return NULL;
     }
 
  no_match:
@@ -62,6 +62,7 @@ __libdw_destroy_frame_cache (Dwarf_CFI *cache)
 {
   /* Most of the data is in our two search trees.  */
   tdestroy (cache->fde_tree, free_fde);
+  free (cache->fdes);
   tdestroy (cache->cie_tree, free_cie);
   tdestroy (cache->expr_tree, free_expr);
 
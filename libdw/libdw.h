@@ -303,6 +303,37 @@ extern int dwarf_next_unit (Dwarf *dwarf, Dwarf_Off off, Dwarf_Off *next_off,
 			    uint64_t *type_signaturep, Dwarf_Off *type_offsetp)
      __nonnull_attribute__ (3);
 
+/* Read the headers of all CUs and type units up front, instead of when
+   a DIE in them is first looked up.  Later lookups of DIE offsets are
+   then a binary search only.  Returns 0 on success, -1 if some unit
+   could not be read; all other units are indexed anyway.  */
+extern int dwarf_index_units (Dwarf *dwarf);
+
+/* Call CALLBACK with the DIE of every CU in DWARF, from NTHREADS
+   threads at the same time (as many as there are CPUs if NTHREADS is
+   zero).  WORKER is the number of the calling thread, below NTHREADS,
+   so the callback can keep per-thread state in an array.  The
+   callback runs concurrently with itself and may use any libdw lookup
+   on DWARF.  Returns 0 when all CUs were handled, 1 if a callback
+   returned DWARF_CB_ABORT, in which case the remaining CUs are
+   skipped, and -1 on error.  When some unit cannot be read, all the
+   CUs that can are still handled before -1 is returned.  If libdw was
+   built without thread-safety all CUs are handled by the calling
+   thread as worker zero.  */
+extern int dwarf_getcus (Dwarf *dwarf,
+			 int (*callback) (Dwarf_Die *cudie,
+					  unsigned int worker, void *arg),
+			 void *arg, unsigned int nthreads);
+
+/* Call CALLBACK for every DIE defining NAME in DWARF, as a function,
+   variable, type or namespace, using the .gdb_index section if there
+   is one.  Otherwise all units are read once to build an index in
+   memory, which later calls reuse.  NAME may also be a linkage name.  Returns 0 when all DIEs were reported, 1 if the
+   callback returned DWARF_CB_ABORT and -1 on error.  */
+extern int dwarf_lookup_name (Dwarf *dwarf, const char *name,
+			      int (*callback) (Dwarf_Die *die, void *arg),
+			      void *arg);
+
 
 /* Decode one DWARF CFI entry (CIE or FDE) from the raw section data.
    The E_IDENT from the originating ELF file indicates the address
@@ -767,6 +798,16 @@ extern int dwarf_getscopes (Dwarf_Die *cudie, Dwarf_Addr pc,
    Returns -1 for errors or 0 if DIE is not found in any scope entry.  */
 extern int dwarf_getscopes_die (Dwarf_Die *die, Dwarf_Die **scopes);
 
+/* Return scope DIEs containing PC address, like dwarf_getscopes.
+   But for a PC in a concrete inlined instance the scopes are not
+   continued in the abstract definition of the inlined function.
+   (*SCOPES)[1] and the following DIEs are always the scopes containing
+   the previous one, so every DW_TAG_inlined_subroutine is followed by
+   the scopes it was inlined into, up to the CU DIE.
+   Returns -1 for errors or 0 if no scopes match PC.  */
+extern int dwarf_getscopes_inlined (Dwarf_Die *cudie, Dwarf_Addr pc,
+				    Dwarf_Die **scopes);
+
 
 /* Search SCOPES[0..NSCOPES-1] for a variable called NAME.
    Ignore the first SKIP_SHADOWS scopes that match the name.
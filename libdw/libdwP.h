@@ -83,6 +83,7 @@ enum
     IDX_debug_macro,
     IDX_debug_ranges,
     IDX_gnu_debugaltlink,
+    IDX_gdb_index,
     IDX_last
   };
 
@@ -164,15 +165,36 @@ struct Dwarf
   } *pubnames_sets;
   size_t pubnames_nsets;
 
-  /* Search tree for the CUs.  */
-  void *cu_tree;
+  /* Index of the CUs.  */
+  struct libdw_unit_index
+  {
+    /* Units are read in order, so both arrays are sorted by offset.
+       STARTS is kept separately to make the binary search cheap.  */
+    Dwarf_Off *starts;
+    struct Dwarf_CU **units;
+    size_t nunits;
+    size_t allocated;
+  } cu_index;
   Dwarf_Off next_cu_offset;
 
-  /* Search tree and sig8 hash table for .debug_types type units.  */
-  void *tu_tree;
+  /* Index and sig8 hash table for .debug_types type units.  */
+  struct libdw_unit_index tu_index;
   Dwarf_Off next_tu_offset;
   Dwarf_Sig8_Hash sig8_hash;
 
+  /* Lock for the CU and TU indexes, their next offsets and the sig8
+     hash table.  */
+  rwlock_define (, cu_lock);
+
+  /* Lock for the abbreviation hash tables of all CUs.  */
+  rwlock_define (, abbrev_lock);
+
+  /* Lock for the data filled in lazily by otherwise read-only calls:
+     files_lines, macro_ops, aranges, pubnames_sets, cfi and the
+     lines, files and locs of all CUs.  It is taken before cu_lock
+     and abbrev_lock, never while holding them.  */
+  rwlock_define (, lock);
+
   /* Search tree for .debug_macro operator tables.  */
   void *macro_ops;
 
@@ -185,6 +207,10 @@ struct Dwarf
   /* Cached info from the CFI section.  */
   struct Dwarf_CFI_s *cfi;
 
+  /* Name index built by dwarf_lookup_name if the file has no
+     .gdb_index.  Protected by LOCK.  */
+  struct libdw_name_index *name_index;
+
   /* Fake loc CU.  Used when synthesizing attributes for Dwarf_Ops that
      came from a location list entry in dwarf_getlocation_attr.  */
   struct Dwarf_CU *fake_loc_cu;
@@ -200,6 +226,18 @@ struct Dwarf
     char mem[0];
   } *mem_tail;
 
+#ifdef USE_LOCKS
+  /* With locking every thread allocates from its own chain of blocks,
+     MEM_TAILS is indexed by a per-thread id and points to where the
+     tail of each chain is kept.  MEM_RWL is only taken for writing when
+     the array grows.  MEM_SERIAL tells this Dwarf apart from all others
+     created in the process.  */
+  struct libdw_memblock ***mem_tails;
+  size_t mem_stacks;
+  unsigned long int mem_serial;
+  rwlock_define (, mem_rwl);
+#endif
+
   /* Default size of allocated memory blocks.  */
   size_t mem_default_size;
 
@@ -264,9 +302,34 @@ struct Dwarf_Line_s
 struct Dwarf_Lines_s
 {
   size_t nlines;
+  /* The addresses of the lines in INFO, kept apart to search them.  */
+  Dwarf_Addr *addrs;
   struct Dwarf_Line_s info[0];
 };
 
+/* Return the index of the first line from L up to U with an address
+   above ADDR, or U if there is none.  The range is narrowed by a
+   bisection without branches on the addresses, the last few are
+   counted in a loop the compiler can vectorize.  */
+static inline size_t
+__libdw_lines_upper_bound (const Dwarf_Lines *lines, size_t l, size_t u,
+			   Dwarf_Addr addr)
+{
+  const Dwarf_Addr *addrs = lines->addrs;
+  size_t n = u - l;
+  while (n > 16)
+    {
+      size_t half = n / 2;
+      l = addrs[l + half] <= addr ? l + half : l;
+      n -= half;
+    }
+
+  size_t below = 0;
+  for (size_t i = 0; i < n; ++i)
+    below += addrs[l + i] <= addr;
+  return l + below;
+}
+
 /* Representation of address ranges.  */
 struct Dwarf_Aranges_s
 {
@@ -312,6 +375,9 @@ struct Dwarf_CU
   /* Known location lists.  */
   void *locs;
 
+  /* Index for dwarf_getscopes, (void *) -1l if it cannot be built.  */
+  struct libdw_scope_index *scope_index;
+
   /* Memory boundaries of this CU.  */
   void *startp;
   void *endp;
@@ -407,9 +473,22 @@ libdw_macro_nforms (Dwarf_Macro *macro)
 extern void __libdw_seterrno (int value) internal_function;
 
 
-/* Memory handling, the easy parts.  This macro does not do any locking.  */
+/* Return the memory block the current thread allocates from.  */
+#ifdef USE_LOCKS
+extern struct libdw_memblock *__libdw_alloc_tail (Dwarf *dbg)
+     __nonnull_attribute__ (1) internal_function;
+
+/* Initialize the memory handling of a new DBG.  */
+extern void __libdw_alloc_init (Dwarf *dbg)
+     __nonnull_attribute__ (1) internal_function;
+#else
+# define __libdw_alloc_tail(dbg) ((dbg)->mem_tail)
+#endif
+
+/* Memory handling, the easy parts.  This macro does not do any locking,
+   the tail block is only ever used by the current thread.  */
 #define libdw_alloc(dbg, type, tsize, cnt) \
-  ({ struct libdw_memblock *_tail = (dbg)->mem_tail;			      \
+  ({ struct libdw_memblock *_tail = __libdw_alloc_tail (dbg);		      \
      size_t _required = (tsize) * (cnt);				      \
      type *_result = (type *) (_tail->mem + (_tail->size - _tail->remaining));\
      size_t _padding = ((__alignof (type)				      \
@@ -435,7 +514,8 @@ extern void *__libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
 /* Default OOM handler.  */
 extern void __libdw_oom (void) __attribute ((noreturn, visibility ("hidden")));
 
-/* Allocate the internal data for a unit not seen before.  */
+/* Allocate the internal data for a unit not seen before.
+   The caller must hold DBG's cu_lock for writing.  */
 extern struct Dwarf_CU *__libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
      __nonnull_attribute__ (1) internal_function;
 
@@ -448,7 +528,9 @@ extern Dwarf_Abbrev *__libdw_findabbrev (struct Dwarf_CU *cu,
 					 unsigned int code)
      __nonnull_attribute__ (1) internal_function;
 
-/* Get abbreviation at given offset.  */
+/* Get abbreviation at given offset.  If CU is not NULL the abbreviation
+   is added to its hash table, the caller must hold DBG's abbrev_lock
+   for writing.  */
 extern Dwarf_Abbrev *__libdw_getabbrev (Dwarf *dbg, struct Dwarf_CU *cu,
 					Dwarf_Off offset, size_t *lengthp,
 					Dwarf_Abbrev *result)
@@ -556,6 +638,69 @@ extern int __libdw_visit_scopes (unsigned int depth,
 				 void *arg)
   __nonnull_attribute__ (2, 4) internal_function;
 
+/* True if __libdw_visit_scopes descends into the children of DIE.  */
+extern bool __libdw_may_have_scopes (Dwarf_Die *die)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Index of the DIEs __libdw_visit_scopes walks in a CU, to find the
+   scopes without walking them.  The nodes are in the order of the walk,
+   node zero is the CU DIE.  */
+struct libdw_scope_node
+{
+  Dwarf_Die die;
+  /* Index of the parent node, unused for the CU DIE.  */
+  unsigned int parent;
+  /* Zero for the CU DIE.  */
+  unsigned int depth;
+  /* The address ranges of the children of this node are
+     RANGES[FIRST_RANGE] up to RANGES[FIRST_RANGE + NRANGES - 1].  */
+  size_t first_range;
+  size_t nranges;
+};
+
+struct libdw_scope_range
+{
+  Dwarf_Addr low;
+  Dwarf_Addr high;
+  /* The highest HIGH of this and the earlier ranges of the same parent,
+     these are sorted by LOW.  */
+  Dwarf_Addr max_high;
+  unsigned int node;
+};
+
+struct libdw_scope_index
+{
+  struct libdw_scope_node *nodes;
+  size_t nnodes;
+  struct libdw_scope_range *ranges;
+  /* Node indices sorted by DIE address, then by index.  */
+  unsigned int *by_addr;
+};
+
+/* Return the scope index of CU, building it on first use.  Returns
+   NULL if it cannot be built, then the scopes must be walked.  */
+extern struct libdw_scope_index *__libdw_scope_index (struct Dwarf_CU *cu)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Return the innermost node containing PC the way dwarf_getscopes
+   finds it, or zero if there is none.  */
+extern unsigned int __libdw_scope_find_pc (struct libdw_scope_index *index,
+					   Dwarf_Addr pc)
+  __nonnull_attribute__ (1) internal_function;
+
+/* Return the first node of DIE below node WITHIN, or zero if there is
+   none.  */
+extern unsigned int __libdw_scope_find_die (struct libdw_scope_index *index,
+					    Dwarf_Die *die,
+					    unsigned int within)
+  __nonnull_attribute__ (1, 2) internal_function;
+
+/* Store the DIEs of NODE and its parents up to the CU DIE into SCOPES,
+   which must have room for the depth of NODE plus one.  */
+extern void __libdw_scope_chain (struct libdw_scope_index *index,
+				 unsigned int node, Dwarf_Die *scopes)
+  __nonnull_attribute__ (1, 3) internal_function;
+
 /* Parse a DWARF Dwarf_Block into an array of Dwarf_Op's,
    and cache the result (via tsearch).  */
 extern int __libdw_intern_expression (Dwarf *dbg,
@@ -746,13 +891,24 @@ void __libdw_empty_loc_attr (Dwarf_Attribute *attr)
    DW_AT_comp_dir or NULL if that attribute is not available.  Caches
    the loaded unit and optionally set *LINESP and/or *FILESP (if not
    NULL) with loaded information.  Returns 0 for success or a negative
-   value for failure.  */
+   value for failure.  The caller must hold DBG's lock for writing.  */
 int __libdw_getsrclines (Dwarf *dbg, Dwarf_Off debug_line_offset,
 			 const char *comp_dir, unsigned address_size,
 			 Dwarf_Lines **linesp, Dwarf_Files **filesp)
   internal_function
   __nonnull_attribute__ (1);
 
+/* Get the line table and the source files of the CU of CUDIE, loading
+   them on first use.  Optionally set *LINESP and/or *FILESP.  Returns 0
+   for success or a negative value for failure.  */
+int __libdw_getcu_srclines (Dwarf_Die *cudie, Dwarf_Lines **linesp,
+			    Dwarf_Files **filesp)
+  internal_function;
+
+/* Free the name index built by dwarf_lookup_name.  */
+void __libdw_name_index_free (struct libdw_name_index *index)
+  internal_function;
+
 /* Load and return value of DW_AT_comp_dir from CUDIE.  */
 const char *__libdw_getcompdir (Dwarf_Die *cudie);
 
@@ -780,12 +936,15 @@ INTDECL (dwarf_getarange_addr)
 INTDECL (dwarf_getarangeinfo)
 INTDECL (dwarf_getaranges)
 INTDECL (dwarf_getlocation_die)
+INTDECL (dwarf_getscopes)
+INTDECL (dwarf_getscopes_die)
 INTDECL (dwarf_getsrcfiles)
 INTDECL (dwarf_getsrclines)
 INTDECL (dwarf_hasattr)
 INTDECL (dwarf_haschildren)
 INTDECL (dwarf_haspc)
 INTDECL (dwarf_highpc)
+INTDECL (dwarf_index_units)
 INTDECL (dwarf_lowpc)
 INTDECL (dwarf_nextcu)
 INTDECL (dwarf_next_unit)
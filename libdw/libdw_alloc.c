@@ -38,6 +38,164 @@
 #include "system.h"
 
 
+#ifdef USE_LOCKS
+/* Index into Dwarf.mem_tails of the current thread, assigned on its
+   first allocation from any Dwarf.  The ids of threads that exited are
+   given out again, so the arrays only grow with the number of threads
+   running at the same time.  */
+static __thread size_t thread_id = (size_t) -1;
+static size_t next_id;
+static size_t *free_ids;
+static size_t nfree_ids;
+static size_t free_ids_alloc;
+static pthread_mutex_t id_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t id_key;
+static bool id_key_valid;
+static pthread_once_t id_once = PTHREAD_ONCE_INIT;
+
+/* Serial number of the last Dwarf created, see Dwarf.mem_serial.  */
+static unsigned long int last_serial;
+
+/* The tails the current thread used last, so that most allocations
+   don't need MEM_RWL.  Dwarf objects are told apart by their serial
+   number, since a new one can get the address of one freed.  */
+#define TAIL_CACHE_SIZE 4
+static __thread struct
+{
+  unsigned long int serial;
+  struct libdw_memblock **tailp;
+} tail_cache[TAIL_CACHE_SIZE];
+static __thread unsigned int tail_cache_next;
+
+/* Placeholder tail of threads that didn't allocate yet.  It has no
+   room, so the first allocation always goes to __libdw_allocate.  */
+static struct libdw_memblock empty_memblock;
+
+static void
+release_id (void *arg)
+{
+  size_t id = (uintptr_t) arg - 1;
+
+  pthread_mutex_lock (&id_lock);
+  if (nfree_ids == free_ids_alloc)
+    {
+      size_t newalloc = 2 * free_ids_alloc + 16;
+      size_t *newids = realloc (free_ids, newalloc * sizeof newids[0]);
+      if (newids != NULL)
+	{
+	  free_ids = newids;
+	  free_ids_alloc = newalloc;
+	}
+    }
+  /* If there is no memory the id is just not used again.  */
+  if (nfree_ids < free_ids_alloc)
+    free_ids[nfree_ids++] = id;
+  pthread_mutex_unlock (&id_lock);
+}
+
+static void
+init_id_key (void)
+{
+  id_key_valid = pthread_key_create (&id_key, release_id) == 0;
+}
+
+static size_t
+get_thread_id (void)
+{
+  if (likely (thread_id != (size_t) -1))
+    return thread_id;
+
+  pthread_once (&id_once, init_id_key);
+
+  pthread_mutex_lock (&id_lock);
+  thread_id = nfree_ids > 0 ? free_ids[--nfree_ids] : next_id++;
+  pthread_mutex_unlock (&id_lock);
+
+  /* The key's destructor gives the id back when the thread exits.  */
+  if (id_key_valid)
+    pthread_setspecific (id_key, (void *) (uintptr_t) (thread_id + 1));
+
+  return thread_id;
+}
+
+void
+internal_function
+__libdw_alloc_init (Dwarf *dbg)
+{
+  rwlock_init (dbg->mem_rwl);
+  dbg->mem_serial = __atomic_add_fetch (&last_serial, 1, __ATOMIC_RELAXED);
+}
+
+/* Return where the tail of the current thread's chain in DBG is kept.  */
+static struct libdw_memblock **
+alloc_tailp (Dwarf *dbg)
+{
+  for (unsigned int i = 0; i < TAIL_CACHE_SIZE; ++i)
+    if (tail_cache[i].serial == dbg->mem_serial)
+      return tail_cache[i].tailp;
+
+  size_t id = get_thread_id ();
+
+  rwlock_rdlock (dbg->mem_rwl);
+  struct libdw_memblock **tailp = (id < dbg->mem_stacks
+				   ? dbg->mem_tails[id] : NULL);
+  rwlock_unlock (dbg->mem_rwl);
+
+  if (unlikely (tailp == NULL))
+    {
+      rwlock_wrlock (dbg->mem_rwl);
+
+      /* Another thread might have grown the array in between.  */
+      if (id >= dbg->mem_stacks)
+	{
+	  size_t stacks = MAX (id + 1, 2 * dbg->mem_stacks);
+	  struct libdw_memblock ***tails
+	    = realloc (dbg->mem_tails, stacks * sizeof tails[0]);
+	  if (tails == NULL)
+	    {
+	      rwlock_unlock (dbg->mem_rwl);
+	      dbg->oom_handler ();
+	    }
+	  for (size_t i = dbg->mem_stacks; i < stacks; ++i)
+	    tails[i] = NULL;
+	  dbg->mem_tails = tails;
+	  dbg->mem_stacks = stacks;
+	}
+
+      /* The tail is kept outside the array, so it doesn't move when
+	 the array grows.  An id given out again finds the chain of the
+	 thread that had it and continues it.  */
+      tailp = dbg->mem_tails[id];
+      if (tailp == NULL)
+	{
+	  tailp = calloc (1, sizeof *tailp);
+	  if (tailp == NULL)
+	    {
+	      rwlock_unlock (dbg->mem_rwl);
+	      dbg->oom_handler ();
+	    }
+	  dbg->mem_tails[id] = tailp;
+	}
+      rwlock_unlock (dbg->mem_rwl);
+    }
+
+  tail_cache[tail_cache_next].serial = dbg->mem_serial;
+  tail_cache[tail_cache_next].tailp = tailp;
+  tail_cache_next = (tail_cache_next + 1) % TAIL_CACHE_SIZE;
+
+  return tailp;
+}
+
+struct libdw_memblock *
+internal_function
+__libdw_alloc_tail (Dwarf *dbg)
+{
+  /* Only this thread ever touches its own tail.  */
+  return *alloc_tailp (dbg) ?: &empty_memblock;
+}
+#endif
+
+
 void *
 __libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
 {
@@ -53,8 +211,14 @@ __libdw_allocate (Dwarf *dbg, size_t minsize, size_t align)
   newp->size = size - offsetof (struct libdw_memblock, mem);
   newp->remaining = (uintptr_t) newp + size - (result + minsize);
 
+#ifdef USE_LOCKS
+  struct libdw_memblock **tailp = alloc_tailp (dbg);
+  newp->prev = *tailp;
+  *tailp = newp;
+#else
   newp->prev = dbg->mem_tail;
   dbg->mem_tail = newp;
+#endif
 
   return (void *) result;
 }
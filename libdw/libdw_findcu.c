@@ -32,42 +32,74 @@
 #endif
 
 #include <assert.h>
-#include <search.h>
+#include <stdlib.h>
+#include <system.h>
 #include "libdwP.h"
 
+/* Add CU to the end of INDEX.  */
 static int
-findcu_cb (const void *arg1, const void *arg2)
+unit_index_append (struct libdw_unit_index *index, struct Dwarf_CU *cu)
 {
-  struct Dwarf_CU *cu1 = (struct Dwarf_CU *) arg1;
-  struct Dwarf_CU *cu2 = (struct Dwarf_CU *) arg2;
-
-  /* Find out which of the two arguments is the search value.  It has
-     end offset 0.  */
-  if (cu1->end == 0)
+  if (index->nunits == index->allocated)
     {
-      if (cu1->start < cu2->start)
+      size_t allocated = MAX (64, 2 * index->allocated);
+      Dwarf_Off *starts = realloc (index->starts,
+				   allocated * sizeof starts[0]);
+      if (starts == NULL)
 	return -1;
-      if (cu1->start >= cu2->end)
-	return 1;
-    }
-  else
-    {
-      if (cu2->start < cu1->start)
-	return 1;
-      if (cu2->start >= cu1->end)
+      index->starts = starts;
+
+      struct Dwarf_CU **units = realloc (index->units,
+					 allocated * sizeof units[0]);
+      if (units == NULL)
 	return -1;
+      index->units = units;
+
+      index->allocated = allocated;
     }
 
+  assert (index->nunits == 0
+	  || index->starts[index->nunits - 1] < cu->start);
+  index->starts[index->nunits] = cu->start;
+  index->units[index->nunits] = cu;
+  ++index->nunits;
+
   return 0;
 }
 
+/* Find the unit in INDEX which contains OFFSET.  */
+static struct Dwarf_CU *
+unit_index_find (const struct libdw_unit_index *index, Dwarf_Off offset)
+{
+  /* Find the first unit starting after OFFSET, the one before it is
+     the only candidate.  */
+  const Dwarf_Off *starts = index->starts;
+  size_t l = 0;
+  size_t u = index->nunits;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (offset < starts[idx])
+	u = idx;
+      else
+	l = idx + 1;
+    }
+
+  if (l == 0)
+    return NULL;
+
+  struct Dwarf_CU *cu = index->units[l - 1];
+  return offset < cu->end ? cu : NULL;
+}
+
 struct Dwarf_CU *
 internal_function
 __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
 {
   Dwarf_Off *const offsetp
     = debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
-  void **tree = debug_types ? &dbg->tu_tree : &dbg->cu_tree;
+  struct libdw_unit_index *index
+    = debug_types ? &dbg->tu_index : &dbg->cu_index;
 
   Dwarf_Off oldoff = *offsetp;
   uint16_t version;
@@ -113,22 +145,24 @@ __libdw_intern_next_unit (Dwarf *dbg, bool debug_types)
   newp->orig_abbrev_offset = newp->last_abbrev_offset = abbrev_offset;
   newp->lines = NULL;
   newp->locs = NULL;
-
-  if (debug_types)
-    Dwarf_Sig8_Hash_insert (&dbg->sig8_hash, type_sig8, newp);
+  newp->scope_index = NULL;
 
   newp->startp = data->d_buf + newp->start;
   newp->endp = data->d_buf + newp->end;
 
-  /* Add the new entry to the search tree.  */
-  if (tsearch (newp, tree, findcu_cb) == NULL)
+  /* Add the new entry to the index.  */
+  if (unit_index_append (index, newp) != 0)
     {
       /* Something went wrong.  Undo the operation.  */
+      Dwarf_Abbrev_Hash_free (&newp->abbrev_hash);
       *offsetp = oldoff;
       __libdw_seterrno (DWARF_E_NOMEM);
       return NULL;
     }
 
+  if (debug_types)
+    Dwarf_Sig8_Hash_insert (&dbg->sig8_hash, type_sig8, newp);
+
   return newp;
 }
 
@@ -136,33 +170,45 @@ struct Dwarf_CU *
 internal_function
 __libdw_findcu (Dwarf *dbg, Dwarf_Off start, bool debug_types)
 {
-  void **tree = debug_types ? &dbg->tu_tree : &dbg->cu_tree;
+  struct libdw_unit_index *index
+    = debug_types ? &dbg->tu_index : &dbg->cu_index;
   Dwarf_Off *next_offset
     = debug_types ? &dbg->next_tu_offset : &dbg->next_cu_offset;
 
   /* Maybe we already know that CU.  */
-  struct Dwarf_CU fake = { .start = start, .end = 0 };
-  struct Dwarf_CU **found = tfind (&fake, tree, findcu_cb);
-  if (found != NULL)
-    return *found;
+  rwlock_rdlock (dbg->cu_lock);
+  struct Dwarf_CU *result = unit_index_find (index, start);
+  rwlock_unlock (dbg->cu_lock);
+  if (result != NULL)
+    return result;
 
-  if (start < *next_offset)
-    {
-      __libdw_seterrno (DWARF_E_INVALID_DWARF);
-      return NULL;
-    }
+  rwlock_wrlock (dbg->cu_lock);
 
-  /* No.  Then read more CUs.  */
-  while (1)
+  /* Another thread might have read it in the meantime.  */
+  result = unit_index_find (index, start);
+  if (result == NULL)
     {
-      struct Dwarf_CU *newp = __libdw_intern_next_unit (dbg, debug_types);
-      if (newp == NULL)
-	return NULL;
-
-      /* Is this the one we are looking for?  */
       if (start < *next_offset)
-	// XXX Match exact offset.
-	return newp;
+	__libdw_seterrno (DWARF_E_INVALID_DWARF);
+      else
+	/* No.  Then read more CUs.  */
+	while (1)
+	  {
+	    struct Dwarf_CU *newp = __libdw_intern_next_unit (dbg,
+							      debug_types);
+	    if (newp == NULL)
+	      break;
+
+	    /* Is this the one we are looking for?  */
+	    if (start < *next_offset)
+	      {
+		// XXX Match exact offset.
+		result = newp;
+		break;
+	      }
+	  }
     }
-  /* NOTREACHED */
+
+  rwlock_unlock (dbg->cu_lock);
+  return result;
 }
@@ -0,0 +1,379 @@
+/* Index of the scopes of a CU by address.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "libdwP.h"
+#include <dwarf.h>
+
+
+/* A range while building the index, before they are grouped by
+   parent.  */
+struct build_range
+{
+  Dwarf_Addr low;
+  Dwarf_Addr high;
+  unsigned int parent;
+  unsigned int node;
+};
+
+struct builder
+{
+  struct libdw_scope_node *nodes;
+  size_t nnodes;
+  size_t nodes_alloc;
+  struct build_range *ranges;
+  size_t nranges;
+  size_t ranges_alloc;
+};
+
+static bool
+add_range (struct builder *b, unsigned int parent, Dwarf_Addr low,
+	   Dwarf_Addr high)
+{
+  if (b->nranges == b->ranges_alloc)
+    {
+      size_t alloc = b->ranges_alloc == 0 ? 64 : 2 * b->ranges_alloc;
+      struct build_range *ranges = realloc (b->ranges,
+					    alloc * sizeof ranges[0]);
+      if (ranges == NULL)
+	return false;
+      b->ranges = ranges;
+      b->ranges_alloc = alloc;
+    }
+
+  /* The node is the one added next.  */
+  b->ranges[b->nranges++] = (struct build_range)
+    { .low = low, .high = high, .parent = parent, .node = b->nnodes };
+  return true;
+}
+
+static bool
+add_node (struct builder *b, Dwarf_Die *die, unsigned int parent)
+{
+  if (b->nnodes == b->nodes_alloc)
+    {
+      size_t alloc = b->nodes_alloc == 0 ? 64 : 2 * b->nodes_alloc;
+      if (alloc > (unsigned int) -1)
+	return false;
+      struct libdw_scope_node *nodes = realloc (b->nodes,
+						alloc * sizeof nodes[0]);
+      if (nodes == NULL)
+	return false;
+      b->nodes = nodes;
+      b->nodes_alloc = alloc;
+    }
+
+  struct libdw_scope_node *node = &b->nodes[b->nnodes++];
+  node->die = *die;
+  node->parent = parent;
+  node->depth = b->nnodes == 1 ? 0 : b->nodes[parent].depth + 1;
+  node->first_range = 0;
+  node->nranges = 0;
+  return true;
+}
+
+static int add_children (struct builder *b, Dwarf_Die *die,
+			 unsigned int parent, struct Dwarf_Die_Chain *imports);
+
+/* Add CHILD and its siblings to node PARENT in the order
+   __libdw_visit_scopes walks them.  Returns -1 if the index cannot be
+   built.  */
+static int
+add_siblings (struct builder *b, Dwarf_Die *child, unsigned int parent,
+	      struct Dwarf_Die_Chain *imports)
+{
+  int ret;
+  do
+    {
+      int tag = INTUSE(dwarf_tag) (child);
+
+      /* The children of an imported unit are walked in its place.  */
+      if (tag == DW_TAG_imported_unit)
+	{
+	  Dwarf_Attribute attr_mem;
+	  Dwarf_Attribute *attr = INTUSE(dwarf_attr) (child, DW_AT_import,
+						      &attr_mem);
+	  Dwarf_Die unit, first;
+	  if (INTUSE(dwarf_formref_die) (attr, &unit) != NULL
+	      && INTUSE(dwarf_child) (&unit, &first) == 0)
+	    {
+	      for (struct Dwarf_Die_Chain *import = imports; import != NULL;
+		   import = import->parent)
+		if (import->die.addr == child->addr)
+		  return -1;
+
+	      struct Dwarf_Die_Chain import = { .die = *child,
+						.parent = imports };
+	      if (add_siblings (b, &first, parent, &import) != 0)
+		return -1;
+	    }
+	  continue;
+	}
+
+      /* Collect the ranges dwarf_haspc would match.  */
+      Dwarf_Addr base, begin, end;
+      ptrdiff_t offset = 0;
+      while ((offset = INTUSE(dwarf_ranges) (child, offset, &base,
+					     &begin, &end)) > 0)
+	if (! add_range (b, parent, begin, end))
+	  return -1;
+      if (offset < 0)
+	{
+	  int error = INTUSE(dwarf_errno) ();
+	  if (error != DWARF_E_NOERROR && error != DWARF_E_NO_DEBUG_RANGES)
+	    return -1;
+	}
+
+      unsigned int node = b->nnodes;
+      if (! add_node (b, child, parent))
+	return -1;
+
+      if (__libdw_may_have_scopes (child) && INTUSE(dwarf_haschildren) (child)
+	  && add_children (b, child, node, imports) != 0)
+	return -1;
+    }
+  while ((ret = INTUSE(dwarf_siblingof) (child, child)) == 0);
+
+  return ret < 0 ? -1 : 0;
+}
+
+static int
+add_children (struct builder *b, Dwarf_Die *die, unsigned int parent,
+	      struct Dwarf_Die_Chain *imports)
+{
+  Dwarf_Die child;
+  int ret = INTUSE(dwarf_child) (die, &child);
+  if (ret != 0)
+    return ret < 0 ? -1 : 0;
+  return add_siblings (b, &child, parent, imports);
+}
+
+static int
+compare_build_ranges (const void *a, const void *b)
+{
+  const struct build_range *r1 = a;
+  const struct build_range *r2 = b;
+  if (r1->parent != r2->parent)
+    return r1->parent < r2->parent ? -1 : 1;
+  if (r1->low != r2->low)
+    return r1->low < r2->low ? -1 : 1;
+  return r1->node < r2->node ? -1 : r1->node > r2->node;
+}
+
+/* A node keyed by its DIE, to sort them for __libdw_scope_find_die.  */
+struct die_node
+{
+  void *addr;
+  unsigned int node;
+};
+
+static int
+compare_die_nodes (const void *a, const void *b)
+{
+  const struct die_node *d1 = a;
+  const struct die_node *d2 = b;
+  if (d1->addr != d2->addr)
+    return d1->addr < d2->addr ? -1 : 1;
+  return d1->node < d2->node ? -1 : d1->node > d2->node;
+}
+
+static struct libdw_scope_index *
+build_index (struct Dwarf_CU *cu)
+{
+  struct builder b = { .nodes = NULL };
+  struct die_node *by_addr = NULL;
+  Dwarf_Die cudie = CUDIE (cu);
+  struct libdw_scope_index *index = NULL;
+  if (! add_node (&b, &cudie, 0)
+      || add_children (&b, &cudie, 0, NULL) != 0)
+    goto out;
+
+  by_addr = malloc (b.nnodes * sizeof by_addr[0]);
+  if (by_addr == NULL)
+    goto out;
+  for (unsigned int i = 0; i < b.nnodes; ++i)
+    by_addr[i] = (struct die_node) { .addr = b.nodes[i].die.addr, .node = i };
+  qsort (by_addr, b.nnodes, sizeof by_addr[0], compare_die_nodes);
+
+  /* Group the ranges by parent, sorted by address.  */
+  qsort (b.ranges, b.nranges, sizeof b.ranges[0], compare_build_ranges);
+
+  Dwarf *dbg = cu->dbg;
+  index = libdw_typed_alloc (dbg, struct libdw_scope_index);
+  index->nnodes = b.nnodes;
+  index->nodes = libdw_alloc (dbg, struct libdw_scope_node,
+			      sizeof (struct libdw_scope_node), b.nnodes);
+  memcpy (index->nodes, b.nodes, b.nnodes * sizeof b.nodes[0]);
+  index->by_addr = libdw_alloc (dbg, unsigned int, sizeof (unsigned int),
+				b.nnodes);
+  for (unsigned int i = 0; i < b.nnodes; ++i)
+    index->by_addr[i] = by_addr[i].node;
+  index->ranges = libdw_alloc (dbg, struct libdw_scope_range,
+			       sizeof (struct libdw_scope_range),
+			       b.nranges ?: 1);
+  for (size_t i = 0; i < b.nranges; ++i)
+    {
+      struct libdw_scope_range *range = &index->ranges[i];
+      struct libdw_scope_node *parent = &index->nodes[b.ranges[i].parent];
+      range->low = b.ranges[i].low;
+      range->high = b.ranges[i].high;
+      range->node = b.ranges[i].node;
+
+      /* MAX_HIGH is the highest end of the parent's ranges so far.  */
+      if (parent->nranges == 0)
+	{
+	  parent->first_range = i;
+	  range->max_high = range->high;
+	}
+      else
+	range->max_high = (range->high > range[-1].max_high
+			   ? range->high : range[-1].max_high);
+      parent->nranges++;
+    }
+
+ out:
+  free (by_addr);
+  free (b.nodes);
+  free (b.ranges);
+  return index;
+}
+
+struct libdw_scope_index *
+internal_function
+__libdw_scope_index (struct Dwarf_CU *cu)
+{
+  Dwarf *dbg = cu->dbg;
+  rwlock_rdlock (dbg->lock);
+  struct libdw_scope_index *index = cu->scope_index;
+  rwlock_unlock (dbg->lock);
+
+  if (index == NULL)
+    {
+      /* Build it without the lock, the DIE functions take it.  Another
+	 thread might install its own index first, then ours is wasted.  */
+      struct libdw_scope_index *built = build_index (cu);
+
+      rwlock_wrlock (dbg->lock);
+      if (cu->scope_index == NULL)
+	cu->scope_index = built ?: (void *) -1l;
+      index = cu->scope_index;
+      rwlock_unlock (dbg->lock);
+    }
+
+  return index == (void *) -1l ? NULL : index;
+}
+
+unsigned int
+internal_function
+__libdw_scope_find_pc (struct libdw_scope_index *index, Dwarf_Addr pc)
+{
+  /* Like __libdw_visit_scopes pruned by dwarf_haspc, descend into the
+     first child containing PC until there is none.  */
+  unsigned int node = 0;
+  while (1)
+    {
+      const struct libdw_scope_node *n = &index->nodes[node];
+      const struct libdw_scope_range *ranges = &index->ranges[n->first_range];
+
+      /* Find the ranges starting at or before PC.  Going back from the
+	 last of them, MAX_HIGH tells when no earlier one can contain PC.  */
+      size_t l = 0, u = n->nranges;
+      while (l < u)
+	{
+	  size_t idx = (l + u) / 2;
+	  if (ranges[idx].low <= pc)
+	    l = idx + 1;
+	  else
+	    u = idx;
+	}
+
+      unsigned int best = 0;
+      while (l-- > 0 && ranges[l].max_high > pc)
+	if (pc < ranges[l].high && (best == 0 || ranges[l].node < best))
+	  best = ranges[l].node;
+
+      if (best == 0)
+	return node;
+      node = best;
+    }
+}
+
+unsigned int
+internal_function
+__libdw_scope_find_die (struct libdw_scope_index *index, Dwarf_Die *die,
+			unsigned int within)
+{
+  /* Find the first node for DIE.  */
+  size_t l = 0, u = index->nnodes;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (index->nodes[index->by_addr[idx]].die.addr < die->addr)
+	l = idx + 1;
+      else
+	u = idx;
+    }
+
+  /* A DIE in an imported unit can appear more than once.  Take the
+     first one below WITHIN.  */
+  unsigned int depth = index->nodes[within].depth;
+  for (; l < index->nnodes; ++l)
+    {
+      unsigned int node = index->by_addr[l];
+      if (index->nodes[node].die.addr != die->addr)
+	break;
+
+      unsigned int parent = node;
+      while (index->nodes[parent].depth > depth)
+	parent = index->nodes[parent].parent;
+      if (parent == within && node != within)
+	return node;
+    }
+
+  return 0;
+}
+
+void
+internal_function
+__libdw_scope_chain (struct libdw_scope_index *index, unsigned int node,
+		     Dwarf_Die *scopes)
+{
+  unsigned int i = 0;
+  while (1)
+    {
+      scopes[i++] = index->nodes[node].die;
+      if (node == 0)
+	break;
+      node = index->nodes[node].parent;
+    }
+}
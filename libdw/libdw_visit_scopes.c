@@ -34,8 +34,9 @@
 #include <dwarf.h>
 
 
-static bool
-may_have_scopes (Dwarf_Die *die)
+bool
+internal_function
+__libdw_may_have_scopes (Dwarf_Die *die)
 {
   switch (INTUSE(dwarf_tag) (die))
     {
@@ -166,7 +167,7 @@ walk_children (struct walk_children_state *state)
 	if (result != DWARF_CB_OK)
 	  return result;
 
-	if (!state->child.prune && may_have_scopes (&state->child.die)
+	if (!state->child.prune && __libdw_may_have_scopes (&state->child.die)
 	    && INTUSE(dwarf_haschildren) (&state->child.die))
 	  {
 	    result = __libdw_visit_scopes (state->depth + 1, &state->child, state->imports,
@@ -47,28 +47,25 @@ struct Dwelf_Strent
 {
   const char *string;
   size_t len;
-  struct Dwelf_Strent *next;
-  struct Dwelf_Strent *left;
-  struct Dwelf_Strent *right;
   size_t offset;
-  char reverse[0];
 };
 
 
+/* The entries are allocated in blocks, so their addresses don't
+   change while more strings are added.  */
 struct memoryblock
 {
   struct memoryblock *next;
-  char memory[0];
+  size_t nentries;
+  Dwelf_Strent entries[0];
 };
 
 
 struct Dwelf_Strtab
 {
-  struct Dwelf_Strent *root;
   struct memoryblock *memory;
-  char *backp;
   size_t left;
-  size_t total;
+  size_t nstrings;
   bool nullstr;
 
   struct Dwelf_Strent null;
@@ -109,22 +106,27 @@ dwelf_strtab_init (bool nullstr)
 
 
 static int
-morememory (Dwelf_Strtab *st, size_t len)
+morememory (Dwelf_Strtab *st)
 {
-  size_t overhead = offsetof (struct memoryblock, memory);
-  len += overhead + MALLOC_OVERHEAD;
-
-  /* Allocate nearest multiple of pagesize >= len.  */
-  len = ((len / ps) + (len % ps != 0)) * ps - MALLOC_OVERHEAD;
+  /* Every block is twice as big as the one before, up to 256 pages.  */
+  size_t overhead = offsetof (struct memoryblock, entries);
+  size_t len = ps;
+  if (st->memory != NULL)
+    {
+      len = 2 * (overhead + MALLOC_OVERHEAD
+		 + st->memory->nentries * sizeof (Dwelf_Strent));
+      len = MIN (((len / ps) + (len % ps != 0)) * ps, 256 * ps);
+    }
+  len -= MALLOC_OVERHEAD;
 
   struct memoryblock *newmem = (struct memoryblock *) malloc (len);
   if (newmem == NULL)
     return 1;
 
   newmem->next = st->memory;
+  newmem->nentries = 0;
   st->memory = newmem;
-  st->backp = newmem->memory;
-  st->left = len - overhead;
+  st->left = (len - overhead) / sizeof (Dwelf_Strent);
 
   return 0;
 }
@@ -146,69 +148,8 @@ dwelf_strtab_free (Dwelf_Strtab *st)
 }
 
 
-static Dwelf_Strent *
-newstring (Dwelf_Strtab *st, const char *str, size_t len)
-{
-  /* Compute the amount of padding needed to make the structure aligned.  */
-  size_t align = ((__alignof__ (struct Dwelf_Strent)
-		   - (((uintptr_t) st->backp)
-		      & (__alignof__ (struct Dwelf_Strent) - 1)))
-		  & (__alignof__ (struct Dwelf_Strent) - 1));
-
-  /* Make sure there is enough room in the memory block.  */
-  if (st->left < align + sizeof (struct Dwelf_Strent) + len)
-    {
-      if (morememory (st, sizeof (struct Dwelf_Strent) + len))
-	return NULL;
-
-      align = 0;
-    }
-
-  /* Create the reserved string.  */
-  Dwelf_Strent *newstr = (Dwelf_Strent *) (st->backp + align);
-  newstr->string = str;
-  newstr->len = len;
-  newstr->next = NULL;
-  newstr->left = NULL;
-  newstr->right = NULL;
-  newstr->offset = 0;
-  for (int i = len - 2; i >= 0; --i)
-    newstr->reverse[i] = str[len - 2 - i];
-  newstr->reverse[len - 1] = '\0';
-  st->backp += align + sizeof (struct Dwelf_Strent) + len;
-  st->left -= align + sizeof (struct Dwelf_Strent) + len;
-
-  return newstr;
-}
-
-
-/* XXX This function should definitely be rewritten to use a balancing
-   tree algorith (AVL, red-black trees).  For now a simple, correct
-   implementation is enough.  */
-static Dwelf_Strent **
-searchstring (Dwelf_Strent **sep, Dwelf_Strent *newstr)
-{
-  /* More strings?  */
-  if (*sep == NULL)
-    {
-      *sep = newstr;
-      return sep;
-    }
-
-  /* Compare the strings.  */
-  int cmpres = memcmp ((*sep)->reverse, newstr->reverse,
-		       MIN ((*sep)->len, newstr->len) - 1);
-  if (cmpres == 0)
-    /* We found a matching string.  */
-    return sep;
-  else if (cmpres > 0)
-    return searchstring (&(*sep)->left, newstr);
-  else
-    return searchstring (&(*sep)->right, newstr);
-}
-
-
-/* Add new string.  The actual string is assumed to be permanent.  */
+/* Add new string.  The actual string is assumed to be permanent.
+   Strings are only merged when the table is finalized.  */
 static Dwelf_Strent *
 strtab_add (Dwelf_Strtab *st, const char *str, size_t len)
 {
@@ -217,63 +158,16 @@ strtab_add (Dwelf_Strtab *st, const char *str, size_t len)
   if (len == 1 && st->null.string != NULL)
     return &st->null;
 
-  /* Allocate memory for the new string and its associated information.  */
-  Dwelf_Strent *newstr = newstring (st, str, len);
-  if (newstr == NULL)
+  /* Make sure there is enough room in the memory block.  */
+  if (st->left == 0 && morememory (st))
     return NULL;
 
-  /* Search in the array for the place to insert the string.  If there
-     is no string with matching prefix and no string with matching
-     leading substring, create a new entry.  */
-  Dwelf_Strent **sep = searchstring (&st->root, newstr);
-  if (*sep != newstr)
-    {
-      /* This is not the same entry.  This means we have a prefix match.  */
-      if ((*sep)->len > newstr->len)
-	{
-	  /* Check whether we already know this string.  */
-	  for (Dwelf_Strent *subs = (*sep)->next; subs != NULL;
-	       subs = subs->next)
-	    if (subs->len == newstr->len)
-	      {
-		/* We have an exact match with a substring.  Free the memory
-		   we allocated.  */
-		st->left += st->backp - (char *) newstr;
-		st->backp = (char *) newstr;
-
-		return subs;
-	      }
-
-	  /* We have a new substring.  This means we don't need the reverse
-	     string of this entry anymore.  */
-	  st->backp -= newstr->len;
-	  st->left += newstr->len;
-
-	  newstr->next = (*sep)->next;
-	  (*sep)->next = newstr;
-	}
-      else if ((*sep)->len != newstr->len)
-	{
-	  /* When we get here it means that the string we are about to
-	     add has a common prefix with a string we already have but
-	     it is longer.  In this case we have to put it first.  */
-	  st->total += newstr->len - (*sep)->len;
-	  newstr->next = *sep;
-	  newstr->left = (*sep)->left;
-	  newstr->right = (*sep)->right;
-	  *sep = newstr;
-	}
-      else
-	{
-	  /* We have an exact match.  Free the memory we allocated.  */
-	  st->left += st->backp - (char *) newstr;
-	  st->backp = (char *) newstr;
-
-	  newstr = *sep;
-	}
-    }
-  else
-    st->total += newstr->len;
+  Dwelf_Strent *newstr = &st->memory->entries[st->memory->nentries++];
+  newstr->string = str;
+  newstr->len = len;
+  newstr->offset = 0;
+  st->left--;
+  st->nstrings++;
 
   return newstr;
 }
@@ -290,26 +184,109 @@ dwelf_strtab_add_len (Dwelf_Strtab *st, const char *str, size_t len)
   return strtab_add (st, str, len);
 }
 
-static void
-copystrings (Dwelf_Strent *nodep, char **freep, size_t *offsetp)
+
+/* The character DEPTH places before the zero terminator of SE, or -1
+   if the string is shorter.  */
+static inline int
+revchar (const Dwelf_Strent *se, size_t depth)
 {
-  if (nodep->left != NULL)
-    copystrings (nodep->left, freep, offsetp);
+  if (depth + 1 >= se->len)
+    return -1;
+  return (unsigned char) se->string[se->len - 2 - depth];
+}
 
-  /* Process the current node.  */
-  nodep->offset = *offsetp;
-  *freep = (char *) mempcpy (*freep, nodep->string, nodep->len);
-  *offsetp += nodep->len;
+/* Whether A is at the end of B, including the zero terminator.  */
+static inline bool
+is_suffix (const Dwelf_Strent *a, const Dwelf_Strent *b)
+{
+  return (a->len <= b->len
+	  && memcmp (a->string, b->string + b->len - a->len, a->len) == 0);
+}
 
-  for (Dwelf_Strent *subs = nodep->next; subs != NULL; subs = subs->next)
+static void
+swap_strents (Dwelf_Strent **a, Dwelf_Strent **b)
+{
+  Dwelf_Strent *tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+/* Sort the N strings in STRS by their reversed strings, shorter
+   strings before the longer ones ending in them, using a three way
+   radix quicksort.  The first DEPTH reversed characters of all strings
+   are already known to be equal.  */
+static void
+sort_strents (Dwelf_Strent **strs, size_t n, size_t depth)
+{
+  while (n > 1)
     {
-      assert (subs->len < nodep->len);
-      subs->offset = nodep->offset + nodep->len - subs->len;
-      assert (subs->offset != 0 || subs->string[0] == '\0');
-    }
+      if (n < 16)
+	{
+	  /* Insertion sort for small sets, comparing the remainders.  */
+	  for (size_t i = 1; i < n; ++i)
+	    for (size_t j = i; j > 0; --j)
+	      {
+		size_t d = depth;
+		int ca, cb;
+		while ((ca = revchar (strs[j - 1], d))
+		       == (cb = revchar (strs[j], d)) && ca != -1)
+		  ++d;
+		if (ca <= cb)
+		  break;
+		swap_strents (&strs[j - 1], &strs[j]);
+	      }
+	  return;
+	}
+
+      /* Partition around the median of three characters into the
+	 strings with a smaller, the same and a bigger character.  */
+      int a = revchar (strs[0], depth);
+      int b = revchar (strs[n / 2], depth);
+      int c = revchar (strs[n - 1], depth);
+      int pivot = (a < b ? (b < c ? b : (a < c ? c : a))
+		   : (a < c ? a : (b < c ? c : b)));
 
-  if (nodep->right != NULL)
-    copystrings (nodep->right, freep, offsetp);
+      size_t lt = 0, i = 0, gt = n;
+      while (i < gt)
+	{
+	  int ch = revchar (strs[i], depth);
+	  if (ch < pivot)
+	    swap_strents (&strs[lt++], &strs[i++]);
+	  else if (ch > pivot)
+	    swap_strents (&strs[i], &strs[--gt]);
+	  else
+	    ++i;
+	}
+
+      /* The strings with the pivot character continue with the next
+	 character, unless they ended and so are all equal.  */
+      struct
+      {
+	Dwelf_Strent **strs;
+	size_t n;
+	size_t depth;
+      } part[3] =
+	{
+	  { strs, lt, depth },
+	  { strs + lt, pivot == -1 ? 0 : gt - lt, depth + 1 },
+	  { strs + gt, n - gt, depth }
+	};
+
+      /* Recurse only on the smaller parts, each at most half of the
+	 strings, and loop on the largest, so the stack stays
+	 logarithmic in the number of strings.  */
+      size_t largest = 0;
+      for (size_t k = 1; k < 3; ++k)
+	if (part[k].n > part[largest].n)
+	  largest = k;
+      for (size_t k = 0; k < 3; ++k)
+	if (k != largest)
+	  sort_strents (part[k].strs, part[k].n, part[k].depth);
+
+      strs = part[largest].strs;
+      n = part[largest].n;
+      depth = part[largest].depth;
+    }
 }
 
 
@@ -318,10 +295,42 @@ dwelf_strtab_finalize (Dwelf_Strtab *st, Elf_Data *data)
 {
   size_t nulllen = st->nullstr ? 1 : 0;
 
+  /* Sorted by their reversed strings every string that is the end of
+     another string comes right before a string it is the end of.  */
+  Dwelf_Strent **strs = malloc ((st->nstrings ?: 1) * sizeof strs[0]);
+  if (strs == NULL)
+    {
+      data->d_buf = NULL;
+      return NULL;
+    }
+
+  size_t n = 0;
+  for (struct memoryblock *mb = st->memory; mb != NULL; mb = mb->next)
+    for (size_t i = 0; i < mb->nentries; ++i)
+      strs[n++] = &mb->entries[i];
+  assert (n == st->nstrings);
+
+  sort_strents (strs, n, 0);
+
+  /* Place the strings that aren't the end of the next one, in order.
+     The others are marked to be placed at the end of the next.  */
+  size_t total = nulllen;
+  for (size_t i = 0; i < n; ++i)
+    if (i + 1 < n && is_suffix (strs[i], strs[i + 1]))
+      strs[i]->offset = (size_t) -1;
+    else
+      {
+	strs[i]->offset = total;
+	total += strs[i]->len;
+      }
+
   /* Fill in the information.  */
-  data->d_buf = malloc (st->total + nulllen);
+  data->d_buf = malloc (total);
   if (data->d_buf == NULL)
-    return NULL;
+    {
+      free (strs);
+      return NULL;
+    }
 
   /* The first byte must always be zero if we created the table with a
      null string.  */
@@ -329,19 +338,22 @@ dwelf_strtab_finalize (Dwelf_Strtab *st, Elf_Data *data)
     *((char *) data->d_buf) = '\0';
 
   data->d_type = ELF_T_BYTE;
-  data->d_size = st->total + nulllen;
+  data->d_size = total;
   data->d_off = 0;
   data->d_align = 1;
   data->d_version = EV_CURRENT;
 
-  /* Now run through the tree and add all the string while also updating
-     the offset members of the elfstrent records.  */
-  char *endp = (char *) data->d_buf + nulllen;
-  size_t copylen = nulllen;
-  if (st->root)
-    copystrings (st->root, &endp, &copylen);
-  assert (copylen == st->total + nulllen);
-
+  /* Copy the strings and go backwards to get the offsets of the ones
+     that are the end of the next one.  */
+  for (size_t i = n; i-- > 0; )
+    if (strs[i]->offset == (size_t) -1)
+      strs[i]->offset = (strs[i + 1]->offset + strs[i + 1]->len
+			 - strs[i]->len);
+    else
+      memcpy ((char *) data->d_buf + strs[i]->offset, strs[i]->string,
+	      strs[i]->len);
+
+  free (strs);
   return data;
 }
 
@@ -586,17 +586,13 @@ dwfl_core_file_report (Dwfl *dwfl, Elf *elf, const char *executable)
 	 up with a list in the same order as the link_map chain.  */
       if (mod->next != NULL)
 	{
-	  if (*lastmodp != mod)
-	    {
-	      lastmodp = &dwfl->modulelist;
-	      while (*lastmodp != mod)
-		lastmodp = &(*lastmodp)->next;
-	    }
-	  *lastmodp = mod->next;
-	  mod->next = NULL;
+	  if (lastmodp == &mod->next)
+	    lastmodp = mod->prevp;
+	  dwfl_module_unlink (mod);
 	  while (*lastmodp != NULL)
 	    lastmodp = &(*lastmodp)->next;
-	  *lastmodp = mod;
+	  dwfl_module_link (mod, lastmodp);
+	  dwfl->report_tailp = NULL;
 	}
       lastmodp = &mod->next;
     }
@@ -40,7 +40,7 @@ dwar (Dwfl_Module *mod, unsigned int idx)
 
 
 static Dwfl_Error
-addrarange (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_arange **arange)
+getaranges (Dwfl_Module *mod)
 {
   if (mod->aranges == NULL)
     {
@@ -84,6 +84,16 @@ addrarange (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_arange **arange)
       mod->lazycu += naranges;
     }
 
+  return DWFL_E_NOERROR;
+}
+
+static Dwfl_Error
+addrarange (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_arange **arange)
+{
+  Dwfl_Error error = getaranges (mod);
+  if (unlikely (error != DWFL_E_NOERROR))
+    return error;
+
   /* The address must be inside the module to begin with.  */
   addr = dwfl_deadjust_dwarf_addr (mod, addr);
 
@@ -316,3 +326,56 @@ __libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr, struct dwfl_cu **cu)
   struct dwfl_arange *arange;
   return addrarange (mod, addr, &arange) ?: arangecu (mod, arange, cu);
 }
+
+Dwfl_Error
+internal_function
+__libdwfl_addrcu_next (Dwfl_Module *mod, Dwarf_Addr addr, size_t *hint,
+		       struct dwfl_cu **cu)
+{
+  Dwfl_Error error = getaranges (mod);
+  if (unlikely (error != DWFL_E_NOERROR))
+    return error;
+
+  addr = dwfl_deadjust_dwarf_addr (mod, addr);
+
+  size_t n = mod->naranges;
+  if (n == 0 || addr < dwar (mod, 0)->addr)
+    return DWFL_E_ADDR_OUTOFRANGE;
+
+  /* Search forward from the last range found.  Gallop to bracket ADDR
+     and then bisect, so nearby addresses are cheap and far ones cost
+     no more than a plain binary search.  */
+  size_t idx = *hint;
+  if (idx >= n || addr < dwar (mod, idx)->addr)
+    idx = 0;
+  size_t step = 1;
+  size_t hi = idx + 1;
+  while (hi < n && dwar (mod, hi)->addr <= addr)
+    {
+      idx = hi;
+      step *= 2;
+      hi = idx + step;
+    }
+  if (hi > n)
+    hi = n;
+  while (hi - idx > 1)
+    {
+      size_t mid = idx + (hi - idx) / 2;
+      if (dwar (mod, mid)->addr <= addr)
+	idx = mid;
+      else
+	hi = mid;
+    }
+
+  /* It might be past the last range, see addrarange.  */
+  if (idx == n - 1)
+    {
+      const Dwarf_Arange *last
+	= &mod->dw->aranges->info[mod->dw->aranges->naranges - 1];
+      if (addr > last->addr + last->length)
+	return DWFL_E_ADDR_OUTOFRANGE;
+    }
+
+  *hint = idx;
+  return arangecu (mod, &mod->aranges[idx], cu);
+}
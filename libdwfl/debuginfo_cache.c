@@ -0,0 +1,323 @@
+/* Cache of debuginfo file searches.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include <search.h>
+
+/* What a search for a file found.  */
+struct debuginfo_lookup
+{
+  char *file_name;		/* The file found, or NULL for none.  */
+  bool check;			/* Its CRC has to be checked.  */
+  size_t keylen;
+  char key[];
+};
+
+/* The sorted names in a directory.  */
+struct debuginfo_dir
+{
+  char *name;
+  bool listed;			/* False if it could not be read.  */
+  size_t nfiles;
+  char **files;
+};
+
+struct dwfl_debuginfo_cache
+{
+  void *lookups;		/* tsearch tree of struct debuginfo_lookup.  */
+  void *dirs;			/* tsearch tree of struct debuginfo_dir.  */
+};
+
+static int
+compare_lookups (const void *a, const void *b)
+{
+  const struct debuginfo_lookup *l1 = a;
+  const struct debuginfo_lookup *l2 = b;
+  if (l1->keylen != l2->keylen)
+    return l1->keylen < l2->keylen ? -1 : 1;
+  return memcmp (l1->key, l2->key, l1->keylen);
+}
+
+static int
+compare_dirs (const void *a, const void *b)
+{
+  const struct debuginfo_dir *d1 = a;
+  const struct debuginfo_dir *d2 = b;
+  return strcmp (d1->name, d2->name);
+}
+
+static int
+compare_files (const void *a, const void *b)
+{
+  return strcmp (*(const char **) a, *(const char **) b);
+}
+
+static struct dwfl_debuginfo_cache *
+get_cache (Dwfl *dwfl)
+{
+  if (dwfl->debuginfo_cache == NULL)
+    dwfl->debuginfo_cache = calloc (1, sizeof *dwfl->debuginfo_cache);
+  return dwfl->debuginfo_cache;
+}
+
+char *
+internal_function
+__libdwfl_debuginfo_cache_key (size_t nparts, const char *const parts[],
+			       size_t *keylen)
+{
+  size_t len = 0;
+  for (size_t i = 0; i < nparts; ++i)
+    len += 1 + (parts[i] != NULL ? strlen (parts[i]) + 1 : 0);
+
+  char *key = malloc (len);
+  if (unlikely (key == NULL))
+    return NULL;
+
+  /* Each part is a marker for null or not and the string with its
+     terminator, so no two lists of parts have the same key.  */
+  char *p = key;
+  for (size_t i = 0; i < nparts; ++i)
+    if (parts[i] == NULL)
+      *p++ = 'n';
+    else
+      {
+	*p++ = 's';
+	p = stpcpy (p, parts[i]) + 1;
+      }
+
+  *keylen = len;
+  return key;
+}
+
+bool
+internal_function
+__libdwfl_debuginfo_cache_find (Dwfl *dwfl, const char *key, size_t keylen,
+				const char **file_name, bool *check)
+{
+  if (dwfl->debuginfo_cache == NULL)
+    return false;
+
+  struct debuginfo_lookup *lookup = malloc (sizeof *lookup + keylen);
+  if (unlikely (lookup == NULL))
+    return false;
+  lookup->keylen = keylen;
+  memcpy (lookup->key, key, keylen);
+
+  struct debuginfo_lookup **found = tfind (lookup,
+					   &dwfl->debuginfo_cache->lookups,
+					   compare_lookups);
+  free (lookup);
+  if (found == NULL)
+    return false;
+
+  *file_name = (*found)->file_name;
+  if (check != NULL)
+    *check = (*found)->check;
+  return true;
+}
+
+static void
+cache_add (Dwfl *dwfl, const char *key, size_t keylen,
+	   const char *file_name, bool check)
+{
+  struct dwfl_debuginfo_cache *cache = get_cache (dwfl);
+  if (unlikely (cache == NULL))
+    return;
+
+  /* Nothing is lost but time if this fails.  */
+  char *name = NULL;
+  if (file_name != NULL && (name = strdup (file_name)) == NULL)
+    return;
+
+  struct debuginfo_lookup *lookup = malloc (sizeof *lookup + keylen);
+  if (unlikely (lookup == NULL))
+    {
+      free (name);
+      return;
+    }
+  lookup->file_name = name;
+  lookup->check = check;
+  lookup->keylen = keylen;
+  memcpy (lookup->key, key, keylen);
+
+  struct debuginfo_lookup **found = tsearch (lookup, &cache->lookups,
+					     compare_lookups);
+  if (found == NULL || *found != lookup)
+    {
+      /* Replace what an earlier search found.  */
+      if (found != NULL)
+	{
+	  free ((*found)->file_name);
+	  (*found)->file_name = name;
+	  (*found)->check = check;
+	}
+      else
+	free (name);
+      free (lookup);
+    }
+}
+
+void
+internal_function
+__libdwfl_debuginfo_cache_add (Dwfl *dwfl, const char *key, size_t keylen,
+			       const char *file_name, bool check)
+{
+  /* The caller's errno says why the search failed.  */
+  int saved_errno = errno;
+  cache_add (dwfl, key, keylen, file_name, check);
+  errno = saved_errno;
+}
+
+/* Read the names of the files in DIR->name.  */
+static void
+list_dir (struct debuginfo_dir *dir)
+{
+  DIR *d = opendir (dir->name);
+  if (d == NULL)
+    {
+      /* A directory that is not there has no files.  */
+      dir->listed = errno == ENOENT || errno == ENOTDIR;
+      return;
+    }
+
+  size_t max = 0;
+  struct dirent *de;
+  while ((de = readdir (d)) != NULL)
+    {
+      if (dir->nfiles == max)
+	{
+	  max = 2 * max ?: 64;
+	  char **files = realloc (dir->files, max * sizeof files[0]);
+	  if (unlikely (files == NULL))
+	    goto fail;
+	  dir->files = files;
+	}
+      if ((dir->files[dir->nfiles] = strdup (de->d_name)) == NULL)
+	goto fail;
+      ++dir->nfiles;
+    }
+  closedir (d);
+
+  qsort (dir->files, dir->nfiles, sizeof dir->files[0], compare_files);
+  dir->listed = true;
+  return;
+
+ fail:
+  closedir (d);
+  while (dir->nfiles > 0)
+    free (dir->files[--dir->nfiles]);
+  free (dir->files);
+  dir->files = NULL;
+}
+
+static bool
+dir_may_have (Dwfl *dwfl, const char *dir_name, const char *file_name)
+{
+  struct dwfl_debuginfo_cache *cache = get_cache (dwfl);
+  if (unlikely (cache == NULL))
+    return true;
+
+  struct debuginfo_dir key = { .name = (char *) dir_name };
+  struct debuginfo_dir **found = tfind (&key, &cache->dirs, compare_dirs);
+  if (found == NULL)
+    {
+      struct debuginfo_dir *dir = calloc (1, sizeof *dir);
+      if (unlikely (dir == NULL))
+	return true;
+      dir->name = strdup (dir_name);
+      if (unlikely (dir->name == NULL))
+	{
+	  free (dir);
+	  return true;
+	}
+      list_dir (dir);
+      found = tsearch (dir, &cache->dirs, compare_dirs);
+      if (unlikely (found == NULL))
+	{
+	  while (dir->nfiles > 0)
+	    free (dir->files[--dir->nfiles]);
+	  free (dir->files);
+	  free (dir->name);
+	  free (dir);
+	  return true;
+	}
+    }
+
+  const struct debuginfo_dir *dir = *found;
+  return (! dir->listed
+	  || bsearch (&file_name, dir->files, dir->nfiles,
+		      sizeof dir->files[0], compare_files) != NULL);
+}
+
+bool
+internal_function
+__libdwfl_debuginfo_dir_may_have (Dwfl *dwfl, const char *dir_name,
+				  const char *file_name)
+{
+  int saved_errno = errno;
+  bool result = dir_may_have (dwfl, dir_name, file_name);
+  errno = saved_errno;
+  return result;
+}
+
+static void
+free_lookup (void *arg)
+{
+  struct debuginfo_lookup *lookup = arg;
+  free (lookup->file_name);
+  free (lookup);
+}
+
+static void
+free_dir (void *arg)
+{
+  struct debuginfo_dir *dir = arg;
+  for (size_t i = 0; i < dir->nfiles; ++i)
+    free (dir->files[i]);
+  free (dir->files);
+  free (dir->name);
+  free (dir);
+}
+
+void
+internal_function
+__libdwfl_debuginfo_cache_free (Dwfl *dwfl)
+{
+  struct dwfl_debuginfo_cache *cache = dwfl->debuginfo_cache;
+  if (cache == NULL)
+    return;
+
+  tdestroy (cache->lookups, free_lookup);
+  tdestroy (cache->dirs, free_dir);
+  free (cache);
+  dwfl->debuginfo_cache = NULL;
+}
@@ -67,10 +67,55 @@ __libdwfl_open_by_build_id (Dwfl_Module *mod, bool debug, char **file_name,
 	    ".debug");
 
   const Dwfl_Callbacks *const cb = mod->dwfl->callbacks;
-  char *path = strdup ((cb->debuginfo_path ? *cb->debuginfo_path : NULL)
-		       ?: DEFAULT_DEBUGINFO_PATH);
+  const char *debuginfo_path = ((cb->debuginfo_path ? *cb->debuginfo_path
+				 : NULL)
+				?: DEFAULT_DEBUGINFO_PATH);
+
+  /* Unless the path changed, the same search finds the same file.  */
+  size_t keylen;
+  char *key = __libdwfl_debuginfo_cache_key (2, (const char *[])
+					     { debuginfo_path, id_name },
+					     &keylen);
+  const char *cached;
+  if (key != NULL
+      && __libdwfl_debuginfo_cache_find (mod->dwfl, key, keylen,
+					 &cached, NULL))
+    {
+      if (cached == NULL)
+	{
+	  free (key);
+	  errno = 0;
+	  return -1;
+	}
+
+      int fd = TEMP_FAILURE_RETRY (open (cached, O_RDONLY));
+      if (fd >= 0)
+	{
+	  char *name = strdup (cached);
+	  if (unlikely (name == NULL))
+	    {
+	      close (fd);
+	      free (key);
+	      return -1;
+	    }
+	  free (*file_name);
+	  *file_name = name;
+	  free (key);
+	  return fd;
+	}
+    }
+
+  char *path = strdup (debuginfo_path);
   if (path == NULL)
-    return -1;
+    {
+      free (key);
+      return -1;
+    }
+
+  /* The .build-id/NN subdirectory and the file name in it.  */
+  const char id_subdir[3] = { id_name[sizeof "/.build-id/" - 1],
+			      id_name[sizeof "/.build-id/"], '\0' };
+  const char *id_file = &id_name[sizeof "/.build-id/" - 1 + 3];
 
   int fd = -1;
   char *dir;
@@ -90,6 +135,29 @@ __libdwfl_open_by_build_id (Dwfl_Module *mod, bool debug, char **file_name,
 	break;
       memcpy (mempcpy (name, dir, dirlen), id_name, sizeof id_name);
 
+      /* Most processes have many modules, reading the .build-id
+	 directories once is cheaper than trying to open a file that is
+	 not there for each.  */
+      char *slash = &name[dirlen + sizeof "/.build-id" - 1];
+      *slash = '\0';
+      bool may_have = __libdwfl_debuginfo_dir_may_have (mod->dwfl, name,
+							 id_subdir);
+      *slash = '/';
+      if (may_have)
+	{
+	  slash = &name[dirlen + sizeof "/.build-id/" - 1 + 2];
+	  *slash = '\0';
+	  may_have = __libdwfl_debuginfo_dir_may_have (mod->dwfl, name,
+						       id_file);
+	  *slash = '/';
+	}
+      if (! may_have)
+	{
+	  free (name);
+	  errno = ENOENT;
+	  continue;
+	}
+
       fd = TEMP_FAILURE_RETRY (open (name, O_RDONLY));
       if (fd >= 0)
 	{
@@ -114,6 +182,11 @@ __libdwfl_open_by_build_id (Dwfl_Module *mod, bool debug, char **file_name,
   if (fd < 0 && errno == ENOENT)
     errno = 0;
 
+  if (key != NULL && (fd >= 0 || errno == 0))
+    __libdwfl_debuginfo_cache_add (mod->dwfl, key, keylen,
+				   fd >= 0 ? *file_name : NULL, false);
+  free (key);
+
   return fd;
 }
 
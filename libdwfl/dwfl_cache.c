@@ -0,0 +1,1121 @@
+/* Persistent cache of symbol and line lookup data keyed by build ID.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "../libdw/libdwP.h"
+#include <fcntl.h>
+#include <search.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system.h>
+#include <unistd.h>
+
+/* A cache file holds what dwfl_module_addrsym and dwfl_module_getsrc
+   need, so a module can answer them without reading its symbol table
+   or DWARF.  It is written in native byte order when a module is first
+   used and then mapped by later sessions.  All addresses are relative
+   to the module's low_addr, so the file is independent of where the
+   module was loaded.
+
+   The symbol part is the result of dwfl_module_addrsym itself for
+   every address range where it does not change.  The line part is
+   the line table of every CU, and the CU address ranges in the form
+   __libdwfl_addrcu uses, so the answers are the same as those from
+   the DWARF.
+
+   The build ID identifies the main file.  A separate debug file the
+   data came from is identified by its name, size and modification
+   time, and the cache is written again when it changed.  When the data
+   came from the main file alone but it lacks a symbol table or DWARF,
+   a debug file installed later would change the answers.  Then the
+   debug file is looked for every time, and the cache is written again
+   when one is found.  */
+
+#define CACHE_MAGIC	"ELFDWFLC"
+#define CACHE_VERSION	2
+#define CACHE_BYTE_ORDER	0x01020304
+#define CACHE_NONE	((uint32_t) -1)
+
+struct cache_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t span;		/* high_addr - low_addr of the module.  */
+  uint64_t arange_end;		/* Last address covered by the aranges.  */
+  uint32_t has_dwarf;		/* Lines are known.  */
+  uint32_t self_contained;	/* Main file has .symtab and DWARF.  */
+  uint64_t debug_mtime;		/* Of the debug file, in nanoseconds.  */
+  uint64_t debug_size;
+  uint32_t debug_file;		/* Offset in the strings, or CACHE_NONE.  */
+  uint32_t build_id_len;
+  uint32_t nsyms;
+  uint32_t nranges;
+  uint32_t ncus;
+  uint32_t nfiles;
+  uint32_t nlines;
+  uint32_t naranges;
+  uint64_t strings_size;
+
+  /* File offsets of the tables, all 8 byte aligned.  */
+  uint64_t build_id_off;
+  uint64_t syms_off;
+  uint64_t ranges_off;
+  uint64_t cus_off;
+  uint64_t files_off;
+  uint64_t lines_off;
+  uint64_t aranges_off;
+  uint64_t strings_off;
+};
+
+struct cache_sym
+{
+  uint64_t value;
+  uint64_t size;
+  uint32_t name;		/* Offset in the strings.  */
+  uint32_t st_name;
+  uint32_t shndx;
+  uint16_t st_shndx;
+  uint8_t info;
+  uint8_t other;
+};
+
+/* The result of dwfl_module_addrsym from START to the next range.  */
+struct cache_range
+{
+  uint64_t start;
+  uint32_t sym;			/* Index in the symbols, or CACHE_NONE.  */
+  uint32_t pad;
+};
+
+struct cache_cu
+{
+  uint32_t first_file;
+  uint32_t nfiles;
+  uint32_t first_line;
+  uint32_t nlines;
+  uint32_t comp_dir;		/* Offset in the strings, or CACHE_NONE.  */
+  uint32_t pad;
+};
+
+struct cache_file
+{
+  uint64_t mtime;
+  uint64_t length;
+  uint32_t name;
+  uint32_t pad;
+};
+
+struct cache_line
+{
+  uint64_t addr;
+  uint32_t file;		/* Index in the files of its CU.  */
+  int32_t line;
+  uint32_t discriminator;
+  uint16_t column;
+  uint8_t flags;
+  uint8_t op_index;
+  uint8_t isa;
+  uint8_t pad[7];
+};
+
+#define LINE_IS_STMT		0x01
+#define LINE_BASIC_BLOCK	0x02
+#define LINE_END_SEQUENCE	0x04
+#define LINE_PROLOGUE_END	0x08
+#define LINE_EPILOGUE_BEGIN	0x10
+
+/* A run of address ranges of one CU, up to the next run.  */
+struct cache_arange
+{
+  uint64_t start;
+  uint32_t cu;
+  uint32_t pad;
+};
+
+struct dwfl_module_cache
+{
+  void *map;
+  size_t size;
+  const struct cache_header *header;
+  const struct cache_sym *syms;
+  const struct cache_range *ranges;
+  const struct cache_cu *cus;
+  const struct cache_file *files;
+  const struct cache_line *lines;
+  const struct cache_arange *aranges;
+  const char *strings;
+
+  /* CUs made up from the cache data on first use.  */
+  struct cache_dwfl_cu **dwfl_cus;
+};
+
+/* What dwfl_module_getsrc returns lines of.  The Dwarf_CU only holds
+   the lines and files, it has no Dwarf.  */
+struct cache_dwfl_cu
+{
+  struct dwfl_cu cu;
+  struct Dwarf_CU dwarf_cu;
+  const char *comp_dir;
+};
+
+/* What the DIE of a made up CU points to: an abbreviation code that
+   makes libdw treat it as invalid.  */
+static const unsigned char null_die[1];
+
+
+int
+dwfl_set_cache_dir (Dwfl *dwfl, const char *dir)
+{
+  if (dwfl == NULL)
+    return -1;
+
+  char *copy = NULL;
+  if (dir != NULL)
+    {
+      copy = strdup (dir);
+      if (copy == NULL)
+	{
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return -1;
+	}
+    }
+
+  free (dwfl->cache_dir);
+  dwfl->cache_dir = copy;
+  return 0;
+}
+
+static char *
+cache_path (Dwfl_Module *mod)
+{
+  const unsigned char *bits;
+  GElf_Addr vaddr;
+  int len = INTUSE(dwfl_module_build_id) (mod, &bits, &vaddr);
+  if (len == 0)
+    {
+      /* The ID might be in the main file, which is cheap to open.  */
+      Dwarf_Addr bias;
+      if (INTUSE(dwfl_module_getelf) (mod, &bias) != NULL)
+	len = INTUSE(dwfl_module_build_id) (mod, &bits, &vaddr);
+    }
+  if (len <= 0)
+    return NULL;
+
+  size_t dirlen = strlen (mod->dwfl->cache_dir);
+  char *path = malloc (dirlen + 1 + 2 * len + 1);
+  if (path == NULL)
+    return NULL;
+
+  char *p = mempcpy (path, mod->dwfl->cache_dir, dirlen);
+  *p++ = '/';
+  for (int i = 0; i < len; ++i)
+    {
+      static const char hex[] = "0123456789abcdef";
+      *p++ = hex[bits[i] >> 4];
+      *p++ = hex[bits[i] & 0xf];
+    }
+  *p = '\0';
+  return path;
+}
+
+
+/* Whether the table of N entries of SIZE at OFF is inside the file.  */
+static bool
+table_ok (const struct dwfl_module_cache *cache, uint64_t off, uint64_t n,
+	  size_t size)
+{
+  return (off % 8 == 0 && off <= cache->size
+	  && n <= (cache->size - off) / size);
+}
+
+static bool
+string_ok (const struct dwfl_module_cache *cache, uint32_t str)
+{
+  return str < cache->header->strings_size;
+}
+
+static uint64_t
+file_mtime (const struct stat *st)
+{
+  return st->st_mtim.tv_sec * 1000000000ULL + st->st_mtim.tv_nsec;
+}
+
+/* Check everything later lookups rely on.  */
+static bool
+cache_valid (Dwfl_Module *mod, struct dwfl_module_cache *cache)
+{
+  const struct cache_header *h = cache->header;
+  if (cache->size < sizeof *h
+      || memcmp (h->magic, CACHE_MAGIC, sizeof h->magic) != 0
+      || h->version != CACHE_VERSION
+      || h->byte_order != CACHE_BYTE_ORDER
+      || h->span != mod->high_addr - mod->low_addr)
+    return false;
+
+  const unsigned char *bits;
+  GElf_Addr vaddr;
+  int len = INTUSE(dwfl_module_build_id) (mod, &bits, &vaddr);
+  if (len <= 0 || h->build_id_len != (uint32_t) len
+      || ! table_ok (cache, h->build_id_off, len, 1)
+      || memcmp (cache->map + h->build_id_off, bits, len) != 0)
+    return false;
+
+  if (! table_ok (cache, h->syms_off, h->nsyms, sizeof cache->syms[0])
+      || ! table_ok (cache, h->ranges_off, h->nranges,
+		     sizeof cache->ranges[0])
+      || ! table_ok (cache, h->cus_off, h->ncus, sizeof cache->cus[0])
+      || ! table_ok (cache, h->files_off, h->nfiles, sizeof cache->files[0])
+      || ! table_ok (cache, h->lines_off, h->nlines, sizeof cache->lines[0])
+      || ! table_ok (cache, h->aranges_off, h->naranges,
+		     sizeof cache->aranges[0])
+      || ! table_ok (cache, h->strings_off, h->strings_size, 1)
+      || h->strings_size == 0
+      || ((const char *) cache->map)[h->strings_off + h->strings_size - 1]
+	 != '\0')
+    return false;
+
+  cache->syms = cache->map + h->syms_off;
+  cache->ranges = cache->map + h->ranges_off;
+  cache->cus = cache->map + h->cus_off;
+  cache->files = cache->map + h->files_off;
+  cache->lines = cache->map + h->lines_off;
+  cache->aranges = cache->map + h->aranges_off;
+  cache->strings = cache->map + h->strings_off;
+
+  for (uint32_t i = 0; i < h->nsyms; ++i)
+    if (! string_ok (cache, cache->syms[i].name))
+      return false;
+
+  for (uint32_t i = 0; i < h->nranges; ++i)
+    if ((cache->ranges[i].sym != CACHE_NONE
+	 && cache->ranges[i].sym >= h->nsyms)
+	|| (i > 0 && cache->ranges[i].start <= cache->ranges[i - 1].start))
+      return false;
+
+  for (uint32_t i = 0; i < h->ncus; ++i)
+    {
+      const struct cache_cu *cu = &cache->cus[i];
+      if (cu->first_file > h->nfiles || cu->nfiles > h->nfiles - cu->first_file
+	  || cu->first_line > h->nlines
+	  || cu->nlines > h->nlines - cu->first_line
+	  || (cu->comp_dir != CACHE_NONE && ! string_ok (cache, cu->comp_dir)))
+	return false;
+      for (uint32_t l = 0; l < cu->nlines; ++l)
+	if (cache->lines[cu->first_line + l].file >= cu->nfiles)
+	  return false;
+    }
+
+  for (uint32_t i = 0; i < h->nfiles; ++i)
+    if (! string_ok (cache, cache->files[i].name))
+      return false;
+
+  for (uint32_t i = 0; i < h->naranges; ++i)
+    if (cache->aranges[i].cu >= h->ncus)
+      return false;
+
+  /* The debug file must not have changed since.  */
+  if (h->debug_file != CACHE_NONE)
+    {
+      struct stat st;
+      if (! string_ok (cache, h->debug_file)
+	  || stat (cache->strings + h->debug_file, &st) != 0
+	  || (uint64_t) st.st_size != h->debug_size
+	  || file_mtime (&st) != h->debug_mtime)
+	return false;
+    }
+
+  return true;
+}
+
+static struct dwfl_module_cache *
+cache_open (Dwfl_Module *mod, const char *path)
+{
+  int fd = open (path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  struct stat st;
+  struct dwfl_module_cache *cache = NULL;
+  if (fstat (fd, &st) == 0 && st.st_size > 0
+      && (cache = calloc (1, sizeof *cache)) != NULL)
+    {
+      cache->size = st.st_size;
+      cache->map = mmap (NULL, cache->size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (cache->map == MAP_FAILED)
+	{
+	  free (cache);
+	  cache = NULL;
+	}
+    }
+  close (fd);
+  if (cache == NULL)
+    return NULL;
+
+  cache->header = cache->map;
+  if (! cache_valid (mod, cache)
+      || (cache->dwfl_cus = calloc (cache->header->ncus,
+				    sizeof cache->dwfl_cus[0])) == NULL)
+    {
+      munmap (cache->map, cache->size);
+      free (cache);
+      return NULL;
+    }
+
+  return cache;
+}
+
+
+/* Growing table of the cache file being written.  */
+struct table
+{
+  void *data;
+  size_t size;
+  size_t allocated;
+};
+
+static void *
+table_add (struct table *table, size_t size)
+{
+  if (table->size + size > table->allocated)
+    {
+      size_t allocated = 2 * (table->size + size) + 1024;
+      void *data = realloc (table->data, allocated);
+      if (data == NULL)
+	return NULL;
+      table->data = data;
+      table->allocated = allocated;
+    }
+
+  void *p = table->data + table->size;
+  memset (p, 0, size);
+  table->size += size;
+  return p;
+}
+
+struct cache_string
+{
+  uint32_t offset;
+  char str[];
+};
+
+static int
+compare_strings (const void *a, const void *b)
+{
+  return strcmp (((const struct cache_string *) a)->str,
+		 ((const struct cache_string *) b)->str);
+}
+
+struct cache_writer
+{
+  Dwfl_Module *mod;
+  struct table syms, ranges, cus, files, lines, aranges, strings;
+  void *string_tree;
+  uint64_t arange_end;
+  bool failed;
+};
+
+/* Offset of STR in the strings, added if it is new.  */
+static uint32_t
+add_string (struct cache_writer *w, const char *str)
+{
+  if (str == NULL)
+    return CACHE_NONE;
+
+  /* The tree has its own copies of the strings, the table moves.  */
+  size_t len = strlen (str) + 1;
+  struct cache_string *entry = malloc (sizeof *entry + len);
+  if (entry == NULL)
+    {
+      w->failed = true;
+      return 0;
+    }
+  memcpy (entry->str, str, len);
+
+  struct cache_string **found = tsearch (entry, &w->string_tree,
+					 compare_strings);
+  if (found == NULL)
+    {
+      free (entry);
+      w->failed = true;
+      return 0;
+    }
+  if (*found != entry)
+    {
+      free (entry);
+      return (*found)->offset;
+    }
+
+  char *p = table_add (&w->strings, len);
+  if (p == NULL || w->strings.size > CACHE_NONE)
+    {
+      w->failed = true;
+      return 0;
+    }
+  memcpy (p, str, len);
+  entry->offset = p - (char *) w->strings.data;
+  return entry->offset;
+}
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  GElf_Addr l = *(const GElf_Addr *) a;
+  GElf_Addr r = *(const GElf_Addr *) b;
+  return l < r ? -1 : l > r;
+}
+
+static bool
+same_sym (const struct cache_sym *s, const GElf_Sym *sym, GElf_Word shndx,
+	  GElf_Addr low_addr)
+{
+  return (s->value == sym->st_value - low_addr && s->size == sym->st_size
+	  && s->st_name == sym->st_name && s->shndx == shndx
+	  && s->st_shndx == sym->st_shndx && s->info == sym->st_info
+	  && s->other == sym->st_other);
+}
+
+/* Record the dwfl_module_addrsym result of every address range.  */
+static void
+write_syms (struct cache_writer *w)
+{
+  Dwfl_Module *mod = w->mod;
+  GElf_Addr *bounds;
+  ssize_t nbounds = __libdwfl_addrsym_bounds (mod, &bounds);
+  if (nbounds < 0)
+    {
+      w->failed = true;
+      return;
+    }
+
+  /* Only addresses inside the module are answered from the cache.  */
+  size_t n = 0;
+  for (ssize_t i = 0; i < nbounds; ++i)
+    if (bounds[i] > mod->low_addr && bounds[i] < mod->high_addr)
+      bounds[n++] = bounds[i];
+  bounds[n++] = mod->low_addr;
+  qsort (bounds, n, sizeof bounds[0], compare_addr);
+
+  uint32_t last = CACHE_NONE;
+  for (size_t i = 0; i < n && ! w->failed; ++i)
+    {
+      if (i > 0 && bounds[i] == bounds[i - 1])
+	continue;
+
+      GElf_Sym sym;
+      GElf_Word shndx;
+      const char *name = INTUSE(dwfl_module_addrsym) (mod, bounds[i], &sym,
+						      &shndx);
+      uint32_t ndx = CACHE_NONE;
+      if (name != NULL)
+	{
+	  struct cache_sym *syms = w->syms.data;
+	  if (last != CACHE_NONE
+	      && same_sym (&syms[last], &sym, shndx, mod->low_addr)
+	      && strcmp (w->strings.data + syms[last].name, name) == 0)
+	    ndx = last;
+	  else
+	    {
+	      uint32_t str = add_string (w, name);
+	      struct cache_sym *s = table_add (&w->syms, sizeof *s);
+	      if (s == NULL)
+		break;
+	      s->value = sym.st_value - mod->low_addr;
+	      s->size = sym.st_size;
+	      s->name = str;
+	      s->st_name = sym.st_name;
+	      s->shndx = shndx;
+	      s->st_shndx = sym.st_shndx;
+	      s->info = sym.st_info;
+	      s->other = sym.st_other;
+	      ndx = w->syms.size / sizeof *s - 1;
+	    }
+	}
+
+      const struct cache_range *ranges = w->ranges.data;
+      size_t nranges = w->ranges.size / sizeof ranges[0];
+      if (nranges > 0 && ranges[nranges - 1].sym == ndx)
+	continue;
+
+      struct cache_range *r = table_add (&w->ranges, sizeof *r);
+      if (r == NULL)
+	break;
+      r->start = bounds[i] - mod->low_addr;
+      r->sym = ndx;
+      last = ndx;
+    }
+  free (bounds);
+}
+
+/* Record the line table of every CU and the CU address ranges.  */
+static bool
+write_lines (struct cache_writer *w)
+{
+  Dwfl_Module *mod = w->mod;
+  Dwarf_Addr bias;
+  Dwarf *dw = INTUSE(dwfl_module_getdwarf) (mod, &bias);
+  if (dw == NULL)
+    return false;
+
+  /* CU DIE offsets, to find the CUs of the aranges.  */
+  Dwarf_Off *cu_offs = NULL;
+  size_t ncus = 0;
+
+  Dwarf_Off off = 0;
+  Dwarf_Off next;
+  size_t hsize;
+  while (! w->failed
+	 && INTUSE(dwarf_nextcu) (dw, off, &next, &hsize, NULL, NULL,
+				  NULL) == 0)
+    {
+      Dwarf_Die cudie;
+      bool have_cudie = INTUSE(dwarf_offdie) (dw, off + hsize,
+					      &cudie) != NULL;
+      Dwarf_Lines *lines;
+      size_t nlines;
+      Dwarf_Files *files;
+      size_t nfiles;
+      if (! have_cudie
+	  || INTUSE(dwarf_getsrclines) (&cudie, &lines, &nlines) != 0
+	  || INTUSE(dwarf_getsrcfiles) (&cudie, &files, &nfiles) != 0)
+	{
+	  /* Keep the CU so the aranges still find it, without lines.  */
+	  lines = NULL;
+	  nlines = 0;
+	  files = NULL;
+	  nfiles = 0;
+	}
+
+      Dwarf_Off *offs = realloc (cu_offs, (ncus + 1) * sizeof offs[0]);
+      struct cache_cu *cu = table_add (&w->cus, sizeof *cu);
+      if (offs == NULL || cu == NULL)
+	{
+	  free (offs ?: cu_offs);
+	  w->failed = true;
+	  return false;
+	}
+      cu_offs = offs;
+      cu_offs[ncus++] = off + hsize;
+
+      cu->first_file = w->files.size / sizeof (struct cache_file);
+      cu->nfiles = nfiles;
+      cu->first_line = w->lines.size / sizeof (struct cache_line);
+      cu->nlines = nlines;
+      Dwarf_Attribute attr_mem;
+      cu->comp_dir = (! have_cudie ? CACHE_NONE
+		      : add_string (w, INTUSE(dwarf_formstring)
+				    (INTUSE(dwarf_attr) (&cudie,
+							 DW_AT_comp_dir,
+							 &attr_mem))));
+
+      for (size_t i = 0; i < nfiles; ++i)
+	{
+	  uint32_t str = add_string (w, files->info[i].name ?: "???");
+	  struct cache_file *f = table_add (&w->files, sizeof *f);
+	  if (f == NULL)
+	    {
+	      w->failed = true;
+	      break;
+	    }
+	  f->mtime = files->info[i].mtime;
+	  f->length = files->info[i].length;
+	  f->name = str;
+	}
+
+      for (size_t i = 0; i < nlines && ! w->failed; ++i)
+	{
+	  const Dwarf_Line *line = &lines->info[i];
+	  struct cache_line *l = table_add (&w->lines, sizeof *l);
+	  if (l == NULL || line->file >= nfiles)
+	    {
+	      w->failed = true;
+	      break;
+	    }
+	  l->addr = dwfl_adjusted_dwarf_addr (mod, line->addr) - mod->low_addr;
+	  l->file = line->file;
+	  l->line = line->line;
+	  l->discriminator = line->discriminator;
+	  l->column = line->column;
+	  l->flags = ((line->is_stmt ? LINE_IS_STMT : 0)
+		      | (line->basic_block ? LINE_BASIC_BLOCK : 0)
+		      | (line->end_sequence ? LINE_END_SEQUENCE : 0)
+		      | (line->prologue_end ? LINE_PROLOGUE_END : 0)
+		      | (line->epilogue_begin ? LINE_EPILOGUE_BEGIN : 0));
+	  l->op_index = line->op_index;
+	  l->isa = line->isa;
+	}
+
+      off = next;
+    }
+
+  /* One run per CU like in __libdwfl_addrcu.  */
+  Dwarf_Aranges *aranges;
+  size_t naranges;
+  if (! w->failed && INTUSE(dwarf_getaranges) (dw, &aranges, &naranges) == 0)
+    for (size_t i = 0; i < naranges; ++i)
+      {
+	const struct Dwarf_Arange_s *a = &aranges->info[i];
+	if (i > 0 && a->offset == aranges->info[i - 1].offset)
+	  continue;
+
+	size_t l = 0;
+	size_t u = ncus;
+	while (l < u)
+	  {
+	    size_t idx = (l + u) / 2;
+	    if (a->offset < cu_offs[idx])
+	      u = idx;
+	    else if (a->offset > cu_offs[idx])
+	      l = idx + 1;
+	    else
+	      {
+		l = idx;
+		break;
+	      }
+	  }
+	if (l >= ncus || cu_offs[l] != a->offset)
+	  {
+	    w->failed = true;
+	    break;
+	  }
+
+	struct cache_arange *r = table_add (&w->aranges, sizeof *r);
+	if (r == NULL)
+	  {
+	    w->failed = true;
+	    break;
+	  }
+	r->start = dwfl_adjusted_dwarf_addr (mod, a->addr) - mod->low_addr;
+	r->cu = l;
+
+	const struct Dwarf_Arange_s *lastar = &aranges->info[naranges - 1];
+	w->arange_end = (dwfl_adjusted_dwarf_addr (mod, lastar->addr)
+			 + lastar->length - mod->low_addr);
+      }
+  else
+    w->failed = true;
+
+  free (cu_offs);
+  return true;
+}
+
+/* Whether ELF has a .symtab, not just a .dynsym.  */
+static bool
+has_symtab (Elf *elf)
+{
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr != NULL && shdr->sh_type == SHT_SYMTAB)
+	return true;
+    }
+  return false;
+}
+
+static bool
+write_table (int fd, uint64_t *offp, uint64_t *off, const struct table *t)
+{
+  static const char zeroes[8];
+  size_t pad = -*off % 8;
+  if (pad != 0 && write_retry (fd, zeroes, pad) != (ssize_t) pad)
+    return false;
+  *off += pad;
+  *offp = *off;
+  if (t->size != 0 && write_retry (fd, t->data, t->size) != (ssize_t) t->size)
+    return false;
+  *off += t->size;
+  return true;
+}
+
+static void
+cache_write (Dwfl_Module *mod, const char *path)
+{
+  struct cache_writer w = { .mod = mod };
+  struct cache_header h;
+  memset (&h, 0, sizeof h);
+
+  /* The strings are never empty, for the checks when reading.  */
+  add_string (&w, "");
+  write_syms (&w);
+  h.has_dwarf = ! w.failed && write_lines (&w);
+
+  /* Where the symbols and DWARF came from.  */
+  struct stat st;
+  h.debug_file = CACHE_NONE;
+  if (mod->debug.elf != NULL && mod->debug.elf != mod->main.elf)
+    {
+      /* Without a name to check later the cache is not written.  */
+      char *real = (mod->debug.name == NULL ? NULL
+		    : realpath (mod->debug.name, NULL));
+      if (real != NULL && stat (real, &st) == 0)
+	{
+	  h.debug_file = add_string (&w, real);
+	  h.debug_size = st.st_size;
+	  h.debug_mtime = file_mtime (&st);
+	}
+      else
+	w.failed = true;
+      free (real);
+    }
+  else
+    h.self_contained = (h.has_dwarf && mod->symfile == &mod->main
+			&& has_symtab (mod->main.elf));
+  tdestroy (w.string_tree, free);
+
+  int fd = -1;
+  char *tmp = NULL;
+  if (w.failed || asprintf (&tmp, "%s.XXXXXX", path) < 0)
+    goto out;
+
+  fd = mkstemp (tmp);
+  if (fd < 0)
+    goto out;
+
+  const unsigned char *bits;
+  GElf_Addr vaddr;
+  int len = INTUSE(dwfl_module_build_id) (mod, &bits, &vaddr);
+  struct table build_id = { .data = (void *) bits, .size = len };
+
+  memcpy (h.magic, CACHE_MAGIC, sizeof h.magic);
+  h.version = CACHE_VERSION;
+  h.byte_order = CACHE_BYTE_ORDER;
+  h.span = mod->high_addr - mod->low_addr;
+  h.arange_end = w.arange_end;
+  h.build_id_len = len;
+  h.nsyms = w.syms.size / sizeof (struct cache_sym);
+  h.nranges = w.ranges.size / sizeof (struct cache_range);
+  h.ncus = w.cus.size / sizeof (struct cache_cu);
+  h.nfiles = w.files.size / sizeof (struct cache_file);
+  h.nlines = w.lines.size / sizeof (struct cache_line);
+  h.naranges = w.aranges.size / sizeof (struct cache_arange);
+  h.strings_size = w.strings.size;
+
+  /* The header goes first, but its offsets are only known after
+     writing the tables.  */
+  uint64_t off = sizeof h;
+  if (len <= 0
+      || lseek (fd, off, SEEK_SET) != (off_t) off
+      || ! write_table (fd, &h.build_id_off, &off, &build_id)
+      || ! write_table (fd, &h.syms_off, &off, &w.syms)
+      || ! write_table (fd, &h.ranges_off, &off, &w.ranges)
+      || ! write_table (fd, &h.cus_off, &off, &w.cus)
+      || ! write_table (fd, &h.files_off, &off, &w.files)
+      || ! write_table (fd, &h.lines_off, &off, &w.lines)
+      || ! write_table (fd, &h.aranges_off, &off, &w.aranges)
+      || ! write_table (fd, &h.strings_off, &off, &w.strings)
+      || pwrite_retry (fd, &h, sizeof h, 0) != sizeof h
+      || fchmod (fd, 0644) != 0
+      || rename (tmp, path) != 0)
+    unlink (tmp);
+
+ out:
+  if (fd >= 0)
+    close (fd);
+  free (tmp);
+  free (w.syms.data);
+  free (w.ranges.data);
+  free (w.cus.data);
+  free (w.files.data);
+  free (w.lines.data);
+  free (w.aranges.data);
+  free (w.strings.data);
+}
+
+
+/* The module's cache, opening or writing it on first use.  */
+static struct dwfl_module_cache *
+cache_get (Dwfl_Module *mod)
+{
+  if (mod->cache != NULL)
+    return mod->cache;
+  if (mod->cache_tried || mod->dwfl->cache_dir == NULL)
+    return NULL;
+  mod->cache_tried = true;
+
+  char *path = cache_path (mod);
+  if (path == NULL)
+    return NULL;
+
+  /* A missing or unusable cache is written from the module's files,
+     for the next session.  This one uses the files, which are now
+     loaded anyway.  */
+  mod->cache = cache_open (mod, path);
+
+  /* If a debug file could add symbols or DWARF, look for it, as the
+     module would without the cache.  Finding one now makes the cache
+     out of date.  */
+  const struct cache_header *h = mod->cache == NULL ? NULL : mod->cache->header;
+  if (h != NULL && h->debug_file == CACHE_NONE && ! h->self_contained)
+    {
+      Dwarf_Addr bias;
+      (void) INTUSE(dwfl_module_getdwarf) (mod, &bias);
+      (void) INTUSE(dwfl_module_getsymtab) (mod);
+      if (mod->debug.elf != NULL && mod->debug.elf != mod->main.elf)
+	__libdwfl_cache_free (mod);
+    }
+
+  if (mod->cache == NULL)
+    cache_write (mod, path);
+
+  free (path);
+  return mod->cache;
+}
+
+bool
+internal_function
+__libdwfl_cache_addrsym (Dwfl_Module *mod, GElf_Addr addr, GElf_Sym *sym,
+			 GElf_Word *shndxp, const char **name)
+{
+  if (mod->symfile != NULL || mod->symerr != DWFL_E_NOERROR)
+    return false;
+
+  struct dwfl_module_cache *cache = cache_get (mod);
+  if (cache == NULL || mod->symfile != NULL
+      || addr < mod->low_addr || addr >= mod->high_addr)
+    return false;
+
+  const struct cache_header *h = cache->header;
+  GElf_Addr rel = addr - mod->low_addr;
+  size_t l = 0;
+  size_t u = h->nranges;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (rel < cache->ranges[idx].start)
+	u = idx;
+      else
+	l = idx + 1;
+    }
+
+  *name = NULL;
+  if (l == 0 || cache->ranges[l - 1].sym == CACHE_NONE)
+    return true;
+
+  const struct cache_sym *s = &cache->syms[cache->ranges[l - 1].sym];
+  sym->st_name = s->st_name;
+  sym->st_info = s->info;
+  sym->st_other = s->other;
+  sym->st_shndx = s->st_shndx;
+  sym->st_value = s->value + mod->low_addr;
+  sym->st_size = s->size;
+  if (shndxp != NULL)
+    *shndxp = s->shndx;
+  *name = cache->strings + s->name;
+  return true;
+}
+
+static void
+free_dwfl_cu (struct cache_dwfl_cu *cu)
+{
+  if (cu != NULL)
+    {
+      free (cu->cu.lines);
+      free (cu->dwarf_cu.lines);
+      free (cu->dwarf_cu.files);
+      free (cu);
+    }
+}
+
+/* Make up the CU with the lines of cache CU NDX.  */
+static struct cache_dwfl_cu *
+make_dwfl_cu (Dwfl_Module *mod, struct dwfl_module_cache *cache, uint32_t ndx)
+{
+  const struct cache_cu *ccu = &cache->cus[ndx];
+  struct cache_dwfl_cu *cu = calloc (1, sizeof *cu);
+  if (cu == NULL)
+    return NULL;
+
+  Dwarf_Files *files = malloc (offsetof (Dwarf_Files, info[ccu->nfiles]));
+  Dwarf_Lines *lines = malloc (offsetof (Dwarf_Lines, info[ccu->nlines])
+				+ ccu->nlines * sizeof (Dwarf_Addr));
+  struct Dwfl_Lines *dwfl_lines = malloc (offsetof (struct Dwfl_Lines,
+						    idx[ccu->nlines]));
+  cu->dwarf_cu.files = files;
+  cu->dwarf_cu.lines = lines;
+  cu->cu.lines = dwfl_lines;
+  if (files == NULL || lines == NULL || dwfl_lines == NULL)
+    {
+      free_dwfl_cu (cu);
+      return NULL;
+    }
+
+  files->ndirs = 0;
+  files->nfiles = ccu->nfiles;
+  for (uint32_t i = 0; i < ccu->nfiles; ++i)
+    {
+      const struct cache_file *f = &cache->files[ccu->first_file + i];
+      files->info[i].name = (char *) cache->strings + f->name;
+      files->info[i].mtime = f->mtime;
+      files->info[i].length = f->length;
+    }
+
+  lines->nlines = ccu->nlines;
+  lines->addrs = (Dwarf_Addr *) &lines->info[ccu->nlines];
+  dwfl_lines->cu = &cu->cu;
+  for (uint32_t i = 0; i < ccu->nlines; ++i)
+    {
+      const struct cache_line *l = &cache->lines[ccu->first_line + i];
+      struct Dwarf_Line_s *line = &lines->info[i];
+      line->files = files;
+      line->addr = l->addr + mod->low_addr;
+      lines->addrs[i] = line->addr;
+      line->file = l->file;
+      line->line = l->line;
+      line->column = l->column;
+      line->is_stmt = (l->flags & LINE_IS_STMT) != 0;
+      line->basic_block = (l->flags & LINE_BASIC_BLOCK) != 0;
+      line->end_sequence = (l->flags & LINE_END_SEQUENCE) != 0;
+      line->prologue_end = (l->flags & LINE_PROLOGUE_END) != 0;
+      line->epilogue_begin = (l->flags & LINE_EPILOGUE_BEGIN) != 0;
+      line->op_index = l->op_index;
+      line->isa = l->isa;
+      line->discriminator = l->discriminator;
+      dwfl_lines->idx[i].idx = i;
+    }
+
+  cu->dwarf_cu.startp = (void *) null_die;
+  cu->dwarf_cu.endp = (void *) null_die + sizeof null_die;
+  cu->cu.die.addr = (void *) null_die;
+  cu->cu.die.cu = &cu->dwarf_cu;
+  cu->cu.die.abbrev = DWARF_END_ABBREV;
+  cu->cu.mod = mod;
+  cu->comp_dir = (ccu->comp_dir == CACHE_NONE ? NULL
+		  : cache->strings + ccu->comp_dir);
+  return cu;
+}
+
+bool
+internal_function
+__libdwfl_cache_getsrc (Dwfl_Module *mod, Dwarf_Addr addr, Dwfl_Line **linep)
+{
+  if (mod->dw != NULL || mod->dwerr != DWFL_E_NOERROR)
+    return false;
+
+  struct dwfl_module_cache *cache = cache_get (mod);
+  if (cache == NULL || mod->dw != NULL)
+    return false;
+
+  const struct cache_header *h = cache->header;
+  *linep = NULL;
+  if (! h->has_dwarf)
+    {
+      __libdwfl_seterrno (DWFL_E_NO_DWARF);
+      return true;
+    }
+
+  /* The same lookup as __libdwfl_addrcu does, and then
+     dwfl_module_getsrc in the lines of the CU.  */
+  Dwfl_Error error = DWFL_E_ADDR_OUTOFRANGE;
+  GElf_Addr rel = addr - mod->low_addr;
+  size_t l = 0;
+  size_t u = h->naranges;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (rel < cache->aranges[idx].start)
+	u = idx;
+      else
+	l = idx + 1;
+    }
+  if (l == 0 || (l == h->naranges && rel > h->arange_end))
+    goto fail;
+
+  uint32_t ndx = cache->aranges[l - 1].cu;
+  if (cache->dwfl_cus[ndx] == NULL)
+    {
+      cache->dwfl_cus[ndx] = make_dwfl_cu (mod, cache, ndx);
+      if (cache->dwfl_cus[ndx] == NULL)
+	{
+	  error = DWFL_E_NOMEM;
+	  goto fail;
+	}
+    }
+
+  struct dwfl_cu *cu = &cache->dwfl_cus[ndx]->cu;
+  Dwarf_Lines *lines = cu->die.cu->lines;
+  l = __libdw_lines_upper_bound (lines, 0, lines->nlines, addr);
+  if (l > 0 && ! lines->info[l - 1].end_sequence)
+    {
+      *linep = &cu->lines->idx[l - 1];
+      return true;
+    }
+
+ fail:
+  __libdwfl_seterrno (error);
+  return true;
+}
+
+struct dwfl_cu *
+internal_function
+__libdwfl_cache_dwarf_cu (Dwfl_Line *line)
+{
+  struct dwfl_cu *cu = dwfl_linecu_inline (line);
+  Dwfl_Module *mod = cu->mod;
+  Dwarf_Addr bias;
+  if (INTUSE(dwfl_module_getdwarf) (mod, &bias) == NULL)
+    return NULL;
+
+  /* The line's CU is the one the lookup by its address found.  */
+  Dwfl_Error error = __libdwfl_addrcu (mod,
+				       cu->die.cu->lines->info[line->idx].addr,
+				       &cu);
+  if (error != DWFL_E_NOERROR)
+    {
+      __libdwfl_seterrno (error);
+      return NULL;
+    }
+  return cu;
+}
+
+const char *
+internal_function
+__libdwfl_cache_comp_dir (struct dwfl_cu *cu)
+{
+  return ((struct cache_dwfl_cu *) cu)->comp_dir;
+}
+
+void
+internal_function
+__libdwfl_cache_free (Dwfl_Module *mod)
+{
+  struct dwfl_module_cache *cache = mod->cache;
+  if (cache != NULL)
+    {
+      for (uint32_t i = 0; i < cache->header->ncus; ++i)
+	free_dwfl_cu (cache->dwfl_cus[i]);
+      free (cache->dwfl_cus);
+      munmap (cache->map, cache->size);
+      free (cache);
+      mod->cache = NULL;
+    }
+}
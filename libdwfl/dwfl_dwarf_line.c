@@ -38,6 +38,7 @@ dwfl_dwarf_line (Dwfl_Line *line, Dwarf_Addr *bias)
   struct dwfl_cu *cu = dwfl_linecu (line);
   const Dwarf_Line *info = &cu->die.cu->lines->info[line->idx];
 
-  *bias = dwfl_adjusted_dwarf_addr (cu->mod, 0);
+  /* Lines made up from the cache have adjusted addresses already.  */
+  *bias = dwfl_cu_cached (cu) ? 0 : dwfl_adjusted_dwarf_addr (cu->mod, 0);
   return (Dwarf_Line *) info;
 }
@@ -27,8 +27,14 @@
    not, see <http://www.gnu.org/licenses/>.  */
 
 #include "libdwflP.h"
+#include <search.h>
 #include <unistd.h>
 
+static void
+nofree (void *arg __attribute__ ((unused)))
+{
+}
+
 void
 dwfl_end (Dwfl *dwfl)
 {
@@ -41,6 +47,11 @@ dwfl_end (Dwfl *dwfl)
   free (dwfl->lookup_addr);
   free (dwfl->lookup_module);
   free (dwfl->lookup_segndx);
+  free (dwfl->cache_dir);
+  __libdwfl_debuginfo_cache_free (dwfl);
+  __libdwfl_kernel_modules_free (dwfl);
+
+  tdestroy (dwfl->module_tree, nofree);
 
   Dwfl_Module *next = dwfl->modulelist;
   while (next != NULL)
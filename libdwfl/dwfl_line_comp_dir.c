@@ -36,6 +36,9 @@ dwfl_line_comp_dir (Dwfl_Line *line)
     return NULL;
 
   struct dwfl_cu *cu = dwfl_linecu (line);
+  if (dwfl_cu_cached (cu))
+    return __libdwfl_cache_comp_dir (cu);
+
   Dwarf_Attribute attr_mem;
   return INTUSE(dwarf_formstring) (INTUSE(dwarf_attr) (&cu->die,
 						       DW_AT_comp_dir,
@@ -37,5 +37,12 @@ dwfl_linecu (Dwfl_Line *line)
     return NULL;
 
   struct dwfl_cu *cu = dwfl_linecu_inline (line);
+  if (dwfl_cu_cached (cu))
+    {
+      /* A CU made up from the cache has no DIEs, use the real one.  */
+      cu = __libdwfl_cache_dwarf_cu (line);
+      if (cu == NULL)
+	return NULL;
+    }
   return &cu->die;
 }
@@ -40,7 +40,8 @@ dwfl_lineinfo (Dwfl_Line *line, Dwarf_Addr *addr, int *linep, int *colp,
   const Dwarf_Line *info = &cu->die.cu->lines->info[line->idx];
 
   if (addr != NULL)
-    *addr = dwfl_adjusted_dwarf_addr (cu->mod, info->addr);
+    *addr = (dwfl_cu_cached (cu) ? info->addr
+	     : dwfl_adjusted_dwarf_addr (cu->mod, info->addr));
   if (linep != NULL)
     *linep = info->line;
   if (colp != NULL)
@@ -64,6 +64,10 @@ __libdwfl_module_free (Dwfl_Module *mod)
   if (mod->aranges != NULL)
     free (mod->aranges);
 
+  __libdwfl_addrsym_index_free (mod);
+  __libdwfl_cache_free (mod);
+  __libdwfl_frame_cache_free (mod);
+
   if (mod->cu != NULL)
     {
       for (size_t i = 0; i < mod->ncu; ++i)
@@ -135,17 +139,15 @@ dwfl_report_begin (Dwfl *dwfl)
 
   for (Dwfl_Module *m = dwfl->modulelist; m != NULL; m = m->next)
     m->gc = true;
+  dwfl->report_tailp = &dwfl->modulelist;
 
   dwfl->offline_next_address = OFFLINE_REDZONE;
 }
 INTDEF (dwfl_report_begin)
 
 static inline Dwfl_Module *
-use (Dwfl_Module *mod, Dwfl_Module **tailp, Dwfl *dwfl)
+use_in_place (Dwfl_Module *mod, Dwfl *dwfl)
 {
-  mod->next = *tailp;
-  *tailp = mod;
-
   if (unlikely (dwfl->lookup_module != NULL))
     {
       free (dwfl->lookup_module);
@@ -155,6 +157,46 @@ use (Dwfl_Module *mod, Dwfl_Module **tailp, Dwfl *dwfl)
   return mod;
 }
 
+static inline Dwfl_Module *
+use (Dwfl_Module *mod, Dwfl_Module **tailp, Dwfl *dwfl)
+{
+  dwfl_module_link (mod, tailp);
+
+  /* Only the modules already reported in this round come before it.  */
+  if (tailp == dwfl->report_tailp)
+    dwfl->report_tailp = &mod->next;
+
+  return use_in_place (mod, dwfl);
+}
+
+/* Order of the modules in DWFL->module_tree.  */
+static int
+compare_modules (const void *a, const void *b)
+{
+  const Dwfl_Module *m1 = a;
+  const Dwfl_Module *m2 = b;
+  if (m1->low_addr != m2->low_addr)
+    return m1->low_addr < m2->low_addr ? -1 : 1;
+  if (m1->high_addr != m2->high_addr)
+    return m1->high_addr < m2->high_addr ? -1 : 1;
+  return strcmp (m1->name, m2->name);
+}
+
+/* The place in the list after the last module not to be removed.  */
+static Dwfl_Module **
+report_tail (Dwfl *dwfl)
+{
+  if (dwfl->report_tailp == NULL)
+    {
+      Dwfl_Module **tailp = &dwfl->modulelist;
+      for (Dwfl_Module *m = *tailp; m != NULL; m = m->next)
+	if (! m->gc)
+	  tailp = &m->next;
+      dwfl->report_tailp = tailp;
+    }
+  return dwfl->report_tailp;
+}
+
 /* Report that a module called NAME spans addresses [START, END).
    Returns the module handle, either existing or newly allocated,
    or returns a null pointer for an allocation error.  */
@@ -162,22 +204,31 @@ Dwfl_Module *
 dwfl_report_module (Dwfl *dwfl, const char *name,
 		    GElf_Addr start, GElf_Addr end)
 {
-  Dwfl_Module **tailp = &dwfl->modulelist, **prevp = tailp;
+  Dwfl_Module key = { .name = (char *) name,
+		      .low_addr = start, .high_addr = end };
+  Dwfl_Module **found = tfind (&key, &dwfl->module_tree, compare_modules);
+
+  /* A module reported again in the same round stays where it is.  */
+  if (found != NULL && ! (*found)->gc)
+    return use_in_place (*found, dwfl);
+
+  Dwfl_Module **tailp = report_tail (dwfl);
 
-  for (Dwfl_Module *m = *prevp; m != NULL; m = *(prevp = &m->next))
+  if (found != NULL)
     {
-      if (m->low_addr == start && m->high_addr == end
-	  && !strcmp (m->name, name))
+      /* This module is still here.  It belongs right after the last
+	 module already reported.  When modules are reported in the same
+	 order as before, it is already there.  Otherwise move it.  */
+      Dwfl_Module *m = *found;
+      m->gc = false;
+      if (m->prevp == tailp)
 	{
-	  /* This module is still here.  Move it to the place in the list
-	     after the last module already reported.  */
-	  *prevp = m->next;
-	  m->gc = false;
-	  return use (m, tailp, dwfl);
+	  dwfl->report_tailp = &m->next;
+	  return use_in_place (m, dwfl);
 	}
 
-      if (! m->gc)
-	tailp = &m->next;
+      dwfl_module_unlink (m);
+      return use (m, tailp, dwfl);
     }
 
   Dwfl_Module *mod = calloc (1, sizeof *mod);
@@ -197,6 +248,13 @@ dwfl_report_module (Dwfl *dwfl, const char *name,
   mod->high_addr = end;
   mod->dwfl = dwfl;
 
+  if (tsearch (mod, &dwfl->module_tree, compare_modules) == NULL)
+    {
+      free (mod->name);
+      free (mod);
+      goto nomem;
+    }
+
   return use (mod, tailp, dwfl);
 }
 INTDEF (dwfl_report_module)
@@ -214,6 +272,8 @@ dwfl_report_end (Dwfl *dwfl,
 				 void *arg),
 		 void *arg)
 {
+  dwfl->report_tailp = NULL;
+
   Dwfl_Module **tailp = &dwfl->modulelist;
   while (*tailp != NULL)
     {
@@ -226,7 +286,8 @@ dwfl_report_end (Dwfl *dwfl,
 	}
       if (m->gc)
 	{
-	  *tailp = m->next;
+	  dwfl_module_unlink (m);
+	  tdelete (m, &dwfl->module_tree, compare_modules);
 	  __libdwfl_module_free (m);
 	}
       else
@@ -27,6 +27,7 @@
    not, see <http://www.gnu.org/licenses/>.  */
 
 #include "libdwflP.h"
+#include <system.h>
 
 struct search_state
 {
@@ -230,6 +231,543 @@ search_table (struct search_state *state, int start, int end)
 	}
 }
 
+/* The sorted index replaces the linear search_table walk for repeated
+   lookups.  Every symbol search_table would try becomes an entry.  The
+   address space is cut at every entry value and end into ranges, and
+   for each range we precompute the sized symbol the linear search
+   would settle on (per pass), plus the sizeless candidates that could
+   still be chosen if no sized symbol covers the address.  Only the
+   same_section check, which depends on ADDR itself, is left for lookup
+   time.  */
+
+struct addrsym_entry
+{
+  GElf_Addr value;		/* Value as tried by try_sym_value.  */
+  GElf_Xword size;		/* st_size of the symbol.  */
+  GElf_Addr key;		/* Lowest address this entry is tried for.  */
+  unsigned int order;		/* Position in the linear search order.  */
+  int ndx;			/* Symbol index for __libdwfl_getsym.  */
+  int binding;			/* binding_value of the symbol.  */
+  bool local;			/* Only tried in the second (locals) pass.  */
+  bool adjusted;		/* Tried against the adjusted st_value.  */
+};
+
+/* Result of one search_table pass over a range.  SIZED only looks at
+   the symbols of that pass.  The sizeless candidates of the second pass
+   include the globals, since the linear search carries them over.  */
+struct addrsym_pass
+{
+  int sized;			/* Best sized symbol, or -1.  */
+  unsigned int cand;		/* Sizeless candidates in CANDS, last first.  */
+  unsigned int ncand;
+};
+
+struct addrsym_range
+{
+  GElf_Addr start;		/* Valid up to the next range start.  */
+  struct addrsym_pass pass[2];
+};
+
+struct dwfl_addrsym_index
+{
+  struct addrsym_entry *entries;
+  struct addrsym_range *ranges;
+  size_t nranges;
+  unsigned int *cands;
+};
+
+static inline GElf_Addr
+entry_end (const struct addrsym_entry *e)
+{
+  GElf_Addr end = e->value + e->size;
+  return end < e->value ? (GElf_Addr) -1 : end;
+}
+
+/* The sized symbol selection of try_sym_value: true if E is a better
+   candidate than the current best CUR, which came earlier.  */
+static inline bool
+better_sized (const struct addrsym_entry *cur, const struct addrsym_entry *e)
+{
+  if (cur == NULL
+      || cur->value < e->value
+      || cur->binding < e->binding)
+    return true;
+  return (cur->value == e->value
+	  && ((cur->size > e->size && cur->binding <= e->binding)
+	      || (cur->size >= e->size && cur->binding < e->binding)));
+}
+
+static int
+compare_entry_key (const void *a, const void *b)
+{
+  const struct addrsym_entry *l = a;
+  const struct addrsym_entry *r = b;
+  if (l->key != r->key)
+    return l->key < r->key ? -1 : 1;
+  return l->order < r->order ? -1 : l->order > r->order;
+}
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  GElf_Addr l = *(const GElf_Addr *) a;
+  GElf_Addr r = *(const GElf_Addr *) b;
+  return l < r ? -1 : l > r;
+}
+
+/* Append the entries search_table would try for symbols START to END.  */
+static void
+collect_entries (Dwfl_Module *mod, bool adjust_st_value, int start, int end,
+		 bool local, struct addrsym_entry *entries, size_t *nentries)
+{
+  for (int i = start; i < end; ++i)
+    {
+      GElf_Sym sym;
+      GElf_Addr value;
+      GElf_Word shndx;
+      Elf *elf;
+      bool resolved;
+      const char *name = __libdwfl_getsym (mod, i, &sym, &value, &shndx,
+					   &elf, NULL, &resolved,
+					   adjust_st_value);
+      if (name == NULL || name[0] == '\0'
+	  || sym.st_shndx == SHN_UNDEF
+	  || GELF_ST_TYPE (sym.st_info) == STT_SECTION
+	  || GELF_ST_TYPE (sym.st_info) == STT_FILE
+	  || GELF_ST_TYPE (sym.st_info) == STT_TLS)
+	continue;
+
+      struct addrsym_entry *e = &entries[(*nentries)++];
+      e->value = e->key = value;
+      e->size = sym.st_size;
+      e->order = *nentries - 1;
+      e->ndx = i;
+      e->binding = binding_value (&sym);
+      e->local = local;
+      e->adjusted = false;
+
+      /* search_table only tries the adjusted st_value when the
+	 resolved value itself was not above ADDR.  */
+      if (resolved && mod->e_type != ET_REL)
+	{
+	  GElf_Addr adjusted_st_value;
+	  adjusted_st_value = dwfl_adjusted_st_value (mod, elf, sym.st_value);
+	  if (adjusted_st_value != value)
+	    {
+	      struct addrsym_entry *a = &entries[(*nentries)++];
+	      *a = *e;
+	      a->value = adjusted_st_value;
+	      a->key = MAX (value, adjusted_st_value);
+	      a->order = *nentries - 1;
+	      a->adjusted = true;
+	    }
+	}
+    }
+}
+
+static void
+free_index (struct dwfl_addrsym_index *index)
+{
+  if (index != NULL)
+    {
+      free (index->entries);
+      free (index->ranges);
+      free (index->cands);
+      free (index);
+    }
+}
+
+void
+internal_function
+__libdwfl_addrsym_index_free (Dwfl_Module *mod)
+{
+  for (size_t i = 0; i < 2; ++i)
+    {
+      free_index (mod->addrsym_index[i]);
+      mod->addrsym_index[i] = NULL;
+    }
+}
+
+/* Sweep state for one candidate set while building the ranges.  */
+struct sweep_set
+{
+  bool any;			/* Any entry seen yet.  */
+  GElf_Addr top;		/* Highest value seen.  */
+  GElf_Addr min_label;		/* Highest end seen.  */
+  unsigned int *cands;		/* Sizeless entries at TOP, last first.  */
+  size_t ncands;
+  bool dirty;			/* CANDS changed since it was last stored.  */
+  unsigned int stored;		/* Where CANDS was last stored.  */
+};
+
+static void
+sweep_add (struct sweep_set *set, const struct addrsym_entry *entries,
+	   unsigned int ei)
+{
+  const struct addrsym_entry *e = &entries[ei];
+  GElf_Addr end = entry_end (e);
+  if (end > set->min_label || ! set->any)
+    set->min_label = end;
+
+  if (! set->any || e->value > set->top)
+    {
+      set->any = true;
+      set->top = e->value;
+      set->ncands = 0;
+      set->dirty = true;
+    }
+
+  if (e->value == set->top && e->size == 0)
+    {
+      /* Keep the candidates sorted so the last one tried comes first.  */
+      size_t i = set->ncands++;
+      while (i > 0 && entries[set->cands[i - 1]].order < e->order)
+	{
+	  set->cands[i] = set->cands[i - 1];
+	  --i;
+	}
+      set->cands[i] = ei;
+      set->dirty = true;
+    }
+}
+
+static struct dwfl_addrsym_index *
+build_index (Dwfl_Module *mod, bool adjust_st_value, int syments,
+	     int first_global)
+{
+  struct dwfl_addrsym_index *index = calloc (1, sizeof *index);
+  struct addrsym_entry *entries = malloc (2 * (size_t) syments
+					  * sizeof entries[0]);
+  GElf_Addr *bounds = NULL;
+  unsigned int *active = NULL;
+  unsigned int *setcands = NULL;
+  struct sweep_set sets[2];
+  memset (sets, 0, sizeof sets);
+  size_t nentries = 0;
+  size_t ncands = 0;
+  size_t maxcands = 0;
+
+  if (index == NULL || entries == NULL)
+    goto nomem;
+  index->entries = entries;
+
+  /* Same order as the linear search: first globals, then locals.  */
+  collect_entries (mod, adjust_st_value, first_global == 0 ? 1 : first_global,
+		   syments, false, entries, &nentries);
+  if (first_global > 1)
+    collect_entries (mod, adjust_st_value, 1, first_global, true,
+		     entries, &nentries);
+
+  qsort (entries, nentries, sizeof entries[0], &compare_entry_key);
+
+  /* Every key and every end of a sized entry starts a new range.  */
+  bounds = malloc ((2 * nentries + 1) * sizeof bounds[0]);
+  active = malloc ((nentries + 1) * sizeof active[0]);
+  setcands = malloc (2 * (nentries + 1) * sizeof setcands[0]);
+  index->ranges = malloc ((2 * nentries + 1) * sizeof index->ranges[0]);
+  if (bounds == NULL || active == NULL || setcands == NULL
+      || index->ranges == NULL)
+    goto nomem;
+  sets[0].cands = setcands;
+  sets[1].cands = setcands + nentries + 1;
+
+  size_t nbounds = 0;
+  for (size_t i = 0; i < nentries; ++i)
+    {
+      bounds[nbounds++] = entries[i].key;
+      if (entries[i].size != 0 && entry_end (&entries[i]) > entries[i].key)
+	bounds[nbounds++] = entry_end (&entries[i]);
+    }
+  qsort (bounds, nbounds, sizeof bounds[0], &compare_addr);
+
+  size_t nactive = 0;
+  size_t next = 0;
+  for (size_t b = 0; b < nbounds; ++b)
+    {
+      GElf_Addr start = bounds[b];
+      if (b > 0 && bounds[b - 1] == start)
+	continue;
+
+      /* Drop sized entries no longer covering the range.  */
+      size_t n = 0;
+      for (size_t i = 0; i < nactive; ++i)
+	if (entry_end (&entries[active[i]]) > start)
+	  active[n++] = active[i];
+      nactive = n;
+
+      /* Add all entries tried from here on.  */
+      for (; next < nentries && entries[next].key == start; ++next)
+	{
+	  const struct addrsym_entry *e = &entries[next];
+	  if (! e->local)
+	    sweep_add (&sets[0], entries, next);
+	  sweep_add (&sets[1], entries, next);
+
+	  if (e->size != 0 && entry_end (e) > start)
+	    {
+	      size_t i = nactive++;
+	      while (i > 0 && entries[active[i - 1]].order > e->order)
+		{
+		  active[i] = active[i - 1];
+		  --i;
+		}
+	      active[i] = next;
+	    }
+	}
+
+      struct addrsym_range r;
+      r.start = start;
+      const struct addrsym_entry *best[2] = { NULL, NULL };
+      for (size_t i = 0; i < nactive; ++i)
+	{
+	  const struct addrsym_entry *e = &entries[active[i]];
+	  if (better_sized (best[e->local], e))
+	    best[e->local] = e;
+	}
+
+      for (int p = 0; p < 2; ++p)
+	{
+	  struct sweep_set *set = &sets[p];
+	  r.pass[p].sized = best[p] == NULL ? -1 : best[p] - entries;
+
+	  if (set->dirty && set->ncands > 0)
+	    {
+	      if (ncands + set->ncands > maxcands)
+		{
+		  size_t newmax = 2 * (ncands + set->ncands) + 64;
+		  unsigned int *newcands = realloc (index->cands, newmax
+						    * sizeof newcands[0]);
+		  if (newcands == NULL)
+		    goto nomem;
+		  index->cands = newcands;
+		  maxcands = newmax;
+		}
+	      memcpy (&index->cands[ncands], set->cands,
+		      set->ncands * sizeof set->cands[0]);
+	      set->stored = ncands;
+	      ncands += set->ncands;
+	    }
+	  set->dirty = false;
+
+	  /* A sizeless symbol is only used when no other symbol
+	     below ADDR reaches beyond it.  */
+	  if (set->ncands > 0 && set->min_label <= set->top)
+	    {
+	      r.pass[p].cand = set->stored;
+	      r.pass[p].ncand = set->ncands;
+	    }
+	  else
+	    {
+	      r.pass[p].cand = 0;
+	      r.pass[p].ncand = 0;
+	    }
+	}
+
+      if (index->nranges > 0
+	  && memcmp (&index->ranges[index->nranges - 1].pass, &r.pass,
+		     sizeof r.pass) == 0)
+	continue;
+      index->ranges[index->nranges++] = r;
+    }
+
+  free (bounds);
+  free (active);
+  free (setcands);
+  return index;
+
+ nomem:
+  free (bounds);
+  free (active);
+  free (setcands);
+  if (index != NULL)
+    free_index (index);
+  else
+    free (entries);
+  __libdwfl_seterrno (DWFL_E_NOMEM);
+  return NULL;
+}
+
+/* Fetch the symbol behind index entry E.  */
+static const char *
+entry_sym (struct search_state *state, const struct addrsym_entry *e,
+	   GElf_Sym *sym, GElf_Addr *value, GElf_Word *shndx, Elf **elf,
+	   bool *resolved)
+{
+  const char *name = __libdwfl_getsym (state->mod, e->ndx, sym, value, shndx,
+				       elf, NULL, resolved,
+				       state->adjust_st_value);
+  if (e->adjusted)
+    {
+      *value = e->value;
+      *resolved = false;
+    }
+  return name;
+}
+
+static void
+use_entry (struct search_state *state, const struct addrsym_entry *e)
+{
+  GElf_Addr value;
+  GElf_Word shndx;
+  Elf *elf;
+  bool resolved;
+  const char *name = entry_sym (state, e, state->closest_sym, &value,
+				&shndx, &elf, &resolved);
+  if (name != NULL)
+    {
+      state->closest_value = value;
+      state->closest_shndx = shndx;
+      state->closest_elf = elf;
+      state->closest_name = name;
+    }
+}
+
+/* The last sizeless candidate of PASS that is in the same section.  */
+static const struct addrsym_entry *
+find_sizeless (struct search_state *state,
+	       const struct dwfl_addrsym_index *index,
+	       const struct addrsym_pass *pass)
+{
+  for (unsigned int i = 0; i < pass->ncand; ++i)
+    {
+      const struct addrsym_entry *e = &index->entries[index->cands[pass->cand
+								   + i]];
+      GElf_Sym sym;
+      GElf_Addr value;
+      GElf_Word shndx;
+      Elf *elf;
+      bool resolved;
+      if (entry_sym (state, e, &sym, &value, &shndx, &elf, &resolved) != NULL
+	  && same_section (state, value,
+			   resolved ? state->mod->main.elf : elf, shndx))
+	return e;
+    }
+  return NULL;
+}
+
+/* Same result as the two search_table passes, using the index.  */
+static void
+search_index (struct search_state *state,
+	      const struct dwfl_addrsym_index *index, int first_global)
+{
+  size_t l = 0;
+  size_t u = index->nranges;
+  while (l < u)
+    {
+      size_t idx = (l + u) / 2;
+      if (state->addr < index->ranges[idx].start)
+	u = idx;
+      else
+	l = idx + 1;
+    }
+  if (l == 0)
+    return;
+  const struct addrsym_range *r = &index->ranges[l - 1];
+
+  if (r->pass[0].sized >= 0)
+    {
+      use_entry (state, &index->entries[r->pass[0].sized]);
+      return;
+    }
+
+  const struct addrsym_entry *sizeless = find_sizeless (state, index,
+							&r->pass[0]);
+  if (first_global > 1 && (sizeless == NULL || sizeless->value != state->addr))
+    {
+      if (r->pass[1].sized >= 0)
+	{
+	  use_entry (state, &index->entries[r->pass[1].sized]);
+	  return;
+	}
+      sizeless = find_sizeless (state, index, &r->pass[1]);
+    }
+
+  if (sizeless != NULL)
+    use_entry (state, sizeless);
+}
+
+static void
+add_section_bounds (Dwfl_Module *mod, Elf *elf, GElf_Addr *bounds,
+		    size_t *nbounds)
+{
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr != NULL)
+	{
+	  bounds[(*nbounds)++] = dwfl_adjusted_st_value (mod, elf,
+							 shdr->sh_addr);
+	  bounds[(*nbounds)++] = dwfl_adjusted_st_value (mod, elf,
+							 shdr->sh_addr
+							 + shdr->sh_size);
+	}
+    }
+}
+
+/* Collect the addresses at which the result of dwfl_module_addrsym can
+   change, unsorted in a malloc'd array: the index range starts and the
+   section bounds.  A sizeless symbol at the start of a range can be
+   chosen for exactly that address only, so the address after every
+   range start is included too.  Returns the number of addresses or -1
+   for errors.  */
+ssize_t
+internal_function
+__libdwfl_addrsym_bounds (Dwfl_Module *mod, GElf_Addr **boundsp)
+{
+  int syments = INTUSE(dwfl_module_getsymtab) (mod);
+  int first_global = INTUSE(dwfl_module_getsymtab_first_global) (mod);
+  if (syments < 0 || first_global < 0)
+    return -1;
+
+  struct dwfl_addrsym_index **indexp = &mod->addrsym_index[true];
+  if (*indexp == NULL)
+    *indexp = build_index (mod, true, syments, first_global);
+  if (*indexp == NULL)
+    return -1;
+
+  /* Sizeless symbols are only used inside their own section, which is
+     looked up in the file they came from or the main file.  */
+  Elf *elfs[3] = { mod->symfile->elf, NULL, mod->aux_sym.elf };
+  if (mod->main.elf != mod->symfile->elf)
+    elfs[1] = mod->main.elf;
+  size_t nsections = 0;
+  for (size_t i = 0; i < 3; ++i)
+    {
+      size_t n;
+      if (elfs[i] == NULL)
+	continue;
+      if (elf_getshdrnum (elfs[i], &n) != 0)
+	{
+	  __libdwfl_seterrno (DWFL_E_LIBELF);
+	  return -1;
+	}
+      nsections += n;
+    }
+
+  GElf_Addr *bounds = malloc ((2 * (*indexp)->nranges + 2 * nsections)
+			      * sizeof bounds[0]);
+  if (bounds == NULL)
+    {
+      __libdwfl_seterrno (DWFL_E_NOMEM);
+      return -1;
+    }
+
+  size_t nbounds = 0;
+  for (size_t i = 0; i < (*indexp)->nranges; ++i)
+    {
+      bounds[nbounds++] = (*indexp)->ranges[i].start;
+      bounds[nbounds++] = (*indexp)->ranges[i].start + 1;
+    }
+  for (size_t i = 0; i < 3; ++i)
+    if (elfs[i] != NULL)
+      add_section_bounds (mod, elfs[i], bounds, &nbounds);
+
+  *boundsp = bounds;
+  return nbounds;
+}
+
 /* Returns the name of the symbol "closest" to ADDR.
    Never returns symbols at addresses above ADDR.  */
 const char *
@@ -274,25 +812,38 @@ __libdwfl_addrsym (Dwfl_Module *_mod, GElf_Addr _addr, GElf_Off *off,
   int first_global = INTUSE (dwfl_module_getsymtab_first_global) (state.mod);
   if (first_global < 0)
     return NULL;
-  search_table (&state, first_global == 0 ? 1 : first_global, syments);
-
-  /* If we found nothing searching the global symbols, then try the locals.
-     Unless we have a global sizeless symbol that matches exactly.  */
-  if (state.closest_name == NULL && first_global > 1
-      && (state.sizeless_name == NULL || state.sizeless_value != state.addr))
-    search_table (&state, 1, first_global);
-
-  /* If we found no proper sized symbol to use, fall back to the best
-     candidate sizeless symbol we found, if any.  */
-  if (state.closest_name == NULL
-      && state.sizeless_name != NULL
-      && state.sizeless_value >= state.min_label)
+
+  /* Build the sorted index on first use.  If that fails we can still
+     fall back to searching the symbol table linearly.  */
+  struct dwfl_addrsym_index **indexp = &_mod->addrsym_index[_adjust_st_value];
+  if (*indexp == NULL)
+    *indexp = build_index (_mod, _adjust_st_value, syments, first_global);
+  if (*indexp != NULL)
+    search_index (&state, *indexp, first_global);
+  else
     {
-      *state.closest_sym = state.sizeless_sym;
-      state.closest_value = state.sizeless_value;
-      state.closest_shndx = state.sizeless_shndx;
-      state.closest_elf = state.sizeless_elf;
-      state.closest_name = state.sizeless_name;
+      search_table (&state, first_global == 0 ? 1 : first_global, syments);
+
+      /* If we found nothing searching the global symbols, then try the
+	 locals.  Unless we have a global sizeless symbol that matches
+	 exactly.  */
+      if (state.closest_name == NULL && first_global > 1
+	  && (state.sizeless_name == NULL
+	      || state.sizeless_value != state.addr))
+	search_table (&state, 1, first_global);
+
+      /* If we found no proper sized symbol to use, fall back to the best
+	 candidate sizeless symbol we found, if any.  */
+      if (state.closest_name == NULL
+	  && state.sizeless_name != NULL
+	  && state.sizeless_value >= state.min_label)
+	{
+	  *state.closest_sym = state.sizeless_sym;
+	  state.closest_value = state.sizeless_value;
+	  state.closest_shndx = state.sizeless_shndx;
+	  state.closest_elf = state.sizeless_elf;
+	  state.closest_name = state.sizeless_name;
+	}
     }
 
   *off = state.addr - state.closest_value;
@@ -311,6 +862,10 @@ const char *
 dwfl_module_addrsym (Dwfl_Module *mod, GElf_Addr addr,
 		     GElf_Sym *closest_sym, GElf_Word *shndxp)
 {
+  const char *name;
+  if (__libdwfl_cache_addrsym (mod, addr, closest_sym, shndxp, &name))
+    return name;
+
   GElf_Off off;
   return __libdwfl_addrsym (mod, addr, &off, closest_sym, shndxp,
 			    NULL, NULL, true);
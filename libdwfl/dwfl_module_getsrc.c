@@ -32,6 +32,10 @@
 Dwfl_Line *
 dwfl_module_getsrc (Dwfl_Module *mod, Dwarf_Addr addr)
 {
+  Dwfl_Line *cached;
+  if (__libdwfl_cache_getsrc (mod, addr, &cached))
+    return cached;
+
   Dwarf_Addr bias;
   if (INTUSE(dwfl_module_getdwarf) (mod, &bias) == NULL)
     return NULL;
@@ -44,32 +48,22 @@ dwfl_module_getsrc (Dwfl_Module *mod, Dwarf_Addr addr)
     {
       Dwarf_Lines *lines = cu->die.cu->lines;
       size_t nlines = lines->nlines;
-      if (nlines > 0)
+
+      /* Now we look at the module-relative address.  */
+      addr -= bias;
+
+      /* The lines are sorted by address, so we can use binary search.  */
+      size_t l = __libdw_lines_upper_bound (lines, 0, nlines, addr);
+      if (l > 0)
 	{
 	  /* This is guaranteed for us by libdw read_srclines.  */
 	  assert(lines->info[nlines - 1].end_sequence);
 
-	  /* Now we look at the module-relative address.  */
-	  addr -= bias;
-
-	  /* The lines are sorted by address, so we can use binary search.  */
-	  size_t l = 0, u = nlines - 1;
-	  while (l < u)
-	    {
-	      size_t idx = u - (u - l) / 2;
-	      Dwarf_Line *line = &lines->info[idx];
-	      if (addr < line->addr)
-		u = idx - 1;
-	      else
-		l = idx;
-	    }
-
 	  /* The last line which is less than or equal to addr is what
 	     we want, unless it is the end_sequence which is after the
 	     current line sequence.  */
-	  Dwarf_Line *line = &lines->info[l];
-	  if (! line->end_sequence && line->addr <= addr)
-	    return &cu->lines->idx[l];
+	  if (! lines->info[l - 1].end_sequence)
+	    return &cu->lines->idx[l - 1];
 	}
 
       error = DWFL_E_ADDR_OUTOFRANGE;
@@ -0,0 +1,155 @@
+/* Find source locations for a sorted array of addresses.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "../libdw/libdwP.h"
+
+/* Find the last line in LINES at or below module-relative ADDR, like
+   the bisection in dwfl_module_getsrc, searching on from index L.  */
+static size_t
+find_line (Dwarf_Lines *lines, Dwarf_Addr addr, size_t l)
+{
+  size_t n = lines->nlines;
+  if (l >= n || addr < lines->addrs[l])
+    l = 0;
+
+  size_t step = 1;
+  size_t hi = l + 1;
+  while (hi < n && lines->addrs[hi] <= addr)
+    {
+      l = hi;
+      step *= 2;
+      hi = l + step;
+    }
+  if (hi > n)
+    hi = n;
+
+  /* LINES->addrs[L] is at or below ADDR, unless L is zero.  */
+  hi = __libdw_lines_upper_bound (lines, l, hi, addr);
+  return hi > l ? hi - 1 : l;
+}
+
+ssize_t
+dwfl_module_getsrc_batch (Dwfl_Module *mod, const Dwarf_Addr *addrs,
+			  size_t naddrs, Dwfl_Line **lines)
+{
+  if (mod == NULL)
+    return -1;
+  if (naddrs == 0)
+    return 0;
+
+  ssize_t found = 0;
+
+  /* With the module's cache file nothing is gained by sweeping.  */
+  Dwfl_Line *cached;
+  if (__libdwfl_cache_getsrc (mod, addrs[0], &cached))
+    {
+      for (size_t i = 0; i < naddrs; ++i)
+	{
+	  if (i > 0 && ! __libdwfl_cache_getsrc (mod, addrs[i], &cached))
+	    cached = INTUSE(dwfl_module_getsrc) (mod, addrs[i]);
+	  lines[i] = cached;
+	  found += cached != NULL;
+	}
+      return found;
+    }
+
+  Dwarf_Addr bias;
+  if (INTUSE(dwfl_module_getdwarf) (mod, &bias) == NULL)
+    return -1;
+
+  /* Sweep the aranges and the line table of the current CU along with
+     the addresses.  Each search starts where the last one ended, so an
+     ascending array is resolved in a single pass.  Any order gives the
+     same results, just slower.  An address whose CU or lines can't be
+     read gets no line, as from dwfl_module_getsrc, and the others are
+     still looked up.  */
+  size_t arange_hint = 0;
+  struct dwfl_cu *lastcu = NULL;
+  Dwfl_Error lastcu_error = DWFL_E_NOERROR;
+  size_t line_hint = 0;
+  size_t failed = 0;
+  Dwfl_Error first_error = DWFL_E_NOERROR;
+  for (size_t i = 0; i < naddrs; ++i)
+    {
+      Dwarf_Addr addr = addrs[i];
+      lines[i] = NULL;
+
+      struct dwfl_cu *cu;
+      Dwfl_Error error = __libdwfl_addrcu_next (mod, addr, &arange_hint, &cu);
+      if (error == DWFL_E_ADDR_OUTOFRANGE)
+	continue;
+      if (likely (error == DWFL_E_NOERROR))
+	{
+	  if (cu != lastcu)
+	    {
+	      lastcu_error = __libdwfl_cu_getsrclines (cu);
+	      lastcu = cu;
+	      line_hint = 0;
+	    }
+	  error = lastcu_error;
+	}
+      if (unlikely (error != DWFL_E_NOERROR))
+	{
+	  if (failed++ == 0)
+	    first_error = error;
+	  continue;
+	}
+
+      Dwarf_Lines *dwlines = cu->die.cu->lines;
+      if (dwlines->nlines == 0)
+	continue;
+
+      /* This is guaranteed for us by libdw read_srclines.  */
+      assert (dwlines->info[dwlines->nlines - 1].end_sequence);
+
+      Dwarf_Addr reladdr = addr - bias;
+      line_hint = find_line (dwlines, reladdr, line_hint);
+
+      /* See dwfl_module_getsrc.  */
+      Dwarf_Line *line = &dwlines->info[line_hint];
+      if (! line->end_sequence && line->addr <= reladdr)
+	{
+	  lines[i] = &cu->lines->idx[line_hint];
+	  ++found;
+	}
+    }
+
+  /* Only an error if no address could be looked up at all.  */
+  if (failed == naddrs)
+    {
+      __libdwfl_seterrno (first_error);
+      return -1;
+    }
+
+  return found;
+}
@@ -27,6 +27,7 @@
    not, see <http://www.gnu.org/licenses/>.  */
 
 #include "libdwflP.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -154,10 +155,43 @@ validate (Dwfl_Module *mod, int fd, bool check, GElf_Word debuglink_crc)
   return !check || check_crc (fd, debuglink_crc);
 }
 
+/* Set *MAIN_STAT to the device and inode of MOD's main file, or to
+   zeros if they are not known.  */
+static void
+main_file_stat (Dwfl_Module *mod, const char *file_name,
+		struct stat *main_stat)
+{
+  if (mod->main.stat_valid)
+    {
+      main_stat->st_dev = mod->main.dev;
+      main_stat->st_ino = mod->main.ino;
+    }
+  else if (mod->main.fd != -1)
+    {
+      if (fstat (mod->main.fd, main_stat) == 0)
+	{
+	  mod->main.dev = main_stat->st_dev;
+	  mod->main.ino = main_stat->st_ino;
+	  mod->main.stat_valid = true;
+	}
+      else
+	{
+	  main_stat->st_dev = 0;
+	  main_stat->st_ino = 0;
+	}
+    }
+  else if (file_name == NULL || stat (file_name, main_stat) < 0)
+    {
+      main_stat->st_dev = 0;
+      main_stat->st_ino = 0;
+    }
+}
+
+/* Set *CHECKED to whether the CRC of the file found had to be checked.  */
 static int
 find_debuginfo_in_path (Dwfl_Module *mod, const char *file_name,
 			const char *debuglink_file, GElf_Word debuglink_crc,
-			char **debuginfo_file_name)
+			char **debuginfo_file_name, bool *checked)
 {
   bool cancheck = debuglink_crc != (GElf_Word) 0;
 
@@ -208,15 +242,8 @@ find_debuginfo_in_path (Dwfl_Module *mod, const char *file_name,
       ++path;
     }
 
-  /* XXX dev/ino should be cached in struct dwfl_file.  */
   struct stat main_stat;
-  if (unlikely ((mod->main.fd != -1 ? fstat (mod->main.fd, &main_stat)
-		 : file_name != NULL ? stat (file_name, &main_stat)
-		 : -1) < 0))
-    {
-      main_stat.st_dev = 0;
-      main_stat.st_ino = 0;
-    }
+  main_file_stat (mod, file_name, &main_stat);
 
   char *file_dirname = (file_basename == file_name ? NULL
 			: strndup (file_name, file_basename - 1 - file_name));
@@ -326,6 +353,7 @@ find_debuginfo_in_path (Dwfl_Module *mod, const char *file_name,
 	  free (localname);
 	  free (file_dirname);
 	  *debuginfo_file_name = fname;
+	  *checked = check;
 	  return fd;
 	}
       free (fname);
@@ -341,6 +369,111 @@ fail_free:
   return -1;
 }
 
+/* Make the key for the search by name.  The module's build ID is part
+   of it since validate checks that.  Alternate debug files are checked
+   against the build ID in the Dwarf, those searches are not cached.  */
+static char *
+by_name_key (Dwfl_Module *mod, const char *file_name,
+	     const char *debuglink_file, GElf_Word debuglink_crc,
+	     size_t *keylen)
+{
+  if (mod->dw != NULL)
+    return NULL;
+
+  const Dwfl_Callbacks *const cb = mod->dwfl->callbacks;
+  const char *debuginfo_path = ((cb->debuginfo_path ? *cb->debuginfo_path
+				 : NULL)
+				?: DEFAULT_DEBUGINFO_PATH);
+
+  /* Build IDs are normally 20 bytes, don't bother with very long ones.  */
+  char build_id[2 * 64 + 1] = "";
+  if (mod->build_id_len > 64)
+    return NULL;
+  const uint8_t *bits = mod->build_id_bits;
+  for (int i = 0; i < mod->build_id_len; ++i)
+    sprintf (&build_id[2 * i], "%02" PRIx8, bits[i]);
+
+  char crc[sizeof "ffffffff"];
+  sprintf (crc, "%08" PRIx32, debuglink_crc);
+
+  return __libdwfl_debuginfo_cache_key (5, (const char *[])
+					{ debuginfo_path, build_id, file_name,
+					  debuglink_file, crc },
+					keylen);
+}
+
+static int
+find_debuginfo_by_name (Dwfl_Module *mod, const char *file_name,
+			const char *debuglink_file, GElf_Word debuglink_crc,
+			char **debuginfo_file_name)
+{
+  /* Most of what is tried is not there.  Unless the path changed, the
+     same search for another module of the same file finds the same.  */
+  size_t keylen;
+  char *key = by_name_key (mod, file_name, debuglink_file, debuglink_crc,
+			   &keylen);
+  const char *cached;
+  bool checked = false;
+  if (key != NULL
+      && __libdwfl_debuginfo_cache_find (mod->dwfl, key, keylen,
+					 &cached, &checked))
+    {
+      if (cached == NULL)
+	{
+	  free (key);
+	  errno = 0;
+	  return -1;
+	}
+
+      int fd = TEMP_FAILURE_RETRY (open (cached, O_RDONLY));
+      if (fd >= 0)
+	{
+	  if (validate (mod, fd, checked, debuglink_crc))
+	    {
+	      char *fname = strdup (cached);
+	      free (key);
+	      if (unlikely (fname == NULL))
+		{
+		  close (fd);
+		  return -1;
+		}
+	      *debuginfo_file_name = fname;
+	      return fd;
+	    }
+	  close (fd);
+	}
+    }
+
+  int fd = find_debuginfo_in_path (mod, file_name,
+				   debuglink_file, debuglink_crc,
+				   debuginfo_file_name, &checked);
+  bool nothing = fd < 0 && errno == 0;
+
+  if (nothing && file_name != NULL)
+    {
+      /* If FILE_NAME is a symlink, the debug file might be associated
+	 with the symlink target name instead.  */
+
+      char *canon = canonicalize_file_name (file_name);
+      if (canon != NULL && strcmp (file_name, canon))
+	{
+	  fd = find_debuginfo_in_path (mod, canon,
+				       debuglink_file, debuglink_crc,
+				       debuginfo_file_name, &checked);
+	  nothing = fd < 0 && errno == 0;
+	}
+      free (canon);
+    }
+
+  if (key != NULL && (fd >= 0 || nothing))
+    __libdwfl_debuginfo_cache_add (mod->dwfl, key, keylen,
+				   fd >= 0 ? *debuginfo_file_name : NULL,
+				   checked);
+  free (key);
+
+  return fd;
+}
+
 int
 dwfl_standard_find_debuginfo (Dwfl_Module *mod,
 			      void **userdata __attribute__ ((unused)),
@@ -376,23 +509,7 @@ dwfl_standard_find_debuginfo (Dwfl_Module *mod,
     }
 
   /* Failing that, search the path by name.  */
-  int fd = find_debuginfo_in_path (mod, file_name,
-				   debuglink_file, debuglink_crc,
-				   debuginfo_file_name);
-
-  if (fd < 0 && errno == 0 && file_name != NULL)
-    {
-      /* If FILE_NAME is a symlink, the debug file might be associated
-	 with the symlink target name instead.  */
-
-      char *canon = canonicalize_file_name (file_name);
-      if (canon != NULL && strcmp (file_name, canon))
-	fd = find_debuginfo_in_path (mod, canon,
-				     debuglink_file, debuglink_crc,
-				     debuginfo_file_name);
-      free (canon);
-    }
-
-  return fd;
+  return find_debuginfo_by_name (mod, file_name, debuglink_file,
+				 debuglink_crc, debuginfo_file_name);
 }
 INTDEF (dwfl_standard_find_debuginfo)
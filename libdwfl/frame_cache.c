@@ -0,0 +1,125 @@
+/* Cache of CFI frame states for recently unwound PCs.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include "libdwflP.h"
+#include "../libdw/cfi.h"
+
+/* Number of frame states kept per module, a power of two.  A profiler
+   unwinding the same few thousand return addresses over and over finds
+   nearly all of them here.  */
+#define FRAME_CACHE_SIZE	4096
+
+struct frame_cache_entry
+{
+  Dwarf_CFI *cfi;
+  Dwarf_Addr pc;
+  Dwarf_Frame *frame;
+};
+
+struct dwfl_frame_cache
+{
+  uint64_t hits;
+  uint64_t misses;
+  struct frame_cache_entry entries[FRAME_CACHE_SIZE];
+};
+
+static inline size_t
+frame_cache_slot (Dwarf_Addr pc)
+{
+  /* Mix the bits above the instruction alignment into the index.  */
+  return ((pc ^ (pc >> 12)) * 0x9e3779b97f4a7c15ull >> 32)
+	 & (FRAME_CACHE_SIZE - 1);
+}
+
+Dwfl_Error
+internal_function
+__libdwfl_frame_cache_addrframe (Dwfl_Module *mod, Dwarf_CFI *cfi,
+				 Dwarf_Addr pc, Dwarf_Frame **frame)
+{
+  struct dwfl_frame_cache *cache = mod->frame_cache;
+  if (cache == NULL)
+    {
+      cache = calloc (1, sizeof *cache);
+      if (unlikely (cache == NULL))
+	return DWFL_E_NOMEM;
+      mod->frame_cache = cache;
+    }
+
+  struct frame_cache_entry *entry = &cache->entries[frame_cache_slot (pc)];
+  if (entry->frame != NULL && entry->cfi == cfi && entry->pc == pc)
+    {
+      cache->hits++;
+      *frame = entry->frame;
+      return DWFL_E_NOERROR;
+    }
+
+  cache->misses++;
+  Dwarf_Frame *found;
+  if (INTUSE(dwarf_cfi_addrframe) (cfi, pc, &found) != 0)
+    return DWFL_E_LIBDW;
+
+  free (entry->frame);
+  entry->cfi = cfi;
+  entry->pc = pc;
+  entry->frame = found;
+  *frame = found;
+  return DWFL_E_NOERROR;
+}
+
+void
+internal_function
+__libdwfl_frame_cache_free (Dwfl_Module *mod)
+{
+  struct dwfl_frame_cache *cache = mod->frame_cache;
+  if (cache == NULL)
+    return;
+
+  for (size_t i = 0; i < FRAME_CACHE_SIZE; i++)
+    free (cache->entries[i].frame);
+  free (cache);
+  mod->frame_cache = NULL;
+}
+
+int
+dwfl_module_frame_cache_stats (Dwfl_Module *mod, uint64_t *hits,
+			       uint64_t *misses)
+{
+  if (mod == NULL)
+    return -1;
+
+  struct dwfl_frame_cache *cache = mod->frame_cache;
+  if (hits != NULL)
+    *hits = cache != NULL ? cache->hits : 0;
+  if (misses != NULL)
+    *misses = cache != NULL ? cache->misses : 0;
+  return 0;
+}
@@ -537,12 +537,14 @@ new_unwound (Dwfl_Frame *state)
    later.  Therefore we continue unwinding leaving the registers undefined.  */
 
 static void
-handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
+handle_cfi (Dwfl_Frame *state, Dwfl_Module *mod, Dwarf_Addr pc,
+	    Dwarf_CFI *cfi, Dwarf_Addr bias)
 {
   Dwarf_Frame *frame;
-  if (INTUSE(dwarf_cfi_addrframe) (cfi, pc, &frame) != 0)
+  Dwfl_Error error = __libdwfl_frame_cache_addrframe (mod, cfi, pc, &frame);
+  if (error != DWFL_E_NOERROR)
     {
-      __libdwfl_seterrno (DWFL_E_LIBDW);
+      __libdwfl_seterrno (error);
       return;
     }
 
@@ -652,7 +654,6 @@ handle_cfi (Dwfl_Frame *state, Dwarf_Addr pc, Dwarf_CFI *cfi, Dwarf_Addr bias)
           unwound->pc += ebl_ra_offset (ebl);
         }
     }
-  free (frame);
 }
 
 static bool
@@ -720,14 +721,14 @@ __libdwfl_frame_unwind (Dwfl_Frame *state)
       Dwarf_CFI *cfi_eh = INTUSE(dwfl_module_eh_cfi) (mod, &bias);
       if (cfi_eh)
 	{
-	  handle_cfi (state, pc - bias, cfi_eh, bias);
+	  handle_cfi (state, mod, pc - bias, cfi_eh, bias);
 	  if (state->unwound)
 	    return;
 	}
       Dwarf_CFI *cfi_dwarf = INTUSE(dwfl_module_dwarf_cfi) (mod, &bias);
       if (cfi_dwarf)
 	{
-	  handle_cfi (state, pc - bias, cfi_dwarf, bias);
+	  handle_cfi (state, mod, pc - bias, cfi_dwarf, bias);
 	  if (state->unwound)
 	    return;
 	}
@@ -89,6 +89,15 @@ extern Dwfl *dwfl_begin (const Dwfl_Callbacks *callbacks)
 /* End a session.  */
 extern void dwfl_end (Dwfl *);
 
+/* Keep the data dwfl_module_addrsym and dwfl_module_getsrc need in
+   files in DIR, named by the hex build ID of the module.  A module
+   with a cache file answers those calls from it without reading its
+   symbol table or DWARF.  A missing cache file is written from the
+   module's files the first time one of them is called.  DIR must
+   exist.  NULL disables the cache again.  Returns 0 on success, -1 on
+   error.  */
+extern int dwfl_set_cache_dir (Dwfl *dwfl, const char *dir);
+
 /* Return implementation's version string suitable for printing.  */
 extern const char *dwfl_version (Dwfl *);
 
@@ -282,7 +291,11 @@ extern int dwfl_module_build_id (Dwfl_Module *mod,
    says to look in /usr/bin, then /usr/bin/.debug, then the path subdirs
    under /usr/lib/debug, in the order /usr/lib/debug/usr/bin, then
    /usr/lib/debug/bin, and finally /usr/lib/debug, for the file name in
-   the .gnu_debuglink section (or "ls.debug" if none was found).  */
+   the .gnu_debuglink section (or "ls.debug" if none was found).
+
+   What a search found, or that it found nothing, is remembered until
+   dwfl_end, and so are the contents of the .build-id directories.
+   Files added later are only found after the path string changed.  */
 
 /* Standard find_elf callback function working solely on build ID.
    This can be tried first by any find_elf callback, to use the
@@ -579,6 +592,16 @@ extern Dwfl_Line *dwfl_onesrcline (Dwarf_Die *cudie, size_t idx);
 extern Dwfl_Line *dwfl_module_getsrc (Dwfl_Module *mod, Dwarf_Addr addr);
 extern Dwfl_Line *dwfl_getsrc (Dwfl *dwfl, Dwarf_Addr addr);
 
+/* Get source for each of the NADDRS addresses in ADDRS, storing in
+   LINES[I] what dwfl_module_getsrc would return for ADDRS[I], or a null
+   pointer where no line covers the address or its CU's lines can't be
+   read.  ADDRS should be sorted in ascending order, then the CUs and line
+   tables are searched in a single sweep.  Returns the number of addresses
+   found, or -1 for errors, when no address at all could be looked up.  */
+extern ssize_t dwfl_module_getsrc_batch (Dwfl_Module *mod,
+					 const Dwarf_Addr *addrs,
+					 size_t naddrs, Dwfl_Line **lines);
+
 /* Get address for source.  */
 extern int dwfl_module_getsrc_file (Dwfl_Module *mod,
 				    const char *fname, int lineno, int column,
@@ -646,6 +669,15 @@ extern int dwfl_module_register_names (Dwfl_Module *mod,
 extern Dwarf_CFI *dwfl_module_dwarf_cfi (Dwfl_Module *mod, Dwarf_Addr *bias);
 extern Dwarf_CFI *dwfl_module_eh_cfi (Dwfl_Module *mod, Dwarf_Addr *bias);
 
+/* Unwinding through the CFI of a module keeps the frame state for the
+   most recently unwound PCs.  Fill in *HITS with the number of frames
+   unwound using such a cached state and *MISSES with the number for
+   which the CFI had to be interpreted.  HITS or MISSES may be a null
+   pointer if that number is not needed.  Returns zero on success, -1 for
+   errors.  */
+extern int dwfl_module_frame_cache_stats (Dwfl_Module *mod, uint64_t *hits,
+					  uint64_t *misses);
+
 
 typedef struct
 {
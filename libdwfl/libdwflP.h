@@ -119,6 +119,12 @@ struct Dwfl
   const Dwfl_Callbacks *callbacks;
 
   Dwfl_Module *modulelist;    /* List in order used by full traversals.  */
+  void *module_tree;	      /* tsearch tree of the modules by address
+				 and name, see dwfl_report_module.  */
+  Dwfl_Module **report_tailp; /* Where in the list the next module
+				 reported goes, no module not to be
+				 removed comes after it.  NULL if it has
+				 to be found again.  */
 
   Dwfl_Process *process;
   Dwfl_Error attacherr;      /* Previous error attaching process.  */
@@ -141,6 +147,15 @@ struct Dwfl
   int lookup_tail_ndx;
 
   struct Dwfl_User_Core *user_core;
+
+  char *cache_dir;		/* Set by dwfl_set_cache_dir, or NULL.  */
+
+  /* What searches for debuginfo files found, see debuginfo_cache.c.  */
+  struct dwfl_debuginfo_cache *debuginfo_cache;
+
+  /* Module files of the last kernel release directory used, see
+     linux-kernel-modules.c.  */
+  struct dwfl_kernel_modules *kernel_modules;
 };
 
 #define OFFLINE_REDZONE		0x10000
@@ -151,6 +166,10 @@ struct dwfl_file
   int fd;
   bool valid;			/* The build ID note has been matched.  */
   bool relocated;		/* Partial relocation of all sections done.  */
+  bool stat_valid;		/* DEV and INO are those of FD.  */
+
+  dev_t dev;
+  ino_t ino;
 
   Elf *elf;
 
@@ -167,6 +186,7 @@ struct Dwfl_Module
 {
   Dwfl *dwfl;
   struct Dwfl_Module *next;	/* Link on Dwfl.modulelist.  */
+  struct Dwfl_Module **prevp;	/* The link to this one on the list.  */
 
   void *userdata;
 
@@ -208,6 +228,15 @@ struct Dwfl_Module
 
   struct dwfl_arange *aranges;	/* Mapping of addresses in module to CUs.  */
 
+  /* Sorted symbol lookup tables for __libdwfl_addrsym, built on first
+     use.  Indexed by its adjust_st_value argument.  */
+  struct dwfl_addrsym_index *addrsym_index[2];
+
+  /* Symbol and line data mapped from the dwfl_set_cache_dir cache, used
+     as long as the files have not been loaded.  */
+  struct dwfl_module_cache *cache;
+  bool cache_tried;		/* Looked for the cache file already.  */
+
   void *build_id_bits;		/* malloc'd copy of build ID bits.  */
   GElf_Addr build_id_vaddr;	/* Address where they reside, 0 if unknown.  */
   int build_id_len;		/* -1 for prior failure, 0 if unset.  */
@@ -218,6 +247,7 @@ struct Dwfl_Module
 
   Dwarf_CFI *dwarf_cfi;		/* Cached DWARF CFI for this module.  */
   Dwarf_CFI *eh_cfi;		/* Cached EH CFI for this module.  */
+  struct dwfl_frame_cache *frame_cache; /* Recently unwound frames.  */
 
   int segment;			/* Index of first segment table entry.  */
   bool gc;			/* Mark/sweep flag.  */
@@ -332,6 +362,35 @@ dwfl_linecu_inline (const Dwfl_Line *line)
 }
 #define dwfl_linecu dwfl_linecu_inline
 
+/* Put MOD on the module list at *PREVP.  */
+static inline void
+dwfl_module_link (Dwfl_Module *mod, Dwfl_Module **prevp)
+{
+  mod->next = *prevp;
+  if (mod->next != NULL)
+    mod->next->prevp = &mod->next;
+  mod->prevp = prevp;
+  *prevp = mod;
+}
+
+/* Take MOD off the module list.  */
+static inline void
+dwfl_module_unlink (Dwfl_Module *mod)
+{
+  *mod->prevp = mod->next;
+  if (mod->next != NULL)
+    mod->next->prevp = mod->prevp;
+  mod->next = NULL;
+}
+
+/* CUs made up from the cache of dwfl_set_cache_dir have no libdw data.
+   Their line addresses are already adjusted.  */
+static inline bool
+dwfl_cu_cached (const struct dwfl_cu *cu)
+{
+  return cu->die.cu->dbg == NULL;
+}
+
 static inline GElf_Addr
 dwfl_adjusted_address (Dwfl_Module *mod, GElf_Addr addr)
 {
@@ -422,6 +481,9 @@ struct __libdwfl_pid_arg
   bool tid_was_stopped;
   /* True if threads are ptrace stopped by caller.  */
   bool assume_ptrace_stopped;
+  /* Chunks of memory read through TID_ATTACHED, allocated on first use.
+     Emptied when the thread is detached.  */
+  struct __libdwfl_pid_memory *memory;
 };
 
 /* If DWfl is not NULL and a Dwfl_Process has been setup that has
@@ -461,8 +523,78 @@ extern const char *__libdwfl_addrsym (Dwfl_Module *mod, GElf_Addr addr,
 				      Dwarf_Addr *bias,
 				      bool adjust_st_value) internal_function;
 
+/* Free the lookup tables built by __libdwfl_addrsym.  */
+extern void __libdwfl_addrsym_index_free (Dwfl_Module *mod)
+  internal_function;
+
+/* Addresses where the dwfl_module_addrsym result can change.  */
+extern ssize_t __libdwfl_addrsym_bounds (Dwfl_Module *mod,
+					 GElf_Addr **boundsp)
+  internal_function;
+
+/* Answer dwfl_module_addrsym from the module's cache file.  Returns
+   false if there is no usable cache.  */
+extern bool __libdwfl_cache_addrsym (Dwfl_Module *mod, GElf_Addr addr,
+				     GElf_Sym *sym, GElf_Word *shndxp,
+				     const char **name) internal_function;
+
+/* Answer dwfl_module_getsrc from the module's cache file.  Returns
+   false if there is no usable cache.  */
+extern bool __libdwfl_cache_getsrc (Dwfl_Module *mod, Dwarf_Addr addr,
+				    Dwfl_Line **line) internal_function;
+
+/* The CU of the module's DWARF containing LINE, a line made up from
+   the cache.  This loads the DWARF.  */
+extern struct dwfl_cu *__libdwfl_cache_dwarf_cu (Dwfl_Line *line)
+  internal_function;
+
+/* DW_AT_comp_dir of a CU made up from the cache.  */
+extern const char *__libdwfl_cache_comp_dir (struct dwfl_cu *cu)
+  internal_function;
+
+/* Free the module's cache data.  */
+extern void __libdwfl_cache_free (Dwfl_Module *mod) internal_function;
+
 extern void __libdwfl_module_free (Dwfl_Module *mod) internal_function;
 
+/* Make the key for a search for a debuginfo file from the NPARTS
+   strings in PARTS, any of which can be NULL.  Returns the malloc'd key
+   and its size in *KEYLEN, or NULL if out of memory.  */
+extern char *__libdwfl_debuginfo_cache_key (size_t nparts,
+					    const char *const parts[],
+					    size_t *keylen)
+  internal_function;
+
+/* Look up what an earlier search with KEY found.  Returns false if
+   there was none.  Otherwise sets *FILE_NAME to the file found, or to
+   NULL if nothing was found, and *CHECK, if not NULL, to whether its CRC
+   has to be checked.  */
+extern bool __libdwfl_debuginfo_cache_find (Dwfl *dwfl, const char *key,
+					    size_t keylen,
+					    const char **file_name,
+					    bool *check)
+  internal_function;
+
+/* Remember FILE_NAME, or NULL for nothing, as what the search with KEY
+   found.  */
+extern void __libdwfl_debuginfo_cache_add (Dwfl *dwfl, const char *key,
+					   size_t keylen,
+					   const char *file_name, bool check)
+  internal_function;
+
+/* Returns false if the directory DIR_NAME is known to have no file
+   FILE_NAME.  The directory is read the first time it is asked about.  */
+extern bool __libdwfl_debuginfo_dir_may_have (Dwfl *dwfl,
+					      const char *dir_name,
+					      const char *file_name)
+  internal_function;
+
+/* Free what the debuginfo file searches in DWFL found.  */
+extern void __libdwfl_debuginfo_cache_free (Dwfl *dwfl) internal_function;
+
+/* Free the kernel module files DWFL has found.  */
+extern void __libdwfl_kernel_modules_free (Dwfl *dwfl) internal_function;
+
 /* Find the main ELF file, update MOD->elferr and/or MOD->main.elf.  */
 extern void __libdwfl_getelf (Dwfl_Module *mod) internal_function;
 
@@ -501,6 +633,18 @@ extern Dwfl_Error __libdwfl_relocate_value (Dwfl_Module *mod, Elf *elf,
 /* Ensure that MOD->ebl is set up.  */
 extern Dwfl_Error __libdwfl_module_getebl (Dwfl_Module *mod) internal_function;
 
+/* Find the frame state for PC in CFI, one of the CFIs of MOD, like
+   dwarf_cfi_addrframe does.  The frame state is kept in MOD's cache of
+   recently unwound PCs and must not be freed by the caller.  */
+extern Dwfl_Error __libdwfl_frame_cache_addrframe (Dwfl_Module *mod,
+						   Dwarf_CFI *cfi,
+						   Dwarf_Addr pc,
+						   Dwarf_Frame **frame)
+  internal_function;
+
+/* Free the frame states cached for MOD.  */
+extern void __libdwfl_frame_cache_free (Dwfl_Module *mod) internal_function;
+
 /* Install a new Dwarf_CFI in *SLOT (MOD->eh_cfi or MOD->dwarf_cfi).  */
 extern Dwarf_CFI *__libdwfl_set_cfi (Dwfl_Module *mod, Dwarf_CFI **slot,
 				     Dwarf_CFI *cfi)
@@ -516,6 +660,13 @@ extern Dwfl_Error __libdwfl_nextcu (Dwfl_Module *mod, struct dwfl_cu *lastcu,
 extern Dwfl_Error __libdwfl_addrcu (Dwfl_Module *mod, Dwarf_Addr addr,
 				    struct dwfl_cu **cu) internal_function;
 
+/* Find the CU by address like __libdwfl_addrcu, searching on from the
+   aranges index in *HINT and storing back the index found.  Start with
+   *HINT zero, it is fastest for ascending addresses.  */
+extern Dwfl_Error __libdwfl_addrcu_next (Dwfl_Module *mod, Dwarf_Addr addr,
+					 size_t *hint, struct dwfl_cu **cu)
+  internal_function;
+
 /* Ensure that CU->lines (and CU->cu->lines) is set up.  */
 extern Dwfl_Error __libdwfl_cu_getsrclines (struct dwfl_cu *cu)
   internal_function;
@@ -578,6 +729,18 @@ extern Dwfl_Module *__libdwfl_report_offline (Dwfl *dwfl, const char *name,
 								const char *))
   internal_function;
 
+/* Likewise, for FD and ELF already opened by __libdw_open_file.
+   Always consumes ELF.  */
+extern Dwfl_Module *__libdwfl_report_offline_elf (Dwfl *dwfl,
+						  const char *name,
+						  const char *file_name,
+						  int fd, Elf *elf,
+						  bool closefd,
+						  int (*predicate)
+						  (const char *,
+						   const char *))
+  internal_function;
+
 /* Free PROCESS.  Unlink and free also any structures it references.  */
 extern void __libdwfl_process_free (Dwfl_Process *process)
   internal_function;
@@ -485,17 +485,13 @@ report_r_debug (uint_fast8_t elfclass, uint_fast8_t elfdata,
 	     up with a list in the same order as the link_map chain.  */
 	  if (mod->next != NULL)
 	    {
-	      if (*lastmodp != mod)
-		{
-		  lastmodp = &dwfl->modulelist;
-		  while (*lastmodp != mod)
-		    lastmodp = &(*lastmodp)->next;
-		}
-	      *lastmodp = mod->next;
-	      mod->next = NULL;
+	      if (lastmodp == &mod->next)
+		lastmodp = mod->prevp;
+	      dwfl_module_unlink (mod);
 	      while (*lastmodp != NULL)
 		lastmodp = &(*lastmodp)->next;
-	      *lastmodp = mod;
+	      dwfl_module_link (mod, lastmodp);
+	      dwfl->report_tailp = NULL;
 	    }
 
 	  lastmodp = &mod->next;
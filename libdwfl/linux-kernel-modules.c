@@ -45,6 +45,7 @@
 #include <stdlib.h>
 #include <sys/utsname.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <unistd.h>
 
 /* If fts.h is included before config.h, its indirect inclusions may not
@@ -281,13 +282,12 @@ report_kernel_archive (Dwfl *dwfl, const char **release,
       else
 	{
 	  /* Find the kernel and move it to the head of the list.  */
-	  Dwfl_Module **tailp = &dwfl->modulelist, **prevp = tailp;
-	  for (Dwfl_Module *m = *prevp; m != NULL; m = *(prevp = &m->next))
+	  for (Dwfl_Module *m = dwfl->modulelist; m != NULL; m = m->next)
 	    if (!m->gc && m->e_type != ET_REL && !strcmp (m->name, "kernel"))
 	      {
-		*prevp = m->next;
-		m->next = *tailp;
-		*tailp = m;
+		dwfl_module_unlink (m);
+		dwfl_module_link (m, &dwfl->modulelist);
+		dwfl->report_tailp = NULL;
 		break;
 	      }
 	}
@@ -298,13 +298,11 @@ report_kernel_archive (Dwfl *dwfl, const char **release,
 }
 
 static size_t
-check_suffix (const FTSENT *f, size_t namelen)
+check_suffix (const char *name, size_t len)
 {
 #define TRY(sfx)							\
-  if ((namelen ? f->fts_namelen == namelen + sizeof sfx - 1		\
-       : f->fts_namelen >= sizeof sfx)					\
-      && !memcmp (f->fts_name + f->fts_namelen - (sizeof sfx - 1),	\
-		  sfx, sizeof sfx))					\
+  if (len >= sizeof sfx							\
+      && !memcmp (name + len - (sizeof sfx - 1), sfx, sizeof sfx))	\
     return sizeof sfx - 1
 
   TRY (".ko");
@@ -321,6 +319,372 @@ check_suffix (const FTSENT *f, size_t namelen)
 #undef	TRY
 }
 
+/* One module file of a kernel release.  */
+struct kernel_module_file
+{
+  char *name;
+  char *path;
+  size_t seq;			/* Index in the order found.  */
+};
+
+/* The module files found in a kernel release directory, sorted by
+   module name.  */
+struct dwfl_kernel_modules
+{
+  char *dir;
+  /* The files are those listed in DIR/modules.dep, or all the files
+     found walking the directory tree.  */
+  bool from_dep;
+  struct kernel_module_file *files;
+  size_t nfiles;
+};
+
+void
+internal_function
+__libdwfl_kernel_modules_free (Dwfl *dwfl)
+{
+  struct dwfl_kernel_modules *modules = dwfl->kernel_modules;
+  if (modules == NULL)
+    return;
+
+  for (size_t i = 0; i < modules->nfiles; ++i)
+    {
+      free (modules->files[i].name);
+      free (modules->files[i].path);
+    }
+  free (modules->files);
+  free (modules->dir);
+  free (modules);
+  dwfl->kernel_modules = NULL;
+}
+
+/* Add the file PATH, whose base name BASE has LEN characters, if it is
+   a module file.  Returns false if out of memory.  */
+static bool
+add_module_file (struct dwfl_kernel_modules *modules, size_t *nalloc,
+		 const char *path, const char *base, size_t len)
+{
+  /* See if this file name matches "*.ko".  */
+  const size_t suffix = check_suffix (base, len);
+  if (suffix == 0)
+    return true;
+
+  if (modules->nfiles == *nalloc)
+    {
+      size_t newalloc = 2 * *nalloc + 64;
+      struct kernel_module_file *newfiles
+	= realloc (modules->files, newalloc * sizeof newfiles[0]);
+      if (newfiles == NULL)
+	return false;
+      modules->files = newfiles;
+      *nalloc = newalloc;
+    }
+
+  /* Following the algorithm by which the kernel makefiles set
+     KBUILD_MODNAME, we replace all ',' or '-' with '_' in the file name
+     and call that the module name.  Modules could well be built using
+     different embedded names than their file names.  To handle that, we
+     would have to look at the __this_module.name contents in the
+     module's text.  */
+  char *name = strndup (base, len - suffix);
+  char *copy = strdup (path);
+  if (unlikely (name == NULL || copy == NULL))
+    {
+      free (name);
+      free (copy);
+      return false;
+    }
+  for (char *p = name; *p != '\0'; ++p)
+    if (*p == '-' || *p == ',')
+      *p = '_';
+
+  modules->files[modules->nfiles].name = name;
+  modules->files[modules->nfiles].path = copy;
+  modules->files[modules->nfiles].seq = modules->nfiles;
+  ++modules->nfiles;
+  return true;
+}
+
+/* Read the module files of DIR from the modules.dep file depmod
+   writes there.  Returns zero on success, ENOENT if there is no such
+   file, or another errno code.  */
+static int
+read_modules_dep (struct dwfl_kernel_modules *modules, const char *dir)
+{
+  char *depfile;
+  if (asprintf (&depfile, "%s/modules.dep", dir) < 0)
+    return ENOMEM;
+  FILE *f = fopen (depfile, "r");
+  free (depfile);
+  if (f == NULL)
+    return errno;
+
+  (void) __fsetlocking (f, FSETLOCKING_BYCALLER);
+
+  /* Each line is "FILE: DEPENDENCIES", FILE relative to DIR.  */
+  int result = 0;
+  size_t nalloc = 0;
+  char *line = NULL;
+  size_t linesz = 0;
+  char *path = NULL;
+  size_t pathsz = 0;
+  ssize_t n;
+  while ((n = getline (&line, &linesz, f)) > 0)
+    {
+      char *colon = memchr (line, ':', n);
+      if (colon == NULL || colon == line)
+	continue;
+      *colon = '\0';
+
+      size_t need = strlen (dir) + 1 + (colon - line) + 1;
+      if (need > pathsz)
+	{
+	  char *newpath = realloc (path, need);
+	  if (newpath == NULL)
+	    {
+	      result = ENOMEM;
+	      break;
+	    }
+	  path = newpath;
+	  pathsz = need;
+	}
+      if (line[0] == '/')
+	strcpy (path, line);
+      else
+	sprintf (path, "%s/%s", dir, line);
+
+      const char *base = strrchr (line, '/');
+      base = base == NULL ? line : base + 1;
+      if (! add_module_file (modules, &nalloc, path, base,
+			     colon - base))
+	{
+	  result = ENOMEM;
+	  break;
+	}
+    }
+  if (result == 0 && ferror_unlocked (f))
+    result = errno ?: EIO;
+
+  free (path);
+  free (line);
+  fclose (f);
+  return result;
+}
+
+/* Do "find DIR -name *.ko".  Returns zero or an errno code.  */
+static int
+walk_modules_dir (struct dwfl_kernel_modules *modules, const char *dir)
+{
+  char *modulesdir[] = { (char *) dir, NULL };
+  FTS *fts = fts_open (modulesdir, FTS_NOSTAT | FTS_LOGICAL, NULL);
+  if (fts == NULL)
+    return errno;
+
+  int result = 0;
+  size_t nalloc = 0;
+  FTSENT *f;
+  while (result == 0 && (f = fts_read (fts)) != NULL)
+    {
+      /* Skip a "source" subtree, which tends to be large.
+	 This insane hard-coding of names is what depmod does too.  */
+      if (f->fts_namelen == sizeof "source" - 1
+	  && !strcmp (f->fts_name, "source"))
+	{
+	  fts_set (fts, f, FTS_SKIP);
+	  continue;
+	}
+
+      switch (f->fts_info)
+	{
+	case FTS_F:
+	case FTS_SL:
+	case FTS_NSOK:
+	  if (! add_module_file (modules, &nalloc, f->fts_path,
+				 f->fts_name, f->fts_namelen))
+	    result = ENOMEM;
+	  break;
+
+	case FTS_ERR:
+	case FTS_DNR:
+	case FTS_NS:
+	  result = f->fts_errno;
+	  break;
+
+	case FTS_SLNONE:
+	default:
+	  break;
+	}
+    }
+  fts_close (fts);
+
+  return result;
+}
+
+static int
+compare_module_files (const void *a, const void *b)
+{
+  const struct kernel_module_file *fa = a;
+  const struct kernel_module_file *fb = b;
+  int cmp = strcmp (fa->name, fb->name);
+  return cmp != 0 ? cmp : strcmp (fa->path, fb->path);
+}
+
+/* Find the module files in the kernel release directory DIR, from its
+   modules.dep or else by walking it, unless WALK.  They are kept until
+   another directory is asked for, or WALK asks for more than
+   modules.dep had.  Returns zero or an errno code.  */
+static int
+get_kernel_modules (Dwfl *dwfl, const char *dir, bool walk,
+		    struct dwfl_kernel_modules **modulesp)
+{
+  struct dwfl_kernel_modules *modules = dwfl->kernel_modules;
+  if (modules != NULL && !strcmp (modules->dir, dir)
+      && (!walk || !modules->from_dep))
+    {
+      *modulesp = modules;
+      return 0;
+    }
+
+  modules = calloc (1, sizeof *modules);
+  if (unlikely (modules == NULL))
+    return ENOMEM;
+  modules->dir = strdup (dir);
+  if (unlikely (modules->dir == NULL))
+    {
+      free (modules);
+      return ENOMEM;
+    }
+
+  int result = ENOENT;
+  if (! walk)
+    {
+      result = read_modules_dep (modules, dir);
+      modules->from_dep = result == 0;
+    }
+  if (result == ENOENT)
+    result = walk_modules_dir (modules, dir);
+
+  __libdwfl_kernel_modules_free (dwfl);
+  dwfl->kernel_modules = modules;
+  if (result != 0)
+    {
+      __libdwfl_kernel_modules_free (dwfl);
+      return result;
+    }
+
+  qsort (modules->files, modules->nfiles, sizeof modules->files[0],
+	 compare_module_files);
+  *modulesp = modules;
+  return 0;
+}
+
+/* A module file to open before it is reported.  */
+struct module_job
+{
+  const struct kernel_module_file *file;
+  int fd;
+  Elf *elf;
+  Dwfl_Error error;
+  int error_errno;
+};
+
+static int
+compare_module_jobs (const void *a, const void *b)
+{
+  const struct module_job *ja = a;
+  const struct module_job *jb = b;
+  return ja->file->seq < jb->file->seq ? -1 : ja->file->seq > jb->file->seq;
+}
+
+struct module_jobs
+{
+  struct module_job *jobs;
+  size_t njobs;
+  size_t next;
+};
+
+/* Open, decompress and check the header of one module file.  This uses
+   nothing but the file, so several can be done at the same time.  */
+static void
+open_module_file (struct module_job *job)
+{
+  job->elf = NULL;
+  job->error = DWFL_E_NOERROR;
+  job->fd = open (job->file->path, O_RDONLY);
+  if (job->fd < 0)
+    {
+      job->error = DWFL_E_ERRNO;
+      job->error_errno = errno;
+      return;
+    }
+
+  job->error = __libdw_open_file (&job->fd, &job->elf, true, true);
+  if (job->error != DWFL_E_NOERROR)
+    {
+      job->error_errno = errno;
+      return;
+    }
+
+  GElf_Ehdr ehdr_mem;
+  if (gelf_getehdr (job->elf, &ehdr_mem) == NULL)
+    {
+      job->error = DWFL_E_LIBELF;
+      elf_end (job->elf);
+      if (job->fd >= 0)
+	close (job->fd);
+      return;
+    }
+
+  /* Don't keep the file descriptor around, as process_elf doesn't.
+     All the modules are opened before the first is reported.  */
+  if (job->fd >= 0 && elf_cntl (job->elf, ELF_C_FDREAD) == 0)
+    {
+      close (job->fd);
+      job->fd = -1;
+    }
+}
+
+static void *
+open_modules_worker (void *arg)
+{
+  struct module_jobs *state = arg;
+
+  size_t idx;
+  while ((idx = __atomic_fetch_add (&state->next, 1, __ATOMIC_RELAXED))
+	 < state->njobs)
+    open_module_file (&state->jobs[idx]);
+
+  return NULL;
+}
+
+/* Open all the files of JOBS, with one thread per CPU.  Each job only
+   uses its own file and Elf, so this needs no locks.  */
+static void
+open_module_files (struct module_job *jobs, size_t njobs)
+{
+  struct module_jobs state = { .jobs = jobs, .njobs = njobs, .next = 0 };
+
+  long int ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+  size_t nthreads = ncpus > 0 ? (size_t) ncpus : 1;
+  if (nthreads > njobs)
+    nthreads = MAX (njobs, 1);
+
+  /* The calling thread is a worker too.  If we cannot start as many
+     threads as requested, the ones we have do all the work.  */
+  pthread_t *threads = malloc (nthreads * sizeof threads[0]);
+  size_t started = 1;
+  while (threads != NULL && started < nthreads
+	 && pthread_create (&threads[started], NULL, open_modules_worker,
+			    &state) == 0)
+    ++started;
+
+  open_modules_worker (&state);
+
+  for (size_t cnt = 1; cnt < started; ++cnt)
+    pthread_join (threads[cnt], NULL);
+  free (threads);
+}
+
 /* Report a kernel and all its modules found on disk, for offline use.
    If RELEASE starts with '/', it names a directory to look in;
    if not, it names a directory to find under /lib/modules/;
@@ -340,109 +704,88 @@ dwfl_linux_kernel_report_offline (Dwfl *dwfl, const char *release,
   result = report_kernel (dwfl, &release, predicate);
   if (result == 0)
     {
-      /* Do "find /lib/modules/RELEASE -name *.ko".  */
-
-      char *modulesdir[] = { NULL, NULL };
+      /* Do "find /lib/modules/RELEASE -name *.ko".  modules.dep may
+	 list files no longer there, or miss new ones, so it is only
+	 used for dwfl_linux_kernel_find_elf.  */
+      char *modulesdir;
       if (release[0] == '/')
-	modulesdir[0] = (char *) release;
-      else
-	{
-	  if (asprintf (&modulesdir[0], MODULEDIRFMT, release) < 0)
-	    return errno;
-	}
+	modulesdir = (char *) release;
+      else if (asprintf (&modulesdir, MODULEDIRFMT, release) < 0)
+	return errno;
+
+      struct dwfl_kernel_modules *modules;
+      result = get_kernel_modules (dwfl, modulesdir, true, &modules);
+      if (modulesdir != release)
+	free (modulesdir);
+      if (result != 0)
+	return result;
 
-      FTS *fts = fts_open (modulesdir, FTS_NOSTAT | FTS_LOGICAL, NULL);
-      if (modulesdir[0] == (char *) release)
-	modulesdir[0] = NULL;
-      if (fts == NULL)
+      struct module_job *jobs = malloc (modules->nfiles * sizeof jobs[0]
+					?: 1);
+      if (unlikely (jobs == NULL))
 	{
-	  free (modulesdir[0]);
-	  return errno;
+	  __libdwfl_seterrno (DWFL_E_NOMEM);
+	  return -1;
 	}
 
-      FTSENT *f;
-      while ((f = fts_read (fts)) != NULL)
+      /* Take the files in the order they were found.  */
+      for (size_t i = 0; i < modules->nfiles; ++i)
+	jobs[i].file = &modules->files[i];
+      qsort (jobs, modules->nfiles, sizeof jobs[0], compare_module_jobs);
+
+      size_t njobs = 0;
+      for (size_t i = 0; i < modules->nfiles; ++i)
 	{
-	  /* Skip a "source" subtree, which tends to be large.
-	     This insane hard-coding of names is what depmod does too.  */
-	  if (f->fts_namelen == sizeof "source" - 1
-	      && !strcmp (f->fts_name, "source"))
+	  const struct kernel_module_file *file = jobs[i].file;
+	  if (predicate != NULL)
 	    {
-	      fts_set (fts, f, FTS_SKIP);
-	      continue;
+	      /* Let the predicate decide whether to use this one.  */
+	      int want = (*predicate) (file->name, file->path);
+	      if (want < 0)
+		{
+		  result = -1;
+		  break;
+		}
+	      if (!want)
+		continue;
 	    }
+	  jobs[njobs++].file = file;
+	}
+
+      /* Opening and decompressing the files is most of the work, and
+	 is done for all of them at once.  They are reported in order,
+	 up to the first one that fails.  */
+      open_module_files (jobs, njobs);
 
-	  switch (f->fts_info)
+      int error = result;
+      result = 0;
+      for (size_t i = 0; i < njobs; ++i)
+	{
+	  struct module_job *job = &jobs[i];
+	  if (result != 0)
 	    {
-	    case FTS_F:
-	    case FTS_SL:
-	    case FTS_NSOK:;
-	      /* See if this file name matches "*.ko".  */
-	      const size_t suffix = check_suffix (f, 0);
-	      if (suffix)
+	      if (job->error == DWFL_E_NOERROR)
 		{
-		  /* We have a .ko file to report.  Following the algorithm
-		     by which the kernel makefiles set KBUILD_MODNAME, we
-		     replace all ',' or '-' with '_' in the file name and
-		     call that the module name.  Modules could well be
-		     built using different embedded names than their file
-		     names.  To handle that, we would have to look at the
-		     __this_module.name contents in the module's text.  */
-
-		  char *name = strndup (f->fts_name, f->fts_namelen - suffix);
-		  if (unlikely (name == NULL))
-		    {
-		      __libdwfl_seterrno (DWFL_E_NOMEM);
-		      result = -1;
-		      break;
-		    }
-		  for (size_t i = 0; i < f->fts_namelen - suffix; ++i)
-		    if (name[i] == '-' || name[i] == ',')
-		      name[i] = '_';
-
-		  if (predicate != NULL)
-		    {
-		      /* Let the predicate decide whether to use this one.  */
-		      int want = (*predicate) (name, f->fts_path);
-		      if (want < 0)
-			{
-			  result = -1;
-			  free (name);
-			  break;
-			}
-		      if (!want)
-			{
-			  free (name);
-			  continue;
-			}
-		    }
-
-		  if (dwfl_report_offline (dwfl, name, f->fts_path, -1) == NULL)
-		    {
-		      free (name);
-		      result = -1;
-		      break;
-		    }
-		  free (name);
+		  elf_end (job->elf);
+		  if (job->fd >= 0)
+		    close (job->fd);
 		}
-	      continue;
-
-	    case FTS_ERR:
-	    case FTS_DNR:
-	    case FTS_NS:
-	      result = f->fts_errno;
-	      break;
-
-	    case FTS_SLNONE:
-	    default:
-	      continue;
 	    }
-
-	  /* We only get here in error cases.  */
-	  break;
+	  else if (job->error != DWFL_E_NOERROR)
+	    {
+	      __libdwfl_seterrno (job->error);
+	      errno = job->error_errno;
+	      result = -1;
+	    }
+	  else if (__libdwfl_report_offline_elf (dwfl, job->file->name,
+						 job->file->path, job->fd,
+						 job->elf, true,
+						 NULL) == NULL)
+	    result = -1;
 	}
-      fts_close (fts);
-      free (modulesdir[0]);
+      free (jobs);
+      if (result == 0)
+	result = error;
     }
 
   return result;
@@ -675,27 +1018,31 @@ dwfl_linux_kernel_report_kernel (Dwfl *dwfl)
 INTDEF (dwfl_linux_kernel_report_kernel)
 
 
-static inline bool
-subst_name (char from, char to,
-            const char * const module_name,
-            char * const alternate_name,
-            const size_t namelen)
+/* Find the module file for MODULE_NAME in MODULES.  */
+static const struct kernel_module_file *
+lookup_kernel_module (const struct dwfl_kernel_modules *modules,
+		      const char *module_name)
 {
-  const char *n = memchr (module_name, from, namelen);
-  if (n == NULL)
-    return false;
-  char *a = mempcpy (alternate_name, module_name, n - module_name);
-  *a++ = to;
-  ++n;
-  const char *p;
-  while ((p = memchr (n, from, namelen - (n - module_name))) != NULL)
+  size_t l = 0;
+  size_t u = modules->nfiles;
+  while (l < u)
     {
-      a = mempcpy (a, n, p - n);
-      *a++ = to;
-      n = p + 1;
+      size_t idx = (l + u) / 2;
+      const struct kernel_module_file *file = &modules->files[idx];
+      int cmp = strcmp (module_name, file->name);
+      if (cmp < 0)
+	u = idx;
+      else if (cmp > 0)
+	l = idx + 1;
+      else
+	{
+	  /* Take the first of several files for the same name.  */
+	  while (idx > 0 && !strcmp (module_name, file[-1].name))
+	    --idx, --file;
+	  return file;
+	}
     }
-  memcpy (a, n, namelen - (n - module_name) + 1);
-  return true;
+  return NULL;
 }
 
 /* Dwfl_Callbacks.find_elf for the running Linux kernel and its modules.  */
@@ -722,21 +1069,6 @@ dwfl_linux_kernel_find_elf (Dwfl_Module *mod,
   if (!strcmp (module_name, KERNEL_MODNAME))
     return find_kernel_elf (mod->dwfl, release, file_name);
 
-  /* Do "find /lib/modules/`uname -r` -name MODULE_NAME.ko".  */
-
-  char *modulesdir[] = { NULL, NULL };
-  if (asprintf (&modulesdir[0], MODULEDIRFMT, release) < 0)
-    return -1;
-
-  FTS *fts = fts_open (modulesdir, FTS_NOSTAT | FTS_LOGICAL, NULL);
-  if (fts == NULL)
-    {
-      free (modulesdir[0]);
-      return -1;
-    }
-
-  size_t namelen = strlen (module_name);
-
   /* This is a kludge.  There is no actual necessary relationship between
      the name of the .ko file installed and the module name the kernel
      knows it by when it's loaded.  The kernel's only idea of the module
@@ -744,77 +1076,57 @@ dwfl_linux_kernel_find_elf (Dwfl_Module *mod,
      .gnu.linkonce.this_module section.
 
      In practice, these module names match the .ko file names except for
-     some using '_' and some using '-'.  So our cheap kludge is to look for
-     two files when either a '_' or '-' appears in a module name, one using
-     only '_' and one only using '-'.  */
+     some using '_' and some using '-'.  So our cheap kludge is to look
+     for the name with only '_', as the file names are kept.  */
+
+  char *name = strdup (module_name);
+  if (unlikely (name == NULL))
+    return -1;
+  for (char *p = name; *p != '\0'; ++p)
+    if (*p == '-' || *p == ',')
+      *p = '_';
 
-  char *alternate_name = malloc (namelen + 1);
-  if (unlikely (alternate_name == NULL))
+  char *modulesdir;
+  if (asprintf (&modulesdir, MODULEDIRFMT, release) < 0)
     {
-      free (modulesdir[0]);
-      return ENOMEM;
+      free (name);
+      return -1;
     }
-  if (!subst_name ('-', '_', module_name, alternate_name, namelen) &&
-      !subst_name ('_', '-', module_name, alternate_name, namelen))
-    alternate_name[0] = '\0';
 
-  FTSENT *f;
-  int error = ENOENT;
-  while ((f = fts_read (fts)) != NULL)
+  /* Look in modules.dep first.  A module installed since depmod last
+     ran is only found walking /lib/modules/`uname -r`.  */
+  struct dwfl_kernel_modules *modules;
+  const struct kernel_module_file *file = NULL;
+  int error = get_kernel_modules (mod->dwfl, modulesdir, false, &modules);
+  if (error == 0)
     {
-      /* Skip a "source" subtree, which tends to be large.
-	 This insane hard-coding of names is what depmod does too.  */
-      if (f->fts_namelen == sizeof "source" - 1
-	  && !strcmp (f->fts_name, "source"))
+      file = lookup_kernel_module (modules, name);
+      if (file == NULL && modules->from_dep)
 	{
-	  fts_set (fts, f, FTS_SKIP);
-	  continue;
+	  error = get_kernel_modules (mod->dwfl, modulesdir, true, &modules);
+	  if (error == 0)
+	    file = lookup_kernel_module (modules, name);
 	}
+    }
+  free (modulesdir);
+  free (name);
 
-      error = ENOENT;
-      switch (f->fts_info)
-	{
-	case FTS_F:
-	case FTS_SL:
-	case FTS_NSOK:
-	  /* See if this file name is "MODULE_NAME.ko".  */
-	  if (check_suffix (f, namelen)
-	      && (!memcmp (f->fts_name, module_name, namelen)
-		  || !memcmp (f->fts_name, alternate_name, namelen)))
-	    {
-	      int fd = open (f->fts_accpath, O_RDONLY);
-	      *file_name = strdup (f->fts_path);
-	      fts_close (fts);
-	      free (modulesdir[0]);
-	      free (alternate_name);
-	      if (fd < 0)
-		free (*file_name);
-	      else if (*file_name == NULL)
-		{
-		  close (fd);
-		  fd = -1;
-		}
-	      return fd;
-	    }
-	  break;
-
-	case FTS_ERR:
-	case FTS_DNR:
-	case FTS_NS:
-	  error = f->fts_errno;
-	  break;
-
-	case FTS_SLNONE:
-	default:
-	  break;
-	}
+  if (file == NULL)
+    {
+      errno = error ?: ENOENT;
+      return -1;
     }
 
-  fts_close (fts);
-  free (modulesdir[0]);
-  free (alternate_name);
-  errno = error;
-  return -1;
+  int fd = open (file->path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+  *file_name = strdup (file->path);
+  if (*file_name == NULL)
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
 }
 INTDEF (dwfl_linux_kernel_find_elf)
 
@@ -35,6 +35,7 @@
 #include <sys/wait.h>
 #include <dirent.h>
 #include <sys/syscall.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #ifdef __linux__
@@ -110,6 +111,85 @@ __libdwfl_ptrace_attach (pid_t tid, bool *tid_was_stoppedp)
   return true;
 }
 
+/* Target memory is read in aligned chunks of this size, so that a chunk
+   never crosses a page boundary.  Unwinding mostly reads the same few
+   stack pages over and over, a handful of chunks is enough.  */
+#define PID_MEMORY_CHUNK_SIZE	4096
+#define PID_MEMORY_NCHUNKS	8
+
+struct __libdwfl_pid_memory
+{
+  /* Start address of each valid chunk.  */
+  Dwarf_Addr addr[PID_MEMORY_NCHUNKS];
+  unsigned int nchunks;
+  /* The chunk to replace next when all are in use.  */
+  unsigned int next;
+  /* Set when process_vm_readv is not available or not permitted, then
+     everything is read with PTRACE_PEEKDATA.  */
+  bool use_ptrace;
+  unsigned char data[PID_MEMORY_NCHUNKS][PID_MEMORY_CHUNK_SIZE];
+};
+
+/* Return the cached chunk of the attached thread's memory containing
+   ADDR, reading it with process_vm_readv if needed.  Returns NULL if
+   it cannot be read that way.  */
+static const unsigned char *
+pid_memory_chunk (struct __libdwfl_pid_arg *pid_arg, Dwarf_Addr addr)
+{
+#ifdef HAVE_PROCESS_VM_READV
+  struct __libdwfl_pid_memory *memory = pid_arg->memory;
+  if (memory == NULL)
+    {
+      memory = malloc (sizeof *memory);
+      if (memory == NULL)
+	return NULL;
+      memory->nchunks = 0;
+      memory->next = 0;
+      memory->use_ptrace = false;
+      pid_arg->memory = memory;
+    }
+  if (memory->use_ptrace)
+    return NULL;
+
+  Dwarf_Addr start = addr & -(Dwarf_Addr) PID_MEMORY_CHUNK_SIZE;
+  for (unsigned int i = 0; i < memory->nchunks; i++)
+    if (memory->addr[i] == start)
+      return memory->data[i];
+
+  unsigned int i;
+  if (memory->nchunks < PID_MEMORY_NCHUNKS)
+    i = memory->nchunks;
+  else
+    {
+      i = memory->next;
+      memory->next = (i + 1) % PID_MEMORY_NCHUNKS;
+    }
+
+  struct iovec local = { memory->data[i], PID_MEMORY_CHUNK_SIZE };
+  struct iovec remote = { (void *) (uintptr_t) start, PID_MEMORY_CHUNK_SIZE };
+  ssize_t n = process_vm_readv (pid_arg->tid_attached, &local, 1,
+				&remote, 1, 0);
+  if (n != PID_MEMORY_CHUNK_SIZE)
+    {
+      /* Without the system call or the permission for it there is no
+	 point trying again.  Other failures and short reads are likely
+	 an unmapped address, let ptrace read just this word.  */
+      if (n < 0 && (errno == ENOSYS || errno == EPERM))
+	memory->use_ptrace = true;
+      return NULL;
+    }
+
+  memory->addr[i] = start;
+  if (i == memory->nchunks)
+    memory->nchunks++;
+  return memory->data[i];
+#else
+  (void) pid_arg;
+  (void) addr;
+  return NULL;
+#endif
+}
+
 static bool
 pid_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result, void *arg)
 {
@@ -117,7 +197,33 @@ pid_memory_read (Dwfl *dwfl, Dwarf_Addr addr, Dwarf_Word *result, void *arg)
   pid_t tid = pid_arg->tid_attached;
   assert (tid > 0);
   Dwfl_Process *process = dwfl->process;
-  if (ebl_get_elfclass (process->ebl) == ELFCLASS64)
+  bool is64 = ebl_get_elfclass (process->ebl) == ELFCLASS64;
+
+  /* The target has our own byte order, so read the word as it is.  */
+  size_t size = is64 ? 8 : 4;
+  size_t offset = addr % PID_MEMORY_CHUNK_SIZE;
+  if (offset + size <= PID_MEMORY_CHUNK_SIZE)
+    {
+      const unsigned char *chunk = pid_memory_chunk (pid_arg, addr);
+      if (chunk != NULL)
+	{
+	  if (is64)
+	    {
+	      uint64_t val;
+	      memcpy (&val, chunk + offset, sizeof val);
+	      *result = val;
+	    }
+	  else
+	    {
+	      uint32_t val;
+	      memcpy (&val, chunk + offset, sizeof val);
+	      *result = val;
+	    }
+	  return true;
+	}
+    }
+
+  if (is64)
     {
 #if SIZEOF_LONG == 8
       errno = 0;
@@ -250,6 +356,7 @@ pid_detach (Dwfl *dwfl __attribute__ ((unused)), void *dwfl_arg)
   elf_end (pid_arg->elf);
   close (pid_arg->elf_fd);
   closedir (pid_arg->dir);
+  free (pid_arg->memory);
   free (pid_arg);
 }
 
@@ -273,6 +380,9 @@ pid_thread_detach (Dwfl_Thread *thread, void *thread_arg)
   pid_t tid = INTUSE(dwfl_thread_tid) (thread);
   assert (pid_arg->tid_attached == tid);
   pid_arg->tid_attached = 0;
+  /* The memory may change once the thread runs again.  */
+  if (pid_arg->memory != NULL)
+    pid_arg->memory->nchunks = 0;
   if (! pid_arg->assume_ptrace_stopped)
     __libdwfl_ptrace_detach (tid, pid_arg->tid_was_stopped);
 }
@@ -376,6 +486,7 @@ dwfl_linux_proc_attach (Dwfl *dwfl, pid_t pid, bool assume_ptrace_stopped)
   pid_arg->elf_fd = elf_fd;
   pid_arg->tid_attached = 0;
   pid_arg->assume_ptrace_stopped = assume_ptrace_stopped;
+  pid_arg->memory = NULL;
   if (! INTUSE(dwfl_attach_state) (dwfl, elf, pid, &pid_thread_callbacks,
 				   pid_arg))
     {
@@ -277,6 +277,18 @@ __libdwfl_report_offline (Dwfl *dwfl, const char *name,
       __libdwfl_seterrno (error);
       return NULL;
     }
+  return __libdwfl_report_offline_elf (dwfl, name, file_name, fd, elf,
+				       closefd, predicate);
+}
+
+Dwfl_Module *
+internal_function
+__libdwfl_report_offline_elf (Dwfl *dwfl, const char *name,
+			      const char *file_name, int fd, Elf *elf,
+			      bool closefd,
+			      int (*predicate) (const char *module,
+						const char *file))
+{
   Dwfl_Module *mod = process_file (dwfl, name, file_name, fd, elf, predicate);
   if (mod == NULL)
     {
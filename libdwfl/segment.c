@@ -150,64 +150,94 @@ lookup (Dwfl *dwfl, GElf_Addr address, int hint)
   return -1;
 }
 
+static int
+compare_addr (const void *a, const void *b)
+{
+  const GElf_Addr *p1 = a, *p2 = b;
+  return *p1 < *p2 ? -1 : *p1 > *p2;
+}
+
+/* Build the table of modules for the segments at once.  Every module
+   start and end is a boundary in the table, besides the boundaries of
+   the segments reported.  Where there was no boundary before, the
+   user segment index of the new one is -1.  */
 static bool
 reify_segments (Dwfl *dwfl)
 {
-  int hint = -1;
-  int highest = -1;
-  bool fixup = false;
+  size_t nmods = 0;
+  for (Dwfl_Module *mod = dwfl->modulelist; mod != NULL; mod = mod->next)
+    if (! mod->gc)
+      ++nmods;
+
+  /* The sorted and unique module boundaries.  */
+  GElf_Addr *bounds = malloc ((2 * nmods ?: 1) * sizeof bounds[0]);
+  if (unlikely (bounds == NULL))
+    return true;
+  size_t nbounds = 0;
+  for (Dwfl_Module *mod = dwfl->modulelist; mod != NULL; mod = mod->next)
+    if (! mod->gc)
+      {
+	bounds[nbounds++] = __libdwfl_segment_start (dwfl, mod->low_addr);
+	bounds[nbounds++] = __libdwfl_segment_end (dwfl, mod->high_addr);
+      }
+  qsort (bounds, nbounds, sizeof bounds[0], compare_addr);
+  size_t nunique = 0;
+  for (size_t i = 0; i < nbounds; ++i)
+    if (nunique == 0 || bounds[nunique - 1] != bounds[i])
+      bounds[nunique++] = bounds[i];
+  nbounds = nunique;
+
+  /* Merge them with the segment boundaries.  */
+  size_t n = dwfl->lookup_elts + nbounds;
+  GElf_Addr *naddr = malloc ((n ?: 1) * sizeof naddr[0]);
+  int *nsegndx = malloc ((n ?: 1) * sizeof nsegndx[0]);
+  Dwfl_Module **nmodule = calloc (n ?: 1, sizeof nmodule[0]);
+  if (unlikely (naddr == NULL || nsegndx == NULL || nmodule == NULL))
+    {
+      free (bounds);
+      free (naddr);
+      free (nsegndx);
+      free (nmodule);
+      return true;
+    }
+
+  size_t elts = 0;
+  size_t i = 0, j = 0;
+  while (i < dwfl->lookup_elts || j < nbounds)
+    if (j == nbounds
+	|| (i < dwfl->lookup_elts && dwfl->lookup_addr[i] <= bounds[j]))
+      {
+	if (j < nbounds && dwfl->lookup_addr[i] == bounds[j])
+	  ++j;
+	/* Of equal segment boundaries only the last one counts.  */
+	if (elts > 0 && naddr[elts - 1] == dwfl->lookup_addr[i])
+	  --elts;
+	naddr[elts] = dwfl->lookup_addr[i];
+	nsegndx[elts++] = dwfl->lookup_segndx[i++];
+      }
+    else
+      {
+	naddr[elts] = bounds[j++];
+	nsegndx[elts++] = -1;
+      }
+  free (bounds);
+
+  free (dwfl->lookup_addr);
+  free (dwfl->lookup_segndx);
+  free (dwfl->lookup_module);
+  dwfl->lookup_addr = naddr;
+  dwfl->lookup_segndx = nsegndx;
+  dwfl->lookup_module = nmodule;
+  dwfl->lookup_elts = elts;
+  dwfl->lookup_alloc = n ?: 1;
+
   for (Dwfl_Module *mod = dwfl->modulelist; mod != NULL; mod = mod->next)
     if (! mod->gc)
       {
 	const GElf_Addr start = __libdwfl_segment_start (dwfl, mod->low_addr);
 	const GElf_Addr end = __libdwfl_segment_end (dwfl, mod->high_addr);
-	bool resized = false;
-
-	int idx = lookup (dwfl, start, hint);
-	if (unlikely (idx < 0))
-	  {
-	    /* Module starts below any segment.  Insert a low one.  */
-	    if (unlikely (insert (dwfl, 0, start, end, -1)))
-	      return true;
-	    idx = 0;
-	    resized = true;
-	  }
-	else if (dwfl->lookup_addr[idx] > start)
-	  {
-	    /* The module starts in the middle of this segment.  Split it.  */
-	    if (unlikely (insert (dwfl, idx + 1, start, end,
-				  dwfl->lookup_segndx[idx])))
-	      return true;
-	    ++idx;
-	    resized = true;
-	  }
-	else if (dwfl->lookup_addr[idx] < start)
-	  {
-	    /* The module starts past the end of this segment.
-	       Add a new one.  */
-	    if (unlikely (insert (dwfl, idx + 1, start, end, -1)))
-	      return true;
-	    ++idx;
-	    resized = true;
-	  }
-
-	if ((size_t) idx + 1 < dwfl->lookup_elts
-	    && end < dwfl->lookup_addr[idx + 1])
-	  {
-	    /* The module ends in the middle of this segment.  Split it.  */
-	    if (unlikely (insert (dwfl, idx + 1,
-				  end, dwfl->lookup_addr[idx + 1], -1)))
-	      return true;
-	    resized = true;
-	  }
-
-	if (dwfl->lookup_module == NULL)
-	  {
-	    dwfl->lookup_module = calloc (dwfl->lookup_alloc,
-					  sizeof dwfl->lookup_module[0]);
-	    if (unlikely (dwfl->lookup_module == NULL))
-	      return true;
-	  }
+	int idx = lookup (dwfl, start, -1);
+	assert (idx >= 0 && dwfl->lookup_addr[idx] == start);
 
 	/* Cache a backpointer in the module.  */
 	mod->segment = idx;
@@ -217,23 +247,8 @@ reify_segments (Dwfl *dwfl)
 	  dwfl->lookup_module[idx++] = mod;
 	while ((size_t) idx < dwfl->lookup_elts
 	       && dwfl->lookup_addr[idx] < end);
-	assert (dwfl->lookup_module[mod->segment] == mod);
-
-	if (resized && idx - 1 >= highest)
-	  /* Expanding the lookup tables invalidated backpointers
-	     we've already stored.  Reset those ones.  */
-	  fixup = true;
-
-	highest = idx - 1;
-	hint = (size_t) idx < dwfl->lookup_elts ? idx : -1;
       }
 
-  if (fixup)
-    /* Reset backpointer indices invalidated by table insertions.  */
-    for (size_t idx = 0; idx < dwfl->lookup_elts; ++idx)
-      if (dwfl->lookup_module[idx] != NULL)
-	dwfl->lookup_module[idx]->segment = idx;
-
   return false;
 }
 
@@ -310,11 +325,22 @@ dwfl_report_segment (Dwfl *dwfl, int ndx, const GElf_Phdr *phdr, GElf_Addr bias,
       || start != dwfl->lookup_tail_vaddr
       || phdr->p_offset != dwfl->lookup_tail_offset)
     {
-      /* Normally just appending keeps us sorted.  */
-
+      /* Normally just appending keeps us sorted.  Otherwise insert it
+	 after the last segment starting at or before it.  */
       size_t i = dwfl->lookup_elts;
-      while (i > 0 && unlikely (start < dwfl->lookup_addr[i - 1]))
-	--i;
+      if (unlikely (i > 0 && start < dwfl->lookup_addr[i - 1]))
+	{
+	  size_t l = 0, u = i - 1;
+	  while (l < u)
+	    {
+	      size_t idx = (l + u) / 2;
+	      if (start < dwfl->lookup_addr[idx])
+		u = idx;
+	      else
+		l = idx + 1;
+	    }
+	  i = l;
+	}
 
       if (unlikely (insert (dwfl, i, start, end, ndx)))
 	{
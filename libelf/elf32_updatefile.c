@@ -506,6 +506,52 @@ fill (int fd, off_t pos, size_t len, char *fillbuf, size_t *filledp)
   return 0;
 }
 
+/* If the LEN bytes at BUF are still in the file mapping of the
+   descriptor ELF was created from, copy them to POS in ELF's file
+   inside the kernel.  Returns the number of bytes copied, the caller
+   writes whatever is left.  */
+static size_t
+copy_from_source (Elf *elf, const char *buf, size_t len, off_t pos)
+{
+#ifdef HAVE_COPY_FILE_RANGE
+  const char *map = elf->source_map;
+  if (map == NULL || elf->source_fd == -1)
+    return 0;
+
+  if (buf < map || (size_t) (buf - map) > elf->source_size
+      || len > elf->source_size - (size_t) (buf - map))
+    return 0;
+
+  loff_t in = buf - map;
+  loff_t out = pos;
+  size_t copied = 0;
+  while (copied < len)
+    {
+      ssize_t n = copy_file_range (elf->source_fd, &in, elf->fildes, &out,
+				   len - copied, 0);
+      if (n > 0)
+	copied += n;
+      else if (n == 0 || errno != EINTR)
+	{
+	  /* Not supported between these files, don't try again.  */
+	  if (n < 0)
+	    {
+	      close (elf->source_fd);
+	      elf->source_fd = -1;
+	    }
+	  break;
+	}
+    }
+  return copied;
+#else
+  (void) elf;
+  (void) buf;
+  (void) pos;
+  (void) len;
+  return 0;
+#endif
+}
+
 
 int
 internal_function
@@ -765,10 +811,16 @@ __elfw2(LIBELFBITS,updatefile) (Elf *elf, int change_bo, size_t shnum)
 			(*fctp) (buf, dl->data.d.d_buf, dl->data.d.d_size, 1);
 		      }
 
-		    ssize_t n = pwrite_retry (elf->fildes, buf,
-					      dl->data.d.d_size,
-					      last_offset);
-		    if (unlikely ((size_t) n != dl->data.d.d_size))
+		    /* Data nobody touched can be copied file to file.  */
+		    size_t copied = 0;
+		    if (! change_bo)
+		      copied = copy_from_source (elf, buf, dl->data.d.d_size,
+						 last_offset);
+
+		    size_t left = dl->data.d.d_size - copied;
+		    ssize_t n = pwrite_retry (elf->fildes, (char *) buf + copied,
+					      left, last_offset + copied);
+		    if (unlikely ((size_t) n != left))
 		      {
 			if (buf != dl->data.d.d_buf && buf != tmpbuf)
 			  free (buf);
@@ -1020,7 +1020,7 @@ dup_elf (int fildes, Elf_Cmd cmd, Elf *ref)
 
 /* Return desriptor for empty file ready for writing.  */
 static struct Elf *
-write_file (int fd, Elf_Cmd cmd)
+write_file (int fd, Elf_Cmd cmd, Elf *ref)
 {
   /* We simply create an empty `Elf' structure.  */
 #define NSCNSALLOC	10
@@ -1040,6 +1040,24 @@ write_file (int fd, Elf_Cmd cmd)
 	      == offsetof (struct Elf, state.elf64.scns));
       result->state.elf.scns_last = &result->state.elf32.scns;
       result->state.elf32.scns.max = NSCNSALLOC;
+
+      /* Remember where unmodified data might come from.  Only a
+	 read-only shared mapping is guaranteed to still match the
+	 file.  We need our own file descriptor since the caller might
+	 close theirs before writing.  REF itself is not referenced,
+	 data pointing into its mapping must stay valid anyway.  */
+      if (ref != NULL && cmd == ELF_C_WRITE && ref->kind == ELF_K_ELF
+	  && ref->cmd == ELF_C_READ_MMAP && ref->parent == NULL
+	  && ref->map_address != NULL && (ref->flags & ELF_F_MMAPPED) != 0
+	  && ref->fildes != -1)
+	{
+	  result->source_fd = dup (ref->fildes);
+	  if (result->source_fd != -1)
+	    {
+	      result->source_map = ref->map_address;
+	      result->source_size = ref->maximum_size;
+	    }
+	}
     }
 
   return result;
@@ -1132,8 +1150,9 @@ elf_begin (int fildes, Elf_Cmd cmd, Elf *ref)
 
     case ELF_C_WRITE:
     case ELF_C_WRITE_MMAP:
-      /* We ignore REF and prepare a descriptor to write a new file.  */
-      retval = write_file (fildes, cmd);
+      /* We prepare a descriptor to write a new file.  REF is only a
+	 hint where the data might come from.  */
+      retval = write_file (fildes, cmd, ref);
       break;
 
     default:
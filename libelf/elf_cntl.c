@@ -69,6 +69,10 @@ elf_cntl (Elf *elf, Elf_Cmd cmd)
       elf->fildes = -1;
       break;
 
+    case ELF_C_PAGED:
+      rwlock_unlock (elf->lock);
+      return INTUSE(elf_cntl_paged) (elf, 1024 * 1024);
+
     default:
       __libelf_seterrno (ELF_E_INVALID_CMD);
       result = -1;
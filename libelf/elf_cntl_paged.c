@@ -0,0 +1,273 @@
+/* Read the file in pages on demand.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <system.h>
+#include "libelfP.h"
+#include "common.h"
+
+
+/* Size of the pages, a power of two.  Pages start at offsets in the
+   file which are multiples of it.  */
+#define PAGE_SIZE_LOG2	16
+#define PAGE_SIZE	((size_t) 1 << PAGE_SIZE_LOG2)
+
+/* Most hash table buckets used, more than that many pages share
+   buckets.  */
+#define MAX_BUCKETS	4096
+
+struct page
+{
+  off_t offset;			/* Offset in the file.  */
+  size_t size;			/* Less than PAGE_SIZE at the end.  */
+  struct page *hash_next;	/* Next page in the same bucket.  */
+  struct page *newer;		/* Next page in the LRU list.  */
+  struct page *older;		/* Previous page in the LRU list.  */
+  unsigned char data[];
+};
+
+struct __libelf_pages
+{
+  size_t budget;		/* Most bytes of pages kept.  */
+  size_t used;			/* Bytes of pages kept.  */
+  struct page *newest;		/* The most recently used page.  */
+  struct page *oldest;		/* The least recently used page.  */
+  size_t nbuckets;
+  struct page *buckets[];
+};
+
+
+void
+internal_function
+__libelf_pages_free (struct __libelf_pages *pages)
+{
+  if (pages == NULL)
+    return;
+
+  struct page *page = pages->newest;
+  while (page != NULL)
+    {
+      struct page *older = page->older;
+      free (page);
+      page = older;
+    }
+  free (pages);
+}
+
+static void
+lru_unlink (struct __libelf_pages *pages, struct page *page)
+{
+  if (page->newer != NULL)
+    page->newer->older = page->older;
+  else
+    pages->newest = page->older;
+  if (page->older != NULL)
+    page->older->newer = page->newer;
+  else
+    pages->oldest = page->newer;
+}
+
+static void
+lru_push (struct __libelf_pages *pages, struct page *page)
+{
+  page->newer = NULL;
+  page->older = pages->newest;
+  if (pages->newest != NULL)
+    pages->newest->newer = page;
+  else
+    pages->oldest = page;
+  pages->newest = page;
+}
+
+/* Drop the least recently used pages until there is room for one more.  */
+static void
+evict (struct __libelf_pages *pages)
+{
+  while (pages->oldest != NULL && pages->used + PAGE_SIZE > pages->budget)
+    {
+      struct page *page = pages->oldest;
+      lru_unlink (pages, page);
+
+      struct page **p = &pages->buckets[(page->offset >> PAGE_SIZE_LOG2)
+					% pages->nbuckets];
+      while (*p != page)
+	p = &(*p)->hash_next;
+      *p = page->hash_next;
+
+      pages->used -= page->size;
+      free (page);
+    }
+}
+
+/* Find the page at OFFSET, reading it if necessary.  */
+static struct page *
+get_page (Elf *elf, off_t offset)
+{
+  struct __libelf_pages *pages = elf->pages;
+  struct page **bucket = &pages->buckets[(offset >> PAGE_SIZE_LOG2)
+					 % pages->nbuckets];
+  struct page *page;
+  for (page = *bucket; page != NULL; page = page->hash_next)
+    if (page->offset == offset)
+      {
+	if (page != pages->newest)
+	  {
+	    lru_unlink (pages, page);
+	    lru_push (pages, page);
+	  }
+	return page;
+      }
+
+  if (unlikely (elf->fildes == -1))
+    {
+      __libelf_seterrno (ELF_E_FD_DISABLED);
+      return NULL;
+    }
+
+  size_t size = PAGE_SIZE;
+  if ((uint64_t) offset >= elf->maximum_size)
+    {
+      __libelf_seterrno (ELF_E_INVALID_OP);
+      return NULL;
+    }
+  if (elf->maximum_size - offset < size)
+    size = elf->maximum_size - offset;
+
+  evict (pages);
+
+  page = malloc (sizeof *page + size);
+  if (page == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  if (unlikely ((size_t) pread_retry (elf->fildes, page->data, size,
+				      elf->start_offset + offset) != size))
+    {
+      free (page);
+      __libelf_seterrno (ELF_E_READ_ERROR);
+      return NULL;
+    }
+
+  page->offset = offset;
+  page->size = size;
+  page->hash_next = *bucket;
+  *bucket = page;
+  lru_push (pages, page);
+  pages->used += size;
+  return page;
+}
+
+int
+internal_function
+__libelf_pages_read (Elf *elf, void *buf, size_t size, off_t offset)
+{
+  while (size > 0)
+    {
+      off_t start = offset & ~(off_t) (PAGE_SIZE - 1);
+      struct page *page = get_page (elf, start);
+      if (page == NULL)
+	return -1;
+
+      size_t skip = offset - start;
+      if (unlikely (skip >= page->size))
+	{
+	  __libelf_seterrno (ELF_E_INVALID_OP);
+	  return -1;
+	}
+
+      size_t n = MIN (size, page->size - skip);
+      buf = mempcpy (buf, page->data + skip, n);
+      offset += n;
+      size -= n;
+    }
+
+  return 0;
+}
+
+
+int
+elf_cntl_paged (Elf *elf, size_t budget)
+{
+  if (elf == NULL)
+    return -1;
+
+  /* The pages would not see what elf_update writes.  */
+  if (elf->cmd != ELF_C_READ && elf->cmd != ELF_C_READ_MMAP
+      && elf->cmd != ELF_C_READ_MMAP_PRIVATE)
+    {
+      __libelf_seterrno (ELF_E_INVALID_OPERAND);
+      return -1;
+    }
+
+  rwlock_wrlock (elf->lock);
+
+  int result = 0;
+  __libelf_pages_free (elf->pages);
+  elf->pages = NULL;
+
+  /* Nothing to do if the whole file is in memory.  */
+  if (budget != 0 && elf->map_address == NULL)
+    {
+      if (elf->fildes == -1)
+	{
+	  __libelf_seterrno (ELF_E_FD_DISABLED);
+	  result = -1;
+	}
+      else
+	{
+	  /* Keep at least one page.  */
+	  budget = MAX (budget, PAGE_SIZE);
+	  size_t nbuckets = MIN (budget / PAGE_SIZE, MAX_BUCKETS);
+	  struct __libelf_pages *pages
+	    = calloc (1, sizeof *pages + nbuckets * sizeof pages->buckets[0]);
+	  if (pages == NULL)
+	    {
+	      __libelf_seterrno (ELF_E_NOMEM);
+	      result = -1;
+	    }
+	  else
+	    {
+	      pages->budget = budget;
+	      pages->nbuckets = nbuckets;
+	      elf->pages = pages;
+	    }
+	}
+    }
+
+  rwlock_unlock (elf->lock);
+
+  return result;
+}
+INTDEF(elf_cntl_paged)
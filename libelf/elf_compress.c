@@ -35,11 +35,15 @@
 #include "libelfP.h"
 #include "common.h"
 
+#include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <zlib.h>
+#ifdef USE_ZSTD
+# include <zstd.h>
+#endif
 
 /* Cleanup and return result.  Don't leak memory.  */
 static void *
@@ -56,18 +60,11 @@ do_deflate_cleanup (void *result, z_stream *z, void *out_buf,
 #define deflate_cleanup(result) \
     do_deflate_cleanup(result, &z, out_buf, ei_data, &cdata)
 
-/* Given a section, uses the (in-memory) Elf_Data to extract the
-   original data size (including the given header size) and data
-   alignment.  Returns a buffer that has at least hsize bytes (for the
-   caller to fill in with a header) plus zlib compressed date.  Also
-   returns the new buffer size in new_size (hsize + compressed data
-   size).  Returns (void *) -1 when FORCE is false and the compressed
-   data would be bigger than the original data.  */
-void *
-internal_function
-__libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
-		   size_t *orig_size, size_t *orig_addralign,
-		   size_t *new_size, bool force)
+/* Compress the data of SCN with zlib, see __libelf_compress.  */
+static void *
+compress_zlib (Elf_Scn *scn, size_t hsize, int ei_data,
+	       size_t *orig_size, size_t *orig_addralign,
+	       size_t *new_size, bool force, int level)
 {
   /* The compressed data is the on-disk data.  We simplify the
      implementation a bit by asking for the (converted) in-memory
@@ -110,7 +107,7 @@ __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
   z.zalloc = Z_NULL;
   z.zfree = Z_NULL;
   z.opaque = Z_NULL;
-  int zrc = deflateInit (&z, Z_BEST_COMPRESSION);
+  int zrc = deflateInit (&z, level == 0 ? Z_BEST_COMPRESSION : level);
   if (zrc != Z_OK)
     {
       free (out_buf);
@@ -207,9 +204,178 @@ __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
   return out_buf;
 }
 
+#ifdef USE_ZSTD
+/* Cleanup and return result.  Don't leak memory.  */
+static void *
+do_zstd_cleanup (void *result, ZSTD_CCtx *cctx, void *out_buf,
+		 int ei_data, Elf_Data *cdatap)
+{
+  ZSTD_freeCCtx (cctx);
+  free (out_buf);
+  if (ei_data != MY_ELFDATA)
+    free (cdatap->d_buf);
+  return result;
+}
+
+#define zstd_cleanup(result) \
+    do_zstd_cleanup(result, cctx, out_buf, ei_data, &cdata)
+
+/* Compress the data of SCN with zstd, see __libelf_compress.  */
+static void *
+compress_zstd (Elf_Scn *scn, size_t hsize, int ei_data,
+	       size_t *orig_size, size_t *orig_addralign,
+	       size_t *new_size, bool force, int level)
+{
+  Elf_Data *data = elf_getdata (scn, NULL);
+  if (data == NULL)
+    return NULL;
+
+  /* A zstd frame has at least a four byte magic, a two byte frame
+     header and a three byte block header.  */
+  Elf_Data *next_data = elf_getdata (scn, data);
+  if (next_data == NULL && !force
+      && data->d_size <= hsize + 4 + 2 + 3)
+    return (void *) -1;
+
+  *orig_addralign = data->d_align;
+  *orig_size = data->d_size;
+
+  /* Guess an output block size like for zlib.  */
+  size_t block = (data->d_size / 8) + hsize;
+  size_t out_size = 2 * block;
+  void *out_buf = malloc (out_size);
+  if (out_buf == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  ZSTD_CCtx *cctx = ZSTD_createCCtx ();
+  if (cctx == NULL
+      || ZSTD_isError (ZSTD_CCtx_setParameter (cctx, ZSTD_c_compressionLevel,
+					       level)))
+    {
+      ZSTD_freeCCtx (cctx);
+      free (out_buf);
+      __libelf_seterrno (ELF_E_COMPRESS_ERROR);
+      return NULL;
+    }
+
+  /* Caller gets to fill in the header at the start.  Just skip it here.  */
+  ZSTD_outBuffer out = { .dst = out_buf, .size = out_size, .pos = hsize };
+
+  Elf_Data cdata;
+  cdata.d_buf = NULL;
+
+  /* Loop over data buffers.  */
+  ZSTD_EndDirective mode = ZSTD_e_continue;
+  do
+    {
+      /* Convert to raw if different endianess.  */
+      cdata = *data;
+      if (ei_data != MY_ELFDATA)
+	{
+	  /* Don't do this conversion in place, we might want to keep
+	     the original data around, caller decides.  */
+	  cdata.d_buf = malloc (data->d_size);
+	  if (cdata.d_buf == NULL)
+	    {
+	      __libelf_seterrno (ELF_E_NOMEM);
+	      return zstd_cleanup (NULL);
+	    }
+	  if (gelf_xlatetof (scn->elf, &cdata, data, ei_data) == NULL)
+	    return zstd_cleanup (NULL);
+	}
+
+      ZSTD_inBuffer in = { .src = cdata.d_buf, .size = cdata.d_size,
+			   .pos = 0 };
+
+      /* Get next buffer to see if this is the last one.  */
+      data = next_data;
+      if (data != NULL)
+	{
+	  *orig_addralign = MAX (*orig_addralign, data->d_align);
+	  *orig_size += data->d_size;
+	  next_data = elf_getdata (scn, data);
+	}
+      else
+	mode = ZSTD_e_end;
+
+      /* Compress one data buffer, at the end until all is flushed.  */
+      size_t left;
+      do
+	{
+	  left = ZSTD_compressStream2 (cctx, &out, &in, mode);
+	  if (ZSTD_isError (left))
+	    {
+	      __libelf_seterrno (ELF_E_COMPRESS_ERROR);
+	      return zstd_cleanup (NULL);
+	    }
+
+	  /* Bail out if we are sure the user doesn't want the
+	     compression forced and we are using more compressed data
+	     than original data.  */
+	  if (!force && mode == ZSTD_e_end && out.pos >= *orig_size)
+	    return zstd_cleanup ((void *) -1);
+
+	  if (out.pos == out.size)
+	    {
+	      void *bigger = realloc (out_buf, out_size + block);
+	      if (bigger == NULL)
+		{
+		  __libelf_seterrno (ELF_E_NOMEM);
+		  return zstd_cleanup (NULL);
+		}
+	      out_buf = bigger;
+	      out_size += block;
+	      out.dst = out_buf;
+	      out.size = out_size;
+	    }
+	}
+      while (mode == ZSTD_e_end ? left != 0 : in.pos < in.size);
+
+      if (ei_data != MY_ELFDATA)
+	{
+	  free (cdata.d_buf);
+	  cdata.d_buf = NULL;
+	}
+    }
+  while (mode != ZSTD_e_end); /* More data blocks.  */
+
+  ZSTD_freeCCtx (cctx);
+  *new_size = out.pos;
+  return out_buf;
+}
+#endif
+
+/* Given a section, uses the (in-memory) Elf_Data to extract the
+   original data size (including the given header size) and data
+   alignment.  Returns a buffer that has at least hsize bytes (for the
+   caller to fill in with a header) plus data compressed with CH_TYPE
+   at LEVEL, zero being the default level.  Also returns the new buffer
+   size in new_size (hsize + compressed data size).  Returns (void *)
+   -1 when FORCE is false and the compressed data would be bigger than
+   the original data.  */
+void *
+internal_function
+__libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
+		   size_t *orig_size, size_t *orig_addralign,
+		   size_t *new_size, bool force, int ch_type, int level)
+{
+#ifdef USE_ZSTD
+  if (ch_type == ELFCOMPRESS_ZSTD)
+    return compress_zstd (scn, hsize, ei_data, orig_size, orig_addralign,
+			  new_size, force, level);
+#endif
+  assert (ch_type == ELFCOMPRESS_ZLIB);
+  return compress_zlib (scn, hsize, ei_data, orig_size, orig_addralign,
+			new_size, force, level);
+}
+
 void *
 internal_function
-__libelf_decompress (void *buf_in, size_t size_in, size_t size_out)
+__libelf_decompress (int ch_type, void *buf_in, size_t size_in,
+		     size_t size_out)
 {
   void *buf_out = malloc (size_out);
   if (unlikely (buf_out == NULL))
@@ -218,6 +384,22 @@ __libelf_decompress (void *buf_in, size_t size_in, size_t size_out)
       return NULL;
     }
 
+#ifdef USE_ZSTD
+  if (ch_type == ELFCOMPRESS_ZSTD)
+    {
+      /* This also decompresses multiple frames after each other.  */
+      size_t ret = ZSTD_decompress (buf_out, size_out, buf_in, size_in);
+      if (unlikely (ZSTD_isError (ret)) || unlikely (ret != size_out))
+	{
+	  free (buf_out);
+	  __libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+	  return NULL;
+	}
+      return buf_out;
+    }
+#endif
+  assert (ch_type == ELFCOMPRESS_ZLIB);
+
   z_stream z =
     {
       .next_in = buf_in,
@@ -258,7 +440,7 @@ __libelf_decompress_elf (Elf_Scn *scn, size_t *size_out, size_t *addralign)
   if (gelf_getchdr (scn, &chdr) == NULL)
     return NULL;
 
-  if (chdr.ch_type != ELFCOMPRESS_ZLIB)
+  if (! __libelf_compress_type_supported (chdr.ch_type))
     {
       __libelf_seterrno (ELF_E_UNKNOWN_COMPRESSION_TYPE);
       return NULL;
@@ -285,7 +467,8 @@ __libelf_decompress_elf (Elf_Scn *scn, size_t *size_out, size_t *addralign)
 		  ? sizeof (Elf32_Chdr) : sizeof (Elf64_Chdr));
   size_t size_in = data->d_size - hsize;
   void *buf_in = data->d_buf + hsize;
-  void *buf_out = __libelf_decompress (buf_in, size_in, chdr.ch_size);
+  void *buf_out = __libelf_decompress (chdr.ch_type, buf_in, size_in,
+				       chdr.ch_size);
   *size_out = chdr.ch_size;
   *addralign = chdr.ch_addralign;
   return buf_out;
@@ -307,6 +490,8 @@ __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size, size_t align,
 
   /* Existing existing data is no longer valid.  */
   scn->data_list_rear = NULL;
+  __libelf_zstream_free (scn->zstream);
+  scn->zstream = NULL;
   if (scn->data_base != scn->rawdata_base)
     free (scn->data_base);
   scn->data_base = NULL;
@@ -320,7 +505,7 @@ __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size, size_t align,
 }
 
 int
-elf_compress (Elf_Scn *scn, int type, unsigned int flags)
+elf_compress_level (Elf_Scn *scn, int type, int level, unsigned int flags)
 {
   if (scn == NULL)
     return -1;
@@ -331,6 +516,19 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       return -1;
     }
 
+  int max_level = 0;
+  if (type == ELFCOMPRESS_ZLIB)
+    max_level = Z_BEST_COMPRESSION;
+#ifdef USE_ZSTD
+  else if (type == ELFCOMPRESS_ZSTD)
+    max_level = ZSTD_maxCLevel ();
+#endif
+  if (level < 0 || level > max_level)
+    {
+      __libelf_seterrno (ELF_E_INVALID_OPERAND);
+      return -1;
+    }
+
   bool force = (flags & ELF_CHF_FORCE) != 0;
 
   Elf *elf = scn->elf;
@@ -378,7 +576,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
     }
 
   int compressed = (sh_flags & SHF_COMPRESSED);
-  if (type == ELFCOMPRESS_ZLIB)
+  if (type != 0 && __libelf_compress_type_supported (type))
     {
       /* Compress/Deflate.  */
       if (compressed == 1)
@@ -392,7 +590,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       size_t orig_size, orig_addralign, new_size;
       void *out_buf = __libelf_compress (scn, hsize, elfdata,
 					 &orig_size, &orig_addralign,
-					 &new_size, force);
+					 &new_size, force, type, level);
 
       /* Compression would make section larger, don't change anything.  */
       if (out_buf == (void *) -1)
@@ -406,7 +604,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       if (elfclass == ELFCLASS32)
 	{
 	  Elf32_Chdr chdr;
-	  chdr.ch_type = ELFCOMPRESS_ZLIB;
+	  chdr.ch_type = type;
 	  chdr.ch_size = orig_size;
 	  chdr.ch_addralign = orig_addralign;
 	  if (elfdata != MY_ELFDATA)
@@ -420,7 +618,7 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       else
 	{
 	  Elf64_Chdr chdr;
-	  chdr.ch_type = ELFCOMPRESS_ZLIB;
+	  chdr.ch_type = type;
 	  chdr.ch_reserved = 0;
 	  chdr.ch_size = orig_size;
 	  chdr.ch_addralign = sh_addralign;
@@ -514,3 +712,9 @@ elf_compress (Elf_Scn *scn, int type, unsigned int flags)
       return -1;
     }
 }
+
+int
+elf_compress (Elf_Scn *scn, int type, unsigned int flags)
+{
+  return elf_compress_level (scn, type, 0, flags);
+}
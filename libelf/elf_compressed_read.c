@@ -0,0 +1,422 @@
+/* Read the decompressed data of a section piece by piece.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <libelf.h>
+#include <system.h>
+#include "libelfP.h"
+#include "common.h"
+
+#include <endian.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#ifdef USE_ZSTD
+# include <zstd.h>
+#endif
+
+
+struct __libelf_zstream
+{
+  Elf64_Word ch_type;
+
+  /* The size of the decompressed data, and how much of it has been
+     decompressed so far.  */
+  size_t size;
+  size_t pos;
+
+  /* The compressed data.  */
+  unsigned char *in;
+  size_t in_size;
+
+  /* In paged mode the compressed data is not all in memory.  Then IN
+     holds the next piece of it, read from IN_OFFSET in SCN on.
+     IN_READ bytes of it were read so far, always all of it when not
+     in paged mode.  */
+  Elf_Scn *scn;
+  size_t in_offset;
+  size_t in_read;
+
+  union
+  {
+    z_stream z;
+#ifdef USE_ZSTD
+    struct
+    {
+      ZSTD_DStream *stream;
+      ZSTD_inBuffer in;
+    } zstd;
+#endif
+  };
+};
+
+void
+internal_function
+__libelf_zstream_free (struct __libelf_zstream *zs)
+{
+  if (zs == NULL)
+    return;
+
+#ifdef USE_ZSTD
+  if (zs->ch_type == ELFCOMPRESS_ZSTD)
+    ZSTD_freeDStream (zs->zstd.stream);
+  else
+#endif
+    inflateEnd (&zs->z);
+  if (zs->scn != NULL)
+    free (zs->in);
+  free (zs);
+}
+
+/* How much of the compressed data is read at once in paged mode.  */
+#define IN_CHUNK_SIZE	(64 * 1024)
+
+/* In paged mode read the next piece of the compressed data once all
+   of the previous piece was used.  */
+static int
+zstream_fill (struct __libelf_zstream *zs)
+{
+  if (zs->scn == NULL || zs->in_read == zs->in_size)
+    return 0;
+
+#ifdef USE_ZSTD
+  if (zs->ch_type == ELFCOMPRESS_ZSTD
+      ? zs->zstd.in.pos < zs->zstd.in.size
+      : zs->z.avail_in > 0)
+    return 0;
+#else
+  if (zs->z.avail_in > 0)
+    return 0;
+#endif
+
+  size_t n = MIN (IN_CHUNK_SIZE, zs->in_size - zs->in_read);
+  ssize_t nread = INTUSE(elf_rawdata_read) (zs->scn, zs->in, n,
+					     zs->in_offset + zs->in_read);
+  if (nread < 0)
+    return -1;
+  if ((size_t) nread != n)
+    {
+      __libelf_seterrno (ELF_E_INVALID_DATA);
+      return -1;
+    }
+  zs->in_read += n;
+
+#ifdef USE_ZSTD
+  if (zs->ch_type == ELFCOMPRESS_ZSTD)
+    {
+      zs->zstd.in.src = zs->in;
+      zs->zstd.in.size = n;
+      zs->zstd.in.pos = 0;
+      return 0;
+    }
+#endif
+  zs->z.next_in = zs->in;
+  zs->z.avail_in = n;
+  return 0;
+}
+
+/* Start decompressing from the beginning again.  */
+static int
+zstream_reset (struct __libelf_zstream *zs)
+{
+  zs->pos = 0;
+  if (zs->scn != NULL)
+    zs->in_read = 0;
+#ifdef USE_ZSTD
+  if (zs->ch_type == ELFCOMPRESS_ZSTD)
+    {
+      zs->zstd.in.pos = 0;
+      if (zs->scn != NULL)
+	zs->zstd.in.size = 0;
+      if (ZSTD_isError (ZSTD_initDStream (zs->zstd.stream)))
+	goto error;
+      return 0;
+    }
+#endif
+
+  zs->z.next_in = zs->in;
+  zs->z.avail_in = zs->scn != NULL ? 0 : zs->in_size;
+  if (inflateReset (&zs->z) == Z_OK)
+    return 0;
+
+#ifdef USE_ZSTD
+ error:
+#endif
+  __libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+  return -1;
+}
+
+/* Set up the decompression of SCN, either compressed with
+   elf_compress or with elf_compress_gnu.  In paged mode, unless the
+   data was already read, only the header is read now.  */
+static struct __libelf_zstream *
+zstream_begin (Elf_Scn *scn)
+{
+  GElf_Shdr shdr_mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+  if (shdr == NULL)
+    return NULL;
+
+  Elf *elf = scn->elf;
+  bool paged = elf->pages != NULL && scn->data_read == 0;
+
+  /* The start of the data, holding the header.  */
+  unsigned char head[sizeof (Elf64_Chdr)];
+  const unsigned char *buf;
+  size_t size;
+  if (paged)
+    {
+      ssize_t n = INTUSE(elf_rawdata_read) (scn, head, sizeof head, 0);
+      if (n < 0)
+	return NULL;
+      buf = head;
+      size = shdr->sh_type == SHT_NOBITS ? 0 : shdr->sh_size;
+      if ((size_t) n < MIN (size, sizeof head))
+	{
+	  __libelf_seterrno (ELF_E_INVALID_DATA);
+	  return NULL;
+	}
+    }
+  else
+    {
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data == NULL)
+	return NULL;
+      buf = data->d_buf;
+      size = data->d_size;
+    }
+
+  struct __libelf_zstream *zs = calloc (1, sizeof *zs);
+  if (zs == NULL)
+    {
+      __libelf_seterrno (ELF_E_NOMEM);
+      return NULL;
+    }
+
+  size_t hsize;
+  if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
+    {
+      hsize = (elf->class == ELFCLASS32
+	       ? sizeof (Elf32_Chdr) : sizeof (Elf64_Chdr));
+      GElf_Chdr chdr;
+      if (paged)
+	{
+	  /* Like gelf_getchdr, but without reading all of the data.  */
+	  if (size < hsize)
+	    {
+	      __libelf_seterrno (ELF_E_INVALID_DATA);
+	      goto fail;
+	    }
+	  if (elf->state.elf32.ehdr->e_ident[EI_DATA] != MY_ELFDATA)
+	    (*__elf_xfctstom[LIBELF_EV_IDX][LIBELF_EV_IDX][elf->class - 1]
+	     [ELF_T_CHDR]) (head, head, hsize, 0);
+	  if (elf->class == ELFCLASS32)
+	    {
+	      Elf32_Chdr chdr32;
+	      memcpy (&chdr32, head, sizeof chdr32);
+	      chdr.ch_type = chdr32.ch_type;
+	      chdr.ch_size = chdr32.ch_size;
+	    }
+	  else
+	    memcpy (&chdr, head, sizeof chdr);
+	}
+      else if (gelf_getchdr (scn, &chdr) == NULL)
+	goto fail;
+      if (! __libelf_compress_type_supported (chdr.ch_type))
+	{
+	  __libelf_seterrno (ELF_E_UNKNOWN_COMPRESSION_TYPE);
+	  goto fail;
+	}
+
+      zs->ch_type = chdr.ch_type;
+      zs->size = chdr.ch_size;
+    }
+  else
+    {
+      /* Like elf_compress_gnu, check for the "ZLIB" magic followed by
+	 the big endian uncompressed size.  */
+      hsize = 4 + 8;
+      uint64_t gsize;
+      if (shdr->sh_type == SHT_NOBITS || size < hsize
+	  || memcmp (buf, "ZLIB", 4) != 0)
+	{
+	  __libelf_seterrno (ELF_E_NOT_COMPRESSED);
+	  goto fail;
+	}
+      memcpy (&gsize, buf + 4, sizeof gsize);
+      gsize = be64toh (gsize);
+      if (gsize != (size_t) gsize)
+	{
+	  __libelf_seterrno (ELF_E_NOT_COMPRESSED);
+	  goto fail;
+	}
+
+      zs->ch_type = ELFCOMPRESS_ZLIB;
+      zs->size = gsize;
+    }
+
+  zs->in_size = size - hsize;
+  zs->in_read = zs->in_size;
+  if (paged)
+    {
+      zs->in = malloc (MIN (IN_CHUNK_SIZE, zs->in_size) ?: 1);
+      if (zs->in == NULL)
+	{
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  goto fail;
+	}
+      zs->scn = scn;
+      zs->in_offset = hsize;
+    }
+  else
+    zs->in = (unsigned char *) buf + hsize;
+
+#ifdef USE_ZSTD
+  if (zs->ch_type == ELFCOMPRESS_ZSTD)
+    {
+      zs->zstd.stream = ZSTD_createDStream ();
+      if (zs->zstd.stream == NULL)
+	{
+	  __libelf_seterrno (ELF_E_NOMEM);
+	  goto fail;
+	}
+      zs->zstd.in.src = zs->in;
+      zs->zstd.in.size = zs->in_size;
+    }
+  else
+#endif
+    if (inflateInit (&zs->z) != Z_OK)
+      {
+	__libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+	goto fail;
+      }
+
+  if (zstream_reset (zs) == 0)
+    return zs;
+
+  __libelf_zstream_free (zs);
+  return NULL;
+
+ fail:
+  if (zs->scn != NULL)
+    free (zs->in);
+  free (zs);
+  return NULL;
+}
+
+/* Decompress the next N bytes into OUT.  */
+static int
+zstream_read (struct __libelf_zstream *zs, void *out, size_t n)
+{
+#ifdef USE_ZSTD
+  if (zs->ch_type == ELFCOMPRESS_ZSTD)
+    {
+      ZSTD_outBuffer zout = { .dst = out, .size = n, .pos = 0 };
+      while (zout.pos < zout.size)
+	{
+	  if (zstream_fill (zs) != 0)
+	    return -1;
+	  size_t done = zout.pos;
+	  size_t ret = ZSTD_decompressStream (zs->zstd.stream, &zout,
+					      &zs->zstd.in);
+	  if (unlikely (ZSTD_isError (ret))
+	      || (zout.pos == done && zs->zstd.in.pos == zs->zstd.in.size))
+	    goto error;
+	}
+      zs->pos += n;
+      return 0;
+    }
+#endif
+
+  zs->z.next_out = out;
+  zs->z.avail_out = n;
+  while (zs->z.avail_out > 0)
+    {
+      if (zstream_fill (zs) != 0)
+	return -1;
+      int zrc = inflate (&zs->z, Z_NO_FLUSH);
+      if (zrc == Z_STREAM_END)
+	{
+	  /* There might be another stream after this one, see
+	     __libelf_decompress.  */
+	  if (zs->z.avail_out > 0
+	      && ((zs->z.avail_in == 0 && zs->in_read == zs->in_size)
+		  || inflateReset (&zs->z) != Z_OK))
+	    goto error;
+	}
+      else if (unlikely (zrc != Z_OK))
+	goto error;
+    }
+  zs->pos += n;
+  return 0;
+
+ error:
+  /* Where the stream is now is unknown, start again next time.  */
+  zs->pos = (size_t) -1;
+  __libelf_seterrno (ELF_E_DECOMPRESS_ERROR);
+  return -1;
+}
+
+ssize_t
+elf_compressed_read (Elf_Scn *scn, void *buf, size_t size, size_t offset)
+{
+  if (scn == NULL)
+    return -1;
+
+  struct __libelf_zstream *zs = scn->zstream;
+  if (zs == NULL)
+    {
+      zs = zstream_begin (scn);
+      if (zs == NULL)
+	return -1;
+      scn->zstream = zs;
+    }
+
+  if (offset >= zs->size)
+    return 0;
+  if (size > zs->size - offset)
+    size = zs->size - offset;
+
+  /* Streams can only be decompressed forward.  */
+  if (offset < zs->pos && zstream_reset (zs) != 0)
+    return -1;
+
+  /* Decompress and drop the data up to OFFSET.  */
+  unsigned char skip[16 * 1024];
+  while (zs->pos < offset)
+    if (zstream_read (zs, skip, MIN (sizeof skip, offset - zs->pos)) != 0)
+      return -1;
+
+  if (zstream_read (zs, buf, size) != 0)
+    return -1;
+
+  return size;
+}
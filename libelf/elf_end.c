@@ -34,6 +34,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include <sys/mman.h>
 
 #include "libelfP.h"
@@ -155,6 +156,7 @@ elf_end (Elf *elf)
 		   freed below.  */
 		if (scn->zdata_base != scn->rawdata_base)
 		  free (scn->zdata_base);
+		__libelf_zstream_free (scn->zstream);
 
 		/* If the file has the same byte order and the
 		   architecture doesn't require overly stringent
@@ -227,6 +229,12 @@ elf_end (Elf *elf)
 	munmap (elf->map_address, elf->maximum_size);
     }
 
+  __libelf_pages_free (elf->pages);
+
+  /* Close our descriptor of the file the data might have come from.  */
+  if (elf->source_map != NULL && elf->source_fd != -1)
+    close (elf->source_fd);
+
   rwlock_unlock (elf->lock);
   rwlock_fini (elf->lock);
 
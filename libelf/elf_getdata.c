@@ -310,7 +310,7 @@ __libelf_set_rawdata_wrlock (Elf_Scn *scn)
 	  scn->rawdata_base = scn->rawdata.d.d_buf
 	    = (char *) elf->map_address + elf->start_offset + offset;
 	}
-      else if (likely (elf->fildes != -1))
+      else if (likely (elf->fildes != -1) || elf->pages != NULL)
 	{
 	  /* First see whether the information in the section header is
 	     valid and it does not ask for too much.  Check for unsigned
@@ -333,15 +333,31 @@ __libelf_set_rawdata_wrlock (Elf_Scn *scn)
 	      return 1;
 	    }
 
-	  ssize_t n = pread_retry (elf->fildes, scn->rawdata.d.d_buf, size,
-				   elf->start_offset + offset);
-	  if (unlikely ((size_t) n != size))
+	  if (elf->pages != NULL)
 	    {
-	      /* Cannot read the data.  */
-	      free (scn->rawdata.d.d_buf);
-	      scn->rawdata_base = scn->rawdata.d.d_buf = NULL;
-	      __libelf_seterrno (ELF_E_READ_ERROR);
-	      return 1;
+	      /* In paged mode use the pages already read, also when the
+		 file descriptor is done, and keep the ones read now for
+		 later partial reads.  */
+	      if (unlikely (__libelf_pages_read (elf, scn->rawdata.d.d_buf,
+						 size, offset) != 0))
+		{
+		  free (scn->rawdata.d.d_buf);
+		  scn->rawdata_base = scn->rawdata.d.d_buf = NULL;
+		  return 1;
+		}
+	    }
+	  else
+	    {
+	      ssize_t n = pread_retry (elf->fildes, scn->rawdata.d.d_buf, size,
+				       elf->start_offset + offset);
+	      if (unlikely ((size_t) n != size))
+		{
+		  /* Cannot read the data.  */
+		  free (scn->rawdata.d.d_buf);
+		  scn->rawdata_base = scn->rawdata.d.d_buf = NULL;
+		  __libelf_seterrno (ELF_E_READ_ERROR);
+		  return 1;
+		}
 	    }
 	}
       else
@@ -93,6 +93,25 @@ elf_getdata_rawchunk (Elf *elf, off_t offset, size_t size, Elf_Type type)
 	  flags = ELF_F_MALLOCED;
 	}
     }
+  else if (elf->pages != NULL)
+    {
+      /* In paged mode only the pages holding the chunk are read.  */
+      rawchunk = malloc (size);
+      if (rawchunk == NULL)
+	goto nomem;
+
+      /* The page cache is changed.  */
+      rwlock_unlock (elf->lock);
+      rwlock_wrlock (elf->lock);
+
+      if (__libelf_pages_read (elf, rawchunk, size, offset) != 0)
+	{
+	  free (rawchunk);
+	  goto out;
+	}
+
+      flags = ELF_F_MALLOCED;
+    }
   else
     {
       /* We allocate the memory and read the data from the file.  */
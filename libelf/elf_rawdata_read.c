@@ -0,0 +1,139 @@
+/* Read part of the uninterpreted data of a section.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+
+#include <system.h>
+#include "libelfP.h"
+#include "common.h"
+
+
+/* Read from the file, the lock of ELF must be held for writing.  */
+static ssize_t
+read_file (Elf_Scn *scn, void *buf, size_t size, size_t offset)
+{
+  Elf *elf = scn->elf;
+  size_t sh_offset, sh_size;
+  int type;
+  if (elf->class == ELFCLASS32)
+    {
+      Elf32_Shdr *shdr = scn->shdr.e32 ?: __elf32_getshdr_wrlock (scn);
+      if (shdr == NULL)
+	return -1;
+      sh_offset = shdr->sh_offset;
+      sh_size = shdr->sh_size;
+      type = shdr->sh_type;
+    }
+  else
+    {
+      Elf64_Shdr *shdr = scn->shdr.e64 ?: __elf64_getshdr_wrlock (scn);
+      if (shdr == NULL)
+	return -1;
+      sh_offset = shdr->sh_offset;
+      sh_size = shdr->sh_size;
+      type = shdr->sh_type;
+    }
+
+  if (type == SHT_NOBITS || offset >= sh_size)
+    return 0;
+
+  /* Check for unsigned overflow like __libelf_set_rawdata.  */
+  if (unlikely (sh_offset > elf->maximum_size
+		|| elf->maximum_size - sh_offset < sh_size))
+    {
+      __libelf_seterrno (ELF_E_INVALID_SECTION_HEADER);
+      return -1;
+    }
+
+  size = MIN (size, sh_size - offset);
+  off_t pos = sh_offset + offset;
+  if (elf->map_address != NULL)
+    memcpy (buf, elf->map_address + elf->start_offset + pos, size);
+  else if (elf->pages != NULL)
+    {
+      if (__libelf_pages_read (elf, buf, size, pos) != 0)
+	return -1;
+    }
+  else if (unlikely (elf->fildes == -1))
+    {
+      __libelf_seterrno (ELF_E_FD_DISABLED);
+      return -1;
+    }
+  else if (unlikely ((size_t) pread_retry (elf->fildes, buf, size,
+					   elf->start_offset + pos) != size))
+    {
+      __libelf_seterrno (ELF_E_READ_ERROR);
+      return -1;
+    }
+
+  return size;
+}
+
+ssize_t
+elf_rawdata_read (Elf_Scn *scn, void *buf, size_t size, size_t offset)
+{
+  if (scn == NULL || scn->elf->kind != ELF_K_ELF)
+    {
+      __libelf_seterrno (ELF_E_INVALID_HANDLE);
+      return -1;
+    }
+
+  /* Like elf_rawdata only the data read from the file is raw.  */
+  if (scn->data_read != 0 && (scn->flags & ELF_F_FILEDATA) == 0)
+    {
+      __libelf_seterrno (ELF_E_DATA_MISMATCH);
+      return -1;
+    }
+
+  ssize_t result;
+  rwlock_wrlock (scn->elf->lock);
+
+  /* Use what was already read, it might also have been changed by
+     elf_compress.  */
+  if (scn->data_read != 0)
+    {
+      Elf_Data *data = &scn->rawdata.d;
+      if (offset >= data->d_size)
+	result = 0;
+      else
+	{
+	  result = MIN (size, data->d_size - offset);
+	  memcpy (buf, data->d_buf + offset, result);
+	}
+    }
+  else
+    result = read_file (scn, buf, size, offset);
+
+  rwlock_unlock (scn->elf->lock);
+
+  return result;
+}
+INTDEF(elf_rawdata_read)
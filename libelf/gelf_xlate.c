@@ -81,6 +81,136 @@ union unaligned
 
 #endif
 
+
+/* Most of the data which has to be converted are arrays: sections of
+   words, addresses, relocations or symbols.  On x86 these are byte
+   swapped 16 or 32 bytes at a time with byte shuffles, if the
+   processor has SSSE3 or AVX2.  Each mask gives for every byte of a
+   16 byte chunk where it comes from.  Records which don't fit a chunk
+   evenly use one mask for each chunk of a block holding a whole number
+   of records.  Whatever doesn't fill a whole block is left to the
+   caller.  */
+#if HAVE_X86_SHUFFLE
+# include <immintrin.h>
+
+/* The most chunks of any block.  */
+# define MAX_MASKS 3
+
+static const unsigned char bswap_16_mask[1][16] =
+  { { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 } };
+static const unsigned char bswap_32_mask[1][16] =
+  { { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 } };
+static const unsigned char bswap_64_mask[1][16] =
+  { { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 } };
+static const unsigned char bswap_32x3_mask[3][16] =
+  {
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 }
+  };
+static const unsigned char bswap_64x3_mask[3][16] =
+  {
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+  };
+
+/* st_name, st_value, st_size, st_info, st_other, st_shndx.  */
+static const unsigned char sym_32_mask[1][16] =
+  { { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 12, 13, 15, 14 } };
+
+/* st_name, st_info, st_other, st_shndx, st_value, st_size, twice
+   in three chunks.  */
+static const unsigned char sym_64_mask[3][16] =
+  {
+    { 3, 2, 1, 0, 4, 5, 7, 6, 15, 14, 13, 12, 11, 10, 9, 8 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 11, 10, 9, 8, 12, 13, 15, 14 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+  };
+
+__attribute__ ((target ("ssse3")))
+static size_t
+shuffle_ssse3 (void *dest, const void *src, size_t len,
+	       const unsigned char (*masks)[16], size_t nmasks)
+{
+  size_t done = 0;
+  while (len - done >= 16 * nmasks)
+    for (size_t m = 0; m < nmasks; ++m)
+      {
+	__m128i mask = _mm_loadu_si128 ((const __m128i *) masks[m]);
+	__m128i v = _mm_loadu_si128 ((const __m128i *) (src + done));
+	_mm_storeu_si128 ((__m128i *) (dest + done),
+			  _mm_shuffle_epi8 (v, mask));
+	done += 16;
+      }
+  return done;
+}
+
+__attribute__ ((target ("avx2")))
+static size_t
+shuffle_avx2 (void *dest, const void *src, size_t len,
+	      const unsigned char (*masks)[16], size_t nmasks)
+{
+  /* The shuffle works on each 16 byte lane separately, so every 32
+     byte vector needs the masks of two consecutive chunks.  */
+  __m256i vmasks[MAX_MASKS];
+  for (size_t m = 0; m < nmasks; ++m)
+    {
+      __m128i lo = _mm_loadu_si128 ((const __m128i *) masks[2 * m % nmasks]);
+      __m128i hi = _mm_loadu_si128 ((const __m128i *)
+				    masks[(2 * m + 1) % nmasks]);
+      vmasks[m] = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo),
+					   hi, 1);
+    }
+
+  size_t done = 0;
+  while (len - done >= 32 * nmasks)
+    for (size_t m = 0; m < nmasks; ++m)
+      {
+	__m256i v = _mm256_loadu_si256 ((const __m256i *) (src + done));
+	_mm256_storeu_si256 ((__m256i *) (dest + done),
+			     _mm256_shuffle_epi8 (v, vmasks[m]));
+	done += 32;
+      }
+  return done;
+}
+
+/* Convert as much of the LEN bytes at SRC as possible into DEST.  The
+   buffers must not overlap, except when DEST comes first.  Returns
+   the number of bytes done.  */
+static size_t
+shuffle (void *dest, const void *src, size_t len,
+	 const unsigned char (*masks)[16], size_t nmasks)
+{
+  if (__builtin_cpu_supports ("avx2"))
+    return shuffle_avx2 (dest, src, len, masks, nmasks);
+  if (__builtin_cpu_supports ("ssse3"))
+    return shuffle_ssse3 (dest, src, len, masks, nmasks);
+  return 0;
+}
+# define SHUFFLE(dest, src, len, masks) \
+  shuffle (dest, src, len, masks, sizeof (masks) / sizeof (masks)[0])
+#else
+# define SHUFFLE(dest, src, len, masks) ((size_t) 0)
+#endif
+
+/* Swap as many of the LEN bytes of SIZE byte values as can be done in
+   bulk.  Returns the number of bytes done.  */
+static inline size_t
+bswap_array (size_t size, void *dest, const void *src, size_t len)
+{
+  if (dest > src && dest < src + len)
+    return 0;
+
+  switch (size)
+    {
+    case 2: return SHUFFLE (dest, src, len, bswap_16_mask);
+    case 4: return SHUFFLE (dest, src, len, bswap_32_mask);
+    case 8: return SHUFFLE (dest, src, len, bswap_64_mask);
+    default: return 0;
+    }
+}
+
 /* Now define the conversion functions for the basic types.  We use here
    the fact that file and memory types are the same and that we have the
    ELFxx_FSZ_* macros.
@@ -108,7 +238,11 @@ union unaligned
 		     int encode __attribute__ ((unused)))		      \
   {									      \
     size_t n = len / sizeof (TName);					      \
-    if (dest < ptr)							      \
+    size_t done = bswap_array (Bytes, dest, ptr, n * Bytes);		      \
+    dest += done;							      \
+    ptr += done;							      \
+    n -= done / Bytes;							      \
+    if (dest <= ptr)							      \
       while (n-- > 0)							      \
 	{								      \
 	  FName##1 (dest, ptr);						      \
@@ -117,8 +251,8 @@ union unaligned
 	}								      \
     else								      \
       {									      \
-	dest += len;							      \
-	ptr += len;							      \
+	dest += n * Bytes;						      \
+	ptr += n * Bytes;						      \
 	while (n-- > 0)							      \
 	  {								      \
 	    ptr -= Bytes;						      \
@@ -161,6 +295,31 @@ union unaligned
 #include "gelf_xlate.h"
 
 
+/* Relocations and dynamic section entries only have fields of one
+   size, they are converted like arrays of words.  Records of three
+   words need a block of three chunks to end on a record boundary.  The
+   symbols have their own masks.  Whatever is not done in bulk is
+   converted record by record.  */
+#define ARRAY(Bits, Name, Masks)					      \
+  static void								      \
+  ElfW2 (Bits, cvt_##Name##_array) (void *dest, const void *src,	      \
+				    size_t len, int encode)		      \
+  {									      \
+    size_t done = 0;							      \
+    if (dest <= src || dest >= src + len)				      \
+      done = SHUFFLE (dest, src, len, Masks);				      \
+    ElfW2 (Bits, cvt_##Name) (dest + done, src + done, len - done, encode);   \
+  }
+ARRAY (32, Sym, sym_32_mask)
+ARRAY (32, Rel, bswap_32_mask)
+ARRAY (32, Rela, bswap_32x3_mask)
+ARRAY (32, Dyn, bswap_32_mask)
+ARRAY (64, Sym, sym_64_mask)
+ARRAY (64, Rel, bswap_64_mask)
+ARRAY (64, Rela, bswap_64x3_mask)
+ARRAY (64, Dyn, bswap_64_mask)
+
+
 /* We have a few functions which we must create by hand since the sections
    do not contain records of only one type.  */
 #include "version_xlate.h"
@@ -178,16 +337,16 @@ const xfct_t __elf_xfctstom[EV_NUM - 1][EV_NUM - 1][ELFCLASSNUM - 1][ELF_T_NUM]
 #define define_xfcts(Bits) \
 	[ELF_T_BYTE]	= elf_cvt_Byte,					      \
 	[ELF_T_ADDR]	= ElfW2(Bits, cvt_Addr),			      \
-	[ELF_T_DYN]	= ElfW2(Bits, cvt_Dyn),				      \
+	[ELF_T_DYN]	= ElfW2(Bits, cvt_Dyn_array),			      \
 	[ELF_T_EHDR]	= ElfW2(Bits, cvt_Ehdr),			      \
 	[ELF_T_HALF]	= ElfW2(Bits, cvt_Half),			      \
 	[ELF_T_OFF]	= ElfW2(Bits, cvt_Off),				      \
 	[ELF_T_PHDR]	= ElfW2(Bits, cvt_Phdr),			      \
-	[ELF_T_RELA]	= ElfW2(Bits, cvt_Rela),			      \
-	[ELF_T_REL]	= ElfW2(Bits, cvt_Rel),				      \
+	[ELF_T_RELA]	= ElfW2(Bits, cvt_Rela_array),			      \
+	[ELF_T_REL]	= ElfW2(Bits, cvt_Rel_array),			      \
 	[ELF_T_SHDR]	= ElfW2(Bits, cvt_Shdr),			      \
 	[ELF_T_SWORD]	= ElfW2(Bits, cvt_Sword),			      \
-	[ELF_T_SYM]	= ElfW2(Bits, cvt_Sym),				      \
+	[ELF_T_SYM]	= ElfW2(Bits, cvt_Sym_array),			      \
 	[ELF_T_WORD]	= ElfW2(Bits, cvt_Word),			      \
 	[ELF_T_XWORD]	= ElfW2(Bits, cvt_Xword),			      \
 	[ELF_T_SXWORD]	= ElfW2(Bits, cvt_Sxword),			      \
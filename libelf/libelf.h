@@ -129,6 +129,7 @@ typedef enum
   ELF_C_READ_MMAP_PRIVATE,	/* Read, but memory is writable, results are
 				   not written to the file.  */
   ELF_C_EMPTY,			/* Copy basic file data but not the content. */
+  ELF_C_PAGED,			/* Read pages of the file only on demand.  */
   /* Keep this the last entry.  */
   ELF_C_NUM
 } Elf_Cmd;
@@ -197,7 +198,12 @@ typedef struct Elf_Scn Elf_Scn;
 extern "C" {
 #endif
 
-/* Return descriptor for ELF file to work according to CMD.  */
+/* Return descriptor for ELF file to work according to CMD.  With
+   ELF_C_WRITE, REF can be the descriptor opened with ELF_C_READ_MMAP
+   the new file is made from.  Section data which still points into
+   the file mapping of REF is then copied directly from the file by
+   elf_update.  As for any data taken from REF, REF must not be ended
+   before the new descriptor is written.  */
 extern Elf *elf_begin (int __fildes, Elf_Cmd __cmd, Elf *__ref);
 
 /* Create a clone of an existing ELF descriptor.  */
@@ -322,7 +328,8 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
 
    elf_compress takes a compression type that should be either zero to
    decompress or an ELFCOMPRESS algorithm to use for compression.
-   Currently only ELFCOMPRESS_ZLIB is supported.  elf_compress_gnu
+   ELFCOMPRESS_ZLIB is supported, and ELFCOMPRESS_ZSTD if libelf was
+   built with zstd.  elf_compress_gnu
    will compress in the traditional GNU compression format when
    compress is one and decompress the section data when compress is
    zero.
@@ -359,6 +366,34 @@ extern Elf64_Chdr *elf64_getchdr (Elf_Scn *__scn);
 extern int elf_compress (Elf_Scn *scn, int type, unsigned int flags);
 extern int elf_compress_gnu (Elf_Scn *scn, int compress, unsigned int flags);
 
+/* Like elf_compress, but compress with the given LEVEL of the
+   compression type.  That is 1 (fastest) to 9 (best) for
+   ELFCOMPRESS_ZLIB and 1 to ZSTD_maxCLevel () for ELFCOMPRESS_ZSTD.
+   Zero is the level elf_compress uses, the best compression for zlib
+   and the default level of zstd.  */
+extern int elf_compress_level (Elf_Scn *scn, int type, int level,
+			       unsigned int flags);
+
+/* Read SIZE bytes of the decompressed data of section SCN from OFFSET
+   on into BUF, without decompressing the whole section.  SCN must be
+   compressed like elf_compress or elf_compress_gnu do it.  Returns the
+   number of bytes read, which is less than SIZE only at the end of the
+   decompressed data, or -1 and sets elf_errno on error.
+
+   The compressed data can only be decompressed from the start.  A
+   read at or after the end of the previous read goes on from there,
+   an earlier OFFSET starts decompressing from the start again.  */
+extern ssize_t elf_compressed_read (Elf_Scn *scn, void *buf, size_t size,
+				    size_t offset);
+
+/* Read SIZE bytes of the uninterpreted data of section SCN from
+   OFFSET on into BUF.  Unless the data was already read this only
+   reads the requested bytes from the file, see elf_cntl_paged.
+   Returns the number of bytes read, which is less than SIZE only at
+   the end of the section data, or -1 and sets elf_errno on error.  */
+extern ssize_t elf_rawdata_read (Elf_Scn *scn, void *buf, size_t size,
+				 size_t offset);
+
 /* Set or clear flags for ELF file.  */
 extern unsigned int elf_flagelf (Elf *__elf, Elf_Cmd __cmd,
 				 unsigned int __flags);
@@ -420,6 +455,18 @@ extern Elf_Arsym *elf_getarsym (Elf *__elf, size_t *__narsyms);
 /* Control ELF descriptor.  */
 extern int elf_cntl (Elf *__elf, Elf_Cmd __cmd);
 
+/* Put ELF, opened for reading, in paged mode.  Then
+   elf_rawdata_read, elf_compressed_read and elf_getdata_rawchunk read
+   the file in aligned pages which are kept in a cache of at most
+   BUDGET bytes, instead of reading whole sections.  elf_getdata and
+   elf_rawdata read through the same pages, but still return the whole
+   section in a buffer of its own, which does not count against BUDGET.
+   A zero BUDGET drops the cache and ends paged mode.  elf_cntl with
+   ELF_C_PAGED uses a budget of one MiB.  This has no effect on
+   descriptors which have the whole file in memory.  Returns 0 on
+   success, -1 on error.  */
+extern int elf_cntl_paged (Elf *__elf, size_t __budget);
+
 /* Retrieve uninterpreted file contents.  */
 extern char *elf_rawfile (Elf *__elf, size_t *__nbytes);
 
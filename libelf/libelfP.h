@@ -247,6 +247,7 @@ struct Elf_Scn
   char *zdata_base;		/* The uncompressed data of the section.  */
   size_t zdata_size;		/* If zdata_base != NULL, the size of data.  */
   size_t zdata_align;		/* If zdata_base != NULL, the addralign.  */
+  struct __libelf_zstream *zstream; /* State of elf_compressed_read.  */
 
   struct Elf_ScnList *list;	/* Pointer to the section list element the
 				   data is in.  */
@@ -313,6 +314,18 @@ struct Elf
   /* Reference counting for the descriptor.  */
   int ref_count;
 
+  /* For a descriptor created with ELF_C_WRITE from a REF descriptor
+     mapped with ELF_C_READ_MMAP, the mapping of REF and a duplicate of
+     its file descriptor.  Data still pointing into SOURCE_MAP is
+     copied directly from SOURCE_FD by elf_update.  */
+  const char *source_map;
+  size_t source_size;
+  int source_fd;
+
+  /* The pages of the file read so far in paged mode, see
+     elf_cntl_paged.  NULL if not in paged mode.  */
+  struct __libelf_pages *pages;
+
   /* Lock to handle multithreaded programs.  */
   rwlock_define (,lock);
 
@@ -555,6 +568,11 @@ extern Elf_Data *__elf_getdata_rdlock (Elf_Scn *__scn, Elf_Data *__data)
      internal_function;
 extern Elf_Data *__elf_rawdata_internal (Elf_Scn *__scn, Elf_Data *__data)
      attribute_hidden;
+extern int __elf_cntl_paged_internal (Elf *__elf, size_t __budget)
+     attribute_hidden;
+extern ssize_t __elf_rawdata_read_internal (Elf_Scn *__scn, void *__buf,
+					    size_t __size, size_t __offset)
+     attribute_hidden;
 /* Should be called to setup first section data element if
    data_list_rear is NULL and we know data_read is set and there is
    raw data available.  Might upgrade the ELF lock from a read to a
@@ -601,18 +619,42 @@ extern GElf_Sym *__gelf_getsym_internal (Elf_Data *__data, int __ndx,
 extern uint32_t __libelf_crc32 (uint32_t crc, unsigned char *buf, size_t len)
      attribute_hidden;
 
+/* Whether sections compressed with CH_TYPE can be handled.  */
+static inline bool
+__libelf_compress_type_supported (Elf64_Word ch_type)
+{
+#ifdef USE_ZSTD
+  if (ch_type == ELFCOMPRESS_ZSTD)
+    return true;
+#endif
+  return ch_type == ELFCOMPRESS_ZLIB;
+}
+
 extern void * __libelf_compress (Elf_Scn *scn, size_t hsize, int ei_data,
 				 size_t *orig_size, size_t *orig_addralign,
-				 size_t *size, bool force)
+				 size_t *size, bool force, int ch_type,
+				 int level)
      internal_function;
 
-extern void * __libelf_decompress (void *buf_in, size_t size_in,
-				   size_t size_out) internal_function;
+extern void * __libelf_decompress (int ch_type, void *buf_in,
+				   size_t size_in, size_t size_out)
+     internal_function;
 extern void * __libelf_decompress_elf (Elf_Scn *scn,
 				       size_t *size_out, size_t *addralign)
      internal_function;
 
 
+extern void __libelf_zstream_free (struct __libelf_zstream *zs)
+     internal_function;
+
+/* Read SIZE bytes at OFFSET of ELF in paged mode through its page
+   cache.  The lock of ELF must be held for writing.  */
+extern int __libelf_pages_read (Elf *elf, void *buf, size_t size,
+				off_t offset)
+     internal_function;
+extern void __libelf_pages_free (struct __libelf_pages *pages)
+     internal_function;
+
 extern void __libelf_reset_rawdata (Elf_Scn *scn, void *buf, size_t size,
 				    size_t align, Elf_Type type)
      internal_function;
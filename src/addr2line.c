@@ -725,82 +725,71 @@ handle_address (const char *string, Dwfl *dwfl)
       Dwarf_Die *cudie = dwfl_module_addrdie (mod, addr, &bias);
 
       Dwarf_Die *scopes = NULL;
-      int nscopes = dwarf_getscopes (cudie, addr - bias, &scopes);
+      int nscopes = dwarf_getscopes_inlined (cudie, addr - bias, &scopes);
       if (nscopes < 0)
 	return 1;
 
-      if (nscopes > 0)
+      if (nscopes > 1)
 	{
-	  Dwarf_Die subroutine;
-	  Dwarf_Off dieoff = dwarf_dieoffset (&scopes[0]);
-	  dwarf_offdie (dwfl_module_getdwarf (mod, &bias),
-			dieoff, &subroutine);
-	  free (scopes);
-	  scopes = NULL;
-
-	  nscopes = dwarf_getscopes_die (&subroutine, &scopes);
-	  if (nscopes > 1)
+	  Dwarf_Die cu;
+	  Dwarf_Files *files;
+	  if (dwarf_diecu (&scopes[0], &cu, NULL, NULL) != NULL
+	      && dwarf_getsrcfiles (cudie, &files, NULL) == 0)
 	    {
-	      Dwarf_Die cu;
-	      Dwarf_Files *files;
-	      if (dwarf_diecu (&scopes[0], &cu, NULL, NULL) != NULL
-		  && dwarf_getsrcfiles (cudie, &files, NULL) == 0)
+	      for (int i = 0; i < nscopes - 1; i++)
 		{
-		  for (int i = 0; i < nscopes - 1; i++)
-		    {
-		      Dwarf_Word val;
-		      Dwarf_Attribute attr;
-		      Dwarf_Die *die = &scopes[i];
-		      if (dwarf_tag (die) != DW_TAG_inlined_subroutine)
-			continue;
+		  Dwarf_Word val;
+		  Dwarf_Attribute attr;
+		  Dwarf_Die *die = &scopes[i];
+		  if (dwarf_tag (die) != DW_TAG_inlined_subroutine)
+		    continue;
 
-		      if (pretty)
-			printf (" (inlined by) ");
+		  if (pretty)
+		    printf (" (inlined by) ");
 
-		      if (show_functions)
+		  if (show_functions)
+		    {
+		      /* Search for the parent inline or function.  It
+			 might not be directly above this inline -- e.g.
+			 there could be a lexical_block in between.  */
+		      for (int j = i + 1; j < nscopes; j++)
 			{
-			  /* Search for the parent inline or function.  It
-			     might not be directly above this inline -- e.g.
-			     there could be a lexical_block in between.  */
-			  for (int j = i + 1; j < nscopes; j++)
+			  Dwarf_Die *parent = &scopes[j];
+			  int tag = dwarf_tag (parent);
+			  if (tag == DW_TAG_inlined_subroutine
+			      || tag == DW_TAG_entry_point
+			      || tag == DW_TAG_subprogram)
 			    {
-			      Dwarf_Die *parent = &scopes[j];
-			      int tag = dwarf_tag (parent);
-			      if (tag == DW_TAG_inlined_subroutine
-				  || tag == DW_TAG_entry_point
-				  || tag == DW_TAG_subprogram)
-				{
-				  printf ("%s%s",
-					  symname (get_diename (parent)),
-					  pretty ? " at " : "\n");
-				  break;
-				}
+			      printf ("%s%s",
+				      symname (get_diename (parent)),
+				      pretty ? " at " : "\n");
+			      break;
 			    }
 			}
+		    }
 
-		      src = NULL;
-		      lineno = 0;
-		      linecol = 0;
-		      if (dwarf_formudata (dwarf_attr (die, DW_AT_call_file,
-						       &attr), &val) == 0)
-			src = dwarf_filesrc (files, val, NULL, NULL);
+		  src = NULL;
+		  lineno = 0;
+		  linecol = 0;
+		  if (dwarf_formudata (dwarf_attr (die, DW_AT_call_file,
+						   &attr), &val) == 0)
+		    src = dwarf_filesrc (files, val, NULL, NULL);
 
-		      if (dwarf_formudata (dwarf_attr (die, DW_AT_call_line,
-						       &attr), &val) == 0)
-			lineno = val;
+		  if (dwarf_formudata (dwarf_attr (die, DW_AT_call_line,
+						   &attr), &val) == 0)
+		    lineno = val;
 
-		      if (dwarf_formudata (dwarf_attr (die, DW_AT_call_column,
-						       &attr), &val) == 0)
-			linecol = val;
+		  if (dwarf_formudata (dwarf_attr (die, DW_AT_call_column,
+						   &attr), &val) == 0)
+		    linecol = val;
 
-		      if (src != NULL)
-			{
-			  print_src (src, lineno, linecol, &cu);
-			  putchar ('\n');
-			}
-		      else
-			puts ("??:0");
+		  if (src != NULL)
+		    {
+		      print_src (src, lineno, linecol, &cu);
+		      putchar ('\n');
 		    }
+		  else
+		    puts ("??:0");
 		}
 	    }
 	}
@@ -22,14 +22,20 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <locale.h>
+#include <pthread.h>
 #include <fcntl.h>
 #include <fnmatch.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
+#ifdef USE_ZSTD
+# include <zstd.h>
+#endif
 #include ELFUTILS_HEADER(elf)
 #include ELFUTILS_HEADER(ebl)
 #include ELFUTILS_HEADER(dwelf)
@@ -52,8 +58,18 @@ static const char *foutput = NULL;
 #define T_DECOMPRESS 1    /* none */
 #define T_COMPRESS_ZLIB 2 /* zlib */
 #define T_COMPRESS_GNU  3 /* zlib-gnu */
+#define T_COMPRESS_ZSTD 4 /* zstd */
 static int type = T_UNSET;
 
+/* The compression level, zero for the default of the type.  */
+static int level = 0;
+
+/* Z_BEST_COMPRESSION, zlib.h conflicts with libeu.h.  */
+#define ZLIB_MAX_LEVEL 9
+
+/* How many threads (de)compress sections.  */
+static unsigned int nthreads = 1;
+
 struct section_pattern
 {
   char *pattern;
@@ -127,13 +143,53 @@ parse_opt (int key, char *arg __attribute__ ((unused)),
 	type = T_COMPRESS_ZLIB;
       else if (strcmp ("zlib-gnu", arg) == 0 || strcmp ("gnu", arg) == 0)
 	type = T_COMPRESS_GNU;
+#ifdef USE_ZSTD
+      else if (strcmp ("zstd", arg) == 0)
+	type = T_COMPRESS_ZSTD;
+#endif
       else
 	argp_error (state, N_("unknown compression type '%s'"), arg);
       break;
 
+    case 'l':
+      {
+	char *end;
+	long int l = strtol (arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || l < 1 || l > INT_MAX)
+	  argp_error (state, N_("invalid compression level '%s'"), arg);
+	level = l;
+      }
+      break;
+
+    case 'j':
+      {
+	char *end;
+	unsigned long int n = strtoul (arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || n > UINT_MAX)
+	  argp_error (state, N_("invalid number of jobs '%s'"), arg);
+	if (n == 0)
+	  {
+	    long int ncpus = sysconf (_SC_NPROCESSORS_ONLN);
+	    n = ncpus > 0 ? ncpus : 1;
+	  }
+	nthreads = n;
+      }
+      break;
+
     case ARGP_KEY_SUCCESS:
       if (type == T_UNSET)
 	type = T_COMPRESS_ZLIB;
+      if (level != 0 && (type == T_DECOMPRESS || type == T_COMPRESS_GNU))
+	argp_error (state,
+		    N_("-l can only be used with ELF compression types"));
+      if (type == T_COMPRESS_ZLIB && level > ZLIB_MAX_LEVEL)
+	argp_error (state, N_("compression level %d too high for zlib, "
+			      "the highest is %d"), level, ZLIB_MAX_LEVEL);
+#ifdef USE_ZSTD
+      if (type == T_COMPRESS_ZSTD && level > ZSTD_maxCLevel ())
+	argp_error (state, N_("compression level %d too high for zstd, "
+			      "the highest is %d"), level, ZSTD_maxCLevel ());
+#endif
       if (patterns == NULL)
 	add_pattern (".?(z)debug*");
       break;
@@ -193,17 +249,35 @@ setshdrstrndx (Elf *elf, GElf_Ehdr *ehdr, size_t ndx)
   return 0;
 }
 
+/* Returns the T_COMPRESS type SCN is compressed with, it must have
+   SHF_COMPRESSED set.  */
+static int
+compressed_type (Elf_Scn *scn)
+{
+  GElf_Chdr chdr;
+  if (gelf_getchdr (scn, &chdr) != NULL && chdr.ch_type == ELFCOMPRESS_ZSTD)
+    return T_COMPRESS_ZSTD;
+  return T_COMPRESS_ZLIB;
+}
+
+/* (De)compress SCN with CTYPE, which is T_COMPRESS_GNU for GNU style
+   compression and otherwise the ELF compression type.  Decompressing
+   ELF compression works for every type.  Reports go to OUT.  */
 static int
 compress_section (Elf_Scn *scn, size_t orig_size, const char *name,
 		  const char *newname, size_t ndx,
-		  bool gnu, bool compress, bool report_verbose)
+		  int ctype, bool compress, bool report_verbose, FILE *out)
 {
   int res;
   unsigned int flags = compress && force ? ELF_CHF_FORCE : 0;
-  if (gnu)
+  if (ctype == T_COMPRESS_GNU)
     res = elf_compress_gnu (scn, compress ? 1 : 0, flags);
+  else if (! compress)
+    res = elf_compress (scn, 0, flags);
   else
-    res = elf_compress (scn, compress ? ELFCOMPRESS_ZLIB : 0, flags);
+    res = elf_compress_level (scn, (ctype == T_COMPRESS_ZSTD
+				    ? ELFCOMPRESS_ZSTD : ELFCOMPRESS_ZLIB),
+			      level, flags);
 
   if (res < 0)
     error (0, 0, "Couldn't decompress section [%zd] %s: %s",
@@ -213,16 +287,16 @@ compress_section (Elf_Scn *scn, size_t orig_size, const char *name,
       if (compress && res == 0)
 	{
 	  if (verbose >= 0)
-	    printf ("[%zd] %s NOT compressed, wouldn't be smaller\n",
-		    ndx, name);
+	    fprintf (out, "[%zd] %s NOT compressed, wouldn't be smaller\n",
+		     ndx, name);
 	}
 
       if (report_verbose && res > 0)
 	{
-	  printf ("[%zd] %s %s", ndx, name,
-		  compress ? "compressed" : "decompressed");
+	  fprintf (out, "[%zd] %s %s", ndx, name,
+		   compress ? "compressed" : "decompressed");
 	  if (newname != NULL)
-	    printf (" -> %s", newname);
+	    fprintf (out, " -> %s", newname);
 
 	  /* Reload shdr, it has changed.  */
 	  GElf_Shdr shdr_mem;
@@ -234,14 +308,177 @@ compress_section (Elf_Scn *scn, size_t orig_size, const char *name,
 	    }
 	  float new = shdr->sh_size;
 	  float orig = orig_size ?: 1;
-	  printf (" (%zu => %" PRIu64 " %.2f%%)\n",
-		  orig_size, shdr->sh_size, (new / orig) * 100);
+	  fprintf (out, " (%zu => %" PRIu64 " %.2f%%)\n",
+		   orig_size, shdr->sh_size, (new / orig) * 100);
 	}
     }
 
   return res;
 }
 
+/* A matching section to (de)compress.  */
+struct section_job
+{
+  Elf_Scn *scn;
+  size_t ndx;
+  size_t size;
+  char *name;
+  char *newname;
+
+  /* Decompress first, to recompress with another type.  */
+  bool decompress_elf;
+  bool decompress_gnu;
+
+  /* (De)compress with this type, T_UNSET if nothing else to do.  */
+  int ctype;
+  bool compress;
+
+  /* The result of compress_section and its report, printed in section
+     order when all jobs are done.  */
+  int res;
+  char *report;
+  size_t report_size;
+};
+
+static void
+run_job (struct section_job *job)
+{
+  FILE *out = open_memstream (&job->report, &job->report_size);
+  if (out == NULL)
+    {
+      error (0, errno, "Couldn't create report for section [%zd]",
+	     job->ndx);
+      job->res = -1;
+      return;
+    }
+
+  job->res = 0;
+  if (job->decompress_elf)
+    job->res = compress_section (job->scn, job->size, job->name, NULL,
+				 job->ndx, T_COMPRESS_ZLIB, false, false, out);
+  if (job->res >= 0 && job->decompress_gnu)
+    job->res = compress_section (job->scn, job->size, job->name, NULL,
+				 job->ndx, T_COMPRESS_GNU, false, false, out);
+  if (job->res >= 0 && job->ctype != T_UNSET)
+    job->res = compress_section (job->scn, job->size, job->name,
+				 job->newname, job->ndx, job->ctype,
+				 job->compress, verbose > 0, out);
+
+  fclose (out);
+}
+
+struct job_queue
+{
+  struct section_job **jobs;
+  size_t njobs;
+  size_t next;
+};
+
+static void *
+job_worker (void *arg)
+{
+  struct job_queue *queue = arg;
+  while (true)
+    {
+      size_t idx = __atomic_fetch_add (&queue->next, 1, __ATOMIC_RELAXED);
+      if (idx >= queue->njobs)
+	break;
+      run_job (queue->jobs[idx]);
+    }
+  return NULL;
+}
+
+/* Biggest sections first, so a huge one doesn't end up last.  */
+static int
+compare_jobs (const void *a, const void *b)
+{
+  const struct section_job *ja = *(const struct section_job **) a;
+  const struct section_job *jb = *(const struct section_job **) b;
+  if (ja->size != jb->size)
+    return ja->size > jb->size ? -1 : 1;
+  return ja->ndx < jb->ndx ? -1 : ja->ndx > jb->ndx;
+}
+
+/* Run the JOBS, indexed by section number, on up to nthreads
+   threads.  Each job only changes its own section, so the result
+   doesn't depend on the order they run in.  */
+static int
+run_jobs (struct section_job **jobs, size_t shnum)
+{
+  struct timespec start;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  struct job_queue queue =
+    {
+      .jobs = xmalloc (shnum * sizeof (struct section_job *)),
+      .njobs = 0,
+      .next = 0
+    };
+  for (size_t ndx = 0; ndx < shnum; ndx++)
+    if (jobs[ndx] != NULL
+	&& (jobs[ndx]->decompress_elf || jobs[ndx]->decompress_gnu
+	    || jobs[ndx]->ctype != T_UNSET))
+      queue.jobs[queue.njobs++] = jobs[ndx];
+  qsort (queue.jobs, queue.njobs, sizeof queue.jobs[0], compare_jobs);
+
+  /* The calling thread is a worker too.  If we cannot start as many
+     threads as requested, the ones we have do all the work.  */
+  size_t njobs = queue.njobs;
+  unsigned int nworkers = nthreads < njobs ? nthreads : njobs;
+  if (nworkers == 0)
+    nworkers = 1;
+  pthread_t *threads = xmalloc (nworkers * sizeof threads[0]);
+  unsigned int started = 1;
+  while (started < nworkers
+	 && pthread_create (&threads[started], NULL, job_worker,
+			    &queue) == 0)
+    ++started;
+
+  job_worker (&queue);
+
+  for (unsigned int cnt = 1; cnt < started; ++cnt)
+    pthread_join (threads[cnt], NULL);
+
+  free (threads);
+  free (queue.jobs);
+
+  int result = 0;
+  for (size_t ndx = 0; ndx < shnum; ndx++)
+    if (jobs[ndx] != NULL)
+      {
+	if (jobs[ndx]->report_size > 0)
+	  fwrite (jobs[ndx]->report, 1, jobs[ndx]->report_size, stdout);
+	if (jobs[ndx]->res < 0)
+	  result = -1;
+      }
+
+  if (verbose > 0)
+    {
+      struct timespec end;
+      clock_gettime (CLOCK_MONOTONIC, &end);
+      double elapsed = ((end.tv_sec - start.tv_sec)
+			+ (end.tv_nsec - start.tv_nsec) / 1e9);
+      printf ("%zd sections processed in %.3f seconds using %u threads\n",
+	      njobs, elapsed, started);
+    }
+
+  return result;
+}
+
+static void
+free_jobs (struct section_job **jobs, size_t shnum)
+{
+  for (size_t ndx = 0; ndx < shnum; ndx++)
+    if (jobs[ndx] != NULL)
+      {
+	free (jobs[ndx]->name);
+	free (jobs[ndx]->newname);
+	free (jobs[ndx]->report);
+	free (jobs[ndx]);
+      }
+  free (jobs);
+}
+
 static int
 process_file (const char *fname)
 {
@@ -269,9 +506,15 @@ process_file (const char *fname)
   /* Section data from names.  */
   void *namesbuf = NULL;
 
+  /* Copy of the symbol table data, if the names need adjusting.  */
+  void *symtabbuf = NULL;
+
   /* Which sections match and need to be (un)compressed.  */
   unsigned int *sections = NULL;
 
+  /* What to do with them, indexed by section number.  */
+  struct section_job **jobs = NULL;
+
   /* How many sections are we talking about?  */
   size_t shnum = 0;
 
@@ -308,6 +551,7 @@ process_file (const char *fname)
 	free (scnstrents);
 	free (symstrents);
 	free (namesbuf);
+	free (symtabbuf);
 	if (scnnames != NULL)
 	  {
 	    for (size_t n = 0; n < shnum; n++)
@@ -317,6 +561,8 @@ process_file (const char *fname)
       }
 
     free (sections);
+    if (jobs != NULL)
+      free_jobs (jobs, shnum);
 
     return res;
   }
@@ -328,7 +574,9 @@ process_file (const char *fname)
       return cleanup (-1);
     }
 
-  elf = elf_begin (fd, ELF_C_READ, NULL);
+  /* Mapped read-only, so data that isn't (de)compressed can be copied
+     straight from the file to the new file by elf_update.  */
+  elf = elf_begin (fd, ELF_C_READ_MMAP, NULL);
   if (elf == NULL)
     {
       error (0, 0, "Couldn't open ELF file %s for reading: %s",
@@ -423,10 +671,10 @@ process_file (const char *fname)
      to be adjusted be if the section header name table is changed.
 
      Second a collection pass that creates the Elf sections and copies
-     the data.  This pass will compress/decompress section data when
-     needed.  And it will collect all data needed if we'll need to
-     construct a new string table. Afterwards the new string table is
-     constructed.
+     the data.  Before it the section data is compressed/decompressed
+     when needed, a section per job, possibly in parallel.  And it
+     will collect all data needed if we'll need to construct a new
+     string table. Afterwards the new string table is constructed.
 
      Third a fixup/adjustment pass over the new Elf that will adjust
      any section references (names) and adjust the layout based on the
@@ -554,7 +802,7 @@ process_file (const char *fname)
       return cleanup (-1);
     }
 
-  elfnew = elf_begin (fdnew, ELF_C_WRITE, NULL);
+  elfnew = elf_begin (fdnew, ELF_C_WRITE, elf);
   if (elfnew == NULL)
     {
       error (0, 0, "Couldn't open new ELF %s for writing: %s",
@@ -636,18 +884,18 @@ process_file (const char *fname)
   char *symtab_name = NULL;
   char *symtab_newname = NULL;
 
-  /* Collection pass.  Copy over the sections, (de)compresses matching
-     sections, collect names of sections and symbol table if
-     necessary.  */
+  /* Matching sections are (de)compressed as jobs, which only touch
+     their own section and can run concurrently.  */
+  jobs = xcalloc (shnum, sizeof (struct section_job *));
+
+  /* Selection pass.  Decide what to do with the matching sections and
+     their names, the work is done in the (de)compression pass.  */
   scn = NULL;
   while ((scn = elf_nextscn (elf, scn)) != NULL)
     {
       size_t ndx = elf_ndxscn (scn);
       assert (ndx < shnum);
 
-      /* (de)compress if section matched.  */
-      char *sname = NULL;
-      char *newname = NULL;
       if (get_section (ndx))
 	{
 	  GElf_Shdr shdr_mem;
@@ -659,7 +907,7 @@ process_file (const char *fname)
 	    }
 
 	  uint64_t size = shdr->sh_size;
-	  sname = elf_strptr (elf, shdrstrndx, shdr->sh_name);
+	  const char *sname = elf_strptr (elf, shdrstrndx, shdr->sh_name);
 	  if (sname == NULL)
 	    {
 	      error (0, 0, "Couldn't get name for section %zd", ndx);
@@ -668,7 +916,13 @@ process_file (const char *fname)
 
 	  /* strdup sname, the shdrstrndx section itself might be
 	     (de)compressed, invalidating the string pointers.  */
-	  sname = xstrdup (sname);
+	  struct section_job *job = xcalloc (1, sizeof *job);
+	  job->scn = scn;
+	  job->ndx = ndx;
+	  job->size = size;
+	  job->name = xstrdup (sname);
+	  job->ctype = T_UNSET;
+	  jobs[ndx] = job;
 
 	  /* We might want to decompress (and rename), but not
 	     compress during this pass since we might need the section
@@ -682,19 +936,13 @@ process_file (const char *fname)
 	    {
 	    case T_DECOMPRESS:
 	      if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
-		{
-		  if (compress_section (scn, size, sname, NULL, ndx,
-					false, false, verbose > 0) < 0)
-		    return cleanup (-1);
-		}
+		job->ctype = T_COMPRESS_ZLIB;
 	      else if (strncmp (sname, ".zdebug", strlen (".zdebug")) == 0)
 		{
 		  snamebuf[0] = '.';
 		  strcpy (&snamebuf[1], &sname[2]);
-		  newname = snamebuf;
-		  if (compress_section (scn, size, sname, newname, ndx,
-					true, false, verbose > 0) < 0)
-		    return cleanup (-1);
+		  job->newname = xstrdup (snamebuf);
+		  job->ctype = T_COMPRESS_GNU;
 		}
 	      else if (verbose > 0)
 		printf ("[%zd] %s already decompressed\n", ndx, sname);
@@ -703,19 +951,15 @@ process_file (const char *fname)
 	    case T_COMPRESS_GNU:
 	      if (strncmp (sname, ".debug", strlen (".debug")) == 0)
 		{
+		  /* First decompress to recompress GNU style.  Don't
+		     report even when verbose.  */
 		  if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
-		    {
-		      /* First decompress to recompress GNU style.
-			 Don't report even when verbose.  */
-		      if (compress_section (scn, size, sname, NULL, ndx,
-					    false, false, false) < 0)
-			return cleanup (-1);
-		    }
+		    job->decompress_elf = true;
 
 		  snamebuf[0] = '.';
 		  snamebuf[1] = 'z';
 		  strcpy (&snamebuf[2], &sname[1]);
-		  newname = snamebuf;
+		  job->newname = xstrdup (snamebuf);
 
 		  if (skip_compress_section)
 		    {
@@ -724,26 +968,20 @@ process_file (const char *fname)
 			  shstrtab_size = size;
 			  shstrtab_compressed = T_COMPRESS_GNU;
 			  shstrtab_name = xstrdup (sname);
-			  shstrtab_newname = xstrdup (newname);
+			  shstrtab_newname = xstrdup (snamebuf);
 			}
 		      else
 			{
 			  symtab_size = size;
 			  symtab_compressed = T_COMPRESS_GNU;
 			  symtab_name = xstrdup (sname);
-			  symtab_newname = xstrdup (newname);
+			  symtab_newname = xstrdup (snamebuf);
 			}
 		    }
 		  else
 		    {
-		      int res = compress_section (scn, size, sname, newname,
-						  ndx, true, true,
-						  verbose > 0);
-		      if (res < 0)
-			return cleanup (-1);
-
-		      if (res == 0)
-			newname = NULL;
+		      job->ctype = T_COMPRESS_GNU;
+		      job->compress = true;
 		    }
 		}
 	      else if (verbose >= 0)
@@ -758,19 +996,25 @@ process_file (const char *fname)
 	      break;
 
 	    case T_COMPRESS_ZLIB:
-	      if ((shdr->sh_flags & SHF_COMPRESSED) == 0)
+	    case T_COMPRESS_ZSTD:
+	      /* First decompress to recompress with the other type.
+		 Don't report even when verbose.  */
+	      if ((shdr->sh_flags & SHF_COMPRESSED) != 0
+		  && compressed_type (scn) != type)
+		job->decompress_elf = true;
+
+	      if ((shdr->sh_flags & SHF_COMPRESSED) == 0
+		  || job->decompress_elf)
 		{
 		  if (strncmp (sname, ".zdebug", strlen (".zdebug")) == 0)
 		    {
 		      /* First decompress to recompress zlib style.
 			 Don't report even when verbose.  */
-		      if (compress_section (scn, size, sname, NULL, ndx,
-					    true, false, false) < 0)
-			return cleanup (-1);
+		      job->decompress_gnu = true;
 
 		      snamebuf[0] = '.';
 		      strcpy (&snamebuf[1], &sname[2]);
-		      newname = snamebuf;
+		      job->newname = xstrdup (snamebuf);
 		    }
 
 		  if (skip_compress_section)
@@ -778,31 +1022,52 @@ process_file (const char *fname)
 		      if (ndx == shdrstrndx)
 			{
 			  shstrtab_size = size;
-			  shstrtab_compressed = T_COMPRESS_ZLIB;
+			  shstrtab_compressed = type;
 			  shstrtab_name = xstrdup (sname);
-			  shstrtab_newname = (newname == NULL
-					      ? NULL : xstrdup (newname));
+			  shstrtab_newname = (job->newname == NULL
+					      ? NULL : xstrdup (job->newname));
 			}
 		      else
 			{
 			  symtab_size = size;
-			  symtab_compressed = T_COMPRESS_ZLIB;
+			  symtab_compressed = type;
 			  symtab_name = xstrdup (sname);
-			  symtab_newname = (newname == NULL
-					    ? NULL : xstrdup (newname));
+			  symtab_newname = (job->newname == NULL
+					    ? NULL : xstrdup (job->newname));
 			}
 		    }
-		  else if (compress_section (scn, size, sname, newname, ndx,
-					     false, true, verbose > 0) < 0)
-		    return cleanup (-1);
+		  else
+		    {
+		      job->ctype = type;
+		      job->compress = true;
+		    }
 		}
 	      else if (verbose > 0)
 		printf ("[%zd] %s already compressed\n", ndx, sname);
 	      break;
 	    }
-
-	  free (sname);
 	}
+    }
+
+  /* (De)compression pass.  */
+  if (run_jobs (jobs, shnum) != 0)
+    return cleanup (-1);
+
+  /* Collection pass.  Copy over the sections, collect names of
+     sections and symbol table if necessary.  */
+  scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      size_t ndx = elf_ndxscn (scn);
+      struct section_job *job = jobs[ndx];
+      const char *sname = job != NULL ? job->name : NULL;
+      const char *newname = job != NULL ? job->newname : NULL;
+
+      /* Not renamed after all if GNU compression wouldn't make the
+	 section smaller.  */
+      if (job != NULL && job->ctype == T_COMPRESS_GNU && job->compress
+	  && job->res == 0)
+	newname = NULL;
 
       Elf_Scn *newscn = elf_newscn (elfnew);
       if (newscn == NULL)
@@ -846,12 +1111,20 @@ process_file (const char *fname)
 	    }
 
 	  *newdata = *data;
+
+	  /* The symbol names are adjusted in place, which cannot be
+	     done in the read-only file mapping.  */
+	  if (adjust_names && ndx == symtabndx && data->d_buf != NULL)
+	    {
+	      symtabbuf = xmalloc (data->d_size);
+	      newdata->d_buf = memcpy (symtabbuf, data->d_buf, data->d_size);
+	    }
 	}
 
       /* Keep track of the (new) section names.  */
       if (adjust_names)
 	{
-	  char *name;
+	  const char *name;
 	  if (newname != NULL)
 	    name = newname;
 	  else
@@ -884,18 +1157,20 @@ process_file (const char *fname)
 		  if ((shdr->sh_flags == SHF_COMPRESSED) != 0)
 		    {
 		      /* Don't report the (internal) uncompression.  */
+		      symtab_compressed = compressed_type (newscn);
 		      if (compress_section (newscn, size, sname, NULL, ndx,
-					    false, false, false) < 0)
+					    T_COMPRESS_ZLIB, false, false,
+					    stdout) < 0)
 			return cleanup (-1);
 
 		      symtab_size = size;
-		      symtab_compressed = T_COMPRESS_ZLIB;
 		    }
 		  else if (strncmp (name, ".zdebug", strlen (".zdebug")) == 0)
 		    {
 		      /* Don't report the (internal) uncompression.  */
 		      if (compress_section (newscn, size, sname, NULL, ndx,
-					    true, false, false) < 0)
+					    T_COMPRESS_GNU, false, false,
+					    stdout) < 0)
 			return cleanup (-1);
 
 		      symtab_size = size;
@@ -1036,7 +1311,7 @@ process_file (const char *fname)
 
 	  shstrtab_size = shdr->sh_size;
 	  if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
-	    shstrtab_compressed = T_COMPRESS_ZLIB;
+	    shstrtab_compressed = compressed_type (oldscn);
 	  else if (strncmp (shstrtab_name, ".zdebug", strlen (".zdebug")) == 0)
 	    shstrtab_compressed = T_COMPRESS_GNU;
 	}
@@ -1046,8 +1321,8 @@ process_file (const char *fname)
 	{
 	  if (compress_section (scn, shstrtab_size, shstrtab_name,
 				shstrtab_newname, shdrstrndx,
-				shstrtab_compressed == T_COMPRESS_GNU,
-				true, verbose > 0) < 0)
+				shstrtab_compressed, true, verbose > 0,
+				stdout) < 0)
 	    return cleanup (-1);
 	}
     }
@@ -1177,7 +1452,7 @@ process_file (const char *fname)
 
 		  symtab_size = shdr->sh_size;
 		  if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
-		    symtab_compressed = T_COMPRESS_ZLIB;
+		    symtab_compressed = compressed_type (oldscn);
 		  else if (strncmp (symtab_name, ".zdebug",
 				    strlen (".zdebug")) == 0)
 		    symtab_compressed = T_COMPRESS_GNU;
@@ -1188,8 +1463,8 @@ process_file (const char *fname)
 		{
 		  if (compress_section (scn, symtab_size, symtab_name,
 					symtab_newname, symtabndx,
-					symtab_compressed == T_COMPRESS_GNU,
-					true, verbose > 0) < 0)
+					symtab_compressed, true,
+					verbose > 0, stdout) < 0)
 		    return cleanup (-1);
 		}
 	    }
@@ -1267,7 +1542,13 @@ main (int argc, char **argv)
 	N_("Place (de)compressed output into FILE"),
 	0 },
       { "type", 't', "TYPE", 0,
-	N_("What type of compression to apply. TYPE can be 'none' (decompress), 'zlib' (ELF ZLIB compression, the default, 'zlib-gabi' is an alias) or 'zlib-gnu' (.zdebug GNU style compression, 'gnu' is an alias)"),
+	N_("What type of compression to apply. TYPE can be 'none' (decompress), 'zlib' (ELF ZLIB compression, the default, 'zlib-gabi' is an alias), 'zlib-gnu' (.zdebug GNU style compression, 'gnu' is an alias) or 'zstd' (ELF ZSTD compression, if supported)"),
+	0 },
+      { "level", 'l', "LEVEL", 0,
+	N_("Compress with LEVEL, from 1 (fastest) to 9 for zlib or the highest zstd level (defaults to 9 for zlib and the zstd default level)"),
+	0 },
+      { "jobs", 'j', "N", 0,
+	N_("(De)compress up to N sections at the same time, 0 means one per processor (defaults to 1)"),
 	0 },
       { "name", 'n', "SECTION", 0,
 	N_("SECTION name to (de)compress, SECTION is an extended wildcard pattern (defaults to '.?(z)debug*')"),
@@ -45,6 +45,7 @@
 #include <libeu.h>
 #include <system.h>
 #include <printversion.h>
+#include <jobs.h>
 
 typedef uint8_t GElf_Byte;
 
@@ -98,16 +99,26 @@ static const char args_doc[] = N_("[FILE...]");
 /* Prototype for option handler.  */
 static error_t parse_opt (int key, char *arg, struct argp_state *state);
 
+/* Parser children.  */
+static struct argp_child argp_children[] =
+  {
+    { &jobs_argp, 0, NULL, 0 },
+    { NULL, 0, NULL, 0}
+  };
+
 /* Data structure to communicate with argp functions.  */
 static struct argp argp =
 {
-  options, parse_opt, args_doc, doc, NULL, NULL, NULL
+  options, parse_opt, args_doc, doc, argp_children, NULL, NULL
 };
 
 
 /* Print symbols in file named FNAME.  */
 static int process_file (const char *fname);
 
+/* Strip the file in the NDXth element of the FILES array.  */
+static int process_file_job (size_t ndx, void *files);
+
 /* Handle one ELF file.  */
 static int handle_elf (int fd, Elf *elf, const char *prefix,
 		       const char *fname, mode_t mode, struct timespec tvp[2]);
@@ -201,15 +212,21 @@ main (int argc, char *argv[])
 	error (EXIT_FAILURE, 0, gettext ("\
 Only one input file allowed together with '-o' and '-f'"));
 
-      /* Process all the remaining files.  */
-      do
-	result |= process_file (argv[remaining]);
-      while (++remaining < argc);
+      /* Process all the remaining files, with -j in parallel.  */
+      result = run_jobs (argc - remaining, process_file_job,
+			 &argv[remaining],
+			 (const char *const *) &argv[remaining]);
     }
 
   return result;
 }
 
+static int
+process_file_job (size_t ndx, void *files)
+{
+  return process_file (((char **) files)[ndx]);
+}
+
 
 /* Handle program arguments.  */
 static error_t
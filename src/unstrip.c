@@ -51,6 +51,7 @@
 #include "libdwelf.h"
 #include "libeu.h"
 #include "printversion.h"
+#include "jobs.h"
 
 #ifndef _
 # define _(str) gettext (str)
@@ -2314,8 +2315,27 @@ match_module (Dwfl_Module *mod,
   return DWARF_CB_OK;
 }
 
-/* Handle files opened implicitly via libdwfl.  */
-static void
+/* The modules matched for -d, run as jobs.  */
+struct output_dir_jobs
+{
+  const struct arg_info *info;
+  Dwfl_Module **mods;
+};
+
+static int
+output_dir_module_job (size_t ndx, void *arg)
+{
+  struct output_dir_jobs *jobs = arg;
+  const struct arg_info *info = jobs->info;
+  handle_output_dir_module (info->output_dir, jobs->mods[ndx], info->force,
+			    info->all, info->ignore,
+			    info->modnames, info->relocate);
+  return 0;
+}
+
+/* Handle files opened implicitly via libdwfl.  Returns the exit
+   status.  */
+static int
 handle_implicit_modules (const struct arg_info *info)
 {
   struct match_module_info mmi = { info->args, NULL, info->match_files };
@@ -2339,11 +2359,35 @@ handle_implicit_modules (const struct arg_info *info)
 			  info->all, info->ignore, info->relocate);
     }
   else
-    do
-      handle_output_dir_module (info->output_dir, mmi.found, info->force,
-				info->all, info->ignore,
-				info->modnames, info->relocate);
-    while ((offset = next (offset)) > 0);
+    {
+      /* Collect all matching modules first, so they can be handled
+	 in parallel with -j.  */
+      size_t nmods = 0;
+      size_t maxmods = 16;
+      Dwfl_Module **mods = xmalloc (maxmods * sizeof mods[0]);
+      const char **names = xmalloc (maxmods * sizeof names[0]);
+      do
+	{
+	  if (nmods == maxmods)
+	    {
+	      maxmods *= 2;
+	      mods = xrealloc (mods, maxmods * sizeof mods[0]);
+	      names = xrealloc (names, maxmods * sizeof names[0]);
+	    }
+	  mods[nmods] = mmi.found;
+	  names[nmods++] = dwfl_module_info (mmi.found, NULL, NULL, NULL,
+					     NULL, NULL, NULL, NULL);
+	}
+      while ((offset = next (offset)) > 0);
+
+      struct output_dir_jobs jobs = { info, mods };
+      int result = run_jobs (nmods, output_dir_module_job, &jobs, names);
+      free (mods);
+      free (names);
+      return result;
+    }
+
+  return 0;
 }
 
 int
@@ -2371,6 +2415,7 @@ main (int argc, char **argv)
 	.header = N_("Input selection options:"),
 	.group = 1,
       },
+      { .argp = &jobs_argp, .group = 3 },
       { .argp = NULL },
     };
   const struct argp argp =
@@ -2440,9 +2485,10 @@ or - if no debuginfo was found, or . if FILE contains the debug information.\
       /* parse_opt checked this.  */
       assert (info.output_file != NULL || info.output_dir != NULL || info.list);
 
-      handle_implicit_modules (&info);
+      result = handle_implicit_modules (&info);
 
       dwfl_end (info.dwfl);
+      return result;
     }
 
   return 0;
@@ -0,0 +1,103 @@
+/* Test program and benchmark for crc32.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#include "system.h"
+#include "libeu.h"
+
+/* Size of the buffer the throughput is measured with.  */
+#define BENCH_SIZE (64 * 1024 * 1024)
+
+/* The CRC computed one bit at a time.  */
+static uint32_t
+reference (uint32_t crc, const unsigned char *buf, size_t len)
+{
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++)
+    {
+      crc ^= buf[i];
+      for (int b = 0; b < 8; b++)
+	crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+  return ~crc;
+}
+
+int
+main (int argc, char *argv[] __attribute__ ((unused)))
+{
+  unsigned char check[] = "123456789";
+  if (crc32 (0, check, 9) != 0xcbf43926)
+    {
+      printf ("wrong CRC of \"%s\": %#" PRIx32 "\n", check,
+	      crc32 (0, check, 9));
+      return 1;
+    }
+
+  /* All lengths up to a few times the block sizes, at all alignments,
+     done in one piece and in two.  */
+  unsigned char buf[600];
+  uint64_t state = 1;
+  for (size_t i = 0; i < sizeof buf; i++)
+    buf[i] = next_random (&state);
+  for (size_t off = 0; off < 16; off++)
+    for (size_t len = 0; off + len <= sizeof buf; len++)
+      {
+	uint32_t expect = reference (0, buf + off, len);
+	size_t split = len > 0 ? next_random (&state) % len : 0;
+	uint32_t whole = crc32 (0, buf + off, len);
+	uint32_t parts = crc32 (crc32 (0, buf + off, split),
+				buf + off + split, len - split);
+	if (whole != expect || parts != expect)
+	  {
+	    printf ("wrong CRC of %zd bytes at %zd: %#" PRIx32 " %#" PRIx32
+		    ", expected %#" PRIx32 "\n", len, off, whole, parts, expect);
+	    return 1;
+	  }
+      }
+
+  /* With an argument also report the throughput.  */
+  if (argc > 1)
+    {
+      unsigned char *big = malloc (BENCH_SIZE);
+      if (big == NULL)
+	return 1;
+      for (size_t i = 0; i < BENCH_SIZE; i++)
+	big[i] = next_random (&state);
+
+      int rounds = 0;
+      uint32_t crc = 0;
+      double start = now (), elapsed;
+      do
+	{
+	  crc = crc32 (crc, big, BENCH_SIZE);
+	  ++rounds;
+	}
+      while ((elapsed = now () - start) < 0.5);
+      printf ("crc32: %.0f MB/s\n", rounds * (BENCH_SIZE / 1e6) / elapsed);
+      free (big);
+    }
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+/* Test program for measuring disassembler throughput.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <fcntl.h>
+#include ELFUTILS_HEADER(asm)
+#include <gelf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench.h"
+
+static int
+count_insn (char *buf __attribute__ ((unused)),
+	    size_t buflen __attribute__ ((unused)), void *arg)
+{
+  ++*(size_t *) arg;
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc < 3)
+    {
+      printf ("Usage: FILE COUNT [bench]\n");
+      return -1;
+    }
+
+  elf_version (EV_CURRENT);
+
+  int fd = open (argv[1], O_RDONLY);
+  if (fd < 0)
+    {
+      perror (argv[1]);
+      return -1;
+    }
+
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    {
+      printf ("elf_begin: %s\n", elf_errmsg (-1));
+      return -1;
+    }
+
+  Ebl *ebl = ebl_openbackend (elf);
+  DisasmCtx_t *ctx = ebl == NULL ? NULL : disasm_begin (ebl, elf, NULL);
+  if (ctx == NULL)
+    {
+      printf ("cannot disassemble %s\n", argv[1]);
+      return -1;
+    }
+
+  /* Disassemble all code sections COUNT times with the same format
+     objdump uses, so every operand is decoded and printed.  */
+  size_t count = strtoul (argv[2], NULL, 0);
+  size_t ninsns = 0;
+  double start = now ();
+  for (size_t i = 0; i < count; ++i)
+    {
+      Elf_Scn *scn = NULL;
+      while ((scn = elf_nextscn (elf, scn)) != NULL)
+	{
+	  GElf_Shdr shdr_mem;
+	  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+	  if (shdr == NULL || shdr->sh_type != SHT_PROGBITS
+	      || (shdr->sh_flags & SHF_EXECINSTR) == 0)
+	    continue;
+
+	  Elf_Data *data = elf_getdata (scn, NULL);
+	  if (data == NULL || data->d_size == 0)
+	    continue;
+
+	  const uint8_t *cur = data->d_buf;
+	  disasm_cb (ctx, &cur, cur + data->d_size, shdr->sh_addr,
+		     "%7m %.1o,%.2o,%.3o%34a %l", count_insn, &ninsns, NULL);
+	}
+    }
+  double elapsed = now () - start;
+
+  printf ("%zu instructions\n", count == 0 ? 0 : ninsns / count);
+  if (argc > 3 && strcmp (argv[3], "bench") == 0)
+    printf ("%.0f instructions/second\n",
+	    elapsed > 0 ? ninsns / elapsed : 0.0);
+
+  disasm_end (ctx);
+  ebl_closebackend (ebl);
+  elf_end (elf);
+  close (fd);
+
+  return 0;
+}
@@ -0,0 +1,245 @@
+/* Test program for FDE lookups in CFI without a binary search table.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dwarf.h>
+#include ELFUTILS_HEADER(dw)
+
+/* What looking up ADDR finds, as text.  */
+static void
+lookup (Dwarf_CFI *cfi, Dwarf_Addr addr, char *buf, size_t size)
+{
+  Dwarf_Frame *frame;
+  if (dwarf_cfi_addrframe (cfi, addr, &frame) != 0)
+    {
+      snprintf (buf, size, "%s", dwarf_errmsg (-1));
+      return;
+    }
+
+  Dwarf_Addr start, end;
+  dwarf_frame_info (frame, &start, &end, NULL);
+  free (frame);
+  snprintf (buf, size, "[%#" PRIx64 ", %#" PRIx64 ")", start, end);
+}
+
+/* Look up every address of the code sections in the .debug_frame CFI
+   and print what was found for each run of addresses.  */
+static void
+lookup_all (const char *file)
+{
+  int fd = open (file, O_RDONLY);
+  assert (fd >= 0);
+  Dwarf *dw = dwarf_begin (fd, DWARF_C_READ);
+  assert (dw != NULL);
+  Dwarf_CFI *cfi = dwarf_getcfi (dw);
+  assert (cfi != NULL);
+  Elf *elf = dwarf_getelf (dw);
+
+  printf ("%s:\n", file);
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      assert (shdr != NULL);
+      if (shdr->sh_type != SHT_PROGBITS
+	  || (shdr->sh_flags & SHF_EXECINSTR) == 0)
+	continue;
+
+      char last[128] = "";
+      Dwarf_Addr from = shdr->sh_addr;
+      for (Dwarf_Addr addr = from; addr <= shdr->sh_addr + shdr->sh_size;
+	   ++addr)
+	{
+	  char found[128] = "";
+	  if (addr < shdr->sh_addr + shdr->sh_size)
+	    lookup (cfi, addr, found, sizeof found);
+	  if (addr > from && strcmp (found, last) != 0)
+	    {
+	      printf ("%#" PRIx64 "..%#" PRIx64 ": %s\n", from, addr - 1,
+		      last);
+	      from = addr;
+	    }
+	  strcpy (last, found);
+	}
+    }
+
+  dwarf_end (dw);
+  close (fd);
+}
+
+/* The address an FDE starts at, for the pcrel sdata4 encoding.  */
+static Dwarf_Addr
+fde_start (const GElf_Shdr *shdr, const Elf_Data *data,
+	   const Dwarf_FDE *fde)
+{
+  int32_t value;
+  memcpy (&value, fde->start, sizeof value);
+  return (shdr->sh_addr + (fde->start - (const uint8_t *) data->d_buf)
+	  + value);
+}
+
+/* Read FILE into memory, drop the binary search table from its
+   .eh_frame_hdr and make the augmentation data of one FDE in .eh_frame
+   too long.  Then looking up an address of that FDE must fail, and all
+   other FDEs must still be found.  */
+static int
+bad_fde (const char *file)
+{
+  int fd = open (file, O_RDONLY);
+  assert (fd >= 0);
+  off_t size = lseek (fd, 0, SEEK_END);
+  char *buf = malloc (size);
+  assert (buf != NULL);
+  assert (pread (fd, buf, size, 0) == size);
+  close (fd);
+
+  Elf *elf = elf_memory (buf, size);
+  assert (elf != NULL);
+  size_t shstrndx;
+  assert (elf_getshdrstrndx (elf, &shstrndx) == 0);
+
+  GElf_Shdr hdr_shdr = { .sh_type = SHT_NULL };
+  GElf_Shdr frame_shdr = { .sh_type = SHT_NULL };
+  Elf_Data *frame_data = NULL;
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      const char *name = elf_strptr (elf, shstrndx, shdr->sh_name);
+      if (name != NULL && strcmp (name, ".eh_frame_hdr") == 0)
+	hdr_shdr = *shdr;
+      else if (name != NULL && strcmp (name, ".eh_frame") == 0)
+	{
+	  frame_shdr = *shdr;
+	  frame_data = elf_rawdata (scn, NULL);
+	}
+    }
+  if (hdr_shdr.sh_type == SHT_NULL || frame_data == NULL)
+    {
+      puts ("no .eh_frame_hdr");
+      return 77;
+    }
+
+  /* The FDEs whose start we can tell, and one to break.  */
+  const unsigned char *e_ident = (const unsigned char *) buf;
+  size_t nfdes = 0;
+  Dwarf_Addr *starts = NULL;
+  uint8_t *bad = NULL;
+  Dwarf_Addr bad_start = 0;
+  Dwarf_Off offset = 0;
+  Dwarf_Off next;
+  Dwarf_CFI_Entry entry;
+  while (dwarf_next_cfi (e_ident, frame_data, true, offset, &next,
+			 &entry) == 0)
+    {
+      if (dwarf_cfi_cie_p (&entry))
+	{
+	  offset = next;
+	  continue;
+	}
+
+      Dwarf_CFI_Entry cie;
+      Dwarf_Off cie_next;
+      if (dwarf_next_cfi (e_ident, frame_data, true, entry.fde.CIE_pointer,
+			  &cie_next, &cie) != 0
+	  || strcmp (cie.cie.augmentation, "zR") != 0
+	  || cie.cie.augmentation_data_size != 1
+	  || cie.cie.augmentation_data[0] != (DW_EH_PE_pcrel
+					      | DW_EH_PE_sdata4))
+	{
+	  offset = next;
+	  continue;
+	}
+
+      /* The augmentation data length follows the start and length.  */
+      uint8_t *auglen = (uint8_t *) entry.fde.start + 8;
+      Dwarf_Addr start = fde_start (&frame_shdr, frame_data, &entry.fde);
+      if (bad == NULL && nfdes > 0 && *auglen == 0
+	  && entry.fde.end - (auglen + 1) < 0x7f)
+	{
+	  bad = auglen;
+	  bad_start = start;
+	}
+      else
+	{
+	  starts = realloc (starts, (nfdes + 1) * sizeof starts[0]);
+	  assert (starts != NULL);
+	  starts[nfdes++] = start;
+	}
+      offset = next;
+    }
+  if (bad == NULL)
+    {
+      puts ("no FDE to break");
+      return 77;
+    }
+
+  elf_end (elf);
+  buf[hdr_shdr.sh_offset + 2] = DW_EH_PE_omit;
+  *bad = 0x7f;
+  elf = elf_memory (buf, size);
+  assert (elf != NULL);
+  Dwarf_CFI *cfi = dwarf_getcfi_elf (elf);
+  assert (cfi != NULL);
+
+  char found[128];
+  lookup (cfi, bad_start, found, sizeof found);
+  printf ("bad FDE: %s\n", found);
+
+  size_t good = 0;
+  for (size_t i = 0; i < nfdes; ++i)
+    {
+      Dwarf_Frame *frame;
+      Dwarf_Addr start;
+      if (dwarf_cfi_addrframe (cfi, starts[i], &frame) == 0)
+	{
+	  dwarf_frame_info (frame, &start, NULL, NULL);
+	  free (frame);
+	  good += start == starts[i];
+	}
+    }
+  printf ("%s of the other FDEs found\n", good == nfdes ? "all" : "not all");
+
+  dwarf_cfi_end (cfi);
+  elf_end (elf);
+  free (starts);
+  free (buf);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  elf_version (EV_CURRENT);
+
+  if (argc == 3 && strcmp (argv[1], "-b") == 0)
+    return bad_fde (argv[2]);
+
+  for (int i = 1; i < argc; ++i)
+    lookup_all (argv[i]);
+
+  return 0;
+}
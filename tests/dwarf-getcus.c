@@ -0,0 +1,177 @@
+/* Test program and benchmark for dwarf_getcus.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include "bench.h"
+
+#define MAX_THREADS 16
+
+/* Per-worker counters, each in its own cache line.  */
+static struct
+{
+  size_t dies;
+  uint64_t sum;
+} __attribute__ ((aligned (64))) counts[MAX_THREADS];
+
+static void
+walk_die (Dwarf_Die *die, unsigned int worker)
+{
+  do
+    {
+      counts[worker].dies++;
+      counts[worker].sum += dwarf_dieoffset (die);
+
+      const char *name = dwarf_diename (die);
+      if (name != NULL)
+	counts[worker].sum += strlen (name);
+
+      const char *file = dwarf_decl_file (die);
+      if (file != NULL)
+	counts[worker].sum += strlen (file);
+
+      Dwarf_Die child;
+      if (dwarf_child (die, &child) == 0)
+	walk_die (&child, worker);
+    }
+  while (dwarf_siblingof (die, die) == 0);
+}
+
+static int
+handle_cu (Dwarf_Die *cudie, unsigned int worker, void *arg)
+{
+  assert (worker < *(unsigned int *) arg);
+  walk_die (cudie, worker);
+  return DWARF_CB_OK;
+}
+
+static int
+count_cu (Dwarf_Die *cudie __attribute__ ((unused)),
+	  unsigned int worker __attribute__ ((unused)), void *arg)
+{
+  __atomic_fetch_add ((size_t *) arg, 1, __ATOMIC_RELAXED);
+  return DWARF_CB_OK;
+}
+
+static int
+abort_cu (Dwarf_Die *cudie __attribute__ ((unused)),
+	  unsigned int worker __attribute__ ((unused)),
+	  void *arg __attribute__ ((unused)))
+{
+  return DWARF_CB_ABORT;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const unsigned int nthreads[] = { 1, 4, MAX_THREADS };
+
+  for (int i = 1; i < argc; i++)
+    {
+      int fd = open (argv[i], O_RDONLY);
+      assert (fd >= 0);
+
+      Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	{
+	  close (fd);
+	  continue;
+	}
+
+      /* The number of CUs whose headers can be read.  */
+      size_t ncus = 0;
+      Dwarf_Off off = 0, noff;
+      size_t hsize;
+      while (dwarf_nextcu (dbg, off, &noff, &hsize, NULL, NULL, NULL) == 0)
+	{
+	  ncus++;
+	  off = noff;
+	}
+
+      const char *name = strrchr (argv[i], '/');
+      name = name != NULL ? name + 1 : argv[i];
+
+      /* With units libdw cannot read, the others are still handled
+	 before the error is reported.  */
+      bool readable = dwarf_index_units (dbg) == 0;
+      dwarf_end (dbg);
+      if (! readable)
+	{
+	  dbg = dwarf_begin (fd, DWARF_C_READ);
+	  assert (dbg != NULL);
+	  size_t handled = 0;
+	  int res = dwarf_getcus (dbg, count_cu, &handled, 4);
+	  printf ("%s: %d, %zd of %zd CUs handled, %s\n",
+		  name, res, handled, ncus, dwarf_errmsg (-1));
+	  dwarf_end (dbg);
+	  close (fd);
+	  continue;
+	}
+
+      size_t dies = 0;
+      uint64_t sum = 0;
+      for (size_t n = 0; n < sizeof nthreads / sizeof nthreads[0]; n++)
+	{
+	  memset (counts, 0, sizeof counts);
+
+	  /* A fresh handle each time, so nothing is decoded yet.  */
+	  dbg = dwarf_begin (fd, DWARF_C_READ);
+	  assert (dbg != NULL);
+	  unsigned int threads = nthreads[n];
+	  double begin = now ();
+	  assert (dwarf_getcus (dbg, handle_cu, &threads, threads) == 0);
+	  double elapsed = now () - begin;
+	  dwarf_end (dbg);
+
+	  size_t total = 0;
+	  uint64_t total_sum = 0;
+	  for (unsigned int w = 0; w < MAX_THREADS; w++)
+	    {
+	      total += counts[w].dies;
+	      total_sum += counts[w].sum;
+	    }
+
+	  /* Every thread count must see the same DIEs.  */
+	  if (n == 0)
+	    {
+	      dies = total;
+	      sum = total_sum;
+	    }
+	  assert (total == dies);
+	  assert (total_sum == sum);
+
+	  printf ("%s: %zd DIEs, %u threads, %.0f DIEs/s\n",
+		  name, total, threads, total / elapsed);
+	}
+
+      /* Aborting stops the walk, if there is a CU at all.  */
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      assert (dbg != NULL);
+      assert (dwarf_getcus (dbg, abort_cu, NULL, 4) == (ncus > 0 ? 1 : 0));
+      dwarf_end (dbg);
+
+      close (fd);
+    }
+
+  return 0;
+}
@@ -0,0 +1,217 @@
+/* Test program for the scope index of dwarf_getscopes.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include <dwarf.h>
+
+#define MAX_DEPTH 256
+
+static bool
+may_have_scopes (Dwarf_Die *die)
+{
+  switch (dwarf_tag (die))
+    {
+    case DW_TAG_compile_unit:
+    case DW_TAG_module:
+    case DW_TAG_lexical_block:
+    case DW_TAG_with_stmt:
+    case DW_TAG_catch_block:
+    case DW_TAG_try_block:
+    case DW_TAG_entry_point:
+    case DW_TAG_inlined_subroutine:
+    case DW_TAG_subprogram:
+    case DW_TAG_namespace:
+    case DW_TAG_class_type:
+    case DW_TAG_structure_type:
+      return true;
+    default:
+      return false;
+    }
+}
+
+/* Find the innermost scope containing PC below DIE by walking all its
+   children, the way dwarf_getscopes did before it had an index.  The
+   scopes are stored innermost last in CHAIN from *N on.  Returns true
+   if a child contains PC.  */
+static bool
+walk (Dwarf_Die *die, Dwarf_Addr pc, Dwarf_Die *chain, int *n)
+{
+  Dwarf_Die child;
+  if (dwarf_child (die, &child) != 0)
+    return false;
+
+  do
+    {
+      if (dwarf_tag (&child) == DW_TAG_imported_unit)
+	{
+	  Dwarf_Attribute attr;
+	  Dwarf_Die unit;
+	  if (dwarf_formref_die (dwarf_attr (&child, DW_AT_import, &attr),
+				 &unit) != NULL
+	      && walk (&unit, pc, chain, n))
+	    return true;
+	  continue;
+	}
+
+      if (dwarf_haspc (&child, pc) > 0)
+	{
+	  assert (*n < MAX_DEPTH);
+	  chain[(*n)++] = child;
+	  if (may_have_scopes (&child))
+	    walk (&child, pc, chain, n);
+	  return true;
+	}
+    }
+  while (dwarf_siblingof (&child, &child) == 0);
+
+  return false;
+}
+
+static void
+check_scopes (Dwarf_Die *cudie, Dwarf_Addr pc)
+{
+  Dwarf_Die chain[MAX_DEPTH];
+  int n = 1;
+  chain[0] = *cudie;
+  if (! walk (cudie, pc, chain, &n))
+    n = 0;
+
+  /* The scopes with all inlined instances are the walked ones.  */
+  Dwarf_Die *scopes;
+  int nscopes = dwarf_getscopes_inlined (cudie, pc, &scopes);
+  if (nscopes != n)
+    {
+      printf ("%#" PRIx64 ": %d scopes, expected %d\n", pc, nscopes, n);
+      exit (1);
+    }
+  for (int i = 0; i < n; i++)
+    if (scopes[i].addr != chain[n - 1 - i].addr)
+      {
+	printf ("%#" PRIx64 ": scope %d is [%" PRIx64 "], expected [%"
+		PRIx64 "]\n", pc, i, dwarf_dieoffset (&scopes[i]),
+		dwarf_dieoffset (&chain[n - 1 - i]));
+	exit (1);
+      }
+  if (n > 0)
+    free (scopes);
+  if (n == 0)
+    return;
+
+  /* The scopes of the innermost DIE are the same.  */
+  assert (dwarf_getscopes_die (&chain[n - 1], &scopes) == n);
+  for (int i = 0; i < n; i++)
+    assert (scopes[i].addr == chain[n - 1 - i].addr);
+  free (scopes);
+
+  /* dwarf_getscopes continues in the abstract definition after the
+     innermost inlined instance.  */
+  int inlined = n - 1;
+  while (inlined > 0
+	 && dwarf_tag (&chain[inlined]) != DW_TAG_inlined_subroutine)
+    inlined--;
+  nscopes = dwarf_getscopes (cudie, pc, &scopes);
+  if (inlined == 0)
+    assert (nscopes == n);
+  else
+    {
+      Dwarf_Attribute attr;
+      Dwarf_Die origin;
+      assert (dwarf_formref_die (dwarf_attr (&chain[inlined],
+					     DW_AT_abstract_origin, &attr),
+				 &origin) != NULL);
+      /* Only the abstract definitions in the same CU are found.  */
+      Dwarf_Die origin_cu;
+      Dwarf_Die *origin_scopes;
+      int norigin = 0;
+      if (dwarf_diecu (&origin, &origin_cu, NULL, NULL) != NULL
+	  && origin_cu.addr == cudie->addr)
+	norigin = dwarf_getscopes_die (&origin, &origin_scopes);
+      if (norigin == 0)
+	{
+	  assert (nscopes == 0);
+	  return;
+	}
+      assert (nscopes == n - inlined + norigin - 1);
+      for (int i = 1; i < norigin; i++)
+	assert (scopes[n - inlined + i - 1].addr == origin_scopes[i].addr);
+      free (origin_scopes);
+    }
+  for (int i = 0; i < n - inlined; i++)
+    assert (scopes[i].addr == chain[n - 1 - i].addr);
+  free (scopes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      fprintf (stderr, "usage: %s FILE\n", argv[0]);
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  assert (fd >= 0);
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    {
+      close (fd);
+      return 0;
+    }
+
+  /* Check the scopes of every line address.  */
+  size_t naddrs = 0;
+  Dwarf_Off off = 0, noff;
+  size_t hsize;
+  while (dwarf_nextcu (dbg, off, &noff, &hsize, NULL, NULL, NULL) == 0)
+    {
+      Dwarf_Die cudie;
+      Dwarf_Lines *lines;
+      size_t nlines;
+      if (dwarf_offdie (dbg, off + hsize, &cudie) == NULL
+	  || dwarf_getsrclines (&cudie, &lines, &nlines) != 0)
+	{
+	  off = noff;
+	  continue;
+	}
+
+      for (size_t i = 0; i < nlines; i++)
+	{
+	  Dwarf_Addr pc;
+	  assert (dwarf_lineaddr (dwarf_onesrcline (lines, i), &pc) == 0);
+	  check_scopes (&cudie, pc);
+	}
+      naddrs += nlines;
+      off = noff;
+    }
+
+  const char *name = strrchr (argv[1], '/');
+  if (naddrs > 0)
+    printf ("%s: %zd addresses\n", name != NULL ? name + 1 : argv[1], naddrs);
+
+  dwarf_end (dbg);
+  close (fd);
+  return 0;
+}
@@ -0,0 +1,162 @@
+/* Test program for DIE offset to unit lookups.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+
+struct die_ref
+{
+  Dwarf_Off offset;
+  Dwarf_Off cu_offset;
+  bool type_unit;
+};
+
+static struct die_ref *dies;
+static size_t ndies;
+
+static void
+add_dies (Dwarf_Die *die, Dwarf_Off cu_offset, bool type_unit)
+{
+  do
+    {
+      dies = realloc (dies, (ndies + 1) * sizeof *dies);
+      assert (dies != NULL);
+      dies[ndies].offset = dwarf_dieoffset (die);
+      dies[ndies].cu_offset = cu_offset;
+      dies[ndies].type_unit = type_unit;
+      ndies++;
+
+      Dwarf_Die child;
+      if (dwarf_child (die, &child) == 0)
+	add_dies (&child, cu_offset, type_unit);
+    }
+  while (dwarf_siblingof (die, die) == 0);
+}
+
+/* Collect all DIEs of the units of one kind, returns false if there
+   is a unit libdw cannot handle.  */
+static bool
+collect_dies (Dwarf *dbg, bool type_units, size_t *nunits)
+{
+  Dwarf_Off off = 0, noff;
+  size_t hsize;
+  Dwarf_Half version;
+  uint64_t sig;
+  Dwarf_Off type_offset;
+  while (dwarf_next_unit (dbg, off, &noff, &hsize, &version, NULL, NULL,
+			  NULL, type_units ? &sig : NULL,
+			  type_units ? &type_offset : NULL) == 0)
+    {
+      if (version < 2 || version > 4)
+	return false;
+
+      Dwarf_Die cudie;
+      Dwarf_Off cu_offset = off + hsize;
+      if (type_units)
+	assert (dwarf_offdie_types (dbg, cu_offset, &cudie) != NULL);
+      else
+	assert (dwarf_offdie (dbg, cu_offset, &cudie) != NULL);
+      add_dies (&cudie, cu_offset, type_units);
+      ++*nunits;
+
+      off = noff;
+    }
+
+  return true;
+}
+
+/* Look up all DIEs from the last to the first and check they end up
+   in the right unit.  */
+static void
+lookup_dies (Dwarf *dbg)
+{
+  for (size_t n = ndies; n-- > 0; )
+    {
+      struct die_ref *ref = &dies[n];
+      Dwarf_Die die, cudie;
+      if (ref->type_unit)
+	assert (dwarf_offdie_types (dbg, ref->offset, &die) != NULL);
+      else
+	assert (dwarf_offdie (dbg, ref->offset, &die) != NULL);
+      assert (dwarf_diecu (&die, &cudie, NULL, NULL) != NULL);
+      assert (dwarf_dieoffset (&cudie) == ref->cu_offset);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  for (int i = 1; i < argc; i++)
+    {
+      int fd = open (argv[i], O_RDONLY);
+      assert (fd >= 0);
+
+      Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	{
+	  close (fd);
+	  continue;
+	}
+
+      ndies = 0;
+      size_t nunits = 0;
+      bool usable = (collect_dies (dbg, false, &nunits)
+		     && collect_dies (dbg, true, &nunits));
+      dwarf_end (dbg);
+      if (! usable || ndies == 0)
+	{
+	  close (fd);
+	  continue;
+	}
+
+      /* Units read on demand while looking up.  */
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      assert (dbg != NULL);
+      lookup_dies (dbg);
+      dwarf_end (dbg);
+
+      const char *name = strrchr (argv[i], '/');
+      name = name != NULL ? name + 1 : argv[i];
+
+      /* All units read up front.  The ones before a unit whose header
+	 cannot be read are still found.  */
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      assert (dbg != NULL);
+      if (dwarf_index_units (dbg) != 0)
+	printf ("%s: dwarf_index_units: %s\n", name, dwarf_errmsg (-1));
+      lookup_dies (dbg);
+
+      /* Offsets outside any unit are still rejected.  */
+      Dwarf_Die die;
+      assert (dwarf_offdie (dbg, (Dwarf_Off) -1, &die) == NULL);
+      dwarf_end (dbg);
+
+      printf ("%s: %zd units, %zd DIEs\n", name, nunits, ndies);
+
+      close (fd);
+    }
+
+  free (dies);
+  return 0;
+}
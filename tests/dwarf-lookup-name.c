@@ -0,0 +1,229 @@
+/* Test program for dwarf_lookup_name.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include <dwarf.h>
+
+struct named_die
+{
+  const char *name;
+  Dwarf_Off offset;
+};
+
+static struct named_die *dies;
+static size_t ndies;
+
+static void
+add_die (const char *name, Dwarf_Off offset)
+{
+  dies = realloc (dies, (ndies + 1) * sizeof *dies);
+  assert (dies != NULL);
+  dies[ndies].name = name;
+  dies[ndies].offset = offset;
+  ndies++;
+}
+
+/* Collect the DIEs an index should have, the definitions outside of
+   function bodies.  */
+static void
+collect_dies (Dwarf_Die *die)
+{
+  do
+    {
+      if (! dwarf_hasattr (die, DW_AT_declaration))
+	{
+	  const char *name = dwarf_diename (die);
+	  if (name != NULL)
+	    add_die (name, dwarf_dieoffset (die));
+
+	  Dwarf_Attribute attr;
+	  const char *linkage_name
+	    = dwarf_formstring (dwarf_attr (die, DW_AT_linkage_name, &attr)
+				?: dwarf_attr (die, DW_AT_MIPS_linkage_name,
+					       &attr));
+	  if (linkage_name != NULL
+	      && (name == NULL || strcmp (name, linkage_name) != 0))
+	    add_die (linkage_name, dwarf_dieoffset (die));
+	}
+
+      Dwarf_Die child;
+      int tag = dwarf_tag (die);
+      if (tag != DW_TAG_subprogram && tag != DW_TAG_lexical_block
+	  && tag != DW_TAG_inlined_subroutine
+	  && dwarf_child (die, &child) == 0)
+	collect_dies (&child);
+    }
+  while (dwarf_siblingof (die, die) == 0);
+}
+
+struct lookup
+{
+  const char *name;
+  Dwarf_Off offset;
+  bool found;
+  size_t count;
+};
+
+static int
+check_die (Dwarf_Die *die, void *arg)
+{
+  struct lookup *lookup = arg;
+
+  Dwarf_Attribute attr;
+  const char *name = dwarf_diename (die);
+  const char *linkage_name
+    = dwarf_formstring (dwarf_attr (die, DW_AT_linkage_name, &attr)
+			?: dwarf_attr (die, DW_AT_MIPS_linkage_name, &attr));
+  assert ((name != NULL && strcmp (name, lookup->name) == 0)
+	  || (linkage_name != NULL
+	      && strcmp (linkage_name, lookup->name) == 0));
+
+  if (dwarf_dieoffset (die) == lookup->offset)
+    lookup->found = true;
+  lookup->count++;
+  return DWARF_CB_OK;
+}
+
+static int
+print_die (Dwarf_Die *die, void *arg)
+{
+  printf ("%s: [%" PRIx64 "] tag %#x\n", (const char *) arg,
+	  dwarf_dieoffset (die), dwarf_tag (die));
+  return DWARF_CB_OK;
+}
+
+static int
+abort_die (Dwarf_Die *die __attribute__ ((unused)),
+	   void *arg __attribute__ ((unused)))
+{
+  return DWARF_CB_ABORT;
+}
+
+/* Look up every collected name and check its DIE is reported.  */
+static int
+check_file (const char *file, int fd)
+{
+  Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+  if (dbg == NULL)
+    return 0;
+
+  /* Skip files with units libdw cannot handle.  */
+  ndies = 0;
+  for (int type_units = 0; type_units <= 1; type_units++)
+    {
+      Dwarf_Off off = 0, noff;
+      size_t hsize;
+      Dwarf_Half version;
+      uint64_t sig;
+      Dwarf_Off type_offset;
+      while (dwarf_next_unit (dbg, off, &noff, &hsize, &version, NULL, NULL,
+			      NULL, type_units ? &sig : NULL,
+			      type_units ? &type_offset : NULL) == 0)
+	{
+	  if (version < 2 || version > 4)
+	    {
+	      dwarf_end (dbg);
+	      return 0;
+	    }
+
+	  Dwarf_Die cudie;
+	  if (type_units)
+	    assert (dwarf_offdie_types (dbg, off + hsize, &cudie) != NULL);
+	  else
+	    assert (dwarf_offdie (dbg, off + hsize, &cudie) != NULL);
+	  collect_dies (&cudie);
+	  off = noff;
+	}
+    }
+
+  /* The first lookup builds the index.  */
+  struct lookup lookup = { .name = "" };
+  assert (dwarf_lookup_name (dbg, lookup.name, check_die, &lookup) == 0);
+
+  int result = 0;
+  size_t reported = 0;
+  for (size_t n = 0; n < ndies; n++)
+    {
+      lookup.name = dies[n].name;
+      lookup.offset = dies[n].offset;
+      lookup.found = false;
+      lookup.count = 0;
+      assert (dwarf_lookup_name (dbg, lookup.name, check_die, &lookup) == 0);
+      if (! lookup.found)
+	{
+	  printf ("%s: [%" PRIx64 "] %s not found\n", file,
+		  dies[n].offset, dies[n].name);
+	  result = 1;
+	}
+      reported += lookup.count;
+    }
+
+  if (ndies > 0)
+    {
+      /* Aborting stops the lookup.  */
+      assert (dwarf_lookup_name (dbg, dies[0].name, abort_die, NULL) == 1);
+
+      const char *name = strrchr (file, '/');
+      printf ("%s: %zd names, %zd DIEs reported\n",
+	      name != NULL ? name + 1 : file, ndies, reported);
+    }
+
+  dwarf_end (dbg);
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+
+  if (argc < 2)
+    {
+      fprintf (stderr, "usage: %s FILE [NAME...]\n", argv[0]);
+      return 1;
+    }
+
+  int fd = open (argv[1], O_RDONLY);
+  assert (fd >= 0);
+
+  /* Without names check all names defined in FILE.  */
+  if (argc == 2)
+    result = check_file (argv[1], fd);
+  else
+    {
+      Dwarf *dbg = dwarf_begin (fd, DWARF_C_READ);
+      assert (dbg != NULL);
+      for (int i = 2; i < argc; i++)
+	if (dwarf_lookup_name (dbg, argv[i], print_die, argv[i]) != 0)
+	  {
+	    printf ("%s: %s\n", argv[i], dwarf_errmsg (-1));
+	    result = 1;
+	  }
+      dwarf_end (dbg);
+    }
+
+  close (fd);
+  return result;
+}
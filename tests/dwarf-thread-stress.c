@@ -0,0 +1,272 @@
+/* Test program hammering one Dwarf handle from several threads.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(dw)
+#include <dwarf.h>
+
+/* Number of threads sharing the handle.  */
+#define NTHREADS 8
+
+/* Rounds of short-lived threads started after the first, so thread
+   ids are given out again and continue the memory of exited threads.  */
+#define ROUNDS 32
+
+static Dwarf *dbg;
+static Dwarf_Off *cus;
+static size_t ncus;
+
+static uint64_t
+mix (uint64_t sum, uint64_t val)
+{
+  return (sum ^ val) * 1099511628211ULL;
+}
+
+static uint64_t
+walk_die (Dwarf_Die *die, uint64_t sum)
+{
+  do
+    {
+      sum = mix (sum, dwarf_dieoffset (die));
+      sum = mix (sum, dwarf_tag (die));
+
+      const char *name = dwarf_diename (die);
+      if (name != NULL)
+	sum = mix (sum, strlen (name));
+
+      int line;
+      if (dwarf_decl_line (die, &line) == 0)
+	sum = mix (sum, line);
+
+      const char *file = dwarf_decl_file (die);
+      if (file != NULL)
+	sum = mix (sum, strlen (file));
+
+      Dwarf_Attribute attr;
+      Dwarf_Op *expr;
+      size_t exprlen;
+      if (dwarf_attr (die, DW_AT_location, &attr) != NULL
+	  && dwarf_getlocation (&attr, &expr, &exprlen) == 0)
+	sum = mix (sum, exprlen);
+      if (dwarf_attr (die, DW_AT_data_member_location, &attr) != NULL
+	  && dwarf_getlocation (&attr, &expr, &exprlen) == 0
+	  && exprlen > 0)
+	sum = mix (sum, expr[0].number);
+
+      Dwarf_Die type;
+      if (dwarf_attr (die, DW_AT_type, &attr) != NULL
+	  && dwarf_formref_die (&attr, &type) != NULL)
+	sum = mix (sum, dwarf_dieoffset (&type));
+
+      Dwarf_Die child;
+      if (dwarf_child (die, &child) == 0)
+	sum = walk_die (&child, sum);
+    }
+  while (dwarf_siblingof (die, die) == 0);
+
+  return sum;
+}
+
+static uint64_t
+walk_cu (Dwarf_Off off)
+{
+  Dwarf_Die cudie;
+  assert (dwarf_offdie (dbg, off, &cudie) != NULL);
+
+  uint64_t sum = mix (0, off);
+
+  Dwarf_Lines *lines;
+  size_t nlines;
+  if (dwarf_getsrclines (&cudie, &lines, &nlines) == 0)
+    {
+      sum = mix (sum, nlines);
+      for (size_t i = 0; i < nlines; i++)
+	{
+	  Dwarf_Addr addr;
+	  assert (dwarf_lineaddr (dwarf_onesrcline (lines, i), &addr) == 0);
+	  sum = mix (sum, addr);
+	}
+    }
+
+  Dwarf_Files *files;
+  size_t nfiles;
+  if (dwarf_getsrcfiles (&cudie, &files, &nfiles) == 0)
+    sum = mix (sum, nfiles);
+
+  return walk_die (&cudie, sum);
+}
+
+static void *
+thread_main (void *arg)
+{
+  size_t start = (uintptr_t) arg;
+  uint64_t *sums = calloc (ncus, sizeof *sums);
+  assert (sums != NULL);
+
+  /* Every thread starts at a different CU, so the lazily built data
+     gets created by different threads concurrently.  */
+  for (size_t n = 0; n < ncus; n++)
+    {
+      size_t i = (start + n) % ncus;
+      sums[i] = walk_cu (cus[i]);
+    }
+
+  Dwarf_Aranges *aranges;
+  size_t naranges;
+  if (dwarf_getaranges (dbg, &aranges, &naranges) == 0)
+    for (size_t i = 0; i < naranges; i++)
+      {
+	Dwarf_Addr start_addr;
+	assert (dwarf_getarangeinfo (dwarf_onearange (aranges, i), &start_addr,
+				     NULL, NULL) == 0);
+	Dwarf_Die cudie;
+	assert (dwarf_addrdie (dbg, start_addr, &cudie) != NULL);
+      }
+
+  return sums;
+}
+
+struct short_job
+{
+  size_t cu;
+  uint64_t sum;
+};
+
+static void *
+short_thread_main (void *arg)
+{
+  struct short_job *job = arg;
+  job->sum = walk_cu (cus[job->cu]);
+  return NULL;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+
+  for (int i = 1; i < argc; i++)
+    {
+      int fd = open (argv[i], O_RDONLY);
+      assert (fd >= 0);
+
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      if (dbg == NULL)
+	{
+	  close (fd);
+	  continue;
+	}
+
+      /* Collect the CU offsets with a throw-away handle, so the shared
+	 one starts out with nothing decoded yet.  Skip files with units
+	 libdw cannot handle, which units of them can still be found
+	 depends on the order of the lookups.  */
+      Dwarf *scan = dwarf_begin (fd, DWARF_C_READ);
+      assert (scan != NULL);
+      ncus = 0;
+      size_t cuhl;
+      Dwarf_Half version;
+      Dwarf_Off off = 0, noff;
+      bool usable = true;
+      while (dwarf_next_unit (scan, off, &noff, &cuhl, &version,
+			      NULL, NULL, NULL, NULL, NULL) == 0)
+	{
+	  if (version < 2 || version > 4)
+	    usable = false;
+	  cus = realloc (cus, (ncus + 1) * sizeof *cus);
+	  assert (cus != NULL);
+	  cus[ncus++] = off + cuhl;
+	  off = noff;
+	}
+      dwarf_end (scan);
+
+      if (ncus == 0 || ! usable)
+	{
+	  dwarf_end (dbg);
+	  close (fd);
+	  continue;
+	}
+
+      pthread_t threads[NTHREADS];
+      for (size_t t = 0; t < NTHREADS; t++)
+	assert (pthread_create (&threads[t], NULL, thread_main,
+				(void *) (uintptr_t) (t * ncus / NTHREADS))
+		== 0);
+
+      uint64_t *sums[NTHREADS];
+      for (size_t t = 0; t < NTHREADS; t++)
+	assert (pthread_join (threads[t], (void **) &sums[t]) == 0);
+
+      /* All threads must have seen exactly the same data.  */
+      for (size_t t = 1; t < NTHREADS; t++)
+	if (memcmp (sums[0], sums[t], ncus * sizeof sums[0][0]) != 0)
+	  {
+	    printf ("%s: thread %zd disagrees\n", argv[i], t);
+	    result = 1;
+	  }
+
+      /* Threads coming and going, each walking one CU again.  */
+      for (size_t r = 0; r < ROUNDS; r++)
+	{
+	  struct short_job jobs[NTHREADS];
+	  for (size_t t = 0; t < NTHREADS; t++)
+	    {
+	      jobs[t].cu = (r * NTHREADS + t) % ncus;
+	      assert (pthread_create (&threads[t], NULL, short_thread_main,
+				      &jobs[t]) == 0);
+	    }
+	  for (size_t t = 0; t < NTHREADS; t++)
+	    {
+	      assert (pthread_join (threads[t], NULL) == 0);
+	      if (jobs[t].sum != sums[0][jobs[t].cu])
+		{
+		  printf ("%s: CU %#" PRIx64 " differs in round %zd\n",
+			  argv[i], cus[jobs[t].cu], r);
+		  result = 1;
+		}
+	    }
+	}
+
+      /* And the same as a single-threaded run on a fresh handle.  */
+      Dwarf *shared = dbg;
+      dbg = dwarf_begin (fd, DWARF_C_READ);
+      assert (dbg != NULL);
+      for (size_t n = 0; n < ncus; n++)
+	if (walk_cu (cus[n]) != sums[0][n])
+	  {
+	    printf ("%s: CU %#" PRIx64 " differs\n", argv[i], cus[n]);
+	    result = 1;
+	  }
+      dwarf_end (dbg);
+
+      for (size_t t = 0; t < NTHREADS; t++)
+	free (sums[t]);
+      dwarf_end (shared);
+      close (fd);
+    }
+
+  free (cus);
+  return result;
+}
@@ -0,0 +1,188 @@
+/* Test program and benchmark for the dwelf_strtab functions.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include ELFUTILS_HEADER(elf)
+#include ELFUTILS_HEADER(dwelf)
+#include <gelf.h>
+#include "bench.h"
+
+/* Add the N strings in STRS to a new table and check every string
+   can be found at its offset.  Returns the table, the finalized data
+   in DATA and the time it took in ELAPSED.  */
+static Dwelf_Strtab *
+build (const char **strs, size_t n, bool nullstr, Dwelf_Strent **ents,
+       Elf_Data *data, double *elapsed)
+{
+  double begin = now ();
+  Dwelf_Strtab *st = dwelf_strtab_init (nullstr);
+  assert (st != NULL);
+  for (size_t i = 0; i < n; i++)
+    {
+      ents[i] = dwelf_strtab_add (st, strs[i]);
+      assert (ents[i] != NULL);
+    }
+  assert (dwelf_strtab_finalize (st, data) == data);
+  *elapsed = now () - begin;
+
+  const char *buf = data->d_buf;
+  if (nullstr)
+    assert (data->d_size > 0 && buf[0] == '\0');
+  for (size_t i = 0; i < n; i++)
+    {
+      size_t off = dwelf_strent_off (ents[i]);
+      if (off >= data->d_size || strcmp (buf + off, strs[i]) != 0
+	  || strcmp (dwelf_strent_str (ents[i]), strs[i]) != 0)
+	{
+	  printf ("\"%s\" not found at %zd\n", strs[i], off);
+	  exit (1);
+	}
+    }
+
+  return st;
+}
+
+/* Strings that are the end of other strings share their bytes.  */
+static void
+check_merge (void)
+{
+  static const char *strs[] =
+    {
+      "", "foo", "bar", "oo", "foobar", "o", "xfoo", "foo", "ar", "",
+      "baz", "az", "z", ".text", ".rela.text", "text"
+    };
+  const size_t n = sizeof strs / sizeof strs[0];
+  Dwelf_Strent *ents[n];
+
+  for (int nullstr = 1; nullstr >= 0; nullstr--)
+    {
+      Elf_Data data;
+      double elapsed;
+      Dwelf_Strtab *st = build (strs, n, nullstr, ents, &data, &elapsed);
+      printf ("nullstr %d, size %zd: ", nullstr, data.d_size);
+      for (size_t i = 0; i < data.d_size; i++)
+	{
+	  char c = ((char *) data.d_buf)[i];
+	  if (c == '\0')
+	    printf ("\\0");
+	  else
+	    putchar (c);
+	}
+      printf ("\n");
+      for (size_t i = 0; i < n; i++)
+	printf ("  \"%s\" %zd\n", strs[i], dwelf_strent_off (ents[i]));
+
+      /* The data is ours.  */
+      free (data.d_buf);
+      dwelf_strtab_free (st);
+    }
+}
+
+/* Add all strings of all string tables in FILE to one table, like
+   strip and unstrip do with the symbol and section names.  */
+static int
+check_file (const char *file)
+{
+  int fd = open (file, O_RDONLY);
+  if (fd < 0)
+    {
+      printf ("%s: cannot open\n", file);
+      return 1;
+    }
+
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL)
+    {
+      printf ("%s: %s\n", file, elf_errmsg (-1));
+      close (fd);
+      return 1;
+    }
+
+  const char **strs = NULL;
+  size_t n = 0, max = 0, size = 0;
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      if (shdr == NULL || shdr->sh_type != SHT_STRTAB
+	  || (shdr->sh_flags & SHF_COMPRESSED) != 0)
+	continue;
+
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data == NULL || data->d_size == 0
+	  || ((char *) data->d_buf)[data->d_size - 1] != '\0')
+	continue;
+
+      const char *buf = data->d_buf;
+      for (size_t off = 0; off < data->d_size; off += strlen (buf + off) + 1)
+	{
+	  if (n == max)
+	    {
+	      max = 2 * max ?: 1024;
+	      strs = realloc (strs, max * sizeof strs[0]);
+	      assert (strs != NULL);
+	    }
+	  strs[n++] = buf + off;
+	}
+      size += data->d_size;
+    }
+
+  Dwelf_Strent **ents = malloc ((n ?: 1) * sizeof ents[0]);
+  assert (ents != NULL);
+  Elf_Data data;
+  double elapsed;
+  Dwelf_Strtab *st = build (strs, n, true, ents, &data, &elapsed);
+
+  const char *name = strrchr (file, '/');
+  printf ("%s: %zd strings, %zd => %zd bytes, %.3f ms\n",
+	  name != NULL ? name + 1 : file, n, size, data.d_size,
+	  elapsed * 1e3);
+
+  free (data.d_buf);
+  dwelf_strtab_free (st);
+  free (ents);
+  free (strs);
+  elf_end (elf);
+  close (fd);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  elf_version (EV_CURRENT);
+
+  /* Without files check the merging of a few strings.  */
+  if (argc < 2)
+    {
+      check_merge ();
+      return 0;
+    }
+
+  int result = 0;
+  for (int i = 1; i < argc; i++)
+    result |= check_file (argv[i]);
+  return result;
+}
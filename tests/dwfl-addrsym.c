@@ -0,0 +1,339 @@
+/* Test program and benchmark for libdwfl address to symbol lookups.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <argp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+/* Number of random addresses looked up per module.  */
+#define LOOKUPS 200000
+
+/* The old linear search of dwfl_module_addrinfo, using only the public
+   interfaces, as a reference for the address index.  */
+
+struct ref_sym
+{
+  const char *name;
+  GElf_Sym sym;
+  GElf_Addr value;
+  GElf_Word shndx;
+  Dwarf_Addr bias;
+};
+
+struct reference
+{
+  Dwfl_Module *mod;
+  const struct ref_sym *syms;
+  GElf_Addr addr;
+  bool rel;
+  int addr_shndx;
+
+  const char *closest_name;
+  GElf_Sym closest_sym;
+  GElf_Addr closest_value;
+
+  const char *sizeless_name;
+  GElf_Sym sizeless_sym;
+  GElf_Addr sizeless_value;
+
+  GElf_Addr min_label;
+};
+
+static int
+section_ndx (Dwfl_Module *mod, GElf_Addr addr)
+{
+  Dwarf_Addr bias;
+  Elf_Scn *scn = dwfl_module_address_section (mod, &addr, &bias);
+  return scn == NULL ? -1 : (int) elf_ndxscn (scn);
+}
+
+static bool
+ref_same_section (struct reference *ref, GElf_Addr value, GElf_Word shndx)
+{
+  if (shndx >= SHN_LORESERVE)
+    return value == ref->addr;
+
+  if (ref->addr_shndx == -2)
+    ref->addr_shndx = section_ndx (ref->mod, ref->addr);
+  return ref->addr_shndx == section_ndx (ref->mod, value);
+}
+
+static int
+binding_value (const GElf_Sym *sym)
+{
+  switch (GELF_ST_BIND (sym->st_info))
+    {
+    case STB_GLOBAL:
+      return 3;
+    case STB_WEAK:
+      return 2;
+    case STB_LOCAL:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
+static void
+ref_try (struct reference *ref, GElf_Addr value, const GElf_Sym *sym,
+	 const char *name, GElf_Word shndx)
+{
+  if (value + sym->st_size > ref->min_label)
+    ref->min_label = value + sym->st_size;
+
+  if (sym->st_size == 0 || ref->addr - value < sym->st_size)
+    {
+      if (ref->closest_name == NULL
+	  || ref->closest_value < value
+	  || binding_value (&ref->closest_sym) < binding_value (sym))
+	{
+	  if (sym->st_size != 0)
+	    {
+	      ref->closest_sym = *sym;
+	      ref->closest_value = value;
+	      ref->closest_name = name;
+	    }
+	  else if (ref->closest_name == NULL
+		   && value >= ref->min_label
+		   && ref_same_section (ref, value, shndx))
+	    {
+	      ref->sizeless_sym = *sym;
+	      ref->sizeless_value = value;
+	      ref->sizeless_name = name;
+	    }
+	}
+      else if (sym->st_size != 0
+	       && ref->closest_value == value
+	       && ((ref->closest_sym.st_size > sym->st_size
+		    && (binding_value (&ref->closest_sym)
+			<= binding_value (sym)))
+		   || (ref->closest_sym.st_size >= sym->st_size
+		       && (binding_value (&ref->closest_sym)
+			   < binding_value (sym)))))
+	{
+	  ref->closest_sym = *sym;
+	  ref->closest_value = value;
+	  ref->closest_name = name;
+	}
+    }
+}
+
+static void
+ref_search (struct reference *ref, int start, int end)
+{
+  for (int i = start; i < end; ++i)
+    {
+      const char *name = ref->syms[i].name;
+      const GElf_Sym sym = ref->syms[i].sym;
+      GElf_Addr value = ref->syms[i].value;
+      GElf_Word shndx = ref->syms[i].shndx;
+      Dwarf_Addr bias = ref->syms[i].bias;
+      if (name == NULL || name[0] == '\0'
+	  || sym.st_shndx == SHN_UNDEF
+	  || value > ref->addr
+	  || GELF_ST_TYPE (sym.st_info) == STT_SECTION
+	  || GELF_ST_TYPE (sym.st_info) == STT_FILE
+	  || GELF_ST_TYPE (sym.st_info) == STT_TLS)
+	continue;
+
+      ref_try (ref, value, &sym, name, shndx);
+
+      /* A function descriptor resolved to its code address also
+	 matches its own (adjusted) st_value.  */
+      GElf_Addr adjusted = sym.st_value + bias;
+      if (! ref->rel && shndx != (GElf_Word) -1
+	  && sym.st_shndx != SHN_ABS && sym.st_shndx != SHN_COMMON
+	  && value != adjusted && adjusted <= ref->addr)
+	ref_try (ref, adjusted, &sym, name, shndx);
+    }
+}
+
+static const char *
+ref_addrinfo (Dwfl_Module *mod, const struct ref_sym *syms, bool rel,
+	      GElf_Addr addr, GElf_Off *off, GElf_Sym *sym)
+{
+  int syments = dwfl_module_getsymtab (mod);
+  int first_global = dwfl_module_getsymtab_first_global (mod);
+  struct reference ref = { .mod = mod, .syms = syms, .addr = addr,
+			   .rel = rel, .addr_shndx = -2 };
+
+  ref_search (&ref, first_global == 0 ? 1 : first_global, syments);
+  if (ref.closest_name == NULL && first_global > 1
+      && (ref.sizeless_name == NULL || ref.sizeless_value != addr))
+    ref_search (&ref, 1, first_global);
+
+  if (ref.closest_name == NULL && ref.sizeless_name != NULL
+      && ref.sizeless_value >= ref.min_label)
+    {
+      ref.closest_sym = ref.sizeless_sym;
+      ref.closest_value = ref.sizeless_value;
+      ref.closest_name = ref.sizeless_name;
+    }
+
+  *off = addr - ref.closest_value;
+  *sym = ref.closest_sym;
+  return ref.closest_name;
+}
+
+static void
+check_addr (Dwfl_Module *mod, const struct ref_sym *syms, bool rel,
+	    GElf_Addr addr, size_t *checked)
+{
+  GElf_Off off, ref_off;
+  GElf_Sym sym, ref_sym;
+  const char *name = dwfl_module_addrinfo (mod, addr, &off, &sym,
+					   NULL, NULL, NULL);
+  const char *ref_name = ref_addrinfo (mod, syms, rel, addr,
+				       &ref_off, &ref_sym);
+
+  if ((name == NULL) != (ref_name == NULL)
+      || (name != NULL
+	  && (strcmp (name, ref_name) != 0 || off != ref_off
+	      || sym.st_value != ref_sym.st_value
+	      || sym.st_size != ref_sym.st_size
+	      || sym.st_info != ref_sym.st_info)))
+    {
+      printf ("%#" PRIx64 ": %s+%#" PRIx64 ", expected %s+%#" PRIx64 "\n",
+	      addr, name ?: "(null)", name == NULL ? 0 : off,
+	      ref_name ?: "(null)", ref_name == NULL ? 0 : ref_off);
+      exit (1);
+    }
+  ++*checked;
+}
+
+/* Compare dwfl_module_addrinfo at and around every symbol address,
+   where the choice between aliases and sizeless symbols is made.  */
+static size_t
+check_syms (Dwfl_Module *mod)
+{
+  GElf_Addr bias;
+  Elf *elf = dwfl_module_getelf (mod, &bias);
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = elf == NULL ? NULL : gelf_getehdr (elf, &ehdr_mem);
+  bool rel = ehdr != NULL && ehdr->e_type == ET_REL;
+
+  int nsyms = dwfl_module_getsymtab (mod);
+  struct ref_sym *syms = calloc (nsyms > 0 ? nsyms : 1, sizeof syms[0]);
+  assert (syms != NULL);
+  for (int i = 1; i < nsyms; ++i)
+    syms[i].name = dwfl_module_getsym_info (mod, i, &syms[i].sym,
+					    &syms[i].value, &syms[i].shndx,
+					    NULL, &syms[i].bias);
+
+  size_t checked = 0;
+  for (int i = 1; i < nsyms; ++i)
+    {
+      if (syms[i].name == NULL)
+	continue;
+
+      GElf_Addr value = syms[i].value;
+      GElf_Xword size = syms[i].sym.st_size;
+      check_addr (mod, syms, rel, value, &checked);
+      if (value > 0)
+	check_addr (mod, syms, rel, value - 1, &checked);
+      check_addr (mod, syms, rel, value + 1, &checked);
+      if (size > 1)
+	{
+	  check_addr (mod, syms, rel, value + size / 2, &checked);
+	  check_addr (mod, syms, rel, value + size - 1, &checked);
+	}
+      check_addr (mod, syms, rel, value + size, &checked);
+    }
+  free (syms);
+
+  return checked;
+}
+
+static int
+lookup_syms (Dwfl_Module *mod,
+	     void **user_data __attribute__ ((unused)),
+	     const char *name __attribute__ ((unused)),
+	     Dwarf_Addr start,
+	     void *arg __attribute__ ((unused)))
+{
+  int syms = dwfl_module_getsymtab (mod);
+  assert (syms >= 0);
+
+  Dwarf_Addr end;
+  const char *file;
+  dwfl_module_info (mod, NULL, NULL, &end, NULL, NULL, &file, NULL);
+  if (end <= start)
+    return DWARF_CB_OK;
+
+  uint64_t state = 42;
+  size_t found = 0;
+  double begin = now ();
+  for (int i = 0; i < LOOKUPS; i++)
+    {
+      GElf_Addr addr = start + next_random (&state) % (end - start);
+      GElf_Sym sym;
+      GElf_Off off;
+      const char *sname = dwfl_module_addrinfo (mod, addr, &off, &sym,
+						NULL, NULL, NULL);
+      if (sname != NULL)
+	{
+	  /* Never a symbol above ADDR, and ADDR inside its size if
+	     it has one.  */
+	  assert (off <= addr - start);
+	  assert (sym.st_size == 0 || off < sym.st_size);
+	  found++;
+	}
+
+      GElf_Sym asym;
+      const char *aname = dwfl_module_addrsym (mod, addr, &asym, NULL);
+      if (aname != NULL)
+	{
+	  assert (asym.st_value <= addr);
+	  found++;
+	}
+    }
+  double elapsed = now () - begin;
+
+  printf ("%s: %d symbols, %d lookups, %zd found, %.3f us/lookup\n",
+	  basename (file), syms, 2 * LOOKUPS, found, elapsed * 1e6 / (2 * LOOKUPS));
+
+  size_t checked = check_syms (mod);
+  printf ("%s: %zd addresses same as linear search\n",
+	  basename (file), checked);
+
+  return DWARF_CB_OK;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int remaining;
+  Dwfl *dwfl;
+  error_t res;
+
+  res = argp_parse (dwfl_standard_argp (), argc, argv, 0, &remaining, &dwfl);
+  assert (res == 0 && dwfl != NULL);
+
+  ptrdiff_t off = 0;
+  do
+    off = dwfl_getmodules (dwfl, lookup_syms, NULL, off);
+  while (off > 0);
+
+  dwfl_end (dwfl);
+
+  return off;
+}
@@ -0,0 +1,224 @@
+/* Test program for the dwfl_set_cache_dir cache.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of addresses looked up per file.  */
+#define LOOKUPS 20000
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+/* What one lookup found, compared between the runs.  */
+struct result
+{
+  const char *sym;
+  GElf_Sym s;
+  GElf_Word shndx;
+  const char *file;
+  Dwarf_Addr line_addr;
+  int line;
+  int col;
+  const char *comp_dir;
+  Dwarf_Addr dwarf_line_addr;
+  bool have_cu;
+  int cu_tag;
+  Dwarf_Off cu_offset;
+  const char *cu_name;
+};
+
+static char *
+dup_or_null (const char *s)
+{
+  if (s == NULL)
+    return NULL;
+  char *copy = strdup (s);
+  assert (copy != NULL);
+  return copy;
+}
+
+/* What dwfl_linecu gives for LINE.  */
+static void
+record_cu (struct result *r, Dwfl_Line *line)
+{
+  Dwarf_Die *cudie = dwfl_linecu (line);
+  assert (cudie != NULL);
+  r->have_cu = true;
+  r->cu_tag = dwarf_tag (cudie);
+  r->cu_offset = dwarf_dieoffset (cudie);
+  r->cu_name = dup_or_null (dwarf_diename (cudie));
+}
+
+/* Look up LOOKUPS addresses spread over FILE.  If CACHED, check
+   nothing but the cache was used.  */
+static void
+lookup (const char *file, const char *cache_dir, struct result *results,
+	bool cached)
+{
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  assert (dwfl != NULL);
+  if (cache_dir != NULL)
+    assert (dwfl_set_cache_dir (dwfl, cache_dir) == 0);
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, file, file, -1);
+  assert (mod != NULL);
+  assert (dwfl_report_end (dwfl, NULL, NULL) == 0);
+
+  Dwarf_Addr start, end;
+  dwfl_module_info (mod, NULL, &start, &end, NULL, NULL, NULL, NULL);
+
+  bool lines = false;
+  Dwfl_Line *last_line = NULL;
+  struct result *last = NULL;
+  for (int i = 0; i < LOOKUPS; i++)
+    {
+      struct result *r = &results[i];
+      GElf_Addr addr = start + (end - start) * i / LOOKUPS;
+      r->sym = dup_or_null (dwfl_module_addrsym (mod, addr, &r->s,
+						 &r->shndx));
+      if (r->sym == NULL)
+	memset (&r->s, 0, sizeof r->s);
+
+      Dwfl_Line *line = dwfl_module_getsrc (mod, addr);
+      r->file = dup_or_null (dwfl_lineinfo (line, &r->line_addr, &r->line,
+					    &r->col, NULL, NULL));
+      r->comp_dir = dup_or_null (dwfl_line_comp_dir (line));
+      r->have_cu = false;
+      r->cu_name = NULL;
+      if (line != NULL)
+	{
+	  assert (dwfl_linemodule (line) == mod);
+	  lines = true;
+
+	  Dwarf_Addr bias, lineaddr;
+	  Dwarf_Line *dwline = dwfl_dwarf_line (line, &bias);
+	  assert (dwline != NULL && dwarf_lineaddr (dwline, &lineaddr) == 0);
+	  r->dwarf_line_addr = lineaddr + bias;
+
+	  /* That would load the DWARF, from the cache check it last.  */
+	  if (cached)
+	    {
+	      last_line = line;
+	      last = r;
+	    }
+	  else
+	    record_cu (r, line);
+	}
+    }
+
+  /* Without a build ID there is no cache.  Without DWARF the debug
+     file is looked for even with a cache, which loads the module.  */
+  const unsigned char *bits;
+  GElf_Addr vaddr;
+  if (cached && lines && dwfl_module_build_id (mod, &bits, &vaddr) > 0)
+    {
+      /* Neither the symbol table nor the DWARF was loaded.  */
+      Dwarf_Addr dwbias, symbias;
+      dwfl_module_info (mod, NULL, NULL, NULL, &dwbias, &symbias, NULL, NULL);
+      assert (dwbias == (Dwarf_Addr) -1);
+      assert (symbias == (Dwarf_Addr) -1);
+    }
+  if (last_line != NULL)
+    record_cu (last, last_line);
+
+  dwfl_end (dwfl);
+}
+
+static bool
+same_string (const char *a, const char *b)
+{
+  return a == b || (a != NULL && b != NULL && strcmp (a, b) == 0);
+}
+
+static size_t
+compare (const char *file, const struct result *ref, const struct result *res)
+{
+  size_t found = 0;
+  for (int i = 0; i < LOOKUPS; i++)
+    {
+      const struct result *a = &ref[i];
+      const struct result *b = &res[i];
+      if (! same_string (a->sym, b->sym)
+	  || memcmp (&a->s, &b->s, sizeof a->s) != 0
+	  || (a->sym != NULL && a->shndx != b->shndx)
+	  || ! same_string (a->file, b->file)
+	  || ! same_string (a->comp_dir, b->comp_dir)
+	  || (a->file != NULL
+	      && (a->line_addr != b->line_addr || a->line != b->line
+		  || a->col != b->col
+		  || a->dwarf_line_addr != b->dwarf_line_addr))
+	  || (a->have_cu && b->have_cu
+	      && (a->cu_tag != b->cu_tag || a->cu_offset != b->cu_offset
+		  || ! same_string (a->cu_name, b->cu_name))))
+	{
+	  printf ("%s: lookup %d: %s %s:%d differs from %s %s:%d\n", file, i,
+		  a->sym, a->file, a->line, b->sym, b->file, b->line);
+	  exit (1);
+	}
+      found += (a->sym != NULL) + (a->file != NULL);
+    }
+  return found;
+}
+
+static void
+free_results (struct result *results)
+{
+  for (int i = 0; i < LOOKUPS; i++)
+    {
+      free ((char *) results[i].sym);
+      free ((char *) results[i].file);
+      free ((char *) results[i].comp_dir);
+      free ((char *) results[i].cu_name);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc < 3)
+    {
+      fprintf (stderr, "usage: %s CACHEDIR FILE...\n", argv[0]);
+      return 1;
+    }
+
+  static struct result ref[LOOKUPS], res[LOOKUPS];
+  for (int i = 2; i < argc; i++)
+    {
+      /* Without a cache, writing the cache, and using it.  */
+      lookup (argv[i], NULL, ref, false);
+      lookup (argv[i], argv[1], res, false);
+      compare (argv[i], ref, res);
+      free_results (res);
+      lookup (argv[i], argv[1], res, true);
+      size_t found = compare (argv[i], ref, res);
+      free_results (res);
+      free_results (ref);
+
+      const char *name = strrchr (argv[i], '/');
+      printf ("%s: %zd found\n", name != NULL ? name + 1 : argv[i], found);
+    }
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+/* Test program for finding the debuginfo of many modules of one file.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 4)
+    {
+      printf ("Usage: DEBUGINFO_PATH FILE COUNT\n");
+      return -1;
+    }
+
+  char *debuginfo_path = argv[1];
+  const Dwfl_Callbacks callbacks =
+    {
+      .find_elf = dwfl_build_id_find_elf,
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .debuginfo_path = &debuginfo_path,
+    };
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  assert (dwfl != NULL);
+
+  /* The same file loaded many times, like a library in many processes.
+     All modules find the same debuginfo file, or all find none.  */
+  size_t count = strtoul (argv[3], NULL, 0);
+  const char *first = NULL;
+  for (size_t i = 0; i < count; i++)
+    {
+      char name[32];
+      snprintf (name, sizeof name, "mod%zd", i);
+      int fd = open (argv[2], O_RDONLY);
+      if (fd < 0)
+	{
+	  printf ("cannot open %s\n", argv[2]);
+	  return 1;
+	}
+      Dwfl_Module *mod = dwfl_report_elf (dwfl, name, argv[2], fd,
+					  i * 0x100000, false);
+      if (mod == NULL)
+	{
+	  printf ("%s: %s\n", argv[2], dwfl_errmsg (-1));
+	  return 1;
+	}
+
+      Dwarf_Addr bias;
+      Dwarf *dw = dwfl_module_getdwarf (mod, &bias);
+      const char *debugfile;
+      dwfl_module_info (mod, NULL, NULL, NULL, NULL, NULL, NULL, &debugfile);
+      if (dw == NULL)
+	debugfile = NULL;
+      else if (debugfile == NULL)
+	debugfile = "main file";
+
+      if (i == 0)
+	first = debugfile;
+      else if ((debugfile == NULL) != (first == NULL)
+	       || (debugfile != NULL && strcmp (debugfile, first) != 0))
+	{
+	  printf ("%s: debuginfo %s, not %s\n", name,
+		  debugfile ?: "none", first ?: "none");
+	  return 1;
+	}
+    }
+
+  const char *base = first != NULL ? strrchr (first, '/') : NULL;
+  printf ("%zd modules, debuginfo %s\n", count,
+	  base != NULL ? base + 1 : first ?: "none");
+
+  dwfl_end (dwfl);
+  return 0;
+}
@@ -0,0 +1,129 @@
+/* Test program for the unwinder frame cache statistics.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include <argp.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* PCs of all frames of one pass, to compare the passes.  */
+static Dwarf_Addr *pcs;
+static size_t npcs;
+static size_t pass_index;
+static int pass;
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg __attribute__ ((unused)))
+{
+  Dwarf_Addr pc;
+  if (! dwfl_frame_pc (state, &pc, NULL))
+    return DWARF_CB_ABORT;
+
+  if (pass == 1)
+    {
+      pcs = realloc (pcs, (npcs + 1) * sizeof *pcs);
+      assert (pcs != NULL);
+      pcs[npcs++] = pc;
+    }
+  else
+    {
+      assert (pass_index < npcs);
+      assert (pcs[pass_index] == pc);
+      pass_index++;
+    }
+  return DWARF_CB_OK;
+}
+
+static int
+thread_callback (Dwfl_Thread *thread, void *arg __attribute__ ((unused)))
+{
+  /* Stopping at an unknown frame is fine, it must stop at the same place
+     in each pass.  */
+  dwfl_thread_getframes (thread, frame_callback, NULL);
+  return DWARF_CB_OK;
+}
+
+struct totals
+{
+  uint64_t hits;
+  uint64_t misses;
+};
+
+static int
+module_callback (Dwfl_Module *mod, void **userdata __attribute__ ((unused)),
+		 const char *name __attribute__ ((unused)),
+		 Dwarf_Addr start __attribute__ ((unused)), void *arg)
+{
+  struct totals *totals = arg;
+  uint64_t hits, misses;
+  assert (dwfl_module_frame_cache_stats (mod, &hits, &misses) == 0);
+
+  /* Either number alone is the same.  */
+  uint64_t only;
+  assert (dwfl_module_frame_cache_stats (mod, &only, NULL) == 0);
+  assert (only == hits);
+  assert (dwfl_module_frame_cache_stats (mod, NULL, &only) == 0);
+  assert (only == misses);
+  assert (dwfl_module_frame_cache_stats (mod, NULL, NULL) == 0);
+
+  totals->hits += hits;
+  totals->misses += misses;
+  return DWARF_CB_OK;
+}
+
+int
+main (int argc, char **argv)
+{
+  /* Takes -e EXEC --core=CORE like the backtrace test.  */
+  int remaining;
+  Dwfl *dwfl = NULL;
+  (void) argp_parse (dwfl_standard_argp (), argc, argv, 0, &remaining,
+		     &dwfl);
+  assert (dwfl != NULL);
+  if (dwfl_pid (dwfl) < 0)
+    {
+      printf ("dwfl_pid: %s\n", dwfl_errmsg (-1));
+      return 1;
+    }
+
+  struct totals last = { 0, 0 };
+  for (pass = 1; pass <= 3; pass++)
+    {
+      pass_index = 0;
+      assert (dwfl_getthreads (dwfl, thread_callback, NULL) == 0);
+      assert (pass == 1 || pass_index == npcs);
+
+      struct totals totals = { 0, 0 };
+      dwfl_getmodules (dwfl, module_callback, &totals, 0);
+      printf ("pass %d: %zd frames, %" PRIu64 " hits, %" PRIu64 " misses\n",
+	      pass, npcs, totals.hits - last.hits,
+	      totals.misses - last.misses);
+
+      /* Once seen, each PC is unwound from the cache.  */
+      if (pass > 1)
+	assert (totals.misses == last.misses);
+      last = totals;
+    }
+
+  free (pcs);
+  dwfl_end (dwfl);
+  return 0;
+}
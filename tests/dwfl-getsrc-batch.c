@@ -0,0 +1,134 @@
+/* Test program and benchmark for dwfl_module_getsrc_batch.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+/* Size of the address batch per file.  */
+#define NADDRS 100000
+
+static const Dwfl_Callbacks offline_callbacks =
+  {
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+    .section_address = dwfl_offline_section_address,
+  };
+
+static int
+compare_addr (const void *a, const void *b)
+{
+  Dwarf_Addr aa = *(const Dwarf_Addr *) a;
+  Dwarf_Addr bb = *(const Dwarf_Addr *) b;
+  return aa < bb ? -1 : aa > bb;
+}
+
+static void
+check (const char *file, const char *what, const Dwarf_Addr *addrs,
+       Dwfl_Line **ref, Dwfl_Line **lines)
+{
+  for (size_t i = 0; i < NADDRS; i++)
+    if (ref[i] != lines[i])
+      {
+	printf ("%s: %s: %#" PRIx64 " found %p instead of %p\n", file, what,
+		addrs[i], lines[i], ref[i]);
+	exit (1);
+      }
+}
+
+static void
+handle_file (const char *file)
+{
+  Dwfl *dwfl = dwfl_begin (&offline_callbacks);
+  assert (dwfl != NULL);
+  Dwfl_Module *mod = dwfl_report_offline (dwfl, file, file, -1);
+  assert (mod != NULL);
+  assert (dwfl_report_end (dwfl, NULL, NULL) == 0);
+
+  Dwarf_Addr bias;
+  if (dwfl_module_getdwarf (mod, &bias) == NULL)
+    {
+      dwfl_end (dwfl);
+      return;
+    }
+
+  Dwarf_Addr start, end;
+  dwfl_module_info (mod, NULL, &start, &end, NULL, NULL, NULL, NULL);
+
+  static Dwarf_Addr addrs[NADDRS];
+  static Dwfl_Line *ref[NADDRS], *lines[NADDRS];
+  uint64_t state = 42;
+  for (size_t i = 0; i < NADDRS; i++)
+    addrs[i] = start + next_random (&state) % (end - start);
+  qsort (addrs, NADDRS, sizeof addrs[0], compare_addr);
+
+  /* Read in all line tables first, so only the lookups are timed.  */
+  size_t found = 0;
+  for (size_t i = 0; i < NADDRS; i++)
+    found += dwfl_module_getsrc (mod, addrs[i]) != NULL;
+
+  double begin = now ();
+  for (size_t i = 0; i < NADDRS; i++)
+    ref[i] = dwfl_module_getsrc (mod, addrs[i]);
+  double single = now () - begin;
+
+  begin = now ();
+  assert (dwfl_module_getsrc_batch (mod, addrs, NADDRS, lines)
+	  == (ssize_t) found);
+  double batch = now () - begin;
+  check (file, "sorted", addrs, ref, lines);
+
+  /* Any order gives the same results.  */
+  for (size_t i = 0; i < NADDRS; i++)
+    {
+      size_t j = next_random (&state) % (i + 1);
+      Dwarf_Addr addr = addrs[i];
+      addrs[i] = addrs[j];
+      addrs[j] = addr;
+      Dwfl_Line *line = ref[i];
+      ref[i] = ref[j];
+      ref[j] = line;
+    }
+  assert (dwfl_module_getsrc_batch (mod, addrs, NADDRS, lines)
+	  == (ssize_t) found);
+  check (file, "shuffled", addrs, ref, lines);
+
+  const char *name = strrchr (file, '/');
+  printf ("%s: %zd found, %.3f ms one by one, %.3f ms batched\n",
+	  name != NULL ? name + 1 : file, found, single * 1e3, batch * 1e3);
+
+  dwfl_end (dwfl);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc < 2)
+    {
+      fprintf (stderr, "usage: %s FILE...\n", argv[0]);
+      return 1;
+    }
+
+  for (int i = 1; i < argc; i++)
+    handle_file (argv[i]);
+
+  return 0;
+}
@@ -1,4 +1,6 @@
-/* Test dwfl_linux_proc_attach works without any modules.
+/* Test dwfl_linux_proc_attach works without any modules, and that
+   reading the memory of an attached process with process_vm_readv gives
+   the same backtrace as reading it with PTRACE_PEEKDATA.
    Copyright (C) 2015 Red Hat, Inc.
    This file is part of elfutils.
 
@@ -28,6 +30,14 @@
 #include <sys/user.h>
 #include <fcntl.h>
 #include <string.h>
+#include <signal.h>
+#include <stddef.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
 #include ELFUTILS_HEADER(dwfl)
 #include <pthread.h>
 #endif
@@ -71,10 +81,225 @@ thread_callback (Dwfl_Thread *thread, void *thread_arg)
   return DWARF_CB_OK;
 }
 
+#define MAX_FRAMES 64
+
+struct frames
+{
+  int n;
+  Dwarf_Addr pc[MAX_FRAMES];
+  bool isactivation[MAX_FRAMES];
+};
+
+static volatile int memory_depth;
+
+static void __attribute__ ((noinline, noreturn))
+memory_level3 (int fd)
+{
+  /* Tell the parent we are here, then wait to be killed.  */
+  char c = 'x';
+  if (write (fd, &c, 1) != 1)
+    _exit (1);
+  for (;;)
+    pause ();
+}
+
+static void __attribute__ ((noinline))
+memory_level2 (int fd)
+{
+  memory_level3 (fd);
+  memory_depth++;
+}
+
+static void __attribute__ ((noinline))
+memory_level1 (int fd)
+{
+  memory_level2 (fd);
+  memory_depth++;
+}
+
+static int
+frame_callback (Dwfl_Frame *state, void *arg)
+{
+  struct frames *frames = arg;
+  Dwarf_Addr pc;
+  bool isactivation;
+  if (! dwfl_frame_pc (state, &pc, &isactivation))
+    return DWARF_CB_ABORT;
+  frames->pc[frames->n] = pc;
+  frames->isactivation[frames->n] = isactivation;
+  return ++frames->n < MAX_FRAMES ? DWARF_CB_OK : DWARF_CB_ABORT;
+}
+
+/* Fork a child that waits in memory_level3, attach to it and put its
+   backtrace in FRAMES.  */
+static void
+unwind_child (struct frames *frames)
+{
+  int fds[2];
+  if (pipe (fds) != 0)
+    error (-1, errno, "pipe");
+  pid_t pid = fork ();
+  if (pid < 0)
+    error (-1, errno, "fork");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      memory_level1 (fds[1]);
+      _exit (1);
+    }
+  close (fds[1]);
+  char c;
+  if (read (fds[0], &c, 1) != 1)
+    error (-1, errno, "child %d didn't start", pid);
+  close (fds[0]);
+
+  /* Wait for the child to sleep in pause, so both backtraces are taken
+     at the same place.  */
+  char path[64];
+  snprintf (path, sizeof path, "/proc/%d/stat", pid);
+  for (int tries = 0; ; tries++)
+    {
+      char state = '?';
+      FILE *f = fopen (path, "r");
+      if (f != NULL)
+	{
+	  if (fscanf (f, "%*d (%*[^)]) %c", &state) != 1)
+	    state = '?';
+	  fclose (f);
+	}
+      if (state == 'S')
+	break;
+      if (tries == 1000)
+	error (-1, 0, "child %d doesn't sleep", pid);
+      usleep (1000);
+    }
+
+  Dwfl *dwfl = dwfl_begin (&proc_callbacks);
+  if (dwfl == NULL)
+    error (-1, 0, "dwfl_begin: %s", dwfl_errmsg (-1));
+  if (dwfl_linux_proc_report (dwfl, pid) != 0)
+    error (-1, 0, "dwfl_linux_proc_report pid %d: %s", pid,
+	   dwfl_errmsg (-1));
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    error (-1, 0, "dwfl_report_end: %s", dwfl_errmsg (-1));
+  if (dwfl_linux_proc_attach (dwfl, pid, false) < 0)
+    error (-1, 0, "dwfl_linux_proc_attach pid %d: %s", pid,
+	   dwfl_errmsg (-1));
+
+  frames->n = 0;
+  dwfl_getthread_frames (dwfl, pid, frame_callback, frames);
+
+  /* The unwinder read the return addresses from the stack, so the
+     functions of the child must all be there.  Its callers depend on
+     where the child was forked, drop them.  */
+  static const char *const names[] =
+    { "memory_level3", "memory_level2", "memory_level1" };
+  size_t found = 0;
+  for (int i = 0; i < frames->n && found < 3; i++)
+    {
+      Dwarf_Addr pc = frames->pc[i] - (frames->isactivation[i] ? 0 : 1);
+      Dwfl_Module *mod = dwfl_addrmodule (dwfl, pc);
+      const char *name = mod != NULL ? dwfl_module_addrname (mod, pc) : NULL;
+      if (name != NULL && strcmp (name, names[found]) == 0 && ++found == 3)
+	frames->n = i + 1;
+    }
+  if (found != 3)
+    error (-1, 0, "%s not in the backtrace of child %d", names[found], pid);
+
+  dwfl_end (dwfl);
+  kill (pid, SIGKILL);
+  waitpid (pid, NULL, 0);
+}
+
+/* Unwind a child once reading its memory with process_vm_readv and once
+   with process_vm_readv failing with EPERM, which makes libdwfl fall
+   back to PTRACE_PEEKDATA.  Both must give the same backtrace.  */
+static void
+check_memory_read (void)
+{
+#if defined HAVE_PROCESS_VM_READV && defined __NR_process_vm_readv
+  /* Check process_vm_readv works at all, else the first unwind would
+     use PTRACE_PEEKDATA too.  */
+  int word = 42, copy = 0;
+  struct iovec local = { &copy, sizeof copy };
+  struct iovec remote = { &word, sizeof word };
+  if (process_vm_readv (getpid (), &local, 1, &remote, 1, 0) != sizeof copy
+      || copy != word)
+    {
+      printf ("process_vm_readv unsupported: %m\n");
+      return;
+    }
+
+  struct frames vm;
+  unwind_child (&vm);
+
+  int fds[2];
+  if (pipe (fds) != 0)
+    error (-1, errno, "pipe");
+  pid_t pid = fork ();
+  if (pid < 0)
+    error (-1, errno, "fork");
+  if (pid == 0)
+    {
+      close (fds[0]);
+      struct sock_filter filter[] =
+	{
+	  BPF_STMT (BPF_LD | BPF_W | BPF_ABS,
+		    offsetof (struct seccomp_data, nr)),
+	  BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, __NR_process_vm_readv, 0, 1),
+	  BPF_STMT (BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EPERM),
+	  BPF_STMT (BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+	};
+      struct sock_fprog prog =
+	{
+	  .len = sizeof filter / sizeof filter[0],
+	  .filter = filter,
+	};
+      struct frames ptrace;
+      ptrace.n = -1;
+      if (prctl (PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0
+	  && prctl (PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0)
+	{
+	  if (process_vm_readv (getpid (), &local, 1, &remote, 1, 0) != -1
+	      || errno != EPERM)
+	    error (-1, 0, "process_vm_readv not blocked");
+	  unwind_child (&ptrace);
+	}
+      if (write (fds[1], &ptrace, sizeof ptrace) != sizeof ptrace)
+	_exit (1);
+      _exit (0);
+    }
+  close (fds[1]);
+  struct frames ptrace;
+  ssize_t n = read (fds[0], &ptrace, sizeof ptrace);
+  close (fds[0]);
+  int status;
+  if (waitpid (pid, &status, 0) != pid || ! WIFEXITED (status)
+      || WEXITSTATUS (status) != 0 || n != sizeof ptrace)
+    error (-1, 0, "unwinding with PTRACE_PEEKDATA failed");
+  if (ptrace.n < 0)
+    {
+      printf ("seccomp unsupported, PTRACE_PEEKDATA not checked\n");
+      return;
+    }
+
+  if (ptrace.n != vm.n)
+    error (-1, 0, "%d frames with process_vm_readv, %d with PTRACE_PEEKDATA",
+	   vm.n, ptrace.n);
+  for (int i = 0; i < vm.n; i++)
+    if (ptrace.pc[i] != vm.pc[i])
+      error (-1, 0, "frame #%d: pc %#" PRIx64 " with process_vm_readv, %#"
+	     PRIx64 " with PTRACE_PEEKDATA", i, vm.pc[i], ptrace.pc[i]);
+#endif
+}
+
 int
 main (int argc __attribute__ ((unused)),
       char **argv __attribute__ ((unused)))
 {
+  /* Before there are threads, so the children can do anything.  */
+  check_memory_read ();
+
   /* Create two extra threads to iterate through.  */
   int err;
   if ((err = pthread_create (&thread1, NULL, sleeper, NULL)) != 0)
@@ -0,0 +1,107 @@
+/* Test program for reporting the modules of a kernel release offline.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Skip the kernel itself, the test directories have none.  */
+static int
+predicate (const char *module, const char *file __attribute__ ((unused)))
+{
+  return strcmp (module, "kernel") != 0;
+}
+
+struct module_list
+{
+  char **lines;
+  size_t nlines;
+  size_t dirlen;
+};
+
+static int
+list_module (Dwfl_Module *mod, void **userdata __attribute__ ((unused)),
+	     const char *name, Dwarf_Addr start __attribute__ ((unused)),
+	     void *arg)
+{
+  struct module_list *list = arg;
+  const char *file;
+  dwfl_module_info (mod, NULL, NULL, NULL, NULL, NULL, &file, NULL);
+  assert (file != NULL && strlen (file) > list->dirlen);
+
+  list->lines = realloc (list->lines,
+			 (list->nlines + 1) * sizeof list->lines[0]);
+  assert (list->lines != NULL);
+  int res = asprintf (&list->lines[list->nlines++], "%s %s",
+		      name, file + list->dirlen + 1);
+  assert (res > 0);
+  return DWARF_CB_OK;
+}
+
+static int
+compare_lines (const void *a, const void *b)
+{
+  return strcmp (*(char * const *) a, *(char * const *) b);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 2)
+    {
+      printf ("Usage: DIR\n");
+      return -1;
+    }
+
+  static const Dwfl_Callbacks callbacks =
+    {
+      .find_elf = dwfl_linux_kernel_find_elf,
+      .find_debuginfo = dwfl_standard_find_debuginfo,
+      .section_address = dwfl_offline_section_address,
+    };
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  assert (dwfl != NULL);
+
+  /* The modules reported before an error are kept.  */
+  if (dwfl_linux_kernel_report_offline (dwfl, argv[1], predicate) != 0)
+    printf ("dwfl_linux_kernel_report_offline: %s\n", dwfl_errmsg (-1));
+
+  if (dwfl_report_end (dwfl, NULL, NULL) != 0)
+    {
+      printf ("dwfl_report_end: %s\n", dwfl_errmsg (-1));
+      return -1;
+    }
+
+  struct module_list list = { .dirlen = strlen (argv[1]) };
+  dwfl_getmodules (dwfl, list_module, &list, 0);
+  qsort (list.lines, list.nlines, sizeof list.lines[0], compare_lines);
+
+  printf ("%zu modules\n", list.nlines);
+  for (size_t i = 0; i < list.nlines; ++i)
+    {
+      puts (list.lines[i]);
+      free (list.lines[i]);
+    }
+  free (list.lines);
+
+  dwfl_end (dwfl);
+
+  return 0;
+}
@@ -0,0 +1,282 @@
+/* Test program and benchmark for reporting many modules and segments.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <assert.h>
+#include <inttypes.h>
+#include ELFUTILS_HEADER(dwfl)
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+/* Module I spans [BASE + I * STRIDE, BASE + I * STRIDE + SIZE).  */
+#define BASE	0x10000000ULL
+#define STRIDE	0x20000
+#define SIZE	0x10000
+
+/* Number of random addresses looked up.  */
+#define LOOKUPS 1000000
+
+static const Dwfl_Callbacks callbacks =
+  {
+    .find_elf = dwfl_linux_proc_find_elf,
+    .find_debuginfo = dwfl_standard_find_debuginfo,
+  };
+
+/* The numbers below N in random order.  */
+static size_t *
+shuffled (size_t n, uint64_t *state)
+{
+  size_t *order = malloc (n * sizeof order[0]);
+  assert (order != NULL);
+  for (size_t i = 0; i < n; i++)
+    order[i] = i;
+  for (size_t i = n; i > 1; i--)
+    {
+      size_t j = next_random (state) % i;
+      size_t tmp = order[i - 1];
+      order[i - 1] = order[j];
+      order[j] = tmp;
+    }
+  return order;
+}
+
+static Dwfl_Module *
+report (Dwfl *dwfl, size_t i)
+{
+  char name[32];
+  snprintf (name, sizeof name, "mod%zu", i);
+  Dwfl_Module *mod = dwfl_report_module (dwfl, name, BASE + i * STRIDE,
+					 BASE + i * STRIDE + SIZE);
+  assert (mod != NULL);
+  return mod;
+}
+
+/* Look up random addresses, in and between the modules, checking
+   they are found in MODS or not at all.  */
+static void
+check_lookups (Dwfl *dwfl, Dwfl_Module **mods, size_t n, uint64_t *state)
+{
+  for (size_t l = 0; l < LOOKUPS; l++)
+    {
+      size_t i = next_random (state) % n;
+      Dwarf_Addr off = next_random (state) % STRIDE;
+      Dwfl_Module *mod = dwfl_addrmodule (dwfl, BASE + i * STRIDE + off);
+      /* The end address of a module still finds it.  */
+      if (mod != (off <= SIZE ? mods[i] : NULL))
+	{
+	  printf ("wrong module for 0x%" PRIx64 "\n",
+		  (uint64_t) (BASE + i * STRIDE + off));
+	  exit (1);
+	}
+    }
+}
+
+static int
+count_removed (Dwfl_Module *mod __attribute__ ((unused)),
+	       void *userdata __attribute__ ((unused)),
+	       const char *name __attribute__ ((unused)),
+	       Dwarf_Addr base __attribute__ ((unused)),
+	       void *arg)
+{
+  ++*(size_t *) arg;
+  return 0;
+}
+
+static int
+count_modules (Dwfl_Module *mod __attribute__ ((unused)),
+	       void **userdata __attribute__ ((unused)),
+	       const char *name __attribute__ ((unused)),
+	       Dwarf_Addr base __attribute__ ((unused)),
+	       void *arg)
+{
+  ++*(size_t *) arg;
+  return DWARF_CB_OK;
+}
+
+struct module_order
+{
+  Dwfl_Module **mods;
+  size_t next;
+};
+
+static int
+check_order (Dwfl_Module *mod,
+	     void **userdata __attribute__ ((unused)),
+	     const char *name __attribute__ ((unused)),
+	     Dwarf_Addr base __attribute__ ((unused)),
+	     void *arg)
+{
+  struct module_order *order = arg;
+  if (mod != order->mods[order->next++])
+    {
+      printf ("module %s out of order\n", name);
+      exit (1);
+    }
+  return DWARF_CB_OK;
+}
+
+/* Report N modules in random order, look up addresses in them, then
+   report all but every tenth again in a new round, and those again in
+   another random order.  */
+static void
+check_modules (size_t n, bool verbose)
+{
+  uint64_t state = n;
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  assert (dwfl != NULL);
+
+  size_t *order = shuffled (n, &state);
+  Dwfl_Module **mods = calloc (n, sizeof mods[0]);
+  assert (mods != NULL);
+
+  double start = now ();
+  dwfl_report_begin (dwfl);
+  for (size_t k = 0; k < n; k++)
+    mods[order[k]] = report (dwfl, order[k]);
+  assert (dwfl_report_end (dwfl, NULL, NULL) == 0);
+  double reported = now ();
+  check_lookups (dwfl, mods, n, &state);
+  double looked_up = now ();
+
+  size_t count = 0;
+  assert (dwfl_getmodules (dwfl, count_modules, &count, 0) == 0);
+  assert (count == n);
+
+  /* The same modules are the same handles, the missing ones are
+     removed.  */
+  double again = now ();
+  dwfl_report_begin (dwfl);
+  for (size_t k = 0; k < n; k++)
+    if (order[k] % 10 != 0)
+      assert (report (dwfl, order[k]) == mods[order[k]]);
+    else
+      mods[order[k]] = NULL;
+  size_t removed = 0;
+  assert (dwfl_report_end (dwfl, count_removed, &removed) == 0);
+  double reported_again = now ();
+  assert (removed == (n + 9) / 10);
+  check_lookups (dwfl, mods, n, &state);
+
+  count = 0;
+  assert (dwfl_getmodules (dwfl, count_modules, &count, 0) == 0);
+  assert (count == n - removed);
+
+  /* In another order the modules are the same handles, listed in the
+     new order.  */
+  size_t *reorder = shuffled (n, &state);
+  struct module_order listed = { .mods = calloc (n, sizeof mods[0]) };
+  assert (listed.mods != NULL);
+  double shuffle = now ();
+  dwfl_report_begin (dwfl);
+  for (size_t k = 0; k < n; k++)
+    if (mods[reorder[k]] != NULL)
+      {
+	assert (report (dwfl, reorder[k]) == mods[reorder[k]]);
+	listed.mods[listed.next++] = mods[reorder[k]];
+      }
+  removed = 0;
+  assert (dwfl_report_end (dwfl, count_removed, &removed) == 0);
+  double reported_shuffled = now ();
+  assert (removed == 0);
+  check_lookups (dwfl, mods, n, &state);
+
+  assert (listed.next == count);
+  listed.next = 0;
+  assert (dwfl_getmodules (dwfl, check_order, &listed, 0) == 0);
+  assert (listed.next == count);
+
+  if (verbose)
+    printf ("%zd modules: report %.3f s, %d lookups %.3f s, "
+	    "report again %.3f s, shuffled %.3f s\n", n, reported - start,
+	    LOOKUPS, looked_up - reported, reported_again - again,
+	    reported_shuffled - shuffle);
+
+  free (listed.mods);
+  free (reorder);
+  free (mods);
+  free (order);
+  dwfl_end (dwfl);
+}
+
+/* Report N segments in random order and look up addresses in them.  */
+static void
+check_segments (size_t n, bool verbose)
+{
+  uint64_t state = n;
+  Dwfl *dwfl = dwfl_begin (&callbacks);
+  assert (dwfl != NULL);
+
+  size_t *order = shuffled (n, &state);
+
+  double start = now ();
+  for (size_t k = 0; k < n; k++)
+    {
+      size_t i = order[k];
+      GElf_Phdr phdr =
+	{
+	  .p_type = PT_LOAD, .p_vaddr = BASE + i * STRIDE,
+	  .p_memsz = SIZE, .p_align = 1
+	};
+      assert (dwfl_report_segment (dwfl, i, &phdr, 0, NULL) == (int) i);
+    }
+  double reported = now ();
+
+  for (size_t l = 0; l < LOOKUPS; l++)
+    {
+      size_t i = next_random (&state) % n;
+      Dwarf_Addr off = next_random (&state) % STRIDE;
+      int ndx = dwfl_addrsegment (dwfl, BASE + i * STRIDE + off, NULL);
+      if (ndx != (off < SIZE ? (int) i : -1))
+	{
+	  printf ("wrong segment for 0x%" PRIx64 ": %d\n",
+		  (uint64_t) (BASE + i * STRIDE + off), ndx);
+	  exit (1);
+	}
+    }
+  double looked_up = now ();
+
+  if (verbose)
+    printf ("%zd segments: report %.3f s, %d lookups %.3f s\n",
+	    n, reported - start, LOOKUPS, looked_up - reported);
+
+  free (order);
+  dwfl_end (dwfl);
+}
+
+int
+main (int argc, char *argv[])
+{
+  /* With an argument report that many modules and print how long it
+     takes.  */
+  if (argc > 1)
+    {
+      size_t n = strtoul (argv[1], NULL, 0);
+      check_modules (n, true);
+      check_segments (n, true);
+      return 0;
+    }
+
+  static const size_t counts[] = { 1, 2, 10, 1000 };
+  for (size_t c = 0; c < sizeof counts / sizeof counts[0]; c++)
+    {
+      check_modules (counts[c], false);
+      check_segments (counts[c], false);
+    }
+  return 0;
+}
@@ -0,0 +1,204 @@
+/* Test program for elf_compressed_read.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <libelf.h>
+#include <gelf.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Read the whole decompressed data of SCN in chunks of CHUNK bytes
+   into BUF.  Returns the number of bytes read or -1.  */
+static ssize_t
+read_chunks (Elf_Scn *scn, char *buf, size_t size, size_t chunk)
+{
+  size_t pos = 0;
+  while (true)
+    {
+      ssize_t n = elf_compressed_read (scn, buf + pos,
+				       chunk < size - pos ? chunk : size - pos,
+				       pos);
+      if (n < 0)
+	return -1;
+      if (n == 0)
+	return pos;
+      pos += n;
+    }
+}
+
+/* Compare reads of the compressed SCN against the data elf_compress
+   and elf_compress_gnu produce.  */
+static int
+check_section (Elf_Scn *scn, const char *name, bool gnu)
+{
+  /* The decompressed size, plus some to check reads stop there.  */
+  size_t size;
+  if (gnu)
+    {
+      Elf_Data *data = elf_rawdata (scn, NULL);
+      if (data == NULL || data->d_size < 12)
+	return 1;
+      const unsigned char *p = data->d_buf;
+      size = 0;
+      for (int i = 4; i < 12; i++)
+	size = (size << 8) | p[i];
+    }
+  else
+    {
+      GElf_Chdr chdr;
+      if (gelf_getchdr (scn, &chdr) == NULL)
+	{
+	  printf ("%s: gelf_getchdr: %s\n", name, elf_errmsg (-1));
+	  return 1;
+	}
+      size = chdr.ch_size;
+    }
+
+  char *whole = malloc (size + 16);
+  char *chunked = malloc (size + 16);
+  if (whole == NULL || chunked == NULL)
+    abort ();
+
+  int result = 0;
+  static const size_t chunks[] = { 1, 7, 100, 4096, 100000 };
+  for (size_t c = 0; c < sizeof chunks / sizeof chunks[0]; c++)
+    {
+      memset (whole, 0, size + 16);
+      ssize_t n = read_chunks (scn, whole, size + 16, chunks[c]);
+      if (n != (ssize_t) size)
+	{
+	  printf ("%s: read %zd bytes in chunks of %zd, expected %zd: %s\n",
+		  name, n, chunks[c], size, elf_errmsg (-1));
+	  result = 1;
+	}
+      else if (c > 0 && memcmp (whole, chunked, size) != 0)
+	{
+	  printf ("%s: chunks of %zd differ\n", name, chunks[c]);
+	  result = 1;
+	}
+      memcpy (chunked, whole, size);
+    }
+
+  /* Reading backwards starts over each time.  */
+  size_t step = size / 64 + 1;
+  for (size_t end = size; end > 0; end = end > step ? end - step : 0)
+    {
+      char byte;
+      if (elf_compressed_read (scn, &byte, 1, end - 1) != 1
+	  || byte != chunked[end - 1])
+	{
+	  printf ("%s: reading backwards at %zd failed\n", name, end - 1);
+	  result = 1;
+	  break;
+	}
+    }
+
+  /* Nothing to read at the end.  */
+  if (elf_compressed_read (scn, whole, 16, size) != 0)
+    {
+      printf ("%s: read after the end\n", name);
+      result = 1;
+    }
+
+  /* The same data as the section decompressed as a whole.  */
+  if ((gnu ? elf_compress_gnu (scn, 0, 0) : elf_compress (scn, 0, 0)) < 0)
+    {
+      printf ("%s: cannot decompress: %s\n", name, elf_errmsg (-1));
+      result = 1;
+    }
+  else
+    {
+      Elf_Data *data = elf_getdata (scn, NULL);
+      if (data == NULL || data->d_size != size
+	  || memcmp (data->d_buf, chunked, size) != 0)
+	{
+	  printf ("%s: data differs from elf_getdata\n", name);
+	  result = 1;
+	}
+    }
+
+  if (result == 0)
+    printf ("%s: %zd bytes\n", name, size);
+
+  free (whole);
+  free (chunked);
+  return result;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result = 0;
+
+  if (argc < 2)
+    {
+      printf ("Usage: files...\n");
+      return -1;
+    }
+
+  elf_version (EV_CURRENT);
+
+  for (int cnt = 1; cnt < argc; ++cnt)
+    {
+      int fd = open (argv[cnt], O_RDONLY);
+
+      Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+      if (elf == NULL)
+	{
+	  printf ("%s not usable %s\n", argv[cnt], elf_errmsg (-1));
+	  result = 1;
+	  close (fd);
+	  continue;
+	}
+
+      size_t strndx;
+      elf_getshdrstrndx (elf, &strndx);
+
+      Elf_Scn *scn = NULL;
+      while ((scn = elf_nextscn (elf, scn)) != NULL)
+	{
+	  GElf_Shdr mem;
+	  GElf_Shdr *shdr = gelf_getshdr (scn, &mem);
+	  const char *name = elf_strptr (elf, strndx, shdr->sh_name);
+	  if ((shdr->sh_flags & SHF_COMPRESSED) != 0)
+	    result |= check_section (scn, name, false);
+	  else if (strncmp (name, ".zdebug", strlen (".zdebug")) == 0)
+	    result |= check_section (scn, name, true);
+	  else
+	    {
+	      /* Uncompressed sections cannot be read.  */
+	      char byte;
+	      if (elf_compressed_read (scn, &byte, 1, 0) != -1)
+		{
+		  printf ("%s: read uncompressed section\n", name);
+		  result = 1;
+		}
+	    }
+	}
+
+      elf_end (elf);
+      close (fd);
+    }
+
+  return result;
+}
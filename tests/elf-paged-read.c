@@ -0,0 +1,344 @@
+/* Test program for reading in paged mode.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <libelf.h>
+#include <gelf.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Read all of section SCN with elf_rawdata_read in chunks of CHUNK
+   bytes into BUF.  Returns the number of bytes read or -1.  */
+static ssize_t
+read_chunks (Elf_Scn *scn, char *buf, size_t size, size_t chunk)
+{
+  size_t pos = 0;
+  while (true)
+    {
+      ssize_t n = elf_rawdata_read (scn, buf + pos,
+				    chunk < size - pos ? chunk : size - pos,
+				    pos);
+      if (n < 0)
+	return -1;
+      if (n == 0)
+	return pos;
+      pos += n;
+    }
+}
+
+/* Read all of the decompressed data of SCN into a new buffer.  */
+static char *
+read_compressed (Elf_Scn *scn, ssize_t *sizep)
+{
+  size_t size = 0;
+  size_t max = 64 * 1024;
+  char *buf = malloc (max);
+  while (buf != NULL)
+    {
+      ssize_t n = elf_compressed_read (scn, buf + size, max - size, size);
+      if (n < 0)
+	break;
+      if (n == 0)
+	{
+	  *sizep = size;
+	  return buf;
+	}
+      size += n;
+      if (size == max)
+	buf = realloc (buf, max *= 2);
+    }
+  free (buf);
+  return NULL;
+}
+
+/* Compare everything read from SCN of ELF in paged mode with the
+   data of REFSCN, read the usual way.  */
+static int
+check_section (Elf *elf, Elf_Scn *scn, Elf_Scn *refscn, const char *name)
+{
+  Elf_Data *data = elf_rawdata (refscn, NULL);
+  if (data == NULL)
+    {
+      printf ("%s: elf_rawdata: %s\n", name, elf_errmsg (-1));
+      return 1;
+    }
+
+  size_t size = data->d_buf == NULL ? 0 : data->d_size;
+  char *buf = malloc (size + 16);
+  if (buf == NULL)
+    abort ();
+
+  int result = 0;
+  static const size_t chunks[] = { 1, 7, 4096, 100000 };
+  for (size_t c = 0; c < sizeof chunks / sizeof chunks[0]; c++)
+    {
+      /* Byte by byte takes too long for big sections.  */
+      if (size > 100000 && chunks[c] < 4096)
+	continue;
+
+      memset (buf, 0, size + 16);
+      ssize_t n = read_chunks (scn, buf, size + 16, chunks[c]);
+      if (n != (ssize_t) size)
+	{
+	  printf ("%s: read %zd bytes in chunks of %zd, expected %zd: %s\n",
+		  name, n, chunks[c], size, elf_errmsg (-1));
+	  result = 1;
+	}
+      else if (size > 0 && memcmp (buf, data->d_buf, size) != 0)
+	{
+	  printf ("%s: chunks of %zd differ\n", name, chunks[c]);
+	  result = 1;
+	}
+    }
+
+  /* The same through elf_getdata_rawchunk.  */
+  GElf_Shdr shdr_mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+  if (shdr != NULL && size > 0)
+    {
+      Elf_Data *chunk = elf_getdata_rawchunk (elf, shdr->sh_offset, size,
+					      ELF_T_BYTE);
+      if (chunk == NULL || chunk->d_size != size
+	  || memcmp (chunk->d_buf, data->d_buf, size) != 0)
+	{
+	  printf ("%s: rawchunk differs\n", name);
+	  result = 1;
+	}
+    }
+
+  /* The decompressed data is the same too.  */
+  char *zbuf = NULL;
+  char *refzbuf = NULL;
+  ssize_t zsize = -1;
+  if (shdr != NULL
+      && ((shdr->sh_flags & SHF_COMPRESSED) != 0
+	  || (size > 4 && memcmp (data->d_buf, "ZLIB", 4) == 0)))
+    {
+      refzbuf = read_compressed (refscn, &zsize);
+      ssize_t n;
+      zbuf = read_compressed (scn, &n);
+      if (refzbuf == NULL || zbuf == NULL || n != zsize
+	  || memcmp (zbuf, refzbuf, zsize) != 0)
+	{
+	  printf ("%s: decompressed data differs: %s\n", name,
+		  elf_errmsg (-1));
+	  result = 1;
+	}
+    }
+
+  /* And the whole section data, after the partial reads.  */
+  Elf_Data *pdata = elf_rawdata (scn, NULL);
+  if (pdata == NULL || (pdata->d_buf == NULL ? 0 : pdata->d_size) != size
+      || (size > 0 && memcmp (pdata->d_buf, data->d_buf, size) != 0))
+    {
+      printf ("%s: elf_rawdata differs: %s\n", name, elf_errmsg (-1));
+      result = 1;
+    }
+
+  if (result == 0 && zsize >= 0)
+    printf ("%s: %zd bytes, %zd decompressed\n", name, size, zsize);
+  else if (result == 0)
+    printf ("%s: %zd bytes\n", name, size);
+
+  free (zbuf);
+  free (refzbuf);
+  free (buf);
+  return result;
+}
+
+/* Once the file descriptor is done only what is in the cache can be
+   read.  Check that a read in the middle of section SCN didn't read
+   all of it.  */
+static int
+check_pages (Elf *elf, Elf_Scn *scn, const char *name)
+{
+  GElf_Shdr shdr_mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+  char byte;
+  size_t mid = shdr->sh_size / 2;
+  if (elf_rawdata_read (scn, &byte, 1, mid) != 1
+      || elf_cntl (elf, ELF_C_FDDONE) != 0)
+    {
+      printf ("%s: %s\n", name, elf_errmsg (-1));
+      return 1;
+    }
+
+  if (elf_rawdata_read (scn, &byte, 1, mid) != 1)
+    {
+      printf ("%s: cached byte cannot be read: %s\n", name, elf_errmsg (-1));
+      return 1;
+    }
+  if (elf_rawdata_read (scn, &byte, 1, 0) != -1
+      || elf_rawdata_read (scn, &byte, 1, shdr->sh_size - 1) != -1)
+    {
+      printf ("%s: all of the section was read\n", name);
+      return 1;
+    }
+
+  printf ("%s: only read the page at %zd\n", name, mid);
+  return 0;
+}
+
+/* elf_getdata reads section SCN through the pages.  Once all of them
+   are cached it doesn't need the file descriptor anymore.  */
+static int
+check_getdata (Elf *elf, Elf_Scn *scn, Elf_Scn *refscn, const char *name)
+{
+  GElf_Shdr shdr_mem;
+  GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+  char byte;
+  for (size_t pos = 0; pos < shdr->sh_size; pos += 4096)
+    if (elf_rawdata_read (scn, &byte, 1, pos) != 1)
+      {
+	printf ("%s: %s\n", name, elf_errmsg (-1));
+	return 1;
+      }
+  if (elf_cntl (elf, ELF_C_FDDONE) != 0)
+    {
+      printf ("%s: %s\n", name, elf_errmsg (-1));
+      return 1;
+    }
+
+  Elf_Data *data = elf_getdata (scn, NULL);
+  Elf_Data *refdata = elf_getdata (refscn, NULL);
+  if (data == NULL || refdata == NULL || data->d_size != refdata->d_size
+      || data->d_type != refdata->d_type
+      || memcmp (data->d_buf, refdata->d_buf, data->d_size) != 0)
+    {
+      printf ("%s: elf_getdata didn't use the pages: %s\n", name,
+	      elf_errmsg (-1));
+      return 1;
+    }
+
+  printf ("%s: elf_getdata read the cached pages\n", name);
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 3)
+    {
+      printf ("Usage: BUDGET FILE\n");
+      return -1;
+    }
+
+  elf_version (EV_CURRENT);
+
+  size_t budget = strtoul (argv[1], NULL, 0);
+  const char *file = argv[2];
+  int fd = open (file, O_RDONLY);
+  int reffd = open (file, O_RDONLY);
+  if (fd < 0 || reffd < 0)
+    {
+      printf ("cannot open %s\n", file);
+      return 1;
+    }
+
+  Elf *elf = elf_begin (fd, ELF_C_READ, NULL);
+  Elf *refelf = elf_begin (reffd, ELF_C_READ, NULL);
+  if (elf == NULL || refelf == NULL)
+    {
+      printf ("%s: elf_begin: %s\n", file, elf_errmsg (-1));
+      return 1;
+    }
+
+  if ((budget == 0
+       ? elf_cntl (elf, ELF_C_PAGED) : elf_cntl_paged (elf, budget)) != 0)
+    {
+      printf ("%s: paged mode: %s\n", file, elf_errmsg (-1));
+      return 1;
+    }
+
+  size_t strndx;
+  if (elf_getshdrstrndx (refelf, &strndx) != 0)
+    {
+      printf ("%s: elf_getshdrstrndx: %s\n", file, elf_errmsg (-1));
+      return 1;
+    }
+
+  int result = 0;
+  Elf_Scn *biggest = NULL;
+  size_t biggest_size = 0;
+  Elf_Scn *small = NULL;
+  Elf_Scn *scn = NULL;
+  Elf_Scn *refscn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL
+	 && (refscn = elf_nextscn (refelf, refscn)) != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (refscn, &shdr_mem);
+      const char *name = elf_strptr (refelf, strndx, shdr->sh_name);
+      result |= check_section (elf, scn, refscn, name);
+
+      if (shdr->sh_type != SHT_NOBITS && shdr->sh_size > biggest_size)
+	{
+	  biggest = scn;
+	  biggest_size = shdr->sh_size;
+	}
+      if (small == NULL && shdr->sh_type != SHT_NOBITS && shdr->sh_size > 0
+	  && shdr->sh_size <= 4 * 65536
+	  && (shdr->sh_flags & SHF_COMPRESSED) == 0)
+	small = refscn;
+    }
+
+  /* Start over with a new descriptor, nothing cached.  */
+  elf_end (elf);
+  elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL || elf_cntl_paged (elf, budget ?: 1 << 20) != 0)
+    {
+      printf ("%s: paged mode: %s\n", file, elf_errmsg (-1));
+      return 1;
+    }
+  if (biggest_size > 4 * 65536)
+    {
+      scn = elf_getscn (elf, elf_ndxscn (biggest));
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      result |= check_pages (elf, scn,
+			     elf_strptr (refelf, strndx, shdr->sh_name));
+    }
+
+  /* And once more, with room for all pages of a small section.  */
+  elf_end (elf);
+  elf = elf_begin (fd, ELF_C_READ, NULL);
+  if (elf == NULL || elf_cntl_paged (elf, 1 << 20) != 0)
+    {
+      printf ("%s: paged mode: %s\n", file, elf_errmsg (-1));
+      return 1;
+    }
+  if (small != NULL)
+    {
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (small, &shdr_mem);
+      result |= check_getdata (elf, elf_getscn (elf, elf_ndxscn (small)),
+			       small,
+			       elf_strptr (refelf, strndx, shdr->sh_name));
+    }
+
+  elf_end (elf);
+  elf_end (refelf);
+  close (fd);
+  close (reffd);
+  return result;
+}
@@ -0,0 +1,200 @@
+/* Test program and benchmark for elf32_xlatetom and elf64_xlatetom.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include <endian.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include ELFUTILS_HEADER(elf)
+#include <gelf.h>
+#include "bench.h"
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+# define OTHER_ENCODING ELFDATA2MSB
+#else
+# define OTHER_ENCODING ELFDATA2LSB
+#endif
+
+/* The types checked, with the sizes of the fields of one record.  */
+static const struct
+{
+  const char *name;
+  int class;
+  Elf_Type type;
+  unsigned char fields[7];
+} types[] =
+  {
+    { "HALF", ELFCLASS32, ELF_T_HALF, { 2 } },
+    { "WORD", ELFCLASS32, ELF_T_WORD, { 4 } },
+    { "SYM", ELFCLASS32, ELF_T_SYM, { 4, 4, 4, 1, 1, 2 } },
+    { "REL", ELFCLASS32, ELF_T_REL, { 4, 4 } },
+    { "RELA", ELFCLASS32, ELF_T_RELA, { 4, 4, 4 } },
+    { "DYN", ELFCLASS32, ELF_T_DYN, { 4, 4 } },
+    { "HALF", ELFCLASS64, ELF_T_HALF, { 2 } },
+    { "WORD", ELFCLASS64, ELF_T_WORD, { 4 } },
+    { "XWORD", ELFCLASS64, ELF_T_XWORD, { 8 } },
+    { "ADDR", ELFCLASS64, ELF_T_ADDR, { 8 } },
+    { "SYM", ELFCLASS64, ELF_T_SYM, { 4, 1, 1, 2, 8, 8 } },
+    { "REL", ELFCLASS64, ELF_T_REL, { 8, 8 } },
+    { "RELA", ELFCLASS64, ELF_T_RELA, { 8, 8, 8 } },
+    { "DYN", ELFCLASS64, ELF_T_DYN, { 8, 8 } },
+  };
+#define NTYPES (sizeof types / sizeof types[0])
+
+static size_t
+record_size (size_t t)
+{
+  size_t size = 0;
+  for (size_t f = 0; types[t].fields[f] != 0; f++)
+    size += types[t].fields[f];
+  return size;
+}
+
+/* Byte swap every field of the LEN bytes at SRC into DEST the slow
+   way.  */
+static void
+reference (size_t t, unsigned char *dest, const unsigned char *src,
+	   size_t len)
+{
+  size_t f = 0;
+  for (size_t pos = 0; pos < len; )
+    {
+      size_t size = types[t].fields[f];
+      for (size_t i = 0; i < size; i++)
+	dest[pos + i] = src[pos + size - 1 - i];
+      pos += size;
+      if (types[t].fields[++f] == 0)
+	f = 0;
+    }
+}
+
+static Elf_Data *
+xlate (size_t t, void *dest, void *src, size_t len)
+{
+  Elf_Data dst_data =
+    {
+      .d_buf = dest, .d_type = types[t].type, .d_size = len,
+      .d_version = EV_CURRENT
+    };
+  Elf_Data src_data = dst_data;
+  src_data.d_buf = src;
+  static Elf_Data result;
+  Elf_Data *data = (types[t].class == ELFCLASS32
+		    ? elf32_xlatetom (&dst_data, &src_data, OTHER_ENCODING)
+		    : elf64_xlatetom (&dst_data, &src_data, OTHER_ENCODING));
+  if (data == NULL)
+    return NULL;
+  result = *data;
+  return &result;
+}
+
+/* Convert arrays of all sizes up to a few hundred records, into
+   another buffer and in place, and compare against the reference.  */
+static int
+check (size_t t)
+{
+  const size_t size = record_size (t);
+  const size_t max = 300 * size;
+  unsigned char *src = malloc (max);
+  unsigned char *dest = malloc (max);
+  unsigned char *expect = malloc (max);
+  if (src == NULL || dest == NULL || expect == NULL)
+    abort ();
+
+  for (size_t i = 0; i < max; i++)
+    src[i] = rand ();
+
+  int result = 0;
+  for (size_t len = 0; len <= max && result == 0; len += size)
+    {
+      reference (t, expect, src, len);
+
+      memset (dest, 0, max);
+      Elf_Data *data = xlate (t, dest, src, len);
+      if (data == NULL || data->d_size != len
+	  || memcmp (dest, expect, len) != 0)
+	{
+	  printf ("%d-bit %s: %zd records differ\n",
+		  types[t].class == ELFCLASS32 ? 32 : 64, types[t].name,
+		  len / size);
+	  result = 1;
+	}
+
+      memcpy (dest, src, len);
+      data = xlate (t, dest, dest, len);
+      if (data == NULL || memcmp (dest, expect, len) != 0)
+	{
+	  printf ("%d-bit %s: %zd records differ in place\n",
+		  types[t].class == ELFCLASS32 ? 32 : 64, types[t].name,
+		  len / size);
+	  result = 1;
+	}
+    }
+
+  if (result == 0)
+    printf ("%d-bit %s: OK\n", types[t].class == ELFCLASS32 ? 32 : 64,
+	    types[t].name);
+
+  free (src);
+  free (dest);
+  free (expect);
+  return result;
+}
+
+/* Print how many MB per second are converted into another buffer.  */
+static void
+bench (size_t t)
+{
+  const size_t size = record_size (t);
+  const size_t len = (16 << 20) / size * size;
+  unsigned char *src = calloc (len, 1);
+  unsigned char *dest = calloc (len, 1);
+  if (src == NULL || dest == NULL)
+    abort ();
+
+  int rounds = 0;
+  double begin = now ();
+  double elapsed;
+  do
+    {
+      xlate (t, dest, src, len);
+      ++rounds;
+    }
+  while ((elapsed = now () - begin) < 0.2);
+
+  printf ("%d-bit %s: %.0f MB/s\n", types[t].class == ELFCLASS32 ? 32 : 64,
+	  types[t].name, rounds * (len / 1e6) / elapsed);
+
+  free (src);
+  free (dest);
+}
+
+int
+main (int argc, char *argv[] __attribute__ ((unused)))
+{
+  elf_version (EV_CURRENT);
+
+  /* With an argument measure the speed, otherwise check the results.  */
+  int result = 0;
+  for (size_t t = 0; t < NTYPES; t++)
+    if (argc > 1)
+      bench (t);
+    else
+      result |= check (t);
+  return result;
+}
@@ -0,0 +1,189 @@
+/* Test program for copying data directly from the source file.
+   This file is part of elfutils.
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   elfutils is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <libelf.h>
+#include <gelf.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* Copy INFILE to OUTFILE keeping the layout.  With SOURCE read
+   INFILE with ELF_C_READ_MMAP and pass it as REF for the new file.
+   Then the input descriptor is ended and closed before the new file
+   is written, the new descriptor must keep what it needs.  */
+static int
+copy (const char *infile, const char *outfile, bool source)
+{
+  int fd = open (infile, O_RDONLY);
+  if (fd < 0)
+    {
+      printf ("cannot open %s\n", infile);
+      return 1;
+    }
+
+  Elf *elf = elf_begin (fd, source ? ELF_C_READ_MMAP : ELF_C_READ, NULL);
+  if (elf == NULL)
+    {
+      printf ("%s: elf_begin: %s\n", infile, elf_errmsg (-1));
+      return 1;
+    }
+
+  int newfd = open (outfile, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (newfd < 0)
+    {
+      printf ("cannot create %s\n", outfile);
+      return 1;
+    }
+
+  Elf *newelf = elf_begin (newfd, ELF_C_WRITE, source ? elf : NULL);
+  if (newelf == NULL)
+    {
+      printf ("%s: elf_begin: %s\n", outfile, elf_errmsg (-1));
+      return 1;
+    }
+
+  GElf_Ehdr ehdr_mem;
+  GElf_Ehdr *ehdr = gelf_getehdr (elf, &ehdr_mem);
+  if (ehdr == NULL
+      || gelf_newehdr (newelf, gelf_getclass (elf)) == 0
+      || gelf_update_ehdr (newelf, ehdr) == 0)
+    {
+      printf ("%s: cannot copy ELF header: %s\n", infile, elf_errmsg (-1));
+      return 1;
+    }
+
+  size_t phnum;
+  if (elf_getphdrnum (elf, &phnum) != 0
+      || (phnum > 0 && gelf_newphdr (newelf, phnum) == 0))
+    {
+      printf ("%s: cannot create phdrs: %s\n", infile, elf_errmsg (-1));
+      return 1;
+    }
+  for (size_t i = 0; i < phnum; i++)
+    {
+      GElf_Phdr phdr_mem;
+      GElf_Phdr *phdr = gelf_getphdr (elf, i, &phdr_mem);
+      if (phdr == NULL || gelf_update_phdr (newelf, i, phdr) == 0)
+	{
+	  printf ("%s: cannot copy phdr: %s\n", infile, elf_errmsg (-1));
+	  return 1;
+	}
+    }
+
+  Elf_Scn *scn = NULL;
+  while ((scn = elf_nextscn (elf, scn)) != NULL)
+    {
+      Elf_Scn *newscn = elf_newscn (newelf);
+      GElf_Shdr shdr_mem;
+      GElf_Shdr *shdr = gelf_getshdr (scn, &shdr_mem);
+      Elf_Data *data = elf_getdata (scn, NULL);
+      Elf_Data *newdata = newscn != NULL ? elf_newdata (newscn) : NULL;
+      if (shdr == NULL || data == NULL || newdata == NULL
+	  || gelf_update_shdr (newscn, shdr) == 0)
+	{
+	  printf ("%s: cannot copy section: %s\n", infile, elf_errmsg (-1));
+	  return 1;
+	}
+      *newdata = *data;
+    }
+
+  /* The new descriptor has its own file descriptor of the input.  */
+  if (source)
+    close (fd);
+
+  elf_flagelf (newelf, ELF_C_SET, ELF_F_LAYOUT);
+  if (elf_update (newelf, ELF_C_WRITE) < 0)
+    {
+      printf ("%s: elf_update: %s\n", outfile, elf_errmsg (-1));
+      return 1;
+    }
+
+  if (elf_end (newelf) != 0)
+    {
+      printf ("%s: elf_end: %s\n", outfile, elf_errmsg (-1));
+      return 1;
+    }
+  close (newfd);
+
+  /* The new descriptor didn't keep a reference to the input.  */
+  if (elf_end (elf) != 0)
+    {
+      printf ("%s: elf_end: wrong reference count\n", infile);
+      return 1;
+    }
+  if (! source)
+    close (fd);
+  return 0;
+}
+
+/* Read all of FILE into a new buffer.  */
+static char *
+slurp (const char *file, size_t *size)
+{
+  int fd = open (file, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    return NULL;
+  char *buf = malloc (st.st_size ?: 1);
+  if (buf == NULL || read (fd, buf, st.st_size) != st.st_size)
+    return NULL;
+  close (fd);
+  *size = st.st_size;
+  return buf;
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc != 4)
+    {
+      printf ("Usage: INFILE OUTFILE1 OUTFILE2\n");
+      return -1;
+    }
+
+  elf_version (EV_CURRENT);
+
+  if (copy (argv[1], argv[2], false) != 0
+      || copy (argv[1], argv[3], true) != 0)
+    return 1;
+
+  size_t size1, size2;
+  char *buf1 = slurp (argv[2], &size1);
+  char *buf2 = slurp (argv[3], &size2);
+  if (buf1 == NULL || buf2 == NULL)
+    {
+      printf ("cannot read output files\n");
+      return 1;
+    }
+
+  if (size1 != size2 || memcmp (buf1, buf2, size1) != 0)
+    {
+      printf ("%s: copies differ\n", argv[1]);
+      return 1;
+    }
+
+  free (buf1);
+  free (buf2);
+  return 0;
+}
@@ -61,6 +61,19 @@ testrun_elfcompress_file()
     echo "uncompress $elfcompressedfile -> $elfuncompressedfile"
     testrun ${abs_top_builddir}/src/elfcompress -v -t none -o ${elfuncompressedfile} ${elfcompressedfile}
     testrun ${abs_top_builddir}/src/elfcmp ${uncompressedfile} ${elfuncompressedfile}
+
+    # Using more threads gives the same files.
+    parallelfile="${infile}.parallel"
+    tempfiles "$parallelfile"
+    echo "compress gnu in parallel $uncompressedfile -> $parallelfile"
+    testrun ${abs_top_builddir}/src/elfcompress -q -j 4 -t gnu -o ${parallelfile} ${uncompressedfile}
+    cmp ${gnucompressedfile} ${parallelfile}
+    echo "compress gabi in parallel $uncompressedfile -> $parallelfile"
+    testrun ${abs_top_builddir}/src/elfcompress -q -j 4 -t zlib -o ${parallelfile} ${uncompressedfile}
+    cmp ${elfcompressedfile} ${parallelfile}
+    echo "uncompress in parallel $gnucompressedfile -> $parallelfile"
+    testrun ${abs_top_builddir}/src/elfcompress -q -j 4 -t none -o ${parallelfile} ${gnucompressedfile}
+    cmp ${gnuuncompressedfile} ${parallelfile}
 }
 
 testrun_elfcompress()
@@ -0,0 +1,34 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Disassembly throughput on the x86-64 test file, see
+# run-disasm-x86-64.sh.
+case "`uname -m`" in
+  x86_64)
+    tempfiles testfile45.o
+    testfiles testfile45.S
+    gcc -m64 -c -o testfile45.o testfile45.S
+
+    testrun_compare ${abs_builddir}/disasm-bench testfile45.o 1 <<\EOF
+11422 instructions
+EOF
+
+    # Not checked, the instructions/second are only informational.
+    testrun ${abs_builddir}/disasm-bench testfile45.o 200 bench
+    ;;
+esac
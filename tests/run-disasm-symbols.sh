@@ -0,0 +1,76 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Branch targets are named after the symbols of the object.  The
+# addresses are relative to each section, so .text.other only sees
+# its own symbols.
+case "`uname -m`" in
+  x86_64)
+    tempfiles testfile-disasm-symbols.S testfile-disasm-symbols.o
+    cat > testfile-disasm-symbols.S <<\EOF
+	.text
+	.type	helper, @function
+helper:
+	lea	0x1(%rdi,%rdi,2),%eax
+	ret
+	.size	helper, .-helper
+	.globl	f
+	.type	f, @function
+f:
+	cmp	$0x3,%edi
+	jg	1f
+0:	call	helper
+	cmp	$0x63,%eax
+	jle	0b
+	ret
+1:	jmp	helper
+	.size	f, .-f
+	.section .text.other,"ax",@progbits
+	.globl	other
+	.type	other, @function
+other:
+	test	%edi,%edi
+	jle	1f
+	jmp	other
+1:	ret
+	.size	other, .-other
+EOF
+    gcc -m64 -c -o testfile-disasm-symbols.o testfile-disasm-symbols.S
+    testrun_compare ${abs_top_builddir}/src/objdump -d testfile-disasm-symbols.o <<\EOF
+testfile-disasm-symbols.o: elf64-elf_x86_64
+
+Disassembly of section .text:
+
+       0:    8d 44 7f 01              lea     0x1(%rdi,%rdi,2),%eax
+       4:    c3                       retq
+       5:    83 ff 03                 cmp     $0x3,%edi
+       8:    7f 0b                    jg      0x15                       # <f+0x10>
+       a:    e8 f1 ff ff ff           callq   0x0                        # <helper>
+       f:    83 f8 63                 cmp     $0x63,%eax
+      12:    7e f6                    jle     0xa                        # <f+0x5>
+      14:    c3                       retq
+      15:    eb e9                    jmp     0x0                        # <helper>
+Disassembly of section .text.other:
+
+       0:    85 ff                    test    %edi,%edi
+       2:    7e 02                    jle     0x6                        # <other+0x6>
+       4:    eb fa                    jmp     0x0                        # <other>
+       6:    c3                       retq
+EOF
+    ;;
+esac
@@ -0,0 +1,116 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Look up every code address in .debug_frame, which has no binary search
+# table.  The results are those from reading the FDEs one by one.
+# See also run-addrcfi.sh.
+testfiles testfile11 testfile12 testfileppc32 testfileppc64
+testfiles testfilearm testfileaarch64
+testrun_compare ${abs_builddir}/dwarf-cfi-lookup testfile11 testfile12 \
+  testfileppc32 testfileppc64 testfilearm testfileaarch64 <<\EOF
+testfile11:
+0x80487e4..0x80487fb: no matching address range
+0x80487fc..0x80488fb: no matching address range
+0x8048900..0x80489b7: no matching address range
+0x80489b8..0x80489b8: [0x80489b8, 0x80489b9)
+0x80489b9..0x80489ba: [0x80489b9, 0x80489bb)
+0x80489bb..0x80489c2: [0x80489bb, 0x80489c3)
+0x80489c3..0x8048c9d: [0x80489c3, 0x8048c9e)
+0x8048c9e..0x8048c9e: [0x8048c9e, 0x8048c9f)
+0x8048c9f..0x8048ca0: [0x8048c9f, 0x8048ca1)
+0x8048ca1..0x8048cd6: [0x8048ca1, 0x8048cd7)
+0x8048cd7..0x8048cd7: no matching address range
+0x8048cd8..0x8048cd8: [0x8048cd8, 0x8048cd9)
+0x8048cd9..0x8048cda: [0x8048cd9, 0x8048cdb)
+0x8048cdb..0x8048cf2: [0x8048cdb, 0x8048cf3)
+0x8048cf3..0x8048cf3: no matching address range
+0x8048cf4..0x8048cf4: [0x8048cf4, 0x8048cf5)
+0x8048cf5..0x8048cf6: [0x8048cf5, 0x8048cf7)
+0x8048cf7..0x8048d2c: [0x8048cf7, 0x8048d2d)
+0x8048d2d..0x8048d2d: no matching address range
+0x8048d2e..0x8048d2e: [0x8048d2e, 0x8048d2f)
+0x8048d2f..0x8048d30: [0x8048d2f, 0x8048d31)
+0x8048d31..0x8048d60: [0x8048d31, 0x8048d61)
+0x8048d61..0x8048d61: no matching address range
+0x8048d62..0x8048d62: [0x8048d62, 0x8048d63)
+0x8048d63..0x8048d64: [0x8048d63, 0x8048d65)
+0x8048d65..0x8048d88: [0x8048d65, 0x8048d89)
+0x8048d89..0x8048d89: no matching address range
+0x8048d8a..0x8048d8a: [0x8048d8a, 0x8048d8b)
+0x8048d8b..0x8048d8c: [0x8048d8b, 0x8048d8d)
+0x8048d8d..0x8048db0: [0x8048d8d, 0x8048db1)
+0x8048db1..0x8048db1: no matching address range
+0x8048db2..0x8048db2: [0x8048db2, 0x8048db3)
+0x8048db3..0x8048db4: [0x8048db3, 0x8048db5)
+0x8048db5..0x8048de4: [0x8048db5, 0x8048de5)
+0x8048de5..0x8048e1f: no matching address range
+0x8048e20..0x8048e3d: no matching address range
+testfile12:
+0x878..0x88f: no matching address range
+0x890..0x8cf: no matching address range
+0x900..0x9cf: no matching address range
+0x9d0..0x9d0: [0x9d0, 0x9d1)
+0x9d1..0x9d3: [0x9d1, 0x9d4)
+0x9d4..0x9e6: [0x9d4, 0x9e7)
+0x9e7..0xa27: no matching address range
+0xa28..0xa35: no matching address range
+testfileppc32:
+0x1000029c..0x100002df: no matching address range
+0x100002e0..0x100002ef: [0x100002e0, 0x100002f0)
+0x100002f0..0x100004bf: no matching address range
+0x100004c0..0x100004cf: [0x100004c0, 0x100004d0)
+0x100004d0..0x1000060f: no matching address range
+0x10000610..0x1000063b: no matching address range
+testfileppc64:
+0x10000348..0x1000037b: no matching address range
+0x10000380..0x1000039f: no matching address range
+0x100003a0..0x100003b3: [0x100003a0, 0x100003b4)
+0x100003b4..0x100003cb: [0x100003b4, 0x100003cc)
+0x100003cc..0x100003d3: [0x100003cc, 0x100003d4)
+0x100003d4..0x100003e3: [0x100003d4, 0x100003e4)
+0x100003e4..0x100005af: no matching address range
+0x100005b0..0x100005cf: [0x100005b0, 0x100005d0)
+0x100005d0..0x100006f7: no matching address range
+0x100006f8..0x10000713: no matching address range
+testfilearm:
+0x8384..0x838f: no matching address range
+0x8390..0x83c7: no matching address range
+0x83c8..0x83db: [0x83c8, 0x83dc)
+0x83dc..0x850f: no matching address range
+0x8510..0x8523: [0x8510, 0x8524)
+0x8524..0x858b: no matching address range
+0x858c..0x8593: no matching address range
+testfileaarch64:
+0x400378..0x40038b: no matching address range
+0x400390..0x4003df: no matching address range
+0x4003e0..0x4003ef: [0x4003e0, 0x4003f0)
+0x4003f0..0x40054f: no matching address range
+0x400550..0x400567: [0x400550, 0x400568)
+0x400568..0x4005e3: no matching address range
+0x4005e4..0x4005f3: no matching address range
+EOF
+
+# A bad FDE in .eh_frame without the .eh_frame_hdr table is not just
+# left out, looking up its addresses fails.
+testrun_compare ${abs_builddir}/dwarf-cfi-lookup -b \
+  ${abs_builddir}/dwarf-cfi-lookup <<\EOF
+bad FDE: invalid DWARF
+all of the other FDEs found
+EOF
+
+exit 0
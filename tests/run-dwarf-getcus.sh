@@ -0,0 +1,35 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Walk all DIEs with 1, 4 and 16 threads, reporting DIEs per second.
+# Without --enable-thread-safety all walks are done by one thread.
+testrun_on_self ${abs_builddir}/dwarf-getcus
+
+# The big-endian unit_length of the third CU of testfile39, at
+# .debug_info offset 298, replaced by a reserved value.  The two CUs
+# before it are still handled, then the error is reported.
+testfiles testfile39
+cp testfile39 testfile39-badunit
+printf '\377\377\377\360' | dd of=testfile39-badunit bs=1 seek=$((0xe10 + 298)) \
+  conv=notrunc 2>/dev/null
+tempfiles testfile39-badunit
+testrun_compare ${abs_builddir}/dwarf-getcus testfile39-badunit <<\EOF
+testfile39-badunit: -1, 2 of 2 CUs handled, invalid DWARF
+EOF
+
+exit 0
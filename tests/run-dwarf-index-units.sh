@@ -0,0 +1,42 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Random DIE offset lookups, with units read lazily and up front,
+# also reporting the time per lookup.
+testrun_on_self ${abs_builddir}/dwarf-index-units
+
+# Multiple CUs, and type units.
+testfiles testfile39 testfile-debug-types
+testrun ${abs_builddir}/dwarf-index-units testfile39 testfile-debug-types \
+  > index-units.out
+if grep dwarf_index_units index-units.out; then
+  exit 1
+fi
+
+# The big-endian unit_length of the third CU, at .debug_info offset 298,
+# replaced by a reserved value.  The two CUs before it are still indexed.
+cp testfile39 testfile39-badunit
+printf '\377\377\377\360' | dd of=testfile39-badunit bs=1 seek=$((0xe10 + 298)) \
+  conv=notrunc 2>/dev/null
+tempfiles testfile39-badunit index-units.out
+testrun ${abs_builddir}/dwarf-index-units testfile39-badunit \
+  > index-units.out
+grep "^testfile39-badunit: dwarf_index_units: invalid DWARF$" index-units.out
+grep "^testfile39-badunit: 2 units," index-units.out
+
+exit 0
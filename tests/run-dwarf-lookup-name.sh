@@ -0,0 +1,43 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Without an index section all names are found through the index
+# built in memory.
+testrun_on_self ${abs_builddir}/dwarf-lookup-name
+
+testfiles testfile-debug-types
+testrun ${abs_builddir}/dwarf-lookup-name testfile-debug-types
+
+# See run-readelf-gdb_index.sh for the sources.  Only the units listed
+# in .gdb_index are searched.
+testfiles testfilegdbindex5 testfilegdbindex7
+for file in testfilegdbindex5 testfilegdbindex7; do
+  testrun_compare ${abs_builddir}/dwarf-lookup-name $file \
+    main hello global say foo char int nonexistent <<\EOF
+main: [34] tag 0x2e
+hello: [97] tag 0x34
+hello: [f7] tag 0x2e
+global: [168] tag 0x34
+say: [12e] tag 0x2e
+foo: [1d] tag 0x13
+char: [2d] tag 0x24
+int: [84] tag 0x24
+EOF
+done
+
+exit 0
@@ -0,0 +1,29 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Several threads walking all CUs of one shared Dwarf handle must all
+# see the same DIEs, line tables and locations.
+testrun_on_self ${abs_builddir}/dwarf-thread-stress
+
+# Some multi-CU files, and type units so DW_FORM_ref_sig8 lookups
+# race too.
+testfiles testfile39 testfile-m68k testfile-debug-types
+testrun ${abs_builddir}/dwarf-thread-stress testfile39 testfile-m68k \
+	testfile-debug-types
+
+exit 0
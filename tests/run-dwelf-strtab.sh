@@ -0,0 +1,60 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Strings that are the end of another string are merged into it.
+testrun_compare ${abs_top_builddir}/tests/dwelf-strtab <<\EOF
+nullstr 1, size 28: \0xfoo\0foobar\0.rela.text\0baz\0
+  "" 0
+  "foo" 2
+  "bar" 9
+  "oo" 3
+  "foobar" 6
+  "o" 4
+  "xfoo" 1
+  "foo" 2
+  "ar" 10
+  "" 0
+  "baz" 24
+  "az" 25
+  "z" 26
+  ".text" 18
+  ".rela.text" 13
+  "text" 19
+nullstr 0, size 27: xfoo\0foobar\0.rela.text\0baz\0
+  "" 4
+  "foo" 1
+  "bar" 8
+  "oo" 2
+  "foobar" 5
+  "o" 3
+  "xfoo" 0
+  "foo" 1
+  "ar" 9
+  "" 4
+  "baz" 23
+  "az" 24
+  "z" 25
+  ".text" 17
+  ".rela.text" 12
+  "text" 18
+EOF
+
+# Rebuild the string tables of real files, printing how long it takes.
+testrun_on_self ${abs_top_builddir}/tests/dwelf-strtab
+
+exit 0
@@ -0,0 +1,27 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Random address lookups, also reporting the time per lookup.
+testrun_on_self ${abs_builddir}/dwfl-addrsym -e
+
+# A ppc64 file with function descriptors, so symbols are also
+# matched against their adjusted st_value.
+testfiles testfilebazdbgppc64
+testrun ${abs_builddir}/dwfl-addrsym -e testfilebazdbgppc64
+
+exit 0
@@ -0,0 +1,55 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Look up addresses without a cache, while writing the cache and from
+# the cache only, all must give the same symbols and lines.
+mkdir cache
+testrun_on_self ${abs_builddir}/dwfl-cache cache
+
+# A file without DWARF, only the symbols are cached.
+testfiles testfile-nolfs
+testrun ${abs_builddir}/dwfl-cache cache testfile-nolfs
+
+rm -f cache/*
+
+# A file whose DWARF is in a separate debug file.  The cache written
+# before the debug file is installed has no lines, and must not be
+# used once it is there.  See run-addr2line-i-test.sh.
+testfiles testfile-inlines
+mkdir bindir bindir/.debug
+testrun ${abs_top_builddir}/src/strip -f testfile-inlines.debug \
+  -o bindir/testfile-inlines testfile-inlines
+testrun ${abs_builddir}/dwfl-cache cache bindir/testfile-inlines \
+  > dwfl-cache.out
+grep "^testfile-inlines: [0-9]* found$" dwfl-cache.out
+mv testfile-inlines.debug bindir/.debug
+testrun ${abs_builddir}/dwfl-cache cache bindir/testfile-inlines \
+  > dwfl-cache.out
+
+# A changed debug file also makes the cache out of date.
+cp bindir/.debug/testfile-inlines.debug testfile-inlines.debug
+mv testfile-inlines.debug bindir/.debug
+touch -d "2000-01-01" bindir/.debug/testfile-inlines.debug
+testrun ${abs_builddir}/dwfl-cache cache bindir/testfile-inlines \
+  > dwfl-cache.out
+
+rm -f cache/* bindir/.debug/testfile-inlines.debug
+rm bindir/testfile-inlines dwfl-cache.out
+rmdir cache bindir/.debug bindir
+
+exit 0
@@ -0,0 +1,61 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# A file with a build ID, see run-addr2line-i-test.sh.
+testfiles testfile-inlines
+
+abs_test_bindir=$(pwd)/bindir
+abs_test_iddir=$(pwd)/iddir
+abs_test_emptydir=$(pwd)/emptydir
+
+mkdir -p ${abs_test_bindir}/.debug ${abs_test_emptydir}
+mkdir -p ${abs_test_iddir}/.build-id/21
+
+testrun ${abs_top_builddir}/src/strip \
+  -f ${abs_test_bindir}/.debug/testfile-inlines.debug \
+  -o ${abs_test_bindir}/testfile-inlines testfile-inlines
+
+# Found by name in the .debug subdirectory for every module.
+testrun_compare ${abs_builddir}/dwfl-debuginfo-cache :.debug \
+  ${abs_test_bindir}/testfile-inlines 100 <<\EOF
+100 modules, debuginfo testfile-inlines.debug
+EOF
+
+# Found by build ID.
+cp ${abs_test_bindir}/.debug/testfile-inlines.debug \
+  ${abs_test_iddir}/.build-id/21/35fd61aca50b90333a956bec1ecfed572dd588.debug
+testrun_compare ${abs_builddir}/dwfl-debuginfo-cache ${abs_test_iddir} \
+  ${abs_test_bindir}/testfile-inlines 100 <<\EOF
+100 modules, debuginfo 35fd61aca50b90333a956bec1ecfed572dd588.debug
+EOF
+
+# Found for none.
+testrun_compare ${abs_builddir}/dwfl-debuginfo-cache ${abs_test_emptydir} \
+  ${abs_test_bindir}/testfile-inlines 100 <<\EOF
+100 modules, debuginfo none
+EOF
+
+# Cleanup
+rm ${abs_test_bindir}/.debug/testfile-inlines.debug
+rm ${abs_test_bindir}/testfile-inlines
+rm ${abs_test_iddir}/.build-id/21/35fd61aca50b90333a956bec1ecfed572dd588.debug
+rmdir ${abs_test_bindir}/.debug ${abs_test_bindir} ${abs_test_emptydir}
+rmdir ${abs_test_iddir}/.build-id/21 ${abs_test_iddir}/.build-id
+rmdir ${abs_test_iddir}
+
+exit 0
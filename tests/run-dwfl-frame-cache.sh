@@ -0,0 +1,28 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Unwind all threads of a core file three times, after the first pass
+# all frames are unwound from the cached CFI frame states.
+testfiles backtrace.x86_64.exec backtrace.x86_64.core
+testrun_compare ${abs_builddir}/dwfl-frame-cache -e backtrace.x86_64.exec --core=backtrace.x86_64.core <<\EOF
+pass 1: 11 frames, 0 hits, 11 misses
+pass 2: 11 frames, 11 hits, 0 misses
+pass 3: 11 frames, 11 hits, 0 misses
+EOF
+
+exit 0
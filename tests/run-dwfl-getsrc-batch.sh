@@ -0,0 +1,33 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Resolve a sorted and a shuffled batch of addresses, both must match
+# what dwfl_module_getsrc finds for each address.
+testrun_on_self ${abs_builddir}/dwfl-getsrc-batch
+
+# The first line table has an unknown version, so its CU's addresses
+# get no line, but all others must still be found.
+cp ${abs_top_builddir}/src/readelf readelf-badline
+line_off=$(testrun ${abs_top_builddir}/src/readelf -S -W readelf-badline \
+	   | sed -n 's/^.* \.debug_line  *[A-Z]*  *[0-9a-f]*  *\([0-9a-f]*\) .*$/\1/p')
+printf '\377\377' | dd of=readelf-badline bs=1 seek=$((0x$line_off + 4)) \
+  conv=notrunc 2>/dev/null
+testrun ${abs_builddir}/dwfl-getsrc-batch readelf-badline
+rm -f readelf-badline
+
+exit 0
@@ -0,0 +1,78 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+testfiles hello_x86_64.ko
+
+abs_test_moddir=$(pwd)/moddir
+mkdir -p ${abs_test_moddir}/kernel/drivers/misc ${abs_test_moddir}/extra
+mkdir -p ${abs_test_moddir}/source
+cp hello_x86_64.ko ${abs_test_moddir}/kernel/drivers/misc/foo.ko
+cp hello_x86_64.ko ${abs_test_moddir}/kernel/drivers/misc/bar-baz.ko
+cp hello_x86_64.ko ${abs_test_moddir}/extra/qux.ko
+cp hello_x86_64.ko ${abs_test_moddir}/source/skipped.ko
+echo "not a module" > ${abs_test_moddir}/extra/readme.txt
+
+# Without modules.dep all module files are found walking the directory.
+testrun_compare ${abs_builddir}/dwfl-report-kernel-modules \
+  ${abs_test_moddir} <<\EOF
+3 modules
+bar_baz kernel/drivers/misc/bar-baz.ko
+foo kernel/drivers/misc/foo.ko
+qux extra/qux.ko
+EOF
+
+# modules.dep doesn't change which files are reported, neither for
+# modules missing there nor for files listed but not there.
+cat > ${abs_test_moddir}/modules.dep <<\EOF
+kernel/drivers/misc/foo.ko:
+kernel/drivers/misc/bar-baz.ko: kernel/drivers/misc/foo.ko
+kernel/drivers/misc/gone.ko:
+EOF
+cp hello_x86_64.ko ${abs_test_moddir}/kernel/drivers/misc/new.ko
+testrun_compare ${abs_builddir}/dwfl-report-kernel-modules \
+  ${abs_test_moddir} <<\EOF
+4 modules
+bar_baz kernel/drivers/misc/bar-baz.ko
+foo kernel/drivers/misc/foo.ko
+new kernel/drivers/misc/new.ko
+qux extra/qux.ko
+EOF
+
+# A module file that is not ELF is an error.  The modules found before
+# it are still reported.
+echo "not a module" > ${abs_test_moddir}/extra/bad.ko
+testrun ${abs_builddir}/dwfl-report-kernel-modules ${abs_test_moddir} \
+  > modules.out
+head -1 modules.out | grep "^dwfl_linux_kernel_report_offline: "
+rm ${abs_test_moddir}/extra/bad.ko
+
+# Many modules, all opened before they are reported.  They must not
+# keep their files open.
+rm ${abs_test_moddir}/modules.dep ${abs_test_moddir}/kernel/drivers/misc/new.ko
+for i in $(seq 1 500); do
+  cp hello_x86_64.ko ${abs_test_moddir}/extra/m$i.ko
+done
+(ulimit -n 64 && testrun ${abs_builddir}/dwfl-report-kernel-modules \
+   ${abs_test_moddir}) | head -1 > modules.out
+echo "503 modules" | cmp - modules.out
+
+# Cleanup
+rm -r ${abs_test_moddir}
+rm modules.out
+
+exit 0
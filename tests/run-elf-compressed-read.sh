@@ -0,0 +1,72 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-elfgetchdr.sh for testfiles.
+
+testfiles testfile-zgnu64 testfile-zgabi32be
+testrun_compare ${abs_top_builddir}/tests/elf-compressed-read testfile-zgnu64 testfile-zgabi32be <<\EOF
+.zdebug_aranges: 96 bytes
+.zdebug_info: 170 bytes
+.zdebug_line: 141 bytes
+.debug_aranges: 64 bytes
+.debug_info: 110 bytes
+.debug_line: 133 bytes
+EOF
+
+# Larger sections, compressed in each supported way.
+tempfiles testfile.zlib testfile.gnu testfile.zstd
+testrun ${abs_top_builddir}/src/elfcompress -q -t zlib -o testfile.zlib \
+  ${abs_top_builddir}/src/readelf
+testrun ${abs_top_builddir}/tests/elf-compressed-read testfile.zlib > /dev/null
+testrun ${abs_top_builddir}/src/elfcompress -q -t gnu -o testfile.gnu \
+  ${abs_top_builddir}/src/readelf
+testrun ${abs_top_builddir}/tests/elf-compressed-read testfile.gnu > /dev/null
+
+# The compression level must be one the type has.
+tempfiles testfile.level level.err
+testrun ${abs_top_builddir}/src/elfcompress -q -t zlib -l 9 -o testfile.level \
+  ${abs_top_builddir}/src/readelf
+testrun ${abs_top_builddir}/tests/elf-compressed-read testfile.level \
+  > /dev/null
+for level in 0 10; do
+  if testrun ${abs_top_builddir}/src/elfcompress -q -t zlib -l $level \
+       -o testfile.level ${abs_top_builddir}/src/readelf 2> level.err; then
+    echo "zlib level $level accepted"
+    exit 1
+  fi
+done
+grep -q "compression level 10 too high for zlib, the highest is 9" level.err
+
+# zstd only if elfcompress was built with it.
+if testrun ${abs_top_builddir}/src/elfcompress -q -t zstd -o testfile.zstd \
+     ${abs_top_builddir}/src/readelf 2> /dev/null; then
+  testrun ${abs_top_builddir}/tests/elf-compressed-read testfile.zstd \
+    > /dev/null
+  testrun ${abs_top_builddir}/src/elfcompress -q -t zstd -l 19 \
+    -o testfile.level ${abs_top_builddir}/src/readelf
+  testrun ${abs_top_builddir}/tests/elf-compressed-read testfile.level \
+    > /dev/null
+  if testrun ${abs_top_builddir}/src/elfcompress -q -t zstd -l 1000 \
+       -o testfile.level ${abs_top_builddir}/src/readelf 2> level.err; then
+    echo "zstd level 1000 accepted"
+    exit 1
+  fi
+  grep -q "compression level 1000 too high for zstd" level.err
+fi
+
+exit 0
@@ -0,0 +1,66 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# See run-elfgetchdr.sh for testfiles.
+
+testfiles testfile-zgnu64 testfile-zgabi32be
+testrun_compare ${abs_top_builddir}/tests/elf-paged-read 0 testfile-zgnu64 <<\EOF
+.text: 42 bytes
+.zdebug_aranges: 50 bytes, 96 decompressed
+.zdebug_info: 111 bytes, 170 decompressed
+.debug_abbrev: 40 bytes
+.zdebug_line: 91 bytes, 141 decompressed
+.shstrtab: 89 bytes
+.symtab: 360 bytes
+.strtab: 75 bytes
+.text: elf_getdata read the cached pages
+EOF
+
+# A cache of a single page.
+testrun_compare ${abs_top_builddir}/tests/elf-paged-read 1 testfile-zgabi32be <<\EOF
+.text: 116 bytes
+.eh_frame: 0 bytes
+.debug_aranges: 51 bytes, 64 decompressed
+.debug_info: 88 bytes, 110 decompressed
+.debug_abbrev: 40 bytes
+.debug_line: 89 bytes, 133 decompressed
+.shstrtab: 96 bytes
+.symtab: 272 bytes
+.strtab: 69 bytes
+.text: elf_getdata read the cached pages
+EOF
+
+# Larger sections, compressed in each supported way, read through the
+# smallest cache and through the default one.
+tempfiles testfile.zlib testfile.gnu testfile.zstd
+testrun ${abs_top_builddir}/src/elfcompress -q -t zlib -o testfile.zlib \
+  ${abs_top_builddir}/libdw/libdw.so
+testrun ${abs_top_builddir}/src/elfcompress -q -t gnu -o testfile.gnu \
+  ${abs_top_builddir}/libdw/libdw.so
+files="${abs_top_builddir}/libdw/libdw.so testfile.zlib testfile.gnu"
+if testrun ${abs_top_builddir}/src/elfcompress -q -t zstd -o testfile.zstd \
+     ${abs_top_builddir}/libdw/libdw.so 2> /dev/null; then
+  files="$files testfile.zstd"
+fi
+
+for file in $files; do
+  testrun ${abs_top_builddir}/tests/elf-paged-read 1 $file > /dev/null
+  testrun ${abs_top_builddir}/tests/elf-paged-read 0 $file > /dev/null
+done
+
+exit 0
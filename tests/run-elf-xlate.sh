@@ -0,0 +1,41 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Converting to the other byte order gives the same as swapping every
+# field by itself.
+testrun_compare ${abs_top_builddir}/tests/elf-xlate <<\EOF
+32-bit HALF: OK
+32-bit WORD: OK
+32-bit SYM: OK
+32-bit REL: OK
+32-bit RELA: OK
+32-bit DYN: OK
+64-bit HALF: OK
+64-bit WORD: OK
+64-bit XWORD: OK
+64-bit ADDR: OK
+64-bit SYM: OK
+64-bit REL: OK
+64-bit RELA: OK
+64-bit DYN: OK
+EOF
+
+# Print how fast it is.
+testrun ${abs_top_builddir}/tests/elf-xlate bench
+
+exit 0
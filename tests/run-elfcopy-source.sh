@@ -0,0 +1,34 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# Copying data straight from a source mapped with ELF_C_READ_MMAP must
+# give the same file as writing the data normally, for all byte orders.
+tempfiles copy.plain copy.source
+
+for file in testfile testfile-zgabi32be testfile-zgnu64be testfileppc32 \
+	    testfile-s390x-hash-both hello_x86_64.ko; do
+  testfiles $file
+  testrun ${abs_builddir}/elfcopy-source $file copy.plain copy.source
+  cmp $file copy.plain
+done
+
+# Also for a file not in the test directory.
+testrun ${abs_builddir}/elfcopy-source ${abs_top_builddir}/src/elfcompress \
+  copy.plain copy.source
+
+exit 0
@@ -0,0 +1,73 @@
+#! /bin/sh
+# This file is part of elfutils.
+#
+# This file is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# elfutils is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+. $srcdir/test-subr.sh
+
+# strip -j processes the files in parallel, but the result, the error
+# messages and their order must be the same as one after the other.
+files="hello_i386.ko hello_x86_64.ko notelf hello_ppc64.ko hello_s390.ko \
+       hello_aarch64.ko testfile notelf2 hello_m68k.ko"
+testfiles hello_i386.ko hello_x86_64.ko hello_ppc64.ko hello_s390.ko \
+	hello_aarch64.ko hello_m68k.ko testfile
+
+mkdir orig serial parallel
+for f in $files; do
+  if test -f $f; then
+    mv $f orig/$f
+  else
+    echo "not an ELF file" > orig/$f
+  fi
+done
+
+tempfiles strip.err.serial strip.err.parallel
+for j in serial parallel; do
+  cp orig/* $j
+  cd $j
+  if test $j = serial; then
+    jobs=1
+  else
+    jobs=4
+  fi
+  testrun ${abs_top_builddir}/src/strip -j $jobs $files \
+    2> ../strip.err.$j && { echo "strip -j $jobs did not fail"; exit 1; }
+  cd ..
+done
+
+diff -u strip.err.serial strip.err.parallel
+for f in $files; do
+  cmp serial/$f parallel/$f
+done
+rm -rf orig serial parallel
+
+# unstrip -d reports every module that cannot be handled, in order.
+testfiles testcore-rtlib
+mkdir out
+tempfiles unstrip.err unstrip.msg
+testrun ${abs_top_builddir}/src/unstrip -j 4 -m -d out --core=testcore-rtlib \
+  2> unstrip.err && { echo "unstrip -j 4 did not fail"; exit 1; }
+sed 's/^.*unstrip: //' unstrip.err > unstrip.msg
+rm -rf out
+
+diff -u unstrip.msg - <<\EOF
+cannot find debug file for module '[exe]': No DWARF information found
+cannot find stripped file for module 'libpthread.so.0': Callback returned failure
+cannot find stripped file for module 'libc.so.6': Callback returned failure
+cannot find stripped file for module 'librt.so.1': Callback returned failure
+cannot find debug file for module 'linux-gate.so.1': No DWARF information found
+cannot find stripped file for module 'ld-linux.so.2': Callback returned failure
+EOF
+
+exit 0